@@ -0,0 +1,158 @@
+/* audio output: raw 16 bit PCM (a file or stdout) or WAV file
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "audio_output.h"
+
+typedef struct {
+    char riff[4];
+    uint32_t riff_size;
+    char wave[4];
+    char fmt[4];
+    uint32_t fmt_size;
+    uint16_t format;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    char data[4];
+    uint32_t data_size;
+} WavHeader;
+
+struct AudioOutput {
+    int fd;
+    int channels;
+    int sample_rate;
+    int wav;
+    unsigned long long data_size;
+};
+
+static void fill_wav_header(WavHeader *header, int channels, int sample_rate, unsigned long long data_size);
+static int write_all(int fd, const void *data, size_t count);
+
+
+AudioOutput *audio_output_open(const char *filename, int channels, int sample_rate)
+{
+    int fd;
+    int wav = 0;
+    if (strcmp(filename, "-") == 0) {
+        /* take over stdout, so nothing else printed there gets mixed with
+         * the audio samples */
+        fflush(stdout);
+        fd = dup(STDOUT_FILENO);
+        if (fd == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+            fprintf(stderr, "dup(stdout) failed: %s\n", strerror(errno));
+            return NULL;
+        }
+    } else {
+        fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            fprintf(stderr, "open(%s) for writing failed: %s\n", filename, strerror(errno));
+            return NULL;
+        }
+        size_t len = strlen(filename);
+        wav = len > 4 && strcasecmp(filename + len - 4, ".wav") == 0;
+    }
+
+    AudioOutput *audio_output = (AudioOutput *)malloc(sizeof(AudioOutput));
+    audio_output->fd = fd;
+    audio_output->channels = channels;
+    audio_output->sample_rate = sample_rate;
+    audio_output->wav = wav;
+    audio_output->data_size = 0;
+    if (wav) {
+        /* the sizes are 'unknown' (as in a stream) until the file is closed */
+        WavHeader header;
+        fill_wav_header(&header, channels, sample_rate, UINT32_MAX - sizeof(WavHeader) + 8);
+        header.data_size = UINT32_MAX;
+        if (write_all(fd, &header, sizeof(header)) == -1) {
+            close(fd);
+            free(audio_output);
+            return NULL;
+        }
+    }
+    return audio_output;
+}
+
+int audio_output_write(AudioOutput *audio_output, const short *samples, unsigned int frames)
+{
+    size_t count = (size_t)frames * audio_output->channels * sizeof(short);
+    if (count == 0)
+        return 0;
+    if (write_all(audio_output->fd, samples, count) == -1)
+        return -1;
+    audio_output->data_size += count;
+    return 0;
+}
+
+int audio_output_close(AudioOutput *audio_output)
+{
+    int ret = 0;
+    if (audio_output->wav) {
+        WavHeader header;
+        unsigned long long data_size = audio_output->data_size;
+        if (data_size > UINT32_MAX - sizeof(WavHeader))
+            data_size = UINT32_MAX - sizeof(WavHeader);
+        fill_wav_header(&header, audio_output->channels, audio_output->sample_rate, data_size);
+        if (pwrite(audio_output->fd, &header, sizeof(header), 0) != sizeof(header)) {
+            fprintf(stderr, "pwrite(WAV header) failed: %s\n", strerror(errno));
+            ret = -1;
+        }
+    }
+    if (close(audio_output->fd) == -1) {
+        fprintf(stderr, "close() failed: %s\n", strerror(errno));
+        ret = -1;
+    }
+    free(audio_output);
+    return ret;
+}
+
+
+static void fill_wav_header(WavHeader *header, int channels, int sample_rate, unsigned long long data_size)
+{
+    memcpy(header->riff, "RIFF", 4);
+    header->riff_size = (uint32_t)(data_size + sizeof(WavHeader) - 8);
+    memcpy(header->wave, "WAVE", 4);
+    memcpy(header->fmt, "fmt ", 4);
+    header->fmt_size = 16;
+    header->format = 1;        /* PCM */
+    header->channels = channels;
+    header->sample_rate = sample_rate;
+    header->byte_rate = sample_rate * channels * sizeof(short);
+    header->block_align = channels * sizeof(short);
+    header->bits_per_sample = 16;
+    memcpy(header->data, "data", 4);
+    header->data_size = (uint32_t)data_size;
+}
+
+static int write_all(int fd, const void *data, size_t count)
+{
+    const char *p = (const char *)data;
+    while (count > 0) {
+        ssize_t nwritten = write(fd, p, count);
+        if (nwritten == -1) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "write() failed: %s\n", strerror(errno));
+            return -1;
+        }
+        p += nwritten;
+        count -= nwritten;
+    }
+    return 0;
+}
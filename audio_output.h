@@ -0,0 +1,24 @@
+/* audio output: raw 16 bit PCM (a file or stdout) or WAV file
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _AUDIO_OUTPUT_H
+#define _AUDIO_OUTPUT_H
+
+typedef struct AudioOutput AudioOutput;
+
+/* '-' writes raw signed 16 bit little endian PCM to stdout (to pipe into
+ * aplay, sox, etc) and from then on anything else printed to stdout goes
+ * to stderr instead; a file name ending in '.wav' gets a WAV header (with
+ * the sizes filled in on close); anything else is a raw PCM file */
+AudioOutput *audio_output_open(const char *filename, int channels, int sample_rate);
+/* write 'frames' frames of interleaved samples; returns -1 on error */
+int audio_output_write(AudioOutput *audio_output, const short *samples, unsigned int frames);
+int audio_output_close(AudioOutput *audio_output);
+
+#endif /* _AUDIO_OUTPUT_H */
@@ -0,0 +1,84 @@
+/* table driven RSPduo channel settings
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "channel_params.h"
+
+/* the enums are read and written as int */
+_Static_assert(sizeof(sdrplay_api_If_kHzT) == sizeof(int), "unexpected enum size");
+
+
+static double channel_param_get(const ChannelParam *param, const sdrplay_api_RxChannelParamsT *rx_channel_params)
+{
+    const char *field = (const char *)rx_channel_params + param->offset;
+    switch (param->type) {
+        case CHANNEL_PARAM_UCHAR:
+            return *(const unsigned char *)field;
+        case CHANNEL_PARAM_INT:
+            return *(const int *)field;
+        case CHANNEL_PARAM_DOUBLE:
+            return *(const double *)field;
+    }
+    return 0.0;
+}
+
+static void channel_param_set(const ChannelParam *param, sdrplay_api_RxChannelParamsT *rx_channel_params, double value)
+{
+    char *field = (char *)rx_channel_params + param->offset;
+    switch (param->type) {
+        case CHANNEL_PARAM_UCHAR:
+            *(unsigned char *)field = (unsigned char)value;
+            break;
+        case CHANNEL_PARAM_INT:
+            *(int *)field = (int)value;
+            break;
+        case CHANNEL_PARAM_DOUBLE:
+            *(double *)field = value;
+            break;
+    }
+}
+
+void channel_params_apply(const ChannelParam *params, int num_params, sdrplay_api_RxChannelParamsT *rx_channel_params, int channel)
+{
+    for (int i = 0; i < num_params; i++)
+        if (params[i].enabled[channel])
+            channel_param_set(&params[i], rx_channel_params, params[i].value[channel]);
+}
+
+sdrplay_api_ReasonForUpdateT channel_params_update(const ChannelParam *params, int num_params, sdrplay_api_RxChannelParamsT *rx_channel_params, int channel)
+{
+    sdrplay_api_ReasonForUpdateT reason_for_update = sdrplay_api_Update_None;
+    for (int i = 0; i < num_params; i++) {
+        const ChannelParam *param = &params[i];
+        if (!param->enabled[channel])
+            continue;
+        double value = param->value[channel];
+        int differs_from_A = param->enabled[0] && value != param->value[0];
+        if (differs_from_A || channel_param_get(param, rx_channel_params) != value) {
+            channel_param_set(param, rx_channel_params, value);
+            reason_for_update |= param->reason;
+        }
+    }
+    return reason_for_update;
+}
+
+int channel_params_verify(const ChannelParam *params, int num_params, const sdrplay_api_RxChannelParamsT *rx_channel_params, int channel, const char *prefix, FILE *stream)
+{
+    int mismatches = 0;
+    for (int i = 0; i < num_params; i++) {
+        const ChannelParam *param = &params[i];
+        if (!param->enabled[channel])
+            continue;
+        double value = channel_param_get(param, rx_channel_params);
+        if (value != param->value[channel]) {
+            fprintf(stream, "unexpected change - RX %s%c %s: %.0lf -> %.0lf\n", prefix, 'A' + channel, param->name, param->value[channel], value);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
@@ -0,0 +1,61 @@
+/* table driven RSPduo channel settings
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _CHANNEL_PARAMS_H
+#define _CHANNEL_PARAMS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <sdrplay_api.h>
+
+/* each setting is described once: where it is in the channel parameters,
+ * the value wanted for A and for B, and the reason for update that
+ * applies it; the same table sets the parameters before sdrplay_api_Init(),
+ * works out what has to be updated in B after it (sdrplay_api_Init()
+ * resets B to the A values), and checks that nothing was changed */
+typedef enum {
+    CHANNEL_PARAM_UCHAR,
+    CHANNEL_PARAM_INT,         /* also the sdrplay_api enums */
+    CHANNEL_PARAM_DOUBLE
+} ChannelParamType;
+
+typedef struct {
+    const char *name;          /* as in the 'unexpected change' messages */
+    size_t offset;             /* in sdrplay_api_RxChannelParamsT */
+    ChannelParamType type;
+    sdrplay_api_ReasonForUpdateT reason;
+    double value[2];           /* A and B */
+    int enabled[2];            /* left alone if not (the gain with the AGC for instance) */
+} ChannelParam;
+
+#define CHANNEL_PARAM_TYPE(field) _Generic((field), \
+    unsigned char: CHANNEL_PARAM_UCHAR, \
+    double: CHANNEL_PARAM_DOUBLE, \
+    default: CHANNEL_PARAM_INT)
+
+#define CHANNEL_PARAM_IF(name, field, reason, value_A, value_B, enabled_A, enabled_B) \
+    { name, offsetof(sdrplay_api_RxChannelParamsT, field), CHANNEL_PARAM_TYPE(((sdrplay_api_RxChannelParamsT *)0)->field), reason, { value_A, value_B }, { enabled_A, enabled_B } }
+#define CHANNEL_PARAM(name, field, reason, value_A, value_B) \
+    CHANNEL_PARAM_IF(name, field, reason, value_A, value_B, 1, 1)
+
+/* channel: 0 for A, 1 for B */
+void channel_params_apply(const ChannelParam *params, int num_params, sdrplay_api_RxChannelParamsT *rx_channel_params, int channel);
+
+/* after sdrplay_api_Init(): set the B values that are not what is wanted,
+ * or that differ from A (in case B still shows the old values), and
+ * return the reasons for update for just those (sdrplay_api_Update_None
+ * if there is nothing to update) */
+sdrplay_api_ReasonForUpdateT channel_params_update(const ChannelParam *params, int num_params, sdrplay_api_RxChannelParamsT *rx_channel_params, int channel);
+
+/* report each value that is not what was set ('unexpected change - RX
+ * <prefix><A|B> <name>: <wanted> -> <actual>'), and return how many */
+int channel_params_verify(const ChannelParam *params, int num_params, const sdrplay_api_RxChannelParamsT *rx_channel_params, int channel, const char *prefix, FILE *stream);
+
+#endif /* _CHANNEL_PARAMS_H */
@@ -0,0 +1,269 @@
+/* single file container for the A and B I/Q streams
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "container.h"
+
+struct Container {
+    char *filename;
+    Output *output;
+    ContainerHeader header;
+    char *chunk;                       /* the chunk being filled */
+    ContainerChunkIndexEntry *chunk_index;
+    size_t chunk_index_size;           /* allocated entries */
+    uint64_t dropped_blocks;
+};
+
+static int write_all(Container *container, const void *data, size_t count);
+static int flush_chunk(Container *container);
+static int write_indexes(Container *container);
+static int64_t realtime_offset_ns(void);
+
+
+Container *container_open(const char *filename, OutputEngine engine, off_t preallocate_size, const double sample_rate[2], const double frequency[2])
+{
+    if (engine == OUTPUT_ENGINE_MMAP) {
+        fprintf(stderr, "the container output is not supported with the mmap output engine\n");
+        return NULL;
+    }
+    Output *output = output_open(filename, engine, preallocate_size);
+    if (output == NULL)
+        return NULL;
+
+    Container *container = (Container *)calloc(1, sizeof(Container));
+    container->filename = strdup(filename);
+    container->output = output;
+    /* page aligned, in case the output engine uses O_DIRECT */
+    if (posix_memalign((void **)&container->chunk, CONTAINER_HEADER_SIZE, CONTAINER_CHUNK_SIZE) != 0) {
+        fprintf(stderr, "posix_memalign(%d) failed\n", CONTAINER_CHUNK_SIZE);
+        output_close(output);
+        free(container->filename);
+        free(container);
+        return NULL;
+    }
+
+    ContainerHeader *header = &container->header;
+    memcpy(header->magic, CONTAINER_MAGIC, sizeof(header->magic));
+    header->version = CONTAINER_VERSION;
+    header->chunk_size = CONTAINER_CHUNK_SIZE;
+    header->time_quantum_ns = CONTAINER_TIME_QUANTUM_NS;
+    header->realtime_offset_ns = realtime_offset_ns();
+    for (int i = 0; i < 2; i++) {
+        header->sample_rate[i] = sample_rate[i];
+        header->frequency[i] = frequency[i];
+    }
+
+    /* the header is written again with the final counts at the end */
+    memset(container->chunk, 0, CONTAINER_HEADER_SIZE);
+    memcpy(container->chunk, header, sizeof(ContainerHeader));
+    if (write_all(container, container->chunk, CONTAINER_HEADER_SIZE) == -1) {
+        output_close(output);
+        free(container->chunk);
+        free(container->filename);
+        free(container);
+        return NULL;
+    }
+    memset(container->chunk, 0, sizeof(ContainerChunkHeader));
+    return container;
+}
+
+int container_append(Container *container, const ContainerBlockHeader *block_header, const void *samples)
+{
+    size_t block_size = CONTAINER_BLOCK_SIZE(block_header->num_samples);
+    if (block_size > CONTAINER_CHUNK_SIZE - sizeof(ContainerChunkHeader)) {
+        container->dropped_blocks++;
+        return 0;
+    }
+    ContainerChunkHeader *chunk_header = (ContainerChunkHeader *)container->chunk;
+    if (chunk_header->used_bytes + block_size > CONTAINER_CHUNK_SIZE) {
+        if (flush_chunk(container) == -1)
+            return -1;
+    }
+    if (chunk_header->num_blocks == 0) {
+        memcpy(chunk_header->magic, CONTAINER_CHUNK_MAGIC, sizeof(chunk_header->magic));
+        chunk_header->chunk_number = container->header.num_chunks;
+        chunk_header->first_timestamp_ns = block_header->timestamp_ns;
+        chunk_header->used_bytes = sizeof(ContainerChunkHeader);
+    }
+
+    char *block = container->chunk + chunk_header->used_bytes;
+    size_t samples_size = block_header->num_samples * 2 * sizeof(short);
+    memcpy(block, block_header, sizeof(ContainerBlockHeader));
+    memcpy(block + sizeof(ContainerBlockHeader), samples, samples_size);
+    memset(block + sizeof(ContainerBlockHeader) + samples_size, 0, block_size - sizeof(ContainerBlockHeader) - samples_size);
+    chunk_header->num_blocks++;
+    chunk_header->used_bytes += block_size;
+
+    ContainerHeader *header = &container->header;
+    if (header->total_blocks[0] + header->total_blocks[1] == 0)
+        header->start_timestamp_ns = block_header->timestamp_ns;
+    int channel = block_header->rx_id == 'B' ? 1 : 0;
+    header->total_blocks[channel]++;
+    header->total_samples[channel] += block_header->num_samples;
+
+    /* the chunk index is built as we go (growing it is cheap compared to
+     * writing a whole chunk) */
+    uint64_t chunk_number = header->num_chunks;
+    if (chunk_number >= container->chunk_index_size) {
+        size_t new_size = container->chunk_index_size > 0 ? 2 * container->chunk_index_size : 1024;
+        ContainerChunkIndexEntry *chunk_index = realloc(container->chunk_index, new_size * sizeof(ContainerChunkIndexEntry));
+        if (chunk_index == NULL) {
+            fprintf(stderr, "realloc(%zu) failed\n", new_size * sizeof(ContainerChunkIndexEntry));
+            return -1;
+        }
+        container->chunk_index = chunk_index;
+        container->chunk_index_size = new_size;
+    }
+    ContainerChunkIndexEntry *entry = &container->chunk_index[chunk_number];
+    /* blocks of the two channels can arrive slightly out of order, so the
+     * chunk range is the max seen rather than the timestamp of the last block */
+    if (chunk_header->num_blocks == 1) {
+        entry->first_timestamp_ns = block_header->timestamp_ns;
+        entry->last_timestamp_ns = block_header->timestamp_ns;
+    } else if (block_header->timestamp_ns > entry->last_timestamp_ns) {
+        entry->last_timestamp_ns = block_header->timestamp_ns;
+    }
+    entry->num_blocks = chunk_header->num_blocks;
+    entry->reserved = 0;
+    return 0;
+}
+
+int container_close(Container *container)
+{
+    int ret = 0;
+    ContainerChunkHeader *chunk_header = (ContainerChunkHeader *)container->chunk;
+    if (chunk_header->num_blocks > 0 && flush_chunk(container) == -1)
+        ret = -1;
+    if (ret == 0 && write_indexes(container) == -1)
+        ret = -1;
+    if (output_close(container->output) == -1)
+        ret = -1;
+
+    /* rewrite the header with the final counts and the index offsets */
+    if (ret == 0) {
+        int fd = open(container->filename, O_WRONLY);
+        if (fd == -1) {
+            fprintf(stderr, "open(%s) failed: %s\n", container->filename, strerror(errno));
+            ret = -1;
+        } else {
+            memset(container->chunk, 0, CONTAINER_HEADER_SIZE);
+            memcpy(container->chunk, &container->header, sizeof(ContainerHeader));
+            if (pwrite(fd, container->chunk, CONTAINER_HEADER_SIZE, 0) != CONTAINER_HEADER_SIZE) {
+                fprintf(stderr, "pwrite(%s) failed: %s\n", container->filename, strerror(errno));
+                ret = -1;
+            }
+            close(fd);
+        }
+    }
+
+    free(container->chunk_index);
+    free(container->chunk);
+    free(container->filename);
+    free(container);
+    return ret;
+}
+
+uint64_t container_num_chunks(const Container *container)
+{
+    return container->header.num_chunks;
+}
+
+uint64_t container_num_blocks(const Container *container)
+{
+    return container->header.total_blocks[0] + container->header.total_blocks[1];
+}
+
+uint64_t container_dropped_blocks(const Container *container)
+{
+    return container->dropped_blocks;
+}
+
+Output *container_output(Container *container)
+{
+    return container->output;
+}
+
+
+static int write_all(Container *container, const void *data, size_t count)
+{
+    size_t written = 0;
+    while (written < count) {
+        ssize_t nwritten = output_write(container->output, (const char *)data + written, count - written);
+        if (nwritten == -1) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "%s - write failed: %s\n", container->filename, strerror(errno));
+            return -1;
+        }
+        written += nwritten;
+    }
+    return 0;
+}
+
+/* chunks are always written in full, so chunk n is at a fixed offset */
+static int flush_chunk(Container *container)
+{
+    ContainerChunkHeader *chunk_header = (ContainerChunkHeader *)container->chunk;
+    memset(container->chunk + chunk_header->used_bytes, 0, CONTAINER_CHUNK_SIZE - chunk_header->used_bytes);
+    if (write_all(container, container->chunk, CONTAINER_CHUNK_SIZE) == -1)
+        return -1;
+    container->header.num_chunks++;
+    memset(chunk_header, 0, sizeof(ContainerChunkHeader));
+    return 0;
+}
+
+static int write_indexes(Container *container)
+{
+    ContainerHeader *header = &container->header;
+    uint64_t num_chunks = header->num_chunks;
+    header->chunk_index_offset = CONTAINER_HEADER_SIZE + num_chunks * CONTAINER_CHUNK_SIZE;
+    if (num_chunks > 0 && write_all(container, container->chunk_index, num_chunks * sizeof(ContainerChunkIndexEntry)) == -1)
+        return -1;
+
+    /* entry k: first chunk whose last block is at or after start + k*quantum;
+     * both sequences are increasing, so this is a single merge pass */
+    header->time_index_offset = header->chunk_index_offset + num_chunks * sizeof(ContainerChunkIndexEntry);
+    header->time_index_count = 0;
+    if (num_chunks == 0)
+        return 0;
+    uint64_t duration_ns = container->chunk_index[num_chunks - 1].last_timestamp_ns - header->start_timestamp_ns;
+    header->time_index_count = duration_ns / header->time_quantum_ns + 1;
+    uint32_t buffer[1024];
+    size_t nbuffer = 0;
+    uint32_t chunk = 0;
+    for (uint64_t k = 0; k < header->time_index_count; k++) {
+        uint64_t t = header->start_timestamp_ns + k * header->time_quantum_ns;
+        while (chunk < num_chunks - 1 && container->chunk_index[chunk].last_timestamp_ns < t)
+            chunk++;
+        buffer[nbuffer++] = chunk;
+        if (nbuffer == sizeof(buffer) / sizeof(buffer[0])) {
+            if (write_all(container, buffer, sizeof(buffer)) == -1)
+                return -1;
+            nbuffer = 0;
+        }
+    }
+    if (nbuffer > 0 && write_all(container, buffer, nbuffer * sizeof(buffer[0])) == -1)
+        return -1;
+    return 0;
+}
+
+static int64_t realtime_offset_ns(void)
+{
+    struct timespec monotonic, realtime;
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    return (int64_t)(realtime.tv_sec - monotonic.tv_sec) * 1000000000LL + (realtime.tv_nsec - monotonic.tv_nsec);
+}
@@ -0,0 +1,107 @@
+/* single file container for the A and B I/Q streams
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _CONTAINER_H
+#define _CONTAINER_H
+
+#include <stdint.h>
+
+#include "output.h"
+
+/* file layout (all the fields are in the host byte order):
+ *   - a ContainerHeader, padded to CONTAINER_HEADER_SIZE
+ *   - num_chunks chunks of exactly chunk_size bytes; each chunk starts with
+ *     a ContainerChunkHeader followed by blocks (a ContainerBlockHeader and
+ *     the interleaved I/Q samples of one callback, padded to 8 bytes);
+ *     blocks never span two chunks, and the A and B blocks are merged in
+ *     timestamp order by the writer (the container itself does not
+ *     require it: the chunk index has the latest timestamp in each chunk)
+ *   - the chunk index: one ContainerChunkIndexEntry per chunk
+ *   - the time index: for each time_quantum_ns since start_timestamp_ns,
+ *     the number of the first chunk with blocks at or after that time
+ *     (as a uint32_t), so seeking to a time offset is a table lookup
+ * the index and the header counts are written when the file is closed;
+ * a recording that was not closed properly can still be read in full by
+ * walking the chunks */
+
+#define CONTAINER_MAGIC "RSPDUODT"
+#define CONTAINER_CHUNK_MAGIC "DTCHUNK"
+#define CONTAINER_VERSION 1
+#define CONTAINER_HEADER_SIZE 4096
+#define CONTAINER_CHUNK_SIZE (1024 * 1024)
+#define CONTAINER_TIME_QUANTUM_NS 10000000ULL
+
+/* block flags */
+#define CONTAINER_BLOCK_RESET 0x01      /* 'reset' was set in the callback */
+#define CONTAINER_BLOCK_GR_CHANGED 0x02
+#define CONTAINER_BLOCK_RF_CHANGED 0x04
+#define CONTAINER_BLOCK_FS_CHANGED 0x08
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t chunk_size;
+    uint64_t num_chunks;
+    uint64_t chunk_index_offset;       /* 0 if the file was not closed properly */
+    uint64_t time_index_offset;
+    uint64_t time_index_count;
+    uint64_t time_quantum_ns;
+    uint64_t start_timestamp_ns;       /* CLOCK_MONOTONIC time of the first block */
+    int64_t realtime_offset_ns;        /* add to a block timestamp to get the UTC time */
+    double sample_rate[2];             /* nominal sample rate for A and B */
+    double frequency[2];               /* center frequency for A and B */
+    uint64_t total_samples[2];
+    uint64_t total_blocks[2];
+} ContainerHeader;
+
+typedef struct {
+    char magic[8];
+    uint64_t chunk_number;
+    uint64_t first_timestamp_ns;
+    uint32_t num_blocks;
+    uint32_t used_bytes;               /* including this header */
+} ContainerChunkHeader;
+
+typedef struct {
+    uint64_t timestamp_ns;             /* CLOCK_MONOTONIC time of the callback */
+    uint32_t first_sample_num;
+    uint32_t num_samples;
+    uint8_t rx_id;                     /* 'A' or 'B' */
+    uint8_t flags;
+    uint16_t reserved[3];
+} ContainerBlockHeader;
+
+typedef struct {
+    uint64_t first_timestamp_ns;
+    uint64_t last_timestamp_ns;
+    uint32_t num_blocks;
+    uint32_t reserved;
+} ContainerChunkIndexEntry;
+
+/* size of a block with num_samples I/Q samples, header included */
+#define CONTAINER_BLOCK_SIZE(num_samples) ((sizeof(ContainerBlockHeader) + (num_samples) * 2 * sizeof(short) + 7) & ~(size_t)7)
+
+
+typedef struct Container Container;
+
+/* the container is written through an output engine (write or uring) */
+Container *container_open(const char *filename, OutputEngine engine, off_t preallocate_size, const double sample_rate[2], const double frequency[2]);
+/* append one block; blocks that do not fit in an empty chunk are dropped;
+ * returns -1 on error */
+int container_append(Container *container, const ContainerBlockHeader *block_header, const void *samples);
+/* flush the last chunk, write the indexes, and update the header */
+int container_close(Container *container);
+
+/* statistics */
+uint64_t container_num_chunks(const Container *container);
+uint64_t container_num_blocks(const Container *container);
+uint64_t container_dropped_blocks(const Container *container);
+Output *container_output(Container *container);
+
+#endif /* _CONTAINER_H */
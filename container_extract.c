@@ -0,0 +1,199 @@
+/* show the contents of an A/B I/Q container and extract the I/Q streams
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "container_reader.h"
+
+#define MAX_PATH_SIZE 1024
+
+static void usage(const char* progname);
+static void show_info(const ContainerReader *reader);
+static int extract_all(const ContainerReader *reader, FILE *outputs[2]);
+static int extract_window(const ContainerReader *reader, double time_offset, unsigned int num_samples, FILE *outputs[2]);
+
+
+int main(int argc, char *argv[])
+{
+    const char *output_file = NULL;
+    double time_offset = 0.0;
+    unsigned int num_samples = 0;
+
+    int c;
+    while ((c = getopt(argc, argv, "o:t:n:h")) != -1) {
+        switch (c) {
+            case 'o':
+                output_file = optarg;
+                break;
+            case 't':
+                if (sscanf(optarg, "%lg", &time_offset) != 1) {
+                    fprintf(stderr, "invalid time offset: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'n':
+                if (sscanf(optarg, "%u", &num_samples) != 1 || num_samples == 0) {
+                    fprintf(stderr, "invalid number of samples: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    ContainerReader *reader = container_reader_open(argv[optind]);
+    if (reader == NULL)
+        exit(1);
+
+    if (output_file == NULL) {
+        show_info(reader);
+        container_reader_close(reader);
+        return 0;
+    }
+
+    FILE *outputs[2];
+    for (int i = 0; i < 2; i++) {
+        char filename[MAX_PATH_SIZE];
+        snprintf(filename, MAX_PATH_SIZE, output_file, 'A' + i);
+        outputs[i] = fopen(filename, "w");
+        if (outputs[i] == NULL) {
+            fprintf(stderr, "fopen(%s) failed: %s\n", filename, strerror(errno));
+            if (i > 0)
+                fclose(outputs[0]);
+            container_reader_close(reader);
+            exit(1);
+        }
+    }
+    int ret;
+    if (num_samples > 0) {
+        ret = extract_window(reader, time_offset, num_samples, outputs);
+    } else {
+        ret = extract_all(reader, outputs);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (fclose(outputs[i]) != 0) {
+            fprintf(stderr, "fclose() failed: %s\n", strerror(errno));
+            ret = -1;
+        }
+    }
+    container_reader_close(reader);
+    return ret == 0 ? 0 : 1;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...] <container file>\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -o <output file> ('%%c' will be replaced by the channel id (A or B)) (default: only show the container contents)\n");
+    fprintf(stderr, "    -t <time offset (s)> (default: 0)\n");
+    fprintf(stderr, "    -n <number of samples> (extract this many A/B samples aligned by sample number starting at the time offset) (default: extract everything as recorded)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+static void show_info(const ContainerReader *reader)
+{
+    const ContainerHeader *header = reader->header;
+    fprintf(stdout, "version=%u chunk_size=%u chunks=%llu indexed=%d time_quantum_ns=%llu time_index_count=%llu\n", header->version, header->chunk_size, (unsigned long long)reader->num_chunks, reader->chunk_index != NULL, (unsigned long long)header->time_quantum_ns, (unsigned long long)reader->time_index_count);
+
+    /* the gaps are found by walking all the blocks */
+    unsigned long long blocks[2] = { 0, 0 };
+    unsigned long long samples[2] = { 0, 0 };
+    unsigned long long gaps[2] = { 0, 0 };
+    unsigned long long gap_samples[2] = { 0, 0 };
+    unsigned long long resets[2] = { 0, 0 };
+    uint32_t next_sample_num[2] = { 0, 0 };
+    uint64_t first_timestamp = 0;
+    uint64_t last_timestamp = 0;
+    unsigned long long out_of_order_blocks = 0;
+    uint64_t chunk = 0;
+    ContainerBlock block = { NULL, NULL };
+    while (container_reader_next_block(reader, &chunk, &block)) {
+        int channel = block.header->rx_id == 'B' ? 1 : 0;
+        if (blocks[channel] > 0 && block.header->first_sample_num != next_sample_num[channel]) {
+            gaps[channel]++;
+            gap_samples[channel] += (uint32_t)(block.header->first_sample_num - next_sample_num[channel]);
+        }
+        if (block.header->flags & CONTAINER_BLOCK_RESET)
+            resets[channel]++;
+        next_sample_num[channel] = block.header->first_sample_num + block.header->num_samples;
+        blocks[channel]++;
+        samples[channel] += block.header->num_samples;
+        if (first_timestamp == 0)
+            first_timestamp = block.header->timestamp_ns;
+        /* the writer merges A and B by timestamp; a block older than one
+         * already written means the merge did not wait for the other side */
+        if (block.header->timestamp_ns < last_timestamp)
+            out_of_order_blocks++;
+        else
+            last_timestamp = block.header->timestamp_ns;
+    }
+    double duration = 1e-9 * (last_timestamp - first_timestamp);
+    time_t start_time = (time_t)((first_timestamp + header->realtime_offset_ns) / 1000000000LL);
+    char start_time_string[64];
+    strftime(start_time_string, sizeof(start_time_string), "%Y-%m-%dT%H:%M:%SZ", gmtime(&start_time));
+    fprintf(stdout, "start_time=%s duration=%.3lfs out_of_order_blocks=%llu\n", start_time_string, duration, out_of_order_blocks);
+    for (int i = 0; i < 2; i++) {
+        fprintf(stdout, "RX %c - frequency=%.0lf sample_rate=%.0lf blocks=%llu samples=%llu gaps=%llu gap_samples=%llu resets=%llu\n", 'A' + i, header->frequency[i], header->sample_rate[i], blocks[i], samples[i], gaps[i], gap_samples[i], resets[i]);
+    }
+}
+
+/* the I/Q streams as they were recorded (like the two output files
+ * written by dual_tuner_recorder without the container) */
+static int extract_all(const ContainerReader *reader, FILE *outputs[2])
+{
+    uint64_t chunk = 0;
+    ContainerBlock block = { NULL, NULL };
+    while (container_reader_next_block(reader, &chunk, &block)) {
+        int channel = block.header->rx_id == 'B' ? 1 : 0;
+        if (fwrite(block.samples, 2 * sizeof(short), block.header->num_samples, outputs[channel]) != block.header->num_samples) {
+            fprintf(stderr, "fwrite() failed: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int extract_window(const ContainerReader *reader, double time_offset, unsigned int num_samples, FILE *outputs[2])
+{
+    short *a = (short *)malloc(num_samples * 2 * sizeof(short));
+    short *b = (short *)malloc(num_samples * 2 * sizeof(short));
+    unsigned int found[2];
+    uint32_t first_sample_num;
+    int ret = container_reader_window(reader, time_offset, num_samples, a, b, found, &first_sample_num);
+    if (ret == -1) {
+        fprintf(stderr, "time offset %.3lfs is past the end of the recording\n", time_offset);
+    } else {
+        fprintf(stdout, "first_sample_num=%u A_samples_found=%u B_samples_found=%u\n", first_sample_num, found[0], found[1]);
+        if (fwrite(a, 2 * sizeof(short), num_samples, outputs[0]) != num_samples ||
+            fwrite(b, 2 * sizeof(short), num_samples, outputs[1]) != num_samples) {
+            fprintf(stderr, "fwrite() failed: %s\n", strerror(errno));
+            ret = -1;
+        }
+    }
+    free(a);
+    free(b);
+    return ret;
+}
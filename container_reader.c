@@ -0,0 +1,225 @@
+/* reader for the single file A/B I/Q container
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "container_reader.h"
+
+static uint64_t chunk_last_timestamp(const ContainerReader *reader, uint64_t chunk);
+
+
+ContainerReader *container_reader_open(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "open(%s) failed: %s\n", filename, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        fprintf(stderr, "fstat(%s) failed: %s\n", filename, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size < CONTAINER_HEADER_SIZE) {
+        fprintf(stderr, "%s: not a container file\n", filename);
+        close(fd);
+        return NULL;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "mmap(%s) failed: %s\n", filename, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    const ContainerHeader *header = (const ContainerHeader *)base;
+    if (memcmp(header->magic, CONTAINER_MAGIC, sizeof(header->magic)) != 0 || header->version != CONTAINER_VERSION || header->chunk_size < sizeof(ContainerChunkHeader)) {
+        fprintf(stderr, "%s: not a container file or unsupported version\n", filename);
+        munmap(base, st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    ContainerReader *reader = (ContainerReader *)calloc(1, sizeof(ContainerReader));
+    reader->fd = fd;
+    reader->base = (const char *)base;
+    reader->size = st.st_size;
+    reader->header = header;
+    if (header->chunk_index_offset != 0 &&
+        header->chunk_index_offset + header->num_chunks * sizeof(ContainerChunkIndexEntry) <= reader->size &&
+        header->time_index_offset + header->time_index_count * sizeof(uint32_t) <= reader->size) {
+        reader->num_chunks = header->num_chunks;
+        reader->chunk_index = (const ContainerChunkIndexEntry *)(reader->base + header->chunk_index_offset);
+        reader->time_index = (const uint32_t *)(reader->base + header->time_index_offset);
+        reader->time_index_count = header->time_index_count;
+    } else {
+        /* the recording was interrupted: use all the complete chunks */
+        fprintf(stderr, "%s: no index - recording not closed properly?\n", filename);
+        reader->num_chunks = (reader->size - CONTAINER_HEADER_SIZE) / header->chunk_size;
+    }
+    /* we are going to walk the data sequentially most of the times */
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+    return reader;
+}
+
+void container_reader_close(ContainerReader *reader)
+{
+    munmap((void *)reader->base, reader->size);
+    close(reader->fd);
+    free(reader);
+}
+
+const ContainerChunkHeader *container_reader_chunk(const ContainerReader *reader, uint64_t chunk)
+{
+    if (chunk >= reader->num_chunks)
+        return NULL;
+    const ContainerChunkHeader *chunk_header = (const ContainerChunkHeader *)(reader->base + CONTAINER_HEADER_SIZE + chunk * reader->header->chunk_size);
+    if (memcmp(chunk_header->magic, CONTAINER_CHUNK_MAGIC, sizeof(chunk_header->magic)) != 0 ||
+        chunk_header->used_bytes > reader->header->chunk_size)
+        return NULL;
+    return chunk_header;
+}
+
+int container_reader_next_block(const ContainerReader *reader, uint64_t *chunk, ContainerBlock *block)
+{
+    while (*chunk < reader->num_chunks) {
+        const ContainerChunkHeader *chunk_header = container_reader_chunk(reader, *chunk);
+        if (chunk_header != NULL) {
+            const char *chunk_start = (const char *)chunk_header;
+            const char *next;
+            if (block->header == NULL) {
+                next = chunk_start + sizeof(ContainerChunkHeader);
+            } else {
+                next = (const char *)block->header + CONTAINER_BLOCK_SIZE(block->header->num_samples);
+            }
+            if (next + sizeof(ContainerBlockHeader) <= chunk_start + chunk_header->used_bytes) {
+                const ContainerBlockHeader *block_header = (const ContainerBlockHeader *)next;
+                if (next + CONTAINER_BLOCK_SIZE(block_header->num_samples) <= chunk_start + chunk_header->used_bytes) {
+                    block->header = block_header;
+                    block->samples = (const short *)(next + sizeof(ContainerBlockHeader));
+                    return 1;
+                }
+            }
+        }
+        (*chunk)++;
+        block->header = NULL;
+    }
+    return 0;
+}
+
+uint64_t container_reader_seek(const ContainerReader *reader, double time_offset)
+{
+    if (reader->num_chunks == 0)
+        return 0;
+    uint64_t target = reader->header->start_timestamp_ns + (uint64_t)(time_offset > 0 ? time_offset * 1e9 : 0);
+    uint64_t chunk;
+    if (reader->time_index_count > 0) {
+        uint64_t k = (target - reader->header->start_timestamp_ns) / reader->header->time_quantum_ns;
+        if (k >= reader->time_index_count)
+            return reader->num_chunks;
+        chunk = reader->time_index[k];
+        /* at most one time quantum worth of chunks to skip */
+        while (chunk < reader->num_chunks && chunk_last_timestamp(reader, chunk) < target)
+            chunk++;
+    } else {
+        /* no index: binary search on the chunk headers */
+        uint64_t lo = 0;
+        uint64_t hi = reader->num_chunks;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (chunk_last_timestamp(reader, mid) < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        chunk = lo;
+    }
+    return chunk;
+}
+
+int container_reader_window(const ContainerReader *reader, double time_offset, unsigned int num_samples, short *a, short *b, unsigned int found[2], uint32_t *first_sample_num)
+{
+    uint64_t target = reader->header->start_timestamp_ns + (uint64_t)(time_offset > 0 ? time_offset * 1e9 : 0);
+    uint64_t chunk = container_reader_seek(reader, time_offset);
+    if (chunk >= reader->num_chunks)
+        return -1;
+
+    /* the first block at or after the target time sets the window start */
+    ContainerBlock block = { NULL, NULL };
+    uint64_t start_chunk = chunk;
+    uint32_t start = 0;
+    int have_start = 0;
+    while (container_reader_next_block(reader, &chunk, &block)) {
+        if (block.header->timestamp_ns >= target) {
+            start = block.header->first_sample_num;
+            have_start = 1;
+            break;
+        }
+    }
+    if (!have_start)
+        return -1;
+
+    memset(a, 0, num_samples * 2 * sizeof(short));
+    memset(b, 0, num_samples * 2 * sizeof(short));
+    found[0] = 0;
+    found[1] = 0;
+    *first_sample_num = start;
+
+    /* the blocks with the same sample numbers from the other channel may
+     * have been received just before, so start from the previous chunk;
+     * sample numbers wrap around at 2^32, hence the signed differences */
+    chunk = start_chunk > 0 ? start_chunk - 1 : 0;
+    block.header = NULL;
+    int done[2] = { 0, 0 };
+    uint64_t done_timestamp = 0;
+    while (!(done[0] && done[1]) && container_reader_next_block(reader, &chunk, &block)) {
+        int channel = block.header->rx_id == 'B' ? 1 : 0;
+        int64_t offset = (int32_t)(block.header->first_sample_num - start);
+        if (offset >= (int64_t)num_samples) {
+            done[channel] = 1;
+            /* if the other channel stopped, do not scan to the end of the file */
+            if (done_timestamp == 0)
+                done_timestamp = block.header->timestamp_ns;
+            else if (block.header->timestamp_ns > done_timestamp + 1000000000ULL)
+                break;
+            continue;
+        }
+        if (offset + block.header->num_samples <= 0)
+            continue;
+        int64_t from = offset < 0 ? -offset : 0;
+        int64_t to = offset + block.header->num_samples > (int64_t)num_samples ? num_samples - offset : block.header->num_samples;
+        short *dst = channel == 0 ? a : b;
+        memcpy(dst + 2 * (offset + from), block.samples + 2 * from, (to - from) * 2 * sizeof(short));
+        found[channel] += to - from;
+    }
+    return 0;
+}
+
+
+static uint64_t chunk_last_timestamp(const ContainerReader *reader, uint64_t chunk)
+{
+    if (reader->chunk_index != NULL)
+        return reader->chunk_index[chunk].last_timestamp_ns;
+    /* without the index the latest block has to be found by walking the chunk */
+    uint64_t last = 0;
+    uint64_t c = chunk;
+    ContainerBlock block = { NULL, NULL };
+    while (container_reader_next_block(reader, &c, &block) && c == chunk)
+        if (block.header->timestamp_ns > last)
+            last = block.header->timestamp_ns;
+    return last;
+}
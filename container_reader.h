@@ -0,0 +1,58 @@
+/* reader for the single file A/B I/Q container
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _CONTAINER_READER_H
+#define _CONTAINER_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "container.h"
+
+/* the whole file is mapped read only; all the pointers returned point
+ * into the mapping and are valid until container_reader_close() */
+typedef struct {
+    int fd;
+    const char *base;
+    size_t size;
+    const ContainerHeader *header;
+    uint64_t num_chunks;
+    const ContainerChunkIndexEntry *chunk_index;    /* NULL if the file was not closed properly */
+    const uint32_t *time_index;
+    uint64_t time_index_count;
+} ContainerReader;
+
+typedef struct {
+    const ContainerBlockHeader *header;
+    const short *samples;              /* interleaved I/Q */
+} ContainerBlock;
+
+ContainerReader *container_reader_open(const char *filename);
+void container_reader_close(ContainerReader *reader);
+
+/* chunk number 'chunk', or NULL if out of range or corrupted */
+const ContainerChunkHeader *container_reader_chunk(const ContainerReader *reader, uint64_t chunk);
+
+/* iterate over the blocks: start with chunk=0 and block->header=NULL;
+ * returns 0 at the end of the file */
+int container_reader_next_block(const ContainerReader *reader, uint64_t *chunk, ContainerBlock *block);
+
+/* first chunk that may contain blocks at or after 'time_offset' seconds
+ * from the start of the recording (constant time with the time index) */
+uint64_t container_reader_seek(const ContainerReader *reader, double time_offset);
+
+/* fill a[] and b[] with the num_samples I/Q samples of channels A and B
+ * starting at the first sample received at or after 'time_offset' seconds;
+ * A and B are aligned by sample number, and missing samples (drops) are
+ * zeros; found[] gets the number of samples actually found in each channel
+ * and first_sample_num the sample number of the first sample in the window;
+ * returns -1 if time_offset is past the end of the recording */
+int container_reader_window(const ContainerReader *reader, double time_offset, unsigned int num_samples, short *a, short *b, unsigned int found[2], uint32_t *first_sample_num);
+
+#endif /* _CONTAINER_READER_H */
@@ -0,0 +1,220 @@
+/* digital down converter: frequency translation and decimating FIR filter
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ddc.h"
+#include "fir_kernels.h"
+
+#define DDC_SLICE_SAMPLES 8192
+#define DDC_MAX_TAPS 4095
+
+struct Ddc {
+    int decimation;
+    int num_taps;
+    unsigned int padded_taps;          /* multiple of FIR_TAPS_PADDING */
+    float *taps;
+    /* the input history (num_taps - 1 samples at most) followed by the
+     * slice being processed, after the frequency translation */
+    float *xi;
+    float *xq;
+    unsigned int length;
+    unsigned int next;                 /* start of the next output window */
+    /* NCO: the phasor advances by 'step' each sample; steps[k] = step^k */
+    int mix;
+    double phasor_re;
+    double phasor_im;
+    double steps_re[9];
+    double steps_im[9];
+    float rot_re[8];
+    float rot_im[8];
+};
+
+static unsigned int process(Ddc *ddc, const short *in, unsigned int n, short *out, float *out_i, float *out_q);
+static void mix_convert(Ddc *ddc, const short *in, unsigned int n, float *xi, float *xq);
+static short saturate(float v);
+
+
+Ddc *ddc_create(double sample_rate, double offset, double bandwidth, int decimation)
+{
+    if (decimation < 1) {
+        fprintf(stderr, "invalid DDC decimation: %d\n", decimation);
+        return NULL;
+    }
+    double output_sample_rate = sample_rate / decimation;
+    if (bandwidth <= 0 || bandwidth >= output_sample_rate) {
+        fprintf(stderr, "invalid DDC bandwidth: %.0lf - it must be less than the output sample rate (%.0lf)\n", bandwidth, output_sample_rate);
+        return NULL;
+    }
+    if (fabs(offset) + bandwidth / 2 > sample_rate / 2) {
+        fprintf(stderr, "invalid DDC frequency offset: %.0lf - outside of the input band\n", offset);
+        return NULL;
+    }
+
+    /* the passband edge is at bandwidth/2 and the stopband starts at
+     * output_sample_rate - bandwidth/2, so whatever aliases after the
+     * decimation lands outside of the passband */
+    double transition = output_sample_rate - bandwidth;
+    int num_taps = fir_lowpass_num_taps(transition / sample_rate);
+    if (num_taps > DDC_MAX_TAPS) {
+        fprintf(stderr, "DDC filter too long (%d taps) - increase the output sample rate or decrease the bandwidth\n", num_taps);
+        return NULL;
+    }
+
+    Ddc *ddc = (Ddc *)calloc(1, sizeof(Ddc));
+    ddc->decimation = decimation;
+    ddc->num_taps = num_taps;
+    ddc->padded_taps = (num_taps + FIR_TAPS_PADDING - 1) & ~(FIR_TAPS_PADDING - 1);
+    ddc->taps = (float *)calloc(ddc->padded_taps, sizeof(float));
+    /* unity gain at DC; the filter is symmetric, so no need to reverse it */
+    fir_lowpass(ddc->taps, num_taps, output_sample_rate / 2 / sample_rate, 1.0);
+
+    /* the dot product may read up to the padded length past the window */
+    size_t capacity = ddc->padded_taps + decimation + DDC_SLICE_SAMPLES + FIR_TAPS_PADDING;
+    ddc->xi = (float *)calloc(capacity, sizeof(float));
+    ddc->xq = (float *)calloc(capacity, sizeof(float));
+    ddc->length = 0;
+    ddc->next = 0;
+
+    ddc->mix = offset != 0.0;
+    ddc->phasor_re = 1.0;
+    ddc->phasor_im = 0.0;
+    double step = -2 * M_PI * offset / sample_rate;
+    for (int k = 0; k <= 8; k++) {
+        ddc->steps_re[k] = cos(step * k);
+        ddc->steps_im[k] = sin(step * k);
+        if (k < 8) {
+            ddc->rot_re[k] = (float)ddc->steps_re[k];
+            ddc->rot_im[k] = (float)ddc->steps_im[k];
+        }
+    }
+
+    fir_kernels_init();
+    return ddc;
+}
+
+void ddc_free(Ddc *ddc)
+{
+    free(ddc->taps);
+    free(ddc->xi);
+    free(ddc->xq);
+    free(ddc);
+}
+
+unsigned int ddc_process(Ddc *ddc, const short *in, unsigned int n, short *out)
+{
+    return process(ddc, in, n, out, NULL, NULL);
+}
+
+unsigned int ddc_process_float(Ddc *ddc, const short *in, unsigned int n, float *out_i, float *out_q)
+{
+    return process(ddc, in, n, NULL, out_i, out_q);
+}
+
+int ddc_num_taps(const Ddc *ddc)
+{
+    return ddc->num_taps;
+}
+
+const char *ddc_kernel_name(const Ddc *ddc)
+{
+    (void)ddc;
+    return fir_kernel_name;
+}
+
+
+static unsigned int process(Ddc *ddc, const short *in, unsigned int n, short *out, float *out_i, float *out_q)
+{
+    unsigned int nout = 0;
+    while (n > 0) {
+        unsigned int m = n < DDC_SLICE_SAMPLES ? n : DDC_SLICE_SAMPLES;
+        mix_convert(ddc, in, m, ddc->xi + ddc->length, ddc->xq + ddc->length);
+        ddc->length += m;
+        in += 2 * m;
+        n -= m;
+
+        /* only the outputs that survive the decimation are computed */
+        while (ddc->next + ddc->num_taps <= ddc->length) {
+            float yi, yq;
+            fir_dot2(ddc->taps, ddc->xi + ddc->next, ddc->xq + ddc->next, ddc->padded_taps, &yi, &yq);
+            if (out != NULL) {
+                out[2*nout] = saturate(yi);
+                out[2*nout+1] = saturate(yq);
+            } else {
+                out_i[nout] = yi;
+                out_q[nout] = yq;
+            }
+            nout++;
+            ddc->next += ddc->decimation;
+        }
+
+        /* keep what the next windows need */
+        unsigned int keep = ddc->length > ddc->next ? ddc->length - ddc->next : 0;
+        if (keep > 0) {
+            memmove(ddc->xi, ddc->xi + ddc->next, keep * sizeof(float));
+            memmove(ddc->xq, ddc->xq + ddc->next, keep * sizeof(float));
+        }
+        ddc->next -= ddc->length - keep;
+        ddc->length = keep;
+    }
+    return nout;
+}
+
+/* deinterleave and multiply by the NCO phasor; the phasor is advanced in
+ * double precision once every 8 samples, and the 8 samples in between are
+ * rotated by the precomputed steps, so the inner loop has no dependencies
+ * and can be vectorized */
+static void mix_convert(Ddc *ddc, const short *in, unsigned int n, float *xi, float *xq)
+{
+    if (!ddc->mix) {
+        for (unsigned int i = 0; i < n; i++) {
+            xi[i] = in[2*i];
+            xq[i] = in[2*i+1];
+        }
+        return;
+    }
+    double phasor_re = ddc->phasor_re;
+    double phasor_im = ddc->phasor_im;
+    unsigned int i = 0;
+    for (; i < n; i += 8) {
+        unsigned int count = n - i < 8 ? n - i : 8;
+        float pr = (float)phasor_re;
+        float pi = (float)phasor_im;
+        for (unsigned int k = 0; k < count; k++) {
+            float rr = pr * ddc->rot_re[k] - pi * ddc->rot_im[k];
+            float ri = pr * ddc->rot_im[k] + pi * ddc->rot_re[k];
+            float vi = in[2*(i+k)];
+            float vq = in[2*(i+k)+1];
+            xi[i+k] = vi * rr - vq * ri;
+            xq[i+k] = vi * ri + vq * rr;
+        }
+        double re = phasor_re * ddc->steps_re[count] - phasor_im * ddc->steps_im[count];
+        double im = phasor_re * ddc->steps_im[count] + phasor_im * ddc->steps_re[count];
+        phasor_re = re;
+        phasor_im = im;
+    }
+    /* keep the amplitude from drifting */
+    double magnitude = sqrt(phasor_re * phasor_re + phasor_im * phasor_im);
+    ddc->phasor_re = phasor_re / magnitude;
+    ddc->phasor_im = phasor_im / magnitude;
+}
+
+static short saturate(float v)
+{
+    v = v >= 0 ? v + 0.5f : v - 0.5f;
+    if (v >= 32767.0f)
+        return 32767;
+    if (v <= -32768.0f)
+        return -32768;
+    return (short)v;
+}
+
@@ -0,0 +1,34 @@
+/* digital down converter: frequency translation and decimating FIR filter
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _DDC_H
+#define _DDC_H
+
+typedef struct Ddc Ddc;
+
+/* shift the signal at 'offset' Hz from the center to 0Hz, low pass filter
+ * it to 'bandwidth' Hz, and decimate it by 'decimation'; the filter is a
+ * windowed sinc with its length chosen from the transition band between
+ * 'bandwidth' and the output sample rate; returns NULL (after printing the
+ * reason) if the parameters are not valid */
+Ddc *ddc_create(double sample_rate, double offset, double bandwidth, int decimation);
+void ddc_free(Ddc *ddc);
+
+/* process n interleaved I/Q samples from in[]; the output samples (at
+ * most n / decimation + 1) are stored interleaved in out[] and their
+ * number is returned; the state is kept from one call to the next */
+unsigned int ddc_process(Ddc *ddc, const short *in, unsigned int n, short *out);
+/* same as ddc_process(), but the output samples are left as floats and
+ * stored in separate I and Q arrays (for further processing) */
+unsigned int ddc_process_float(Ddc *ddc, const short *in, unsigned int n, float *out_i, float *out_q);
+
+int ddc_num_taps(const Ddc *ddc);
+const char *ddc_kernel_name(const Ddc *ddc);
+
+#endif /* _DDC_H */
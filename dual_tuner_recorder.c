@@ -9,42 +9,389 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#define _GNU_SOURCE
+
 #include <errno.h>
-#include <fcntl.h>
 #include <getopt.h>
 #include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
 
 #include <sdrplay_api.h>
 
+#include "audio_output.h"
+#include "channel_params.h"
+#include "container.h"
+#include "ddc.h"
+#include "histogram.h"
+#include "iq_compress.h"
+#include "iq_kernels.h"
+#include "iq_server.h"
+#include "nbfm.h"
+#include "output.h"
+#include "psd.h"
+#include "rate_estimator.h"
+#include "realtime.h"
+#include "ring_buffer.h"
+#include "sample_format.h"
+#include "shm_ring.h"
+#include "trigger.h"
+#include "xcorr.h"
+
 #define UNUSED(x) (void)(x)
 #define MAX_PATH_SIZE 1024
+#define RING_BUFFER_SIZE (32 * 1024 * 1024)
+#define WRITER_BATCH_SIZE (1024 * 1024)
+#define WRITER_POLL_INTERVAL_NS 2000000
+/* how long the container writer waits for the other channel before it
+ * writes a block on its own (well above the duration of a callback) */
+#define CONTAINER_HOLD_NS 50000000ULL
+#define AUDIO_RING_BUFFER_SIZE (1024 * 1024)
+#define AUDIO_INPUT_SAMPLES 65536
+#define AUDIO_WRITER_FRAMES 4096
+#define COMPRESS_CHUNK_SAMPLES 65536
+#define FORMAT_CHUNK_SAMPLES 65536
+#define STATS_POLL_INTERVAL_NS 100000000
+#define STATS_DROPS_INTERVAL 1.0
+#define ANCHOR_RING_BUFFER_SIZE (256 * 1024)
+#define EVENT_RING_BUFFER_SIZE (64 * 1024)
+#define GAP_HOLE_MIN_SIZE (1024 * 1024)
+#define GAP_FLAG_VALUE SHRT_MIN
+
+/* the RSPduo's recorded in a single run, each with its A and B channels */
+#define MAX_RSPDUOS 8
+#define MAX_CHANNELS (2 * MAX_RSPDUOS)
+
+typedef enum {
+    GAP_FILL_NONE,
+    GAP_FILL_ZERO,             /* zeros (holes in the file for large gaps) */
+    GAP_FILL_FLAG              /* GAP_FLAG_VALUE in both I and Q */
+} GapFill;
+
+#define ROTATION_NONE UINT64_MAX
+#define ROTATION_POLL_INTERVAL_NS 100000000
+#define ROTATION_LEAD_TIME 0.1
+#define ROTATION_SEQUENCE_FORMAT "-%06d"
+
+#define TRIGGER_DEFAULT_PRE_TRIGGER 1.0
+#define TRIGGER_DEFAULT_HANG_TIME 2.0
+/* kept in the ring buffer on top of the pre-trigger, for the blocks
+ * between the trigger in one tuner and the other */
+#define PRE_TRIGGER_MARGIN (1024 * 1024)
+
+#define SCAN_MAX_FREQUENCIES 256
+#define SCAN_DEFAULT_DWELL 1.0
+#define SCAN_DEFAULT_SETTLING_TIME 0.01
+#define SCAN_POLL_INTERVAL_NS 1000000
+/* a retune not seen in the stream by then is given up on */
+#define SCAN_RETUNE_TIMEOUT_NS 1000000000ULL
+
+#define XCORR_RING_BUFFER_SIZE (8 * 1024 * 1024)
+#define XCORR_DEFAULT_INTERVAL 1.0
+#define XCORR_DEFAULT_SIZE 4096
+#define XCORR_POLL_INTERVAL_NS 2000000
+
+#define PSD_RING_BUFFER_SIZE (1024 * 1024)
+#define PSD_DEFAULT_SIZE 1024
+#define PSD_DEFAULT_INTERVAL 0.1
+#define PSD_DEFAULT_FRAMES 16
+#define SHM_RING_DEFAULT_SIZE_MB 32
+#define SERVER_RING_BUFFER_SIZE (16 * 1024 * 1024)
+#define SERVER_DEFAULT_ADDRESS "127.0.0.1"
+#define SERVER_ADDRESS_SIZE 64
+#define PSD_POLL_INTERVAL_NS 10000000
+
+typedef enum {
+    STREAM_EVENT_GAP,          /* the dropped samples go in the output here */
+    STREAM_EVENT_ROTATION,     /* the next output file starts here */
+    STREAM_EVENT_TRIGGER_OPEN, /* a recorded segment starts here (usually in the past) */
+    STREAM_EVENT_TRIGGER_CLOSE,/* and stops here */
+    STREAM_EVENT_RETUNE        /* the first sample kept at a new frequency */
+} StreamEventType;
+
+/* queued by the callback for the writer thread, at ring_offset (in bytes
+ * written to the ring buffer) */
+typedef struct {
+    StreamEventType type;
+    uint64_t ring_offset;
+    uint64_t sample_index;     /* unwrapped sample number */
+    uint64_t num_samples;      /* gap, or the settling samples before a retune */
+    double frequency;          /* retune only */
+    int64_t latency_ns;        /* retune only (-1 for the initial frequency) */
+} StreamEvent;
+
+/* per channel instrumentation */
+enum {
+    RX_METRIC_CALLBACK_INTERVAL,   /* time between consecutive callbacks */
+    RX_METRIC_CALLBACK_TIME,       /* time spent inside rx_callback() */
+    RX_METRIC_WRITE_LATENCY,       /* time to process and write one batch */
+    RX_METRIC_NUM_SAMPLES,         /* numSamples of each callback */
+    RX_METRIC_RETUNE_LATENCY,      /* from the scan retune request to its first sample */
+    RX_METRICS
+};
+static const char *rx_metric_names[RX_METRICS] = {
+    "callback_interval_ns",
+    "callback_time_ns",
+    "write_latency_ns",
+    "num_samples",
+    "retune_latency_ns"
+};
 
 typedef struct {
     struct timeval earliest_callback;
     struct timeval latest_callback;
     unsigned long long total_samples;
     unsigned int next_sample_num;
-    int output_fd;
-    short imin, imax;
-    short qmin, qmax;
+    Output *output;
+    Container *container;      /* shared by A and B (NULL if not used) */
+    Ddc *ddc;                  /* only record the channel of interest (NULL if not used) */
+    short *ddc_buffer;
+    char *compress_buffer;     /* lossless compression (NULL if not used) */
+    unsigned long long compress_input_bytes;
+    SampleFormat sample_format;
+    float sample_scale;        /* cs8 and cs12 */
+    char *format_buffer;       /* converted samples (NULL for cs16) */
+    unsigned long long clipped_values;
+    Nbfm *nbfm;                /* live NBFM demodulation (NULL if not used) */
+    RingBuffer audio_ring_buffer;
+    short *audio_discard;      /* the audio lost when the audio ring buffer is full */
+    AudioOutput *audio_output; /* per channel, or stereo in A only */
+    pthread_t audio_writer;
+    atomic_int audio_writer_stop;
+    IQRange iq_range;
     char rx_id;
+    const char *serial_number;
+    const char *device_prefix; /* '<serial number>/' in the messages with more than one RSPduo */
+    int cpu;                   /* writer thread CPU affinity (-1 if not used) */
+    RingBuffer ring_buffer;
+    pthread_t writer;
+    atomic_int writer_stop;
+    double writer_cpu_time;
+    Histogram *histograms;     /* RX_METRICS histograms */
+    uint64_t last_callback_ns;
+    uint64_t first_callback_ns;
+    atomic_ullong dropped_events;
+    atomic_ullong dropped_samples;
+    RateEstimator rate_estimator;
+    FILE *anchor_file;         /* sample/time anchors sidecar (NULL if not used) */
+    RingBuffer anchor_ring_buffer;
+    unsigned long long file_samples;   /* samples that went in the output (callback) */
+    GapFill gap_fill;
+    RingBuffer event_ring_buffer;      /* gaps and rotations (NULL buffer if not used) */
+    short *gap_buffer;         /* one batch of fill samples */
+    FILE *gap_log;
+    unsigned long long events_lost;
+    /* file rotation: the callback queues the rotation at rotation_target
+     * (the same sample number for A and B), the writer thread switches
+     * to next_output (opened ahead of time by the rotation thread), and
+     * hands the old one to the rotation thread to be closed */
+    _Atomic uint64_t rotation_target;
+    _Atomic uint64_t last_sample_index;
+    _Atomic(Output *) next_output;
+    _Atomic(Output *) retired_output;
+    atomic_int file_number;
+    _Atomic long long output_bytes;
+    long long rotated_bytes;   /* in the files before the current one */
+    /* squelch trigger: the callback measures the power of each block and
+     * queues the start and the end of the segments, and the writer thread
+     * only keeps the last pre_trigger_bytes of the ring buffer between them */
+    Trigger *trigger;          /* shared by A and B (NULL if not used) */
+    TriggerChannel trigger_channel;
+    size_t pre_trigger_bytes;
+    FILE *trigger_log;
+    unsigned long long segments;
+    unsigned long long discarded_bytes;
+    _Atomic uint64_t peak_power;   /* highest block I^2+Q^2 per sample since the last stats */
+    /* scan: the scan thread retunes the channel after each dwell, and the
+     * callback finds the first block at the new frequency (rfChanged),
+     * skips the settling samples, and queues the retune marker with the
+     * first sample kept */
+    const double *scan_frequencies;    /* NULL if not used */
+    int num_scan_frequencies;
+    atomic_int scan_index;             /* the frequency requested last */
+    _Atomic uint64_t retune_request_ns;    /* CLOCK_MONOTONIC_RAW (0 if no retune is pending) */
+    _Atomic uint64_t retune_effective_ns;  /* fitted time of the first sample at the current frequency */
+    atomic_int gain_changed;           /* set by the event callback */
+    int scan_started;
+    uint64_t settle_samples;
+    uint64_t settle_until;             /* the samples before this are skipped */
+    StreamEvent retune_marker;
+    int retune_marker_pending;
+    unsigned long long hops;
+    unsigned long long settle_discarded;
+    unsigned long long retune_timeouts;
+    FILE *hop_log;
+    /* A/B cross-correlation: the callback copies the samples to this ring
+     * buffer (as TapBlock's), and the xcorr thread of the RSPduo takes
+     * them from there, so the output path never waits for it */
+    int xcorr_enable;
+    RingBuffer xcorr_ring_buffer;
+    /* live PSD: every PSD interval the callback copies just the samples for
+     * one average to this ring buffer, so the cost of the PSD thread does
+     * not depend on the sample rate */
+    Psd *psd;                  /* NULL if not used */
+    FILE *psd_file;
+    RingBuffer psd_ring_buffer;
+    uint64_t psd_interval_samples;
+    uint64_t psd_next_sample_index;    /* the next average starts here */
+    unsigned int psd_average_samples;
+    unsigned int psd_left;             /* still to copy for this average */
+    unsigned long long psd_records;
+    /* the shared memory ring for the local readers */
+    ShmRing *shm_ring;
+    double frequency;
+    unsigned long long shm_blocks;
+    /* the samples for the TCP server */
+    RingBuffer server_ring_buffer;
 } RXContext;
 
+/* in the xcorr and PSD ring buffers: the header, then num_samples I values
+ * and num_samples Q values (padded to a multiple of 8 bytes) */
+typedef struct {
+    uint64_t sample_index;
+    uint32_t num_samples;
+    uint32_t padding;
+} TapBlock;
+
+/* one RSPduo: its channels are rx_contexts[2 * i] (A) and rx_contexts[2 * i + 1] (B) */
+typedef struct {
+    sdrplay_api_DeviceT device;
+    sdrplay_api_DeviceParamsT *device_params;
+    char prefix[SDRPLAY_MAX_SER_NO_LEN + 1];
+    Trigger trigger;           /* shared by its A and B */
+    long long bytes_written;
+    double ab_time_offset_ns;
+    uint64_t quick_check_ns;   /* the throwaway sdrplay_api_Init()/Uninit() (0 with the fast start) */
+    uint64_t init_start_ns;    /* the sdrplay_api_Init() that starts streaming */
+    uint64_t init_ns;
+} DeviceContext;
+
+typedef struct {
+    RXContext *rx_contexts;
+    int num_channels;
+    char filenames[MAX_CHANNELS][MAX_PATH_SIZE];  /* output file names ('%c' and 'SERIAL' replaced) */
+    OutputEngine output_engine;
+    off_t preallocate_sizes[MAX_CHANNELS];
+    double sample_rates[MAX_CHANNELS];    /* at the callbacks */
+    off_t size;                /* rotate at this size (0 if not used) */
+    off_t size_thresholds[MAX_CHANNELS];  /* start the rotation here, so that the file
+                                           * ends up no bigger than size */
+    int interval;              /* rotate at multiples of this wall clock time in seconds (0 if not used) */
+    pthread_t thread;
+    atomic_int stop;
+} RotationContext;
+
+typedef struct {
+    DeviceContext *device_contexts;
+    RXContext *rx_contexts;
+    int num_channels;
+    double dwell;
+    pthread_t thread;
+    atomic_int stop;
+} ScanContext;
+
+/* one per RSPduo: it cross-correlates its A and B channels */
+typedef struct {
+    RXContext *rx_contexts;    /* A and B */
+    const char *prefix;
+    Xcorr *xcorr;
+    FILE *log;
+    double sample_rate;
+    pthread_t thread;
+    atomic_int stop;
+    /* the following are only updated by the xcorr thread */
+    uint64_t first_sample_index;
+    unsigned long long reports;
+    unsigned long long skipped_samples;    /* in A or B only (drops or tap overflows) */
+    double lag_min;
+    double lag_max;
+    double lag_sum;
+    double magnitude_sum;
+    /* least squares fit of the unwrapped phase vs time */
+    double last_phase;
+    double unwrapped_phase;
+    double sum_t;
+    double sum_p;
+    double sum_tt;
+    double sum_tp;
+} XcorrContext;
+
+typedef struct {
+    RXContext *rx_contexts;
+    int num_channels;
+    pthread_t thread;
+    atomic_int stop;
+} PsdContext;
+
+typedef struct {
+    RXContext *rx_contexts;
+    int num_channels;
+    double interval;           /* 0: only report the drops */
+    pthread_t thread;
+    atomic_int stop;
+} StatsContext;
+
 static void usage(const char* progname);
 static void rxA_callback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, void *cbContext);
 static void rxB_callback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, void *cbContext);
 static void event_callback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, sdrplay_api_EventParamsT *params, void *cbContext);
 static void rx_callback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, RXContext *rxContext);
+static void *writer_thread(void *arg);
+static void *container_writer_thread(void *arg);
+static void *audio_writer_thread(void *arg);
+static ssize_t ddc_write(RXContext *rxContext, const void *data, size_t count);
+static void samples_write(RXContext *rxContext, const short *samples, unsigned int n);
+static void nbfm_write(RXContext *rxContext, const void *data, size_t count);
+static void event_push(RXContext *rxContext, StreamEventType type, uint64_t ring_offset, uint64_t sample_index, uint64_t num_samples);
+static void gap_push(RXContext *rxContext, uint64_t sample_index, uint64_t num_samples);
+static void gap_queue(RXContext *rxContext, uint64_t sample_index, uint64_t num_samples);
+static unsigned long long output_position(const RXContext *rxContext);
+static void gap_write(RXContext *rxContext, const StreamEvent *gap);
+static void output_rotate(RXContext *rxContext, const StreamEvent *rotation);
+static int pre_trigger_service(RXContext *rxContext, int *recording, size_t *demodulated);
+static void trigger_log(RXContext *rxContext, const char *what, uint64_t sample_index);
+static unsigned int scan_block(RXContext *rxContext, int changed, uint64_t sample_index);
+static void retune_push(RXContext *rxContext, uint64_t sample_index);
+static void hop_log(RXContext *rxContext, const StreamEvent *retune);
+static void *scan_thread(void *arg);
+static size_t tap_block_size(unsigned int num_samples);
+static void tap_push(RingBuffer *ring_buffer, uint64_t sample_index, const short *xi, const short *xq, unsigned int numSamples);
+static void xcorr_log(XcorrContext *xcorr_context, const XcorrReport *report);
+static void *xcorr_thread(void *arg);
+static void psd_tap(RXContext *rxContext, uint64_t sample_index, const short *xi, const short *xq, unsigned int numSamples);
+static void *psd_thread(void *arg);
+static void xcorr_summary(XcorrContext *xcorr_context);
+static void *stats_thread(void *arg);
+static void stats_json(FILE *fp, const RXContext *rxContext, double actual_sample_rate);
+static void anchors_write(RXContext *rxContext);
+static void *rotation_thread(void *arg);
+static Output *rotation_open(RotationContext *rotation_context, int i, int file_number);
+static void sequence_filename(char *sequenced, size_t size, const char *filename, int file_number);
+static void channel_filename(char *filename, size_t size, const char *format, char rx_id, const char *serial_number);
+static int sample_ring_buffer_init(RingBuffer *ring_buffer, size_t size, RealtimeStatus *realtime_status);
+static void writer_affinity(RXContext *rxContext, pthread_t thread);
+static void release_devices(DeviceContext *device_contexts, int num_devices);
+static int device_check(const DeviceContext *device_context, const ChannelParam *channel_params, int num_channel_params, double rspduo_sample_rate);
+static void stop_handler(int signum);
+static uint64_t monotonic_ns(void);
+static uint64_t monotonic_raw_ns(void);
+static double output_sample_rate(double rspduo_sample_rate, sdrplay_api_If_kHzT if_frequency, int decimation);
+
+static volatile sig_atomic_t stop_requested = 0;
 
 
 int main(int argc, char *argv[])
 {
-    const char *serial_number = NULL;
+    char serial_numbers[MAX_RSPDUOS][SDRPLAY_MAX_SER_NO_LEN];
+    int num_serial_numbers = 0;
     double rspduo_sample_rate = 0.0;
     int decimation_A = 1;
     int decimation_B = 1;
@@ -72,14 +419,69 @@ int main(int argc, char *argv[])
     double frequency_B = 100e6;
     int streaming_time = 10;  /* streaming time in seconds */
     const char *output_file = NULL;
+    OutputEngine output_engine = OUTPUT_ENGINE_WRITE;
+    int container_enable = 0;
+    double ddc_offset_A = 0.0;
+    double ddc_offset_B = 0.0;
+    double ddc_bandwidth_A = 0.0;
+    double ddc_bandwidth_B = 0.0;
+    int ddc_decimation_A = 1;
+    int ddc_decimation_B = 1;
+    int compress_enable = 0;
+    SampleFormat sample_format = SAMPLE_FORMAT_CS16;
+    double sample_scale = 1.0;
+    const char *audio_file = NULL;
+    double volume = NBFM_DEFAULT_VOLUME;
+    double stats_interval = 0.0;
+    const char *json_file = NULL;
+    const char *anchor_file = NULL;
+    GapFill gap_fill = GAP_FILL_NONE;
+    off_t rotation_size = 0;
+    int rotation_interval = 0;
+    int trigger_enable = 0;
+    double trigger_threshold = 0.0;
+    double trigger_pre_trigger = TRIGGER_DEFAULT_PRE_TRIGGER;
+    double trigger_hang_time = TRIGGER_DEFAULT_HANG_TIME;
+    double scan_frequencies[2][SCAN_MAX_FREQUENCIES];
+    int num_scan_frequencies[2] = { 0, 0 };
+    double scan_dwell = SCAN_DEFAULT_DWELL;
+    double scan_settling_time = SCAN_DEFAULT_SETTLING_TIME;
+    const char *iq_kernel = NULL;
+    int cpus[MAX_CHANNELS];
+    int num_cpus = 0;
+    int realtime_priority = 0;
+    const char *xcorr_file = NULL;
+    double xcorr_interval = XCORR_DEFAULT_INTERVAL;
+    int xcorr_size = XCORR_DEFAULT_SIZE;
+    const char *psd_file = NULL;
+    int psd_size = PSD_DEFAULT_SIZE;
+    double psd_interval = PSD_DEFAULT_INTERVAL;
+    int psd_frames = PSD_DEFAULT_FRAMES;
+    const char *shm_name = NULL;
+    double shm_size_MB = SHM_RING_DEFAULT_SIZE_MB;
+    char server_address[SERVER_ADDRESS_SIZE] = SERVER_DEFAULT_ADDRESS;
+    int server_ports[2] = { 0, 0 };
+    int fast_start = 0;
     int debug_enable = 0;
 
     int c;
-    while ((c = getopt(argc, argv, "s:r:d:i:b:g:l:DIy:f:x:o:Lh")) != -1) {
+    while ((c = getopt(argc, argv, "s:r:d:i:b:g:l:DIy:f:H:w:x:o:O:e:czF:W:Z:A:v:S:J:T:G:R:Q:k:a:P:X:M:m:N:qLh")) != -1) {
         int n;
         switch (c) {
             case 's':
-                serial_number = optarg;
+                /* one or more serial numbers, separated by commas */
+                num_serial_numbers = 0;
+                for (const char *p = optarg; ; p++) {
+                    int len = strcspn(p, ",");
+                    if (len == 0 || len >= SDRPLAY_MAX_SER_NO_LEN || num_serial_numbers == MAX_RSPDUOS) {
+                        fprintf(stderr, "invalid serial number(s): %s\n", optarg);
+                        exit(1);
+                    }
+                    snprintf(serial_numbers[num_serial_numbers++], SDRPLAY_MAX_SER_NO_LEN, "%.*s", len, p);
+                    p += len;
+                    if (*p == '\0')
+                        break;
+                }
                 break;
             case 'r':
                 if (sscanf(optarg, "%lg", &rspduo_sample_rate) != 1) {
@@ -164,8 +566,47 @@ int main(int argc, char *argv[])
                 if (n == 1)
                     frequency_B = frequency_A;
                 break;
+            case 'H': {
+                /* '<A list>[/<B list>]', each separated by commas */
+                const char *p = optarg;
+                num_scan_frequencies[0] = 0;
+                num_scan_frequencies[1] = 0;
+                for (int k = 0; k < 2 && *p != '\0'; k++) {
+                    while (1) {
+                        double frequency;
+                        int len;
+                        if (sscanf(p, "%lg%n", &frequency, &len) != 1 || frequency <= 0 || num_scan_frequencies[k] == SCAN_MAX_FREQUENCIES) {
+                            fprintf(stderr, "invalid scan frequency list: %s\n", optarg);
+                            exit(1);
+                        }
+                        scan_frequencies[k][num_scan_frequencies[k]++] = frequency;
+                        p += len;
+                        if (*p != ',')
+                            break;
+                        p++;
+                    }
+                    if (*p == '/' && k == 0) {
+                        p++;
+                    } else if (*p != '\0') {
+                        fprintf(stderr, "invalid scan frequency list: %s\n", optarg);
+                        exit(1);
+                    }
+                }
+                if (num_scan_frequencies[1] == 0) {
+                    for (int k = 0; k < num_scan_frequencies[0]; k++)
+                        scan_frequencies[1][k] = scan_frequencies[0][k];
+                    num_scan_frequencies[1] = num_scan_frequencies[0];
+                }
+                break;
+            }
+            case 'w':
+                if (sscanf(optarg, "%lg,%lg", &scan_dwell, &scan_settling_time) < 1 || scan_dwell <= 0 || scan_settling_time < 0) {
+                    fprintf(stderr, "invalid scan dwell: %s\n", optarg);
+                    exit(1);
+                }
+                break;
             case 'x':
-                if (sscanf(optarg, "%d", &streaming_time) != 1) {
+                if (sscanf(optarg, "%d", &streaming_time) != 1 || streaming_time < 0) {
                     fprintf(stderr, "invalid streaming time: %s\n", optarg);
                     exit(1);
                 }
@@ -173,6 +614,210 @@ int main(int argc, char *argv[])
             case 'o':
                 output_file = optarg;
                 break;
+            case 'O':
+                if (sample_format_from_string(optarg, &sample_format, &sample_scale) == -1) {
+                    fprintf(stderr, "invalid output sample format: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'e':
+                if (output_engine_from_string(optarg, &output_engine) == -1) {
+                    fprintf(stderr, "invalid output engine: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'c':
+                container_enable = 1;
+                break;
+            case 'z':
+                compress_enable = 1;
+                break;
+            case 'F':
+                n = sscanf(optarg, "%lg,%lg", &ddc_offset_A, &ddc_offset_B);
+                if (n < 1) {
+                    fprintf(stderr, "invalid DDC frequency offset: %s\n", optarg);
+                    exit(1);
+                }
+                if (n == 1)
+                    ddc_offset_B = ddc_offset_A;
+                break;
+            case 'W':
+                n = sscanf(optarg, "%lg,%lg", &ddc_bandwidth_A, &ddc_bandwidth_B);
+                if (n < 1) {
+                    fprintf(stderr, "invalid DDC bandwidth: %s\n", optarg);
+                    exit(1);
+                }
+                if (n == 1)
+                    ddc_bandwidth_B = ddc_bandwidth_A;
+                break;
+            case 'Z':
+                n = sscanf(optarg, "%d,%d", &ddc_decimation_A, &ddc_decimation_B);
+                if (n < 1 || ddc_decimation_A < 1 || ddc_decimation_B < 1) {
+                    fprintf(stderr, "invalid DDC decimation: %s\n", optarg);
+                    exit(1);
+                }
+                if (n == 1)
+                    ddc_decimation_B = ddc_decimation_A;
+                break;
+            case 'A':
+                audio_file = optarg;
+                break;
+            case 'v':
+                if (sscanf(optarg, "%lg", &volume) != 1 || volume <= 0) {
+                    fprintf(stderr, "invalid volume: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'S':
+                if (sscanf(optarg, "%lg", &stats_interval) != 1 || stats_interval < 0) {
+                    fprintf(stderr, "invalid stats interval: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'J':
+                json_file = optarg;
+                break;
+            case 'T':
+                anchor_file = optarg;
+                break;
+            case 'R': {
+                double value;
+                char unit;
+                if (sscanf(optarg, "%lg%c", &value, &unit) != 2 || value <= 0) {
+                    fprintf(stderr, "invalid rotation: %s\n", optarg);
+                    exit(1);
+                }
+                if (unit == 'M' || unit == 'G') {
+                    rotation_size = (off_t)(value * (unit == 'M' ? 1e6 : 1e9));
+                } else if (unit == 's' || unit == 'm' || unit == 'h') {
+                    rotation_interval = (int)(value * (unit == 's' ? 1 : unit == 'm' ? 60 : 3600));
+                } else {
+                    fprintf(stderr, "invalid rotation: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'G':
+                if (strcmp(optarg, "zero") == 0) {
+                    gap_fill = GAP_FILL_ZERO;
+                } else if (strcmp(optarg, "flag") == 0) {
+                    gap_fill = GAP_FILL_FLAG;
+                } else {
+                    fprintf(stderr, "invalid gap fill: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'Q':
+                if (sscanf(optarg, "%lg,%lg,%lg", &trigger_threshold, &trigger_pre_trigger, &trigger_hang_time) < 1 || trigger_pre_trigger < 0 || trigger_hang_time < 0) {
+                    fprintf(stderr, "invalid squelch: %s\n", optarg);
+                    exit(1);
+                }
+                trigger_enable = 1;
+                break;
+            case 'k':
+                iq_kernel = optarg;
+                break;
+            case 'a':
+                /* the writer threads in channel order (and again from the
+                 * start of the list if there are more of them) */
+                num_cpus = 0;
+                for (const char *p = optarg; ; p++) {
+                    int cpu;
+                    int len;
+                    if (sscanf(p, "%d%n", &cpu, &len) != 1 || cpu < 0 || cpu >= CPU_SETSIZE || num_cpus == MAX_CHANNELS) {
+                        fprintf(stderr, "invalid CPU list: %s\n", optarg);
+                        exit(1);
+                    }
+                    cpus[num_cpus++] = cpu;
+                    p += len;
+                    if (*p != ',') {
+                        if (*p != '\0') {
+                            fprintf(stderr, "invalid CPU list: %s\n", optarg);
+                            exit(1);
+                        }
+                        break;
+                    }
+                }
+                break;
+            case 'P':
+                if (sscanf(optarg, "%d", &realtime_priority) != 1 || realtime_priority < sched_get_priority_min(SCHED_FIFO) || realtime_priority > sched_get_priority_max(SCHED_FIFO)) {
+                    fprintf(stderr, "invalid real-time priority: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'X': {
+                static char xcorr_path[MAX_PATH_SIZE];
+                int len = 0;
+                sscanf(optarg, "%*[^,]%n", &len);
+                if (len == 0 || len >= MAX_PATH_SIZE) {
+                    fprintf(stderr, "invalid cross-correlation: %s\n", optarg);
+                    exit(1);
+                }
+                snprintf(xcorr_path, MAX_PATH_SIZE, "%.*s", len, optarg);
+                xcorr_file = xcorr_path;
+                if (optarg[len] == ',' && (sscanf(optarg + len + 1, "%lg,%d", &xcorr_interval, &xcorr_size) < 1 || xcorr_interval <= 0 || xcorr_size < 16 || (xcorr_size & (xcorr_size - 1)) != 0)) {
+                    fprintf(stderr, "invalid cross-correlation: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'M': {
+                static char psd_path[MAX_PATH_SIZE];
+                int len = 0;
+                sscanf(optarg, "%*[^,]%n", &len);
+                if (len == 0 || len >= MAX_PATH_SIZE) {
+                    fprintf(stderr, "invalid PSD monitor: %s\n", optarg);
+                    exit(1);
+                }
+                snprintf(psd_path, MAX_PATH_SIZE, "%.*s", len, optarg);
+                psd_file = psd_path;
+                if (optarg[len] == ',' && (sscanf(optarg + len + 1, "%d,%lg,%d", &psd_size, &psd_interval, &psd_frames) < 1 || psd_size < 16 || (psd_size & (psd_size - 1)) != 0 || psd_interval <= 0 || psd_frames < 1)) {
+                    fprintf(stderr, "invalid PSD monitor: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'm': {
+                static char shm_path[MAX_PATH_SIZE];
+                int len = 0;
+                sscanf(optarg, "%*[^,]%n", &len);
+                if (len == 0 || len >= MAX_PATH_SIZE) {
+                    fprintf(stderr, "invalid shared memory ring: %s\n", optarg);
+                    exit(1);
+                }
+                snprintf(shm_path, MAX_PATH_SIZE, "%.*s", len, optarg);
+                shm_name = shm_path;
+                if (optarg[len] == ',' && (sscanf(optarg + len + 1, "%lg", &shm_size_MB) != 1 || shm_size_MB <= 0)) {
+                    fprintf(stderr, "invalid shared memory ring: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'N': {
+                /* '[<address>:]<A port>[,<B port>]' */
+                const char *ports = strchr(optarg, ':');
+                if (ports != NULL) {
+                    if (ports - optarg >= SERVER_ADDRESS_SIZE) {
+                        fprintf(stderr, "invalid server: %s\n", optarg);
+                        exit(1);
+                    }
+                    snprintf(server_address, SERVER_ADDRESS_SIZE, "%.*s", (int)(ports - optarg), optarg);
+                    ports++;
+                } else {
+                    ports = optarg;
+                }
+                n = sscanf(ports, "%d,%d", &server_ports[0], &server_ports[1]);
+                if (n == 1)
+                    server_ports[1] = server_ports[0] + 1;
+                if (n < 1 || server_ports[0] < 0 || server_ports[0] > 65535 || server_ports[1] < 0 || server_ports[1] > 65535 || (server_ports[0] == 0 && server_ports[1] == 0) || server_ports[0] == server_ports[1]) {
+                    fprintf(stderr, "invalid server: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            }
+            case 'q':
+                fast_start = 1;
+                break;
             case 'L':
                 debug_enable = 1;
                 break;
@@ -188,7 +833,160 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* a pipe or a FIFO as the output ('-' is stdout) takes the pipe engine */
+    if (output_file != NULL && !container_enable) {
+        char filename[MAX_PATH_SIZE];
+        channel_filename(filename, MAX_PATH_SIZE, output_file, 'A', "SERIAL");
+        if (output_is_pipe(filename))
+            output_engine = OUTPUT_ENGINE_PIPE;
+    }
+    /* with the mmap and the pipe engines the callbacks store the samples
+     * directly into the output */
+    int direct_output = output_engine == OUTPUT_ENGINE_MMAP || output_engine == OUTPUT_ENGINE_PIPE;
+    if (output_engine == OUTPUT_ENGINE_PIPE && (output_file == NULL || container_enable || strstr(output_file, "SAMPLERATE") != NULL)) {
+        fprintf(stderr, "the pipe output engine needs an output file name without 'SAMPLERATE' (a pipe cannot be renamed), and it is not supported with the container output\n");
+        exit(1);
+    }
+    if (output_file != NULL && audio_file != NULL && strcmp(output_file, "-") == 0 && strcmp(audio_file, "-") == 0) {
+        fprintf(stderr, "the I/Q samples and the NBFM audio cannot both go to stdout\n");
+        exit(1);
+    }
+    if ((ddc_decimation_A > 1 || ddc_decimation_B > 1) && (container_enable || direct_output)) {
+        fprintf(stderr, "the DDC is not supported with the container output or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if (compress_enable && (container_enable || direct_output)) {
+        fprintf(stderr, "the compressed output is not supported with the container output or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if (sample_format != SAMPLE_FORMAT_CS16 && (compress_enable || container_enable || direct_output)) {
+        fprintf(stderr, "the %s output format is not supported with the compressed output, with the container output, or with the mmap or the pipe output engines\n", sample_format_name(sample_format));
+        exit(1);
+    }
+    if (gap_fill != GAP_FILL_NONE && (output_file == NULL || container_enable || direct_output)) {
+        fprintf(stderr, "the gap fill needs an output file, and it is not supported with the container output (where each block has its sample number) or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if ((rotation_size > 0 || rotation_interval > 0) && (output_file == NULL || container_enable || direct_output)) {
+        fprintf(stderr, "the file rotation needs an output file, and it is not supported with the container output or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if (trigger_enable && (output_file == NULL || container_enable || direct_output)) {
+        fprintf(stderr, "the squelch trigger needs an output file, and it is not supported with the container output or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if (trigger_enable && (decimation_A != decimation_B || if_frequency_A != if_frequency_B)) {
+        fprintf(stderr, "the squelch trigger needs the same sample rate for A and B\n");
+        exit(1);
+    }
+    if (xcorr_file != NULL && (decimation_A != decimation_B || if_frequency_A != if_frequency_B)) {
+        fprintf(stderr, "the cross-correlation needs the same sample rate for A and B\n");
+        exit(1);
+    }
+    if (psd_file != NULL && strstr(psd_file, "%c") == NULL) {
+        fprintf(stderr, "the PSD file name needs '%%c'\n");
+        exit(1);
+    }
+    if (shm_name != NULL && (shm_name[0] != '/' || strchr(shm_name + 1, '/') != NULL || strstr(shm_name, "%c") == NULL)) {
+        fprintf(stderr, "the shared memory ring name needs to start with '/' (and have no other '/'), and it needs '%%c'\n");
+        exit(1);
+    }
+    /* unlike SAMPLERATE, the format is known from the start */
+    char formatted_output_file[MAX_PATH_SIZE];
+    const char *format_string = "FORMAT";
+    if (output_file != NULL && strstr(output_file, format_string)) {
+        const char *p = strstr(output_file, format_string);
+        snprintf(formatted_output_file, MAX_PATH_SIZE, "%.*s%s%s", (int)(p - output_file), output_file, sample_format_name(sample_format), p + strlen(format_string));
+        output_file = formatted_output_file;
+    }
+    int scan_enable = num_scan_frequencies[0] > 0;
+    if (scan_enable && (output_file == NULL || container_enable || direct_output)) {
+        fprintf(stderr, "the scan needs an output file, and it is not supported with the container output or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if (scan_enable && trigger_enable) {
+        fprintf(stderr, "the scan is not supported with the squelch trigger\n");
+        exit(1);
+    }
+    if (scan_enable && scan_settling_time >= scan_dwell) {
+        fprintf(stderr, "the scan settling time must be shorter than the dwell\n");
+        exit(1);
+    }
+    if (scan_enable) {
+        /* each tuner starts at the first frequency in its list */
+        frequency_A = scan_frequencies[0][0];
+        frequency_B = scan_frequencies[1][0];
+    }
+    if (gap_fill == GAP_FILL_FLAG && (ddc_decimation_A > 1 || ddc_decimation_B > 1)) {
+        fprintf(stderr, "the gap fill with flagged samples is not supported with the DDC\n");
+        exit(1);
+    }
+    if (audio_file != NULL && ((output_file != NULL && container_enable) || direct_output)) {
+        fprintf(stderr, "the NBFM audio output is not supported with the container output or with the mmap or the pipe output engines\n");
+        exit(1);
+    }
+    if (num_serial_numbers > 1 && ((output_file != NULL && strstr(output_file, "SERIAL") == NULL) || (anchor_file != NULL && strstr(anchor_file, "SERIAL") == NULL) || (xcorr_file != NULL && strstr(xcorr_file, "SERIAL") == NULL) || (psd_file != NULL && strstr(psd_file, "SERIAL") == NULL) || (shm_name != NULL && strstr(shm_name, "SERIAL") == NULL))) {
+        fprintf(stderr, "with more than one RSPduo the output, anchor, cross-correlation, and PSD file names and the shared memory ring name need 'SERIAL'\n");
+        exit(1);
+    }
+    if (num_serial_numbers > 1 && (server_ports[0] != 0 || server_ports[1] != 0)) {
+        fprintf(stderr, "the server mode is supported with one RSPduo only\n");
+        exit(1);
+    }
+    if (num_serial_numbers > 1 && audio_file != NULL) {
+        fprintf(stderr, "the NBFM audio output is not supported with more than one RSPduo\n");
+        exit(1);
+    }
+
+    /* real-time mode: lock the memory before anything is allocated (the
+     * rest is done as the buffers and the threads are created, and what
+     * took effect is reported before streaming starts) */
+    RealtimeStatus realtime_status;
+    realtime_init(&realtime_status, realtime_priority);
+    if (realtime_priority > 0)
+        realtime_lock_memory(&realtime_status);
+
+    /* open the audio outputs first, since '-' takes over stdout; '%c' in
+     * the audio file name means one (mono) file per channel, otherwise A
+     * and B are the left and right channels of one file */
+    AudioOutput *audio_outputs[2] = { NULL, NULL };
+    if (audio_file != NULL) {
+        int per_channel = strstr(audio_file, "%c") != NULL;
+        for (int i = 0; i < (per_channel ? 2 : 1); i++) {
+            char filename[MAX_PATH_SIZE];
+            snprintf(filename, MAX_PATH_SIZE, audio_file, 'A' + i);
+            audio_outputs[i] = audio_output_open(filename, per_channel ? 1 : 2, NBFM_DEFAULT_AUDIO_SAMPLE_RATE);
+            if (audio_outputs[i] == NULL) {
+                if (i > 0)
+                    audio_output_close(audio_outputs[0]);
+                exit(1);
+            }
+        }
+    }
+
+    /* each channel setting once (see channel_params.h); the four DC offset
+     * compensation parameters are the same for A and B */
+    ChannelParam channel_params[] = {
+        CHANNEL_PARAM("decimation.enable", ctrlParams.decimation.enable, sdrplay_api_Update_Ctrl_Decimation, decimation_A > 1, decimation_B > 1),
+        CHANNEL_PARAM("decimation.decimationFactor", ctrlParams.decimation.decimationFactor, sdrplay_api_Update_Ctrl_Decimation, decimation_A, decimation_B),
+        CHANNEL_PARAM_IF("tuner1AmPortSel", rspDuoTunerParams.tuner1AmPortSel, sdrplay_api_Update_RspDuo_AmPortSelect, sdrplay_api_RspDuo_AMPORT_2, sdrplay_api_RspDuo_AMPORT_2, 1, 0),
+        CHANNEL_PARAM("ifType", tunerParams.ifType, sdrplay_api_Update_Tuner_IfType, if_frequency_A, if_frequency_B),
+        CHANNEL_PARAM("bwType", tunerParams.bwType, sdrplay_api_Update_Tuner_BwType, if_bandwidth_A, if_bandwidth_B),
+        CHANNEL_PARAM("agc.enable", ctrlParams.agc.enable, sdrplay_api_Update_Ctrl_Agc, agc_A, agc_B),
+        CHANNEL_PARAM_IF("gain.gRdB", tunerParams.gain.gRdB, sdrplay_api_Update_Tuner_Gr, gRdB_A, gRdB_B, agc_A == sdrplay_api_AGC_DISABLE, agc_B == sdrplay_api_AGC_DISABLE),
+        CHANNEL_PARAM("gain.LNAstate", tunerParams.gain.LNAstate, sdrplay_api_Update_Tuner_Gr, LNAstate_A, LNAstate_B),
+        CHANNEL_PARAM("dcOffset.DCenable", ctrlParams.dcOffset.DCenable, sdrplay_api_Update_Ctrl_DCoffsetIQimbalance, DCenable_A, DCenable_B),
+        CHANNEL_PARAM("dcOffset.IQenable", ctrlParams.dcOffset.IQenable, sdrplay_api_Update_Ctrl_DCoffsetIQimbalance, IQenable_A, IQenable_B),
+        CHANNEL_PARAM("dcOffsetTuner.dcCal", tunerParams.dcOffsetTuner.dcCal, sdrplay_api_Update_Tuner_DcOffset, dcCal, dcCal),
+        CHANNEL_PARAM("dcOffsetTuner.speedUp", tunerParams.dcOffsetTuner.speedUp, sdrplay_api_Update_Tuner_DcOffset, speedUp, speedUp),
+        CHANNEL_PARAM("dcOffsetTuner.trackTime", tunerParams.dcOffsetTuner.trackTime, sdrplay_api_Update_Tuner_DcOffset, trackTime, trackTime),
+        CHANNEL_PARAM("dcOffsetTuner.refreshRateTime", tunerParams.dcOffsetTuner.refreshRateTime, sdrplay_api_Update_Tuner_DcOffset, refreshRateTime, refreshRateTime),
+        CHANNEL_PARAM("rfHz", tunerParams.rfFreq.rfHz, sdrplay_api_Update_Tuner_Frf, frequency_A, frequency_B)
+    };
+    int num_channel_params = sizeof(channel_params) / sizeof(channel_params[0]);
+
     /* open SDRplay API and check version */
+    uint64_t startup_ns = monotonic_ns();
     sdrplay_api_ErrT err;
     err = sdrplay_api_Open();
     if (err != sdrplay_api_Success) {
@@ -215,10 +1013,6 @@ int main(int argc, char *argv[])
         sdrplay_api_Close();
         exit(1);
     }
-#ifdef SDRPLAY_MAX_DEVICES
-#undef SDRPLAY_MAX_DEVICES
-#endif
-#define SDRPLAY_MAX_DEVICES 4
     unsigned int ndevices = SDRPLAY_MAX_DEVICES;
     sdrplay_api_DeviceT devices[SDRPLAY_MAX_DEVICES];
     err = sdrplay_api_GetDevices(devices, &ndevices, ndevices);
@@ -228,338 +1022,382 @@ int main(int argc, char *argv[])
         sdrplay_api_Close();
         exit(1);
     }
-    int device_index = -1;
-    for (unsigned int i = 0; i < ndevices; i++) {
-        /* we are only interested in RSPduo's */
-        if (devices[i].valid && devices[i].hwVer == SDRPLAY_RSPduo_ID) {
-            if (serial_number == NULL || strcmp(devices[i].SerNo, serial_number) == 0) {
-                device_index = i;
-                break;
+    /* the RSPduo's in the order of the serial numbers (or the first one) */
+    int num_devices = num_serial_numbers > 0 ? num_serial_numbers : 1;
+    DeviceContext device_contexts[MAX_RSPDUOS];
+    for (int d = 0; d < num_devices; d++) {
+        int device_index = -1;
+        for (unsigned int i = 0; i < ndevices; i++) {
+            /* we are only interested in RSPduo's */
+            if (devices[i].valid && devices[i].hwVer == SDRPLAY_RSPduo_ID) {
+                if (num_serial_numbers == 0 || strcmp(devices[i].SerNo, serial_numbers[d]) == 0) {
+                    device_index = i;
+                    break;
+                }
             }
         }
-    }
-    if (device_index == -1) {
-        fprintf(stderr, "SDRplay RSPduo not found or not available\n");
-        sdrplay_api_UnlockDeviceApi();
-        sdrplay_api_Close();
-        exit(1);
-    }
-    sdrplay_api_DeviceT device = devices[device_index];
+        for (int k = 0; k < d && device_index != -1; k++)
+            if (strcmp(device_contexts[k].device.SerNo, devices[device_index].SerNo) == 0)
+                device_index = -1;
+        if (device_index == -1) {
+            if (num_serial_numbers > 0) {
+                fprintf(stderr, "SDRplay RSPduo %s not found or not available\n", serial_numbers[d]);
+            } else {
+                fprintf(stderr, "SDRplay RSPduo not found or not available\n");
+            }
+            release_devices(device_contexts, d);
+            sdrplay_api_UnlockDeviceApi();
+            sdrplay_api_Close();
+            exit(1);
+        }
+        DeviceContext *device_context = &device_contexts[d];
+        sdrplay_api_DeviceT *device = &device_context->device;
+        *device = devices[device_index];
+        /* the messages only say which RSPduo with more than one */
+        if (num_devices > 1) {
+            snprintf(device_context->prefix, sizeof(device_context->prefix), "%.*s/", SDRPLAY_MAX_SER_NO_LEN - 1, device->SerNo);
+        } else {
+            device_context->prefix[0] = '\0';
+        }
+        device_context->bytes_written = 0;
+        device_context->ab_time_offset_ns = 0.0;
+        device_context->quick_check_ns = 0;
 
-    /* select RSPduo dual tuner mode */
-    if ((device.rspDuoMode & sdrplay_api_RspDuoMode_Dual_Tuner) != sdrplay_api_RspDuoMode_Dual_Tuner ||
-        (device.tuner & sdrplay_api_Tuner_Both) != sdrplay_api_Tuner_Both) {
-        fprintf(stderr, "SDRplay RSPduo dual tuner mode not available\n");
-        sdrplay_api_UnlockDeviceApi();
-        sdrplay_api_Close();
-        exit(1);
-    }
-    device.tuner = sdrplay_api_Tuner_Both;
-    device.rspDuoMode = sdrplay_api_RspDuoMode_Dual_Tuner;
-    device.rspDuoSampleFreq = rspduo_sample_rate;
+        /* select RSPduo dual tuner mode */
+        if ((device->rspDuoMode & sdrplay_api_RspDuoMode_Dual_Tuner) != sdrplay_api_RspDuoMode_Dual_Tuner ||
+            (device->tuner & sdrplay_api_Tuner_Both) != sdrplay_api_Tuner_Both) {
+            fprintf(stderr, "SDRplay RSPduo %s dual tuner mode not available\n", device->SerNo);
+            release_devices(device_contexts, d);
+            sdrplay_api_UnlockDeviceApi();
+            sdrplay_api_Close();
+            exit(1);
+        }
+        device->tuner = sdrplay_api_Tuner_Both;
+        device->rspDuoMode = sdrplay_api_RspDuoMode_Dual_Tuner;
+        device->rspDuoSampleFreq = rspduo_sample_rate;
 
-    err = sdrplay_api_SelectDevice(&device);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_SelectDevice() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_UnlockDeviceApi();
-        sdrplay_api_Close();
-        exit(1);
+        err = sdrplay_api_SelectDevice(device);
+        if (err != sdrplay_api_Success) {
+            fprintf(stderr, "sdrplay_api_SelectDevice() failed: %s\n", sdrplay_api_GetErrorString(err));
+            release_devices(device_contexts, d);
+            sdrplay_api_UnlockDeviceApi();
+            sdrplay_api_Close();
+            exit(1);
+        }
     }
 
     err = sdrplay_api_UnlockDeviceApi();
     if (err != sdrplay_api_Success) {
         fprintf(stderr, "sdrplay_api_UnlockDeviceApi() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_ReleaseDevice(&device);
+        release_devices(device_contexts, num_devices);
         sdrplay_api_Close();
         exit(1);
     }
 
-    if (debug_enable) {
-        err = sdrplay_api_DebugEnable(device.dev, sdrplay_api_DbgLvl_Verbose);
+    for (int d = 0; d < num_devices; d++) {
+        DeviceContext *device_context = &device_contexts[d];
+        sdrplay_api_DeviceT *device = &device_context->device;
+
+        if (debug_enable) {
+            err = sdrplay_api_DebugEnable(device->dev, sdrplay_api_DbgLvl_Verbose);
+            if (err != sdrplay_api_Success) {
+                fprintf(stderr, "sdrplay_api_DebugEnable() failed: %s\n", sdrplay_api_GetErrorString(err));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+        }
+
+        // select device settings
+        sdrplay_api_DeviceParamsT *device_params;
+        err = sdrplay_api_GetDeviceParams(device->dev, &device_params);
         if (err != sdrplay_api_Success) {
-            fprintf(stderr, "sdrplay_api_DebugEnable() failed: %s\n", sdrplay_api_GetErrorString(err));
-            sdrplay_api_ReleaseDevice(&device);
+            fprintf(stderr, "sdrplay_api_GetDeviceParams() failed: %s\n", sdrplay_api_GetErrorString(err));
+            release_devices(device_contexts, num_devices);
             sdrplay_api_Close();
             exit(1);
         }
-    }
+        device_context->device_params = device_params;
+        sdrplay_api_RxChannelParamsT *rx_channelA_params = device_params->rxChannelA ;
+        sdrplay_api_RxChannelParamsT *rx_channelB_params = device_params->rxChannelB ;
+        device_params->devParams->fsFreq.fsHz = rspduo_sample_rate;
+        channel_params_apply(channel_params, num_channel_params, rx_channelA_params, 0);
+        channel_params_apply(channel_params, num_channel_params, rx_channelB_params, 1);
 
-    // select device settings
-    sdrplay_api_DeviceParamsT *device_params;
-    err = sdrplay_api_GetDeviceParams(device.dev, &device_params);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_GetDeviceParams() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_ReleaseDevice(&device);
-        sdrplay_api_Close();
-        exit(1);
-    }
-    sdrplay_api_RxChannelParamsT *rx_channelA_params = device_params->rxChannelA ;
-    sdrplay_api_RxChannelParamsT *rx_channelB_params = device_params->rxChannelB ;
-    device_params->devParams->fsFreq.fsHz = rspduo_sample_rate;
-    rx_channelA_params->ctrlParams.decimation.enable = decimation_A > 1;
-    rx_channelA_params->ctrlParams.decimation.decimationFactor = decimation_A;
-    rx_channelA_params->rspDuoTunerParams.tuner1AmPortSel = sdrplay_api_RspDuo_AMPORT_2;
-    rx_channelA_params->tunerParams.ifType = if_frequency_A;
-    rx_channelA_params->tunerParams.bwType = if_bandwidth_A;
-    rx_channelA_params->ctrlParams.agc.enable = agc_A;
-    if (agc_A == sdrplay_api_AGC_DISABLE) {
-        rx_channelA_params->tunerParams.gain.gRdB = gRdB_A;
-    }
-    rx_channelA_params->tunerParams.gain.LNAstate = LNAstate_A;
-    rx_channelA_params->ctrlParams.dcOffset.DCenable = DCenable_A;
-    rx_channelA_params->ctrlParams.dcOffset.IQenable = IQenable_A;
-    rx_channelA_params->tunerParams.dcOffsetTuner.dcCal = dcCal;
-    rx_channelA_params->tunerParams.dcOffsetTuner.speedUp = speedUp;
-    rx_channelA_params->tunerParams.dcOffsetTuner.trackTime = trackTime;
-    rx_channelA_params->tunerParams.dcOffsetTuner.refreshRateTime = refreshRateTime;
-    rx_channelB_params->tunerParams.dcOffsetTuner.dcCal = dcCal;
-    rx_channelB_params->tunerParams.dcOffsetTuner.speedUp = speedUp;
-    rx_channelB_params->tunerParams.dcOffsetTuner.trackTime = trackTime;
-    rx_channelB_params->tunerParams.dcOffsetTuner.refreshRateTime = refreshRateTime;
-    rx_channelA_params->tunerParams.rfFreq.rfHz = frequency_A;
-
-    /* quick check */
-    sdrplay_api_CallbackFnsT callbackNullFns = { NULL, NULL, NULL };
-    err = sdrplay_api_Init(device.dev, &callbackNullFns, NULL);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_Init() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_ReleaseDevice(&device);
-        sdrplay_api_Close();
-        exit(1);
-    }
-    // since sdrplay_api_Init() resets channelB settings to channelA values,
-    // we need to update all the settings for channelB that are different
-    sdrplay_api_ReasonForUpdateT reason_for_update = sdrplay_api_Update_None;
-    if (decimation_B != decimation_A) {
-        rx_channelB_params->ctrlParams.decimation.enable = decimation_B > 1;
-        rx_channelB_params->ctrlParams.decimation.decimationFactor = decimation_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_Decimation;
-    }
-    if (if_frequency_B != if_frequency_A) {
-        rx_channelB_params->tunerParams.ifType = if_frequency_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_IfType;
-    }
-    if (if_bandwidth_B != if_bandwidth_A) {
-        rx_channelB_params->tunerParams.bwType = if_bandwidth_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_BwType;
-    }
-    if (agc_B != agc_A) {
-        rx_channelB_params->ctrlParams.agc.enable = agc_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_Agc;
-    }
-    if (agc_B == sdrplay_api_AGC_DISABLE) {
-        if (gRdB_B != gRdB_A) {
-            rx_channelB_params->tunerParams.gain.gRdB = gRdB_B;
-            reason_for_update |= sdrplay_api_Update_Tuner_Gr;
+        /* quick check (with the fast start the settings are only checked
+         * after the sdrplay_api_Init() that starts streaming) */
+        if (fast_start)
+            continue;
+        uint64_t quick_check_start_ns = monotonic_ns();
+        sdrplay_api_CallbackFnsT callbackNullFns = { NULL, NULL, NULL };
+        err = sdrplay_api_Init(device->dev, &callbackNullFns, NULL);
+        if (err != sdrplay_api_Success) {
+            fprintf(stderr, "sdrplay_api_Init() failed: %s\n", sdrplay_api_GetErrorString(err));
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
         }
-    }
-    if (LNAstate_B != LNAstate_A) {
-        rx_channelB_params->tunerParams.gain.LNAstate = LNAstate_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_Gr;
-    }
-    if (DCenable_B != DCenable_A) {
-        rx_channelB_params->ctrlParams.dcOffset.DCenable = DCenable_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_DCoffsetIQimbalance;
-    }
-    if (IQenable_B != IQenable_A) {
-        rx_channelB_params->ctrlParams.dcOffset.IQenable = IQenable_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_DCoffsetIQimbalance;
-    }
-    if (frequency_B != frequency_A) {
-        rx_channelB_params->tunerParams.rfFreq.rfHz = frequency_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_Frf;
-    }
-    if (reason_for_update != sdrplay_api_Update_None) {
-        err = sdrplay_api_Update(device.dev, sdrplay_api_Tuner_B, reason_for_update, sdrplay_api_Update_Ext1_None);
+        // since sdrplay_api_Init() resets channelB settings to channelA values,
+        // we need to update all the settings for channelB that are different
+        sdrplay_api_ReasonForUpdateT reason_for_update = channel_params_update(channel_params, num_channel_params, rx_channelB_params, 1);
+        if (reason_for_update != sdrplay_api_Update_None) {
+            err = sdrplay_api_Update(device->dev, sdrplay_api_Tuner_B, reason_for_update, sdrplay_api_Update_Ext1_None);
+            if (err != sdrplay_api_Success) {
+                fprintf(stderr, "sdrplay_api_Update(0x%08x) failed: %s\n", reason_for_update, sdrplay_api_GetErrorString(err));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+        }
+
+        if (!device_check(device_context, channel_params, num_channel_params, rspduo_sample_rate)) {
+            sdrplay_api_Uninit(device->dev);
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
+
+        err = sdrplay_api_Uninit(device->dev);
         if (err != sdrplay_api_Success) {
-            fprintf(stderr, "sdrplay_api_Update(0x%08x) failed: %s\n", reason_for_update, sdrplay_api_GetErrorString(err));
-            sdrplay_api_ReleaseDevice(&device);
+            fprintf(stderr, "sdrplay_api_Uninit() failed: %s\n", sdrplay_api_GetErrorString(err));
+            release_devices(device_contexts, num_devices);
             sdrplay_api_Close();
             exit(1);
         }
+        device_context->quick_check_ns = monotonic_ns() - quick_check_start_ns;
     }
 
-    /* print settings */
-    fprintf(stdout, "SerNo=%s hwVer=%d tuner=0x%02x rspDuoMode=0x%02x rspDuoSampleFreq=%.0lf\n", device.SerNo, device.hwVer, device.tuner, device.rspDuoMode, device.rspDuoSampleFreq);
-    fprintf(stdout, "RX A - LO=%.0lf BW=%d If=%d Dec=%d IFagc=%d IFgain=%d LNAgain=%d\n", rx_channelA_params->tunerParams.rfFreq.rfHz, rx_channelA_params->tunerParams.bwType, rx_channelA_params->tunerParams.ifType, rx_channelA_params->ctrlParams.decimation.decimationFactor, rx_channelA_params->ctrlParams.agc.enable, rx_channelA_params->tunerParams.gain.gRdB, rx_channelA_params->tunerParams.gain.LNAstate);
-    fprintf(stdout, "RX A - DCenable=%d IQenable=%d dcCal=%d speedUp=%d trackTime=%d refreshRateTime=%d\n", (int)(rx_channelA_params->ctrlParams.dcOffset.DCenable), (int)(rx_channelA_params->ctrlParams.dcOffset.IQenable), (int)(rx_channelA_params->tunerParams.dcOffsetTuner.dcCal), (int)(rx_channelA_params->tunerParams.dcOffsetTuner.speedUp), rx_channelA_params->tunerParams.dcOffsetTuner.trackTime, rx_channelA_params->tunerParams.dcOffsetTuner.refreshRateTime);
-    fprintf(stdout, "RX B - LO=%.0lf BW=%d If=%d Dec=%d IFagc=%d IFgain=%d LNAgain=%d\n", rx_channelB_params->tunerParams.rfFreq.rfHz, rx_channelB_params->tunerParams.bwType, rx_channelB_params->tunerParams.ifType, rx_channelB_params->ctrlParams.decimation.decimationFactor, rx_channelB_params->ctrlParams.agc.enable, rx_channelB_params->tunerParams.gain.gRdB, rx_channelB_params->tunerParams.gain.LNAstate);
-    fprintf(stdout, "RX B - DCenable=%d IQenable=%d dcCal=%d speedUp=%d trackTime=%d refreshRateTime=%d\n", (int)(rx_channelB_params->ctrlParams.dcOffset.DCenable), (int)(rx_channelB_params->ctrlParams.dcOffset.IQenable), (int)(rx_channelB_params->tunerParams.dcOffsetTuner.dcCal), (int)(rx_channelB_params->tunerParams.dcOffsetTuner.speedUp), rx_channelB_params->tunerParams.dcOffsetTuner.trackTime, rx_channelB_params->tunerParams.dcOffsetTuner.refreshRateTime);
-
-    int init_ok = 1;
-    if (device.tuner != sdrplay_api_Tuner_Both) {
-        fprintf(stderr, "unexpected change - tuner: 0x%02x -> 0x%02x\n", sdrplay_api_Tuner_Both, device.tuner);
-        init_ok = 0;
+    if (iq_kernels_init(iq_kernel) == -1) {
+        fprintf(stderr, "I/Q kernel %s not available\n", iq_kernel);
+        release_devices(device_contexts, num_devices);
+        sdrplay_api_Close();
+        exit(1);
     }
-    if (device.rspDuoMode != sdrplay_api_RspDuoMode_Dual_Tuner) {
-        fprintf(stderr, "unexpected change - rspDuoMode: 0x%02x -> 0x%02x\n", sdrplay_api_RspDuoMode_Dual_Tuner, device.rspDuoMode);
-        init_ok = 0;
+    fprintf(stdout, "I/Q kernel=%s\n", iq_kernel_name);
+    if (sample_format != SAMPLE_FORMAT_CS16) {
+        sample_format_init();
+        fprintf(stdout, "output format=%s scale=%lg kernel=%s\n", sample_format_name(sample_format), sample_scale, sample_format_kernel->name);
     }
-    if (device.rspDuoSampleFreq != rspduo_sample_rate) {
-        fprintf(stderr, "unexpected change - rspDuoSampleFreq: %.0lf -> %.0lf\n", rspduo_sample_rate, device.rspDuoSampleFreq);
-        init_ok = 0;
+
+    /* now for the real thing */
+    int num_channels = 2 * num_devices;
+    RXContext *rx_contexts = (RXContext *)malloc(num_channels * sizeof(RXContext));
+    for (int i = 0; i < num_channels; i++) {
+        DeviceContext *device_context = &device_contexts[i / 2];
+        rx_contexts[i] = (RXContext){
+          .earliest_callback = {0, 0},
+          .latest_callback = {0, 0},
+          .total_samples = 0,
+          .next_sample_num = 0xffffffff,
+          .output = NULL,
+          .container = NULL,
+          .ddc = NULL,
+          .compress_buffer = NULL,
+          .compress_input_bytes = 0,
+          .sample_format = SAMPLE_FORMAT_CS16,
+          .sample_scale = 1.0f,
+          .format_buffer = NULL,
+          .clipped_values = 0,
+          .nbfm = NULL,
+          .audio_discard = NULL,
+          .audio_output = NULL,
+          .file_samples = 0,
+          .gap_fill = GAP_FILL_NONE,
+          .gap_buffer = NULL,
+          .gap_log = NULL,
+          .events_lost = 0,
+          .iq_range = { SHRT_MAX, SHRT_MIN, SHRT_MAX, SHRT_MIN },
+          .rx_id = i % 2 == 0 ? 'A' : 'B',
+          .serial_number = device_context->device.SerNo,
+          .device_prefix = device_context->prefix,
+          .cpu = num_cpus > 0 ? cpus[i % num_cpus] : -1
+        };
     }
-    if (device_params->devParams->fsFreq.fsHz != rspduo_sample_rate) {
-        fprintf(stderr, "unexpected change - fsHz: %.0lf -> %.0lf\n", rspduo_sample_rate, device_params->devParams->fsFreq.fsHz);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->ctrlParams.decimation.enable != (decimation_A > 1)) {
-        fprintf(stderr, "unexpected change - RX A decimation.enable: %d -> %d\n", decimation_A > 1, rx_channelA_params->ctrlParams.decimation.enable);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->ctrlParams.decimation.enable != (decimation_B > 1)) {
-        fprintf(stderr, "unexpected change - RX B decimation.enable: %d -> %d\n", decimation_B > 1, rx_channelB_params->ctrlParams.decimation.enable);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->ctrlParams.decimation.decimationFactor != decimation_A) {
-        fprintf(stderr, "unexpected change - RX A decimation.decimationFactor: %d -> %d\n", decimation_A, rx_channelA_params->ctrlParams.decimation.decimationFactor);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->ctrlParams.decimation.decimationFactor != decimation_B) {
-        fprintf(stderr, "unexpected change - RX B decimation.decimationFactor: %d -> %d\n", decimation_B, rx_channelB_params->ctrlParams.decimation.decimationFactor);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.ifType != if_frequency_A) {
-        fprintf(stderr, "unexpected change - RX A ifType: %d -> %d\n", if_frequency_A, rx_channelA_params->tunerParams.ifType);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.ifType != if_frequency_B) {
-        fprintf(stderr, "unexpected change - RX B ifType: %d -> %d\n", if_frequency_B, rx_channelB_params->tunerParams.ifType);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.bwType != if_bandwidth_A) {
-        fprintf(stderr, "unexpected change - RX A bwType: %d -> %d\n", if_bandwidth_A, rx_channelA_params->tunerParams.bwType);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.bwType != if_bandwidth_B) {
-        fprintf(stderr, "unexpected change - RX B bwType: %d -> %d\n", if_bandwidth_B, rx_channelB_params->tunerParams.bwType);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->ctrlParams.agc.enable != agc_A) {
-        fprintf(stderr, "unexpected change - RX A agc.enable: %d -> %d\n", agc_A, rx_channelA_params->ctrlParams.agc.enable);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->ctrlParams.agc.enable != agc_B) {
-        fprintf(stderr, "unexpected change - RX B agc.enable: %d -> %d\n", agc_B, rx_channelB_params->ctrlParams.agc.enable);
-        init_ok = 0;
-    }
-    if (agc_A == sdrplay_api_AGC_DISABLE) {
-        if (rx_channelA_params->tunerParams.gain.gRdB != gRdB_A) {
-            fprintf(stderr, "unexpected change - RX A gain.gRdB: %d -> %d\n", gRdB_A, rx_channelA_params->tunerParams.gain.gRdB);
-            init_ok = 0;
+
+    for (int i = 0; i < num_channels; i++) {
+        RXContext *rx_context = &rx_contexts[i];
+        rx_context->histograms = (Histogram *)malloc(RX_METRICS * sizeof(Histogram));
+        for (int k = 0; k < RX_METRICS; k++)
+            histogram_init(&rx_context->histograms[k]);
+        rx_context->last_callback_ns = 0;
+        rx_context->first_callback_ns = 0;
+        atomic_init(&rx_context->dropped_events, 0);
+        atomic_init(&rx_context->dropped_samples, 0);
+        rate_estimator_init(&rx_context->rate_estimator);
+        atomic_init(&rx_context->rotation_target, ROTATION_NONE);
+        atomic_init(&rx_context->last_sample_index, ROTATION_NONE);
+        atomic_init(&rx_context->next_output, NULL);
+        atomic_init(&rx_context->retired_output, NULL);
+        atomic_init(&rx_context->file_number, 0);
+        atomic_init(&rx_context->output_bytes, 0);
+        rx_context->rotated_bytes = 0;
+        rx_context->trigger = NULL;
+        trigger_channel_init(&rx_context->trigger_channel);
+        rx_context->pre_trigger_bytes = 0;
+        rx_context->trigger_log = NULL;
+        rx_context->segments = 0;
+        rx_context->discarded_bytes = 0;
+        atomic_init(&rx_context->peak_power, 0);
+        rx_context->scan_frequencies = NULL;
+        rx_context->num_scan_frequencies = 0;
+        atomic_init(&rx_context->scan_index, 0);
+        atomic_init(&rx_context->retune_request_ns, 0);
+        atomic_init(&rx_context->retune_effective_ns, 0);
+        atomic_init(&rx_context->gain_changed, 0);
+        rx_context->scan_started = 0;
+        rx_context->settle_samples = 0;
+        rx_context->settle_until = 0;
+        rx_context->retune_marker_pending = 0;
+        rx_context->hops = 0;
+        rx_context->settle_discarded = 0;
+        rx_context->retune_timeouts = 0;
+        rx_context->hop_log = NULL;
+        rx_context->xcorr_enable = 0;
+        if (xcorr_file != NULL) {
+            if (ring_buffer_init(&rx_context->xcorr_ring_buffer, XCORR_RING_BUFFER_SIZE) == -1) {
+                fprintf(stderr, "RX %s%c - cross-correlation ring buffer initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            rx_context->xcorr_enable = 1;
         }
-    }
-    if (agc_B == sdrplay_api_AGC_DISABLE) {
-        if (rx_channelB_params->tunerParams.gain.gRdB != gRdB_B) {
-            fprintf(stderr, "unexpected change - RX B gain.gRdB: %d -> %d\n", gRdB_B, rx_channelB_params->tunerParams.gain.gRdB);
-            init_ok = 0;
+        rx_context->psd = NULL;
+        rx_context->psd_file = NULL;
+        rx_context->psd_records = 0;
+        if (psd_file != NULL) {
+            char filename[MAX_PATH_SIZE];
+            channel_filename(filename, MAX_PATH_SIZE, psd_file, rx_context->rx_id, rx_context->serial_number);
+            rx_context->psd = psd_create(psd_size, psd_frames);
+            rx_context->psd_file = rx_context->psd != NULL ? fopen(filename, "w") : NULL;
+            if (rx_context->psd_file == NULL) {
+                if (rx_context->psd != NULL)
+                    fprintf(stderr, "fopen(%s) failed: %s\n", filename, strerror(errno));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            PsdFileHeader header = {
+                .magic = PSD_MAGIC,
+                .version = PSD_VERSION,
+                .rx_id = rx_context->rx_id,
+                .fft_size = psd_size,
+                .frames = psd_frames,
+                .sample_rate = output_sample_rate(rspduo_sample_rate, i % 2 == 0 ? if_frequency_A : if_frequency_B, i % 2 == 0 ? decimation_A : decimation_B),
+                .frequency = i % 2 == 0 ? frequency_A : frequency_B,
+                .interval = psd_interval
+            };
+            rx_context->psd_interval_samples = (uint64_t)(psd_interval * header.sample_rate);
+            rx_context->psd_next_sample_index = 0;
+            rx_context->psd_average_samples = psd_average_samples(rx_context->psd);
+            rx_context->psd_left = 0;
+            if (fwrite(&header, sizeof(header), 1, rx_context->psd_file) != 1 || fflush(rx_context->psd_file) != 0 ||
+                ring_buffer_init(&rx_context->psd_ring_buffer, PSD_RING_BUFFER_SIZE) == -1) {
+                fprintf(stderr, "RX %s%c - PSD file initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+        }
+        rx_context->frequency = i % 2 == 0 ? frequency_A : frequency_B;
+        rx_context->shm_ring = NULL;
+        rx_context->shm_blocks = 0;
+        if (shm_name != NULL) {
+            char name[MAX_PATH_SIZE];
+            channel_filename(name, MAX_PATH_SIZE, shm_name, rx_context->rx_id, rx_context->serial_number);
+            rx_context->shm_ring = shm_ring_create(name, (size_t)(shm_size_MB * 1024 * 1024), rx_context->rx_id, output_sample_rate(rspduo_sample_rate, i % 2 == 0 ? if_frequency_A : if_frequency_B, i % 2 == 0 ? decimation_A : decimation_B), rx_context->frequency);
+            if (rx_context->shm_ring == NULL) {
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+        }
+        rx_context->server_ring_buffer.buffer = NULL;
+        if (server_ports[i % 2] != 0 && ring_buffer_init(&rx_context->server_ring_buffer, SERVER_RING_BUFFER_SIZE) == -1) {
+            fprintf(stderr, "RX %s%c - server ring buffer initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
+        rx_context->anchor_file = NULL;
+        if (anchor_file != NULL) {
+            /* the callbacks queue the anchors, and the stats thread writes them */
+            char filename[MAX_PATH_SIZE];
+            channel_filename(filename, MAX_PATH_SIZE, anchor_file, rx_context->rx_id, rx_context->serial_number);
+            rx_context->anchor_file = fopen(filename, "w");
+            if (rx_context->anchor_file == NULL) {
+                fprintf(stderr, "fopen(%s) failed: %s\n", filename, strerror(errno));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            AnchorFileHeader header = {
+                .magic = ANCHOR_MAGIC,
+                .version = ANCHOR_VERSION,
+                .rx_id = rx_context->rx_id,
+                .sample_rate = output_sample_rate(rspduo_sample_rate, i % 2 == 0 ? if_frequency_A : if_frequency_B, i % 2 == 0 ? decimation_A : decimation_B)
+            };
+            if (fwrite(&header, sizeof(header), 1, rx_context->anchor_file) != 1 ||
+                ring_buffer_init(&rx_context->anchor_ring_buffer, ANCHOR_RING_BUFFER_SIZE) == -1) {
+                fprintf(stderr, "RX %s%c - anchor file initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
         }
-    }
-    if (rx_channelA_params->tunerParams.gain.LNAstate != LNAstate_A) {
-        fprintf(stderr, "unexpected change - RX A gain.LNAstate: %d -> %d\n", LNAstate_A, rx_channelA_params->tunerParams.gain.LNAstate);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.gain.LNAstate != LNAstate_B) {
-        fprintf(stderr, "unexpected change - RX B gain.LNAstate: %d -> %d\n", LNAstate_B, rx_channelB_params->tunerParams.gain.LNAstate);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->ctrlParams.dcOffset.DCenable != DCenable_A) {
-        fprintf(stderr, "unexpected change - RX A dcOffset.DCenable: %d -> %d\n", DCenable_A, rx_channelA_params->ctrlParams.dcOffset.DCenable);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->ctrlParams.dcOffset.DCenable != DCenable_B) {
-        fprintf(stderr, "unexpected change - RX B dcOffset.DCenable: %d -> %d\n", DCenable_B, rx_channelB_params->ctrlParams.dcOffset.DCenable);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->ctrlParams.dcOffset.IQenable != IQenable_A) {
-        fprintf(stderr, "unexpected change - RX A dcOffset.IQenable: %d -> %d\n", IQenable_A, rx_channelA_params->ctrlParams.dcOffset.IQenable);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->ctrlParams.dcOffset.IQenable != IQenable_B) {
-        fprintf(stderr, "unexpected change - RX B dcOffset.IQenable: %d -> %d\n", IQenable_B, rx_channelB_params->ctrlParams.dcOffset.IQenable);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.dcOffsetTuner.dcCal != dcCal) {
-        fprintf(stderr, "unexpected change - RX A dcOffsetTuner.dcCal: %d -> %d\n", dcCal, rx_channelA_params->tunerParams.dcOffsetTuner.dcCal);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.dcOffsetTuner.speedUp != speedUp) {
-        fprintf(stderr, "unexpected change - RX A dcOffsetTuner.speedUp: %d -> %d\n", speedUp, rx_channelA_params->tunerParams.dcOffsetTuner.speedUp);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.dcOffsetTuner.trackTime != trackTime) {
-        fprintf(stderr, "unexpected change - RX A dcOffsetTuner.trackTime: %d -> %d\n", trackTime, rx_channelA_params->tunerParams.dcOffsetTuner.trackTime);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.dcOffsetTuner.refreshRateTime != refreshRateTime) {
-        fprintf(stderr, "unexpected change - RX A dcOffsetTuner.refreshRateTime: %d -> %d\n", refreshRateTime, rx_channelA_params->tunerParams.dcOffsetTuner.refreshRateTime);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.dcOffsetTuner.dcCal != dcCal) {
-        fprintf(stderr, "unexpected change - RX B dcOffsetTuner.dcCal: %d -> %d\n", dcCal, rx_channelB_params->tunerParams.dcOffsetTuner.dcCal);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.dcOffsetTuner.speedUp != speedUp) {
-        fprintf(stderr, "unexpected change - RX B dcOffsetTuner.speedUp: %d -> %d\n", speedUp, rx_channelB_params->tunerParams.dcOffsetTuner.speedUp);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.dcOffsetTuner.trackTime != trackTime) {
-        fprintf(stderr, "unexpected change - RX B dcOffsetTuner.trackTime: %d -> %d\n", trackTime, rx_channelB_params->tunerParams.dcOffsetTuner.trackTime);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.dcOffsetTuner.refreshRateTime != refreshRateTime) {
-        fprintf(stderr, "unexpected change - RX B dcOffsetTuner.refreshRateTime: %d -> %d\n", refreshRateTime, rx_channelB_params->tunerParams.dcOffsetTuner.refreshRateTime);
-        init_ok = 0;
-    }
-    if (rx_channelA_params->tunerParams.rfFreq.rfHz != frequency_A) {
-        fprintf(stderr, "unexpected change - RX A rfHz: %.0lf -> %.0lf\n", frequency_A, rx_channelA_params->tunerParams.rfFreq.rfHz);
-        init_ok = 0;
-    }
-    if (rx_channelB_params->tunerParams.rfFreq.rfHz != frequency_B) {
-        fprintf(stderr, "unexpected change - RX B rfHz: %.0lf -> %.0lf\n", frequency_B, rx_channelB_params->tunerParams.rfFreq.rfHz);
-        init_ok = 0;
     }
 
-    if (!init_ok) {
-        sdrplay_api_Uninit(device.dev);
-        sdrplay_api_ReleaseDevice(&device);
-        sdrplay_api_Close();
-        exit(1);
-    }
+    int rotation_enable = rotation_size > 0 || rotation_interval > 0;
+    RotationContext rotation_context = {
+        .rx_contexts = rx_contexts,
+        .num_channels = num_channels,
+        .output_engine = output_engine,
+        .size = rotation_size,
+        .interval = rotation_interval
+    };
+    atomic_init(&rotation_context.stop, 0);
 
-    err = sdrplay_api_Uninit(device.dev);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_Uninit() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_ReleaseDevice(&device);
-        sdrplay_api_Close();
-        exit(1);
+    ScanContext scan_context = {
+        .device_contexts = device_contexts,
+        .rx_contexts = rx_contexts,
+        .num_channels = num_channels,
+        .dwell = scan_dwell
+    };
+    atomic_init(&scan_context.stop, 0);
+    if (scan_enable) {
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            rx_context->scan_frequencies = scan_frequencies[i % 2];
+            rx_context->num_scan_frequencies = num_scan_frequencies[i % 2];
+            rx_context->settle_samples = (uint64_t)(scan_settling_time * output_sample_rate(rspduo_sample_rate, i % 2 == 0 ? if_frequency_A : if_frequency_B, i % 2 == 0 ? decimation_A : decimation_B));
+            /* sdrplay_api_Init() starts B at the frequency of A: the first
+             * sample at its own is found like for a retune */
+            if (i % 2 == 1 && frequency_B != frequency_A)
+                atomic_store(&rx_context->retune_request_ns, monotonic_raw_ns());
+        }
+        fprintf(stdout, "scan frequencies=%d/%d dwell=%.3lfs settling_time=%.3lfs\n", num_scan_frequencies[0], num_scan_frequencies[1], scan_dwell, scan_settling_time);
     }
 
-    /* now for the real thing */
-    RXContext rx_contexts[] = {
-        { .earliest_callback = {0, 0},
-          .latest_callback = {0, 0},
-          .total_samples = 0,
-          .next_sample_num = 0xffffffff,
-          .output_fd = -1,
-          .imin = SHRT_MAX,
-          .imax = SHRT_MIN,
-          .qmin = SHRT_MAX,
-          .qmax = SHRT_MIN,
-          .rx_id = 'A'
-        },
-        { .earliest_callback = {0, 0},
-          .latest_callback = {0, 0},
-          .total_samples = 0,
-          .next_sample_num = 0xffffffff,
-          .output_fd = -1,
-          .imin = SHRT_MAX,
-          .imax = SHRT_MIN,
-          .qmin = SHRT_MAX,
-          .qmax = SHRT_MIN,
-          .rx_id = 'B'
+    /* A and B have the same sample rate and the same sample numbers, so
+     * the trigger works in samples (each RSPduo has its own sample clock,
+     * and its own trigger) */
+    if (trigger_enable) {
+        double sample_rate = output_sample_rate(rspduo_sample_rate, if_frequency_A, decimation_A);
+        uint64_t pre_trigger = (uint64_t)(trigger_pre_trigger * sample_rate);
+        for (int d = 0; d < num_devices; d++) {
+            if (trigger_init(&device_contexts[d].trigger, trigger_threshold, pre_trigger, (uint64_t)(trigger_hang_time * sample_rate)) == -1) {
+                fprintf(stderr, "squelch trigger initialization failed\n");
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
         }
-    };
+        for (int i = 0; i < num_channels; i++) {
+            rx_contexts[i].trigger = &device_contexts[i / 2].trigger;
+            rx_contexts[i].pre_trigger_bytes = pre_trigger * 2 * sizeof(short) + PRE_TRIGGER_MARGIN;
+        }
+        fprintf(stdout, "squelch threshold=%.1lfdBFS pre_trigger=%.1lfs hang_time=%.1lfs\n", trigger_threshold, trigger_pre_trigger, trigger_hang_time);
+    }
 
     sdrplay_api_CallbackFnsT callbackFns = {
         rxA_callback,
@@ -567,135 +1405,773 @@ int main(int argc, char *argv[])
         event_callback
     };
 
-    if (output_file != NULL) {
-        for (int i = 0; i < 2; i++) {
+    if (output_file != NULL && container_enable) {
+        /* both channels of each RSPduo go to a single file: the callbacks
+         * copy each block with its header into the ring buffers, and one
+         * writer thread per RSPduo merges them into the container chunks */
+        double sample_rates[2] = {
+            output_sample_rate(rspduo_sample_rate, if_frequency_A, decimation_A),
+            output_sample_rate(rspduo_sample_rate, if_frequency_B, decimation_B)
+        };
+        double frequencies[2] = { frequency_A, frequency_B };
+        off_t preallocate_size = streaming_time > 0 ? (off_t)((sample_rates[0] + sample_rates[1]) * (streaming_time + 2)) * 2 * sizeof(short) : 0;
+        for (int d = 0; d < num_devices; d++) {
+            RXContext *device_rx_contexts = &rx_contexts[2 * d];
+            char filename[MAX_PATH_SIZE];
+            channel_filename(filename, MAX_PATH_SIZE, output_file, 'C', device_rx_contexts[0].serial_number);
+            Container *container = container_open(filename, output_engine, preallocate_size, sample_rates, frequencies);
+            if (container == NULL) {
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            for (int i = 0; i < 2; i++) {
+                RXContext *rx_context = &device_rx_contexts[i];
+                rx_context->container = container;
+                if (sample_ring_buffer_init(&rx_context->ring_buffer, RING_BUFFER_SIZE, &realtime_status) == -1) {
+                    fprintf(stderr, "RX %s%c - ring buffer initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+            }
+            int ret = pthread_create(&device_rx_contexts[0].writer, NULL, container_writer_thread, device_rx_contexts);
+            if (ret != 0) {
+                fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            writer_affinity(&device_rx_contexts[0], device_rx_contexts[0].writer);
+            if (realtime_priority > 0)
+                realtime_thread(&realtime_status, device_rx_contexts[0].writer);
+        }
+    } else if (output_file != NULL || audio_file != NULL) {
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            double sample_rate = output_sample_rate(rspduo_sample_rate, i % 2 == 0 ? if_frequency_A : if_frequency_B, i % 2 == 0 ? decimation_A : decimation_B);
+            int ddc_decimation = i % 2 == 0 ? ddc_decimation_A : ddc_decimation_B;
+            if (output_file != NULL && ddc_decimation > 1) {
+                /* default bandwidth: half of the output sample rate */
+                double ddc_bandwidth = i % 2 == 0 ? ddc_bandwidth_A : ddc_bandwidth_B;
+                if (ddc_bandwidth == 0.0)
+                    ddc_bandwidth = sample_rate / ddc_decimation / 2;
+                double ddc_offset = i % 2 == 0 ? ddc_offset_A : ddc_offset_B;
+                rx_context->ddc = ddc_create(sample_rate, ddc_offset, ddc_bandwidth, ddc_decimation);
+                if (rx_context->ddc == NULL) {
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+                rx_context->ddc_buffer = (short *)malloc(WRITER_BATCH_SIZE);
+                fprintf(stdout, "RX %s%c - DDC offset=%.0lf bandwidth=%.0lf decimation=%d taps=%d kernel=%s\n", rx_context->device_prefix, rx_context->rx_id, ddc_offset, ddc_bandwidth, ddc_decimation, ddc_num_taps(rx_context->ddc), ddc_kernel_name(rx_context->ddc));
+            }
+            if (audio_file != NULL) {
+                /* the demodulator tunes to the same channel of interest */
+                double nbfm_bandwidth = i % 2 == 0 ? ddc_bandwidth_A : ddc_bandwidth_B;
+                if (nbfm_bandwidth == 0.0)
+                    nbfm_bandwidth = NBFM_DEFAULT_BANDWIDTH;
+                rx_context->nbfm = nbfm_create(sample_rate, i % 2 == 0 ? ddc_offset_A : ddc_offset_B, nbfm_bandwidth, NBFM_DEFAULT_AUDIO_SAMPLE_RATE, volume);
+                rx_context->audio_discard = rx_context->nbfm != NULL ? (short *)malloc(nbfm_max_audio_samples(rx_context->nbfm, AUDIO_INPUT_SAMPLES) * sizeof(short)) : NULL;
+                if (rx_context->nbfm == NULL || rx_context->audio_discard == NULL || ring_buffer_init(&rx_context->audio_ring_buffer, AUDIO_RING_BUFFER_SIZE) == -1) {
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+                fprintf(stdout, "RX %s%c - ", rx_context->device_prefix, rx_context->rx_id);
+                nbfm_print(rx_context->nbfm, stdout);
+                rx_context->audio_output = audio_outputs[i];
+            }
+        }
+        for (int i = 0; i < num_channels && output_file != NULL; i++) {
             char filename[MAX_PATH_SIZE];
-            snprintf(filename, MAX_PATH_SIZE, output_file, rx_contexts[i].rx_id);
-            int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-            if (fd == -1) {
-                fprintf(stderr, "open(%s) for writing failed: %s\n", filename, strerror(errno));
+            channel_filename(filename, MAX_PATH_SIZE, output_file, rx_contexts[i].rx_id, rx_contexts[i].serial_number);
+            /* preallocate for the expected amount of data (in each file
+             * when rotating) plus some margin */
+            double callback_sample_rate = output_sample_rate(rspduo_sample_rate, i % 2 == 0 ? if_frequency_A : if_frequency_B, i % 2 == 0 ? decimation_A : decimation_B);
+            double expected_sample_rate = callback_sample_rate / (i % 2 == 0 ? ddc_decimation_A : ddc_decimation_B);
+            int file_time = rotation_interval > 0 ? rotation_interval : streaming_time;
+            off_t preallocate_size = file_time > 0 ? (off_t)(expected_sample_rate * (file_time + 2)) * sample_format_size(sample_format) : 0;
+            if (rotation_size > 0) {
+                /* what is written after the rotation is started (the
+                 * lead time, the polling of the rotation thread, and the
+                 * batch the writer thread is still waiting for) */
+                double batch_time = WRITER_BATCH_SIZE / (callback_sample_rate * 2 * sizeof(short));
+                off_t margin = (off_t)(expected_sample_rate * (ROTATION_LEAD_TIME + ROTATION_POLL_INTERVAL_NS * 1e-9 + batch_time)) * sample_format_size(sample_format);
+                rotation_context.size_thresholds[i] = rotation_size > margin ? rotation_size - margin : 0;
+                preallocate_size = rotation_size + margin;
+            }
+            strcpy(rotation_context.filenames[i], filename);
+            rotation_context.preallocate_sizes[i] = preallocate_size;
+            rotation_context.sample_rates[i] = callback_sample_rate;
+            char output_filename[MAX_PATH_SIZE];
+            if (rotation_enable) {
+                sequence_filename(output_filename, MAX_PATH_SIZE, filename, 0);
+            } else {
+                strcpy(output_filename, filename);
+            }
+            /* stdout takes A only (use FIFOs to stream both) */
+            if (strcmp(output_filename, "-") == 0 && i % 2 == 1)
+                continue;
+            Output *output = output_open(output_filename, output_engine, preallocate_size);
+            if (output == NULL) {
                 for (int j = 0; j < i; j++) {
-                    if (rx_contexts[j].output_fd > 0) {
-                        close(rx_contexts[j].output_fd);
+                    if (rx_contexts[j].output != NULL) {
+                        output_close(rx_contexts[j].output);
                     }
                 }
-                sdrplay_api_ReleaseDevice(&device);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            rx_contexts[i].output = output;
+            if (compress_enable) {
+                IQCompressHeader header;
+                iq_compress_header(&header);
+                if (output_write(output, &header, sizeof(header)) != sizeof(header)) {
+                    fprintf(stderr, "RX %s%c - compressed file header write failed\n", rx_contexts[i].device_prefix, rx_contexts[i].rx_id);
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+                rx_contexts[i].compress_buffer = (char *)malloc(iq_compress_bound(COMPRESS_CHUNK_SAMPLES));
+            }
+            if (sample_format != SAMPLE_FORMAT_CS16) {
+                rx_contexts[i].sample_format = sample_format;
+                rx_contexts[i].sample_scale = (float)sample_scale;
+                rx_contexts[i].format_buffer = (char *)malloc(FORMAT_CHUNK_SAMPLES * sample_format_size(sample_format) + SAMPLE_FORMAT_PADDING);
+            }
+            if (gap_fill != GAP_FILL_NONE) {
+                /* the callback queues the gaps, and the writer thread fills
+                 * them in at the right place in the stream */
+                RXContext *rx_context = &rx_contexts[i];
+                rx_context->gap_fill = gap_fill;
+                rx_context->gap_buffer = (short *)malloc(WRITER_BATCH_SIZE);
+                short fill_value = gap_fill == GAP_FILL_FLAG ? GAP_FLAG_VALUE : 0;
+                for (size_t k = 0; k < WRITER_BATCH_SIZE / sizeof(short); k++)
+                    rx_context->gap_buffer[k] = fill_value;
+                char gap_log_filename[MAX_PATH_SIZE + 5];
+                snprintf(gap_log_filename, sizeof(gap_log_filename), "%s.gaps", filename);
+                rx_context->gap_log = fopen(gap_log_filename, "w");
+                if (rx_context->gap_log == NULL) {
+                    fprintf(stderr, "RX %s%c - gap log initialization failed: %s\n", rx_context->device_prefix, rx_context->rx_id, strerror(errno));
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+                fprintf(rx_context->gap_log, "# output_sample sample_index gap_samples fill\n");
+            }
+            if (trigger_enable) {
+                /* where each recorded segment starts and stops */
+                RXContext *rx_context = &rx_contexts[i];
+                char trigger_log_filename[MAX_PATH_SIZE + 9];
+                snprintf(trigger_log_filename, sizeof(trigger_log_filename), "%s.triggers", filename);
+                rx_context->trigger_log = fopen(trigger_log_filename, "w");
+                if (rx_context->trigger_log == NULL) {
+                    fprintf(stderr, "RX %s%c - trigger log initialization failed: %s\n", rx_context->device_prefix, rx_context->rx_id, strerror(errno));
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+                fprintf(rx_context->trigger_log, "# output_sample sample_index event\n");
+            }
+            if (scan_enable) {
+                /* where each frequency starts */
+                RXContext *rx_context = &rx_contexts[i];
+                char hop_log_filename[MAX_PATH_SIZE + 5];
+                snprintf(hop_log_filename, sizeof(hop_log_filename), "%s.hops", filename);
+                rx_context->hop_log = fopen(hop_log_filename, "w");
+                if (rx_context->hop_log == NULL) {
+                    fprintf(stderr, "RX %s%c - hop log initialization failed: %s\n", rx_context->device_prefix, rx_context->rx_id, strerror(errno));
+                    release_devices(device_contexts, num_devices);
+                    sdrplay_api_Close();
+                    exit(1);
+                }
+                fprintf(rx_context->hop_log, "# output_sample sample_index frequency latency_us settling_samples\n");
+            }
+        }
+        if (compress_enable) {
+            iq_compress_init();
+            fprintf(stdout, "compression block_samples=%d kernel=%s\n", IQ_COMPRESS_BLOCK_SAMPLES, iq_compress_kernel_name);
+        }
+
+        /* the callbacks only copy the samples into the ring buffers;
+         * the actual writes to disk are done by one writer thread per channel
+         * (with the mmap engine the callbacks store the samples directly
+         * into the file mapping, and the writer thread only manages it);
+         * the writer threads also run the NBFM demodulators, and a separate
+         * thread writes the audio */
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            /* with the squelch trigger the ring buffer also holds the pre-trigger */
+            if (rx_context->output == NULL && rx_context->nbfm == NULL)
+                continue;
+            if (!direct_output && sample_ring_buffer_init(&rx_context->ring_buffer, RING_BUFFER_SIZE + rx_context->pre_trigger_bytes, &realtime_status) == -1) {
+                fprintf(stderr, "RX %s%c - ring buffer initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            if ((gap_fill != GAP_FILL_NONE || rotation_enable || trigger_enable || scan_enable) && ring_buffer_init(&rx_context->event_ring_buffer, EVENT_RING_BUFFER_SIZE) == -1) {
+                fprintf(stderr, "RX %s%c - event ring buffer initialization failed\n", rx_context->device_prefix, rx_context->rx_id);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            int ret = pthread_create(&rx_context->writer, NULL, writer_thread, rx_context);
+            if (ret != 0) {
+                fprintf(stderr, "RX %s%c - pthread_create() failed: %s\n", rx_context->device_prefix, rx_context->rx_id, strerror(ret));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            writer_affinity(rx_context, rx_context->writer);
+            if (realtime_priority > 0)
+                realtime_thread(&realtime_status, rx_context->writer);
+        }
+        if (audio_file != NULL) {
+            int ret = pthread_create(&rx_contexts[0].audio_writer, NULL, audio_writer_thread, rx_contexts);
+            if (ret != 0) {
+                fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            if (realtime_priority > 0)
+                realtime_thread(&realtime_status, rx_contexts[0].audio_writer);
+        }
+        if (rotation_enable) {
+            int ret = pthread_create(&rotation_context.thread, NULL, rotation_thread, &rotation_context);
+            if (ret != 0) {
+                fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+                release_devices(device_contexts, num_devices);
                 sdrplay_api_Close();
                 exit(1);
             }
-            rx_contexts[i].output_fd = fd;
         }
     }
 
-    err = sdrplay_api_Init(device.dev, &callbackFns, rx_contexts);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_Init() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_ReleaseDevice(&device);
+    /* the callbacks only count the drops; this thread reports them (and
+     * the latency percentiles every stats interval), and writes the anchors */
+    StatsContext stats_context = {
+        .rx_contexts = rx_contexts,
+        .num_channels = num_channels,
+        .interval = stats_interval
+    };
+    atomic_init(&stats_context.stop, 0);
+    int ret = pthread_create(&stats_context.thread, NULL, stats_thread, &stats_context);
+    if (ret != 0) {
+        fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+        release_devices(device_contexts, num_devices);
         sdrplay_api_Close();
         exit(1);
     }
-    // since sdrplay_api_Init() resets channelB settings to channelA values,
-    // we need to update all the settings for channelB that are different
-    reason_for_update = sdrplay_api_Update_None;
-    if (decimation_B != decimation_A) {
-        rx_channelB_params->ctrlParams.decimation.enable = decimation_B > 1;
-        rx_channelB_params->ctrlParams.decimation.decimationFactor = decimation_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_Decimation;
-    }
-    if (if_frequency_B != if_frequency_A) {
-        rx_channelB_params->tunerParams.ifType = if_frequency_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_IfType;
-    }
-    if (if_bandwidth_B != if_bandwidth_A) {
-        rx_channelB_params->tunerParams.bwType = if_bandwidth_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_BwType;
+
+    /* the cross-correlation of A and B of each RSPduo, off the output path */
+    XcorrContext xcorr_contexts[MAX_RSPDUOS];
+    if (xcorr_file != NULL) {
+        double xcorr_sample_rate = output_sample_rate(rspduo_sample_rate, if_frequency_A, decimation_A);
+        unsigned int interval_samples = (unsigned int)(xcorr_interval * xcorr_sample_rate);
+        for (int d = 0; d < num_devices; d++) {
+            XcorrContext *xcorr_context = &xcorr_contexts[d];
+            memset(xcorr_context, 0, sizeof(XcorrContext));
+            xcorr_context->rx_contexts = &rx_contexts[2 * d];
+            xcorr_context->prefix = device_contexts[d].prefix;
+            xcorr_context->sample_rate = xcorr_sample_rate;
+            xcorr_context->xcorr = xcorr_create(xcorr_size, interval_samples);
+            char filename[MAX_PATH_SIZE];
+            channel_filename(filename, MAX_PATH_SIZE, xcorr_file, 'X', device_contexts[d].device.SerNo);
+            xcorr_context->log = xcorr_context->xcorr != NULL ? fopen(filename, "w") : NULL;
+            if (xcorr_context->log == NULL) {
+                if (xcorr_context->xcorr != NULL)
+                    fprintf(stderr, "fopen(%s) failed: %s\n", filename, strerror(errno));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            fprintf(xcorr_context->log, "# sample_rate=%.0lf fft_size=%d interval=%.3lfs\n", xcorr_sample_rate, xcorr_size, xcorr_interval);
+            fprintf(xcorr_context->log, "# sample_index time lag_samples magnitude phase_deg frames\n");
+            atomic_init(&xcorr_context->stop, 0);
+            ret = pthread_create(&xcorr_context->thread, NULL, xcorr_thread, xcorr_context);
+            if (ret != 0) {
+                fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+        }
+        fprintf(stdout, "cross-correlation fft_size=%d interval=%.3lfs\n", xcorr_size, xcorr_interval);
     }
-    if (agc_B != agc_A) {
-        rx_channelB_params->ctrlParams.agc.enable = agc_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_Agc;
+
+    PsdContext psd_context = {
+        .rx_contexts = rx_contexts,
+        .num_channels = num_channels
+    };
+    atomic_init(&psd_context.stop, 0);
+    if (psd_file != NULL) {
+        ret = pthread_create(&psd_context.thread, NULL, psd_thread, &psd_context);
+        if (ret != 0) {
+            fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
+        fprintf(stdout, "PSD monitor fft_size=%d interval=%.3lfs frames=%d kernel=%s\n", psd_size, psd_interval, psd_frames, psd_kernel_name(rx_contexts[0].psd));
     }
-    if (agc_B == sdrplay_api_AGC_DISABLE) {
-        if (gRdB_B != gRdB_A) {
-            rx_channelB_params->tunerParams.gain.gRdB = gRdB_B;
-            reason_for_update |= sdrplay_api_Update_Tuner_Gr;
+
+    /* the TCP server: one event loop for both channels */
+    IqServer *server = NULL;
+    if (server_ports[0] != 0 || server_ports[1] != 0) {
+        server = iq_server_create();
+        if (server == NULL) {
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            if (server_ports[i] == 0)
+                continue;
+            double sample_rate = output_sample_rate(rspduo_sample_rate, i == 0 ? if_frequency_A : if_frequency_B, i == 0 ? decimation_A : decimation_B);
+            if (iq_server_add_channel(server, server_address, server_ports[i], rx_context->rx_id, sample_rate, rx_context->frequency, &rx_context->server_ring_buffer) == -1) {
+                iq_server_free(server);
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+            fprintf(stdout, "RX %c - serving on %s:%d\n", rx_context->rx_id, server_address, server_ports[i]);
+        }
+        if (iq_server_start(server) == -1) {
+            iq_server_free(server);
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
         }
     }
-    if (LNAstate_B != LNAstate_A) {
-        rx_channelB_params->tunerParams.gain.LNAstate = LNAstate_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_Gr;
+
+    if (realtime_priority > 0) {
+        fprintf(stdout, "real-time mode - mlockall=");
+        if (realtime_status.memory_locked) {
+            fprintf(stdout, "ok");
+        } else {
+            fprintf(stdout, "skipped (%s)", realtime_status.memory_error);
+        }
+        fprintf(stdout, " huge_page_ring_buffers=%d/%d sched_fifo_threads=%d/%d priority=%d", realtime_status.huge_page_ring_buffers, realtime_status.ring_buffers, realtime_status.fifo_threads, realtime_status.threads, realtime_status.priority);
+        if (realtime_status.fifo_threads < realtime_status.threads)
+            fprintf(stdout, " (%s)", strerror(realtime_status.thread_error));
+        fprintf(stdout, " writer_affinity=%s\n", num_cpus > 0 ? "pinned" : "none");
     }
-    if (DCenable_B != DCenable_A) {
-        rx_channelB_params->ctrlParams.dcOffset.DCenable = DCenable_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_DCoffsetIQimbalance;
+
+    /* each RSPduo calls back with the context of its own channels */
+    for (int d = 0; d < num_devices; d++) {
+        DeviceContext *device_context = &device_contexts[d];
+        device_context->init_start_ns = monotonic_ns();
+        err = sdrplay_api_Init(device_context->device.dev, &callbackFns, &rx_contexts[2 * d]);
+        if (err != sdrplay_api_Success) {
+            fprintf(stderr, "sdrplay_api_Init() failed: %s\n", sdrplay_api_GetErrorString(err));
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
+        device_context->init_ns = monotonic_ns() - device_context->init_start_ns;
+        // since sdrplay_api_Init() resets channelB settings to channelA values,
+        // we need to update all the settings for channelB that are different
+        sdrplay_api_RxChannelParamsT *rx_channelB_params = device_context->device_params->rxChannelB;
+        sdrplay_api_ReasonForUpdateT reason_for_update = channel_params_update(channel_params, num_channel_params, rx_channelB_params, 1);
+        if (reason_for_update != sdrplay_api_Update_None) {
+            err = sdrplay_api_Update(device_context->device.dev, sdrplay_api_Tuner_B, reason_for_update, sdrplay_api_Update_Ext1_None);
+            if (err != sdrplay_api_Success) {
+                fprintf(stderr, "sdrplay_api_Update(0x%08x) failed: %s\n", reason_for_update, sdrplay_api_GetErrorString(err));
+                release_devices(device_contexts, num_devices);
+                sdrplay_api_Close();
+                exit(1);
+            }
+        }
+        if (fast_start && !device_check(device_context, channel_params, num_channel_params, rspduo_sample_rate)) {
+            for (int k = 0; k <= d; k++)
+                sdrplay_api_Uninit(device_contexts[k].device.dev);
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
     }
-    if (IQenable_B != IQenable_A) {
-        rx_channelB_params->ctrlParams.dcOffset.IQenable = IQenable_B;
-        reason_for_update |= sdrplay_api_Update_Ctrl_DCoffsetIQimbalance;
+
+    if (scan_enable) {
+        ret = pthread_create(&scan_context.thread, NULL, scan_thread, &scan_context);
+        if (ret != 0) {
+            fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+            release_devices(device_contexts, num_devices);
+            sdrplay_api_Close();
+            exit(1);
+        }
     }
-    if (frequency_B != frequency_A) {
-        rx_channelB_params->tunerParams.rfFreq.rfHz = frequency_B;
-        reason_for_update |= sdrplay_api_Update_Tuner_Frf;
+
+    /* stream for streaming_time seconds (or until SIGINT or SIGTERM) */
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = stop_handler;
+    sigemptyset(&stop_action.sa_mask);
+    stop_action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+    /* a reader going away is dealt with in output_service() */
+    if (output_engine == OUTPUT_ENGINE_PIPE)
+        signal(SIGPIPE, SIG_IGN);
+    if (streaming_time > 0) {
+        fprintf(stderr, "streaming for %d seconds\n", streaming_time);
+    } else {
+        fprintf(stderr, "streaming until SIGINT or SIGTERM\n");
+    }
+    const struct timespec stop_poll_interval = { 0, 100000000 };
+    uint64_t streaming_start_ns = monotonic_ns();
+    while (!stop_requested && (streaming_time == 0 || monotonic_ns() - streaming_start_ns < (uint64_t)streaming_time * 1000000000ULL))
+        nanosleep(&stop_poll_interval, NULL);
+    if (stop_requested)
+        fprintf(stderr, "stopping\n");
+    double streaming_elapsed = 1e-9 * (monotonic_ns() - streaming_start_ns);
+
+    /* no more retunes from here on */
+    if (scan_enable) {
+        atomic_store(&scan_context.stop, 1);
+        pthread_join(scan_context.thread, NULL);
     }
-    if (reason_for_update != sdrplay_api_Update_None) {
-        err = sdrplay_api_Update(device.dev, sdrplay_api_Tuner_B, reason_for_update, sdrplay_api_Update_Ext1_None);
+
+    for (int d = 0; d < num_devices; d++) {
+        err = sdrplay_api_Uninit(device_contexts[d].device.dev);
         if (err != sdrplay_api_Success) {
-            fprintf(stderr, "sdrplay_api_Update(0x%08x) failed: %s\n", reason_for_update, sdrplay_api_GetErrorString(err));
-            sdrplay_api_ReleaseDevice(&device);
+            fprintf(stderr, "sdrplay_api_Uninit() failed: %s\n", sdrplay_api_GetErrorString(err));
+            release_devices(device_contexts, num_devices);
             sdrplay_api_Close();
             exit(1);
         }
     }
 
-    fprintf(stderr, "streaming for %d seconds\n", streaming_time);
-    sleep(streaming_time);
+    atomic_store(&stats_context.stop, 1);
+    pthread_join(stats_context.thread, NULL);
 
-    err = sdrplay_api_Uninit(device.dev);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_Uninit() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_ReleaseDevice(&device);
-        sdrplay_api_Close();
-        exit(1);
+    if (psd_file != NULL) {
+        atomic_store(&psd_context.stop, 1);
+        pthread_join(psd_context.thread, NULL);
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            fprintf(stderr, "RX %s%c - psd records=%llu tap_overflows=%llu\n", rx_context->device_prefix, rx_context->rx_id, rx_context->psd_records, rx_context->psd_ring_buffer.overruns);
+            if (fclose(rx_context->psd_file) != 0)
+                fprintf(stderr, "RX %s%c - PSD file close failed: %s\n", rx_context->device_prefix, rx_context->rx_id, strerror(errno));
+            rx_context->psd_file = NULL;
+            psd_free(rx_context->psd);
+            rx_context->psd = NULL;
+            ring_buffer_free(&rx_context->psd_ring_buffer);
+        }
+    }
+
+    /* the clients get what is left, then they are disconnected */
+    if (server != NULL) {
+        iq_server_stop(server);
+        for (int i = 0, k = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            if (server_ports[i] == 0)
+                continue;
+            IqServerStats stats;
+            iq_server_stats(server, k++, &stats);
+            fprintf(stderr, "RX %s%c - server clients=%llu frames=%llu frames_sent=%llu bytes_sent=%llu frames_dropped=%llu zerocopy_sends=%llu zerocopy_copied=%llu tap_overflows=%llu\n", rx_context->device_prefix, rx_context->rx_id, stats.clients, stats.frames, stats.frames_sent, stats.bytes_sent, stats.frames_dropped, stats.zerocopy_sends, stats.zerocopy_copied, rx_context->server_ring_buffer.overruns);
+            ring_buffer_free(&rx_context->server_ring_buffer);
+        }
+        iq_server_free(server);
+    }
+
+    /* the readers still attached see that the recorder is done */
+    if (shm_name != NULL) {
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            fprintf(stderr, "RX %s%c - shm blocks=%llu\n", rx_context->device_prefix, rx_context->rx_id, rx_context->shm_blocks);
+            shm_ring_close(rx_context->shm_ring);
+            rx_context->shm_ring = NULL;
+        }
+    }
+
+    /* the xcorr threads take what is left in their ring buffers first */
+    if (xcorr_file != NULL) {
+        for (int d = 0; d < num_devices; d++) {
+            XcorrContext *xcorr_context = &xcorr_contexts[d];
+            atomic_store(&xcorr_context->stop, 1);
+            pthread_join(xcorr_context->thread, NULL);
+            xcorr_summary(xcorr_context);
+            if (fclose(xcorr_context->log) != 0)
+                fprintf(stderr, "%sxcorr - log file close failed: %s\n", xcorr_context->prefix, strerror(errno));
+            xcorr_free(xcorr_context->xcorr);
+            for (int i = 0; i < 2; i++) {
+                xcorr_context->rx_contexts[i].xcorr_enable = 0;
+                ring_buffer_free(&xcorr_context->rx_contexts[i].xcorr_ring_buffer);
+            }
+        }
     }
 
-    /* wait one second after sdrplay_api_Uninit() before closing the files */
-    sleep(1);
+    /* the callbacks are done once sdrplay_api_Uninit() returns: the writer
+     * threads drain the ring buffers below before the files are closed */
 
-    for (int i = 0; i < 2; i++) {
-        if (rx_contexts[i].output_fd > 0) {
-            if (close(rx_contexts[i].output_fd) == -1) {
-                fprintf(stderr, "close(%d) failed: %s\n", rx_contexts[i].output_fd, strerror(errno));
+    for (int d = 0; d < num_devices; d++) {
+        /* let the writer thread drain what is left in the ring buffers */
+        RXContext *device_rx_contexts = &rx_contexts[2 * d];
+        Container *container = device_rx_contexts[0].container;
+        if (container == NULL)
+            continue;
+        atomic_store(&device_rx_contexts[0].writer_stop, 1);
+        pthread_join(device_rx_contexts[0].writer, NULL);
+        Output *output = container_output(container);
+        fprintf(stderr, "%scontainer - output_engine=%s direct=%d bytes_written=%lld chunks=%llu blocks=%llu dropped_blocks=%llu writer_cpu_time=%.3lfs\n", device_contexts[d].prefix, output_engine_name(output->engine), output->direct, (long long)output->size, (unsigned long long)container_num_chunks(container), (unsigned long long)container_num_blocks(container), (unsigned long long)container_dropped_blocks(container), device_rx_contexts[0].writer_cpu_time);
+        device_contexts[d].bytes_written += output->size;
+        container_close(container);
+        for (int i = 0; i < 2; i++)
+            device_rx_contexts[i].container = NULL;
+    }
+    for (int i = 0; i < num_channels; i++) {
+        RXContext *rx_context = &rx_contexts[i];
+        if (rx_context->output != NULL || rx_context->nbfm != NULL) {
+            /* let the writer threads drain what is left in the ring buffers */
+            atomic_store(&rx_context->writer_stop, 1);
+        }
+    }
+    for (int i = 0; i < num_channels; i++) {
+        RXContext *rx_context = &rx_contexts[i];
+        if (rx_context->output != NULL || rx_context->nbfm != NULL)
+            pthread_join(rx_context->writer, NULL);
+    }
+    if (rotation_enable) {
+        /* all the writers are done: close the files retired by the last
+         * rotation, and remove the ones opened ahead of time */
+        atomic_store(&rotation_context.stop, 1);
+        pthread_join(rotation_context.thread, NULL);
+    }
+    for (int i = 0; i < num_channels; i++) {
+        RXContext *rx_context = &rx_contexts[i];
+        if (rx_context->output != NULL) {
+            Output *output = rx_context->output;
+            fprintf(stderr, "RX %s%c - output_engine=%s direct=%d bytes_written=%lld overruns=%llu writer_cpu_time=%.3lfs\n", rx_context->device_prefix, rx_context->rx_id, output_engine_name(output->engine), output->direct, (long long)output->size, output->overruns, rx_context->writer_cpu_time);
+            if (output->engine == OUTPUT_ENGINE_PIPE) {
+                unsigned long long dropped_buffers;
+                unsigned long long dropped_bytes;
+                output_pipe_drops(output, &dropped_buffers, &dropped_bytes);
+                fprintf(stderr, "RX %s%c - pipe dropped_buffers=%llu dropped_bytes=%llu\n", rx_context->device_prefix, rx_context->rx_id, dropped_buffers, dropped_bytes);
+            }
+            if (rx_context->compress_buffer != NULL) {
+                fprintf(stderr, "RX %s%c - compression input_bytes=%llu output_bytes=%lld ratio=%.3lf\n", rx_context->device_prefix, rx_context->rx_id, rx_context->compress_input_bytes, (long long)output->size, rx_context->compress_input_bytes > 0 ? (double)output->size / rx_context->compress_input_bytes : 0.0);
+                free(rx_context->compress_buffer);
+                rx_context->compress_buffer = NULL;
+            }
+            if (rx_context->format_buffer != NULL) {
+                fprintf(stderr, "RX %s%c - format=%s scale=%lg kernel=%s clipped_values=%llu\n", rx_context->device_prefix, rx_context->rx_id, sample_format_name(rx_context->sample_format), rx_context->sample_scale, sample_format_kernel->name, rx_context->clipped_values);
+                free(rx_context->format_buffer);
+                rx_context->format_buffer = NULL;
+            }
+            device_contexts[i / 2].bytes_written += rx_context->rotated_bytes + output->size;
+            output_close(output);
+            rx_context->output = NULL;
+        }
+        if (rx_context->gap_log != NULL) {
+            fclose(rx_context->gap_log);
+            rx_context->gap_log = NULL;
+            free(rx_context->gap_buffer);
+        }
+        if (rx_context->trigger_log != NULL) {
+            fprintf(stderr, "RX %s%c - squelch segments=%llu discarded_samples=%llu\n", rx_context->device_prefix, rx_context->rx_id, rx_context->segments, rx_context->discarded_bytes / (2 * sizeof(short)));
+            fclose(rx_context->trigger_log);
+            rx_context->trigger_log = NULL;
+        }
+        if (rx_context->hop_log != NULL) {
+            HistogramSnapshot *retune_latency = (HistogramSnapshot *)malloc(sizeof(HistogramSnapshot));
+            histogram_snapshot(&rx_context->histograms[RX_METRIC_RETUNE_LATENCY], retune_latency);
+            fprintf(stderr, "RX %s%c - scan hops=%llu hops_per_second=%.2lf retune_latency_ms=%.2lf/%.2lf/%.2lf settling_samples=%llu usable=%.2lf%% retune_timeouts=%llu\n", rx_context->device_prefix, rx_context->rx_id, rx_context->hops, streaming_elapsed > 0 ? rx_context->hops / streaming_elapsed : 0.0, 1e-6 * histogram_percentile(retune_latency, 50.0), 1e-6 * histogram_percentile(retune_latency, 99.0), 1e-6 * histogram_max(retune_latency), rx_context->settle_discarded, rx_context->total_samples > 0 ? 100.0 * (rx_context->total_samples - rx_context->settle_discarded) / rx_context->total_samples : 0.0, rx_context->retune_timeouts);
+            free(retune_latency);
+            fclose(rx_context->hop_log);
+            rx_context->hop_log = NULL;
+        }
+        if (rx_context->event_ring_buffer.buffer != NULL) {
+            if (rx_context->events_lost > 0)
+                fprintf(stderr, "RX %s%c - gap/rotation/squelch/retune events lost=%llu (the sample index is not exact)\n", rx_context->device_prefix, rx_context->rx_id, rx_context->events_lost);
+            ring_buffer_free(&rx_context->event_ring_buffer);
+        }
+        if (rx_context->ddc != NULL) {
+            ddc_free(rx_context->ddc);
+            free(rx_context->ddc_buffer);
+            rx_context->ddc = NULL;
+        }
+    }
+    if (rx_contexts[0].nbfm != NULL) {
+        /* the demodulators are done: write out the rest of the audio */
+        atomic_store(&rx_contexts[0].audio_writer_stop, 1);
+        pthread_join(rx_contexts[0].audio_writer, NULL);
+        for (int i = 0; i < 2; i++) {
+            RXContext *rx_context = &rx_contexts[i];
+            RingBuffer *ring_buffer = &rx_context->audio_ring_buffer;
+            fprintf(stderr, "RX %s%c - audio high_water_mark=%zu (%.1lf%%) overruns=%llu\n", rx_context->device_prefix, rx_context->rx_id, ring_buffer->high_water_mark, 100.0 * ring_buffer->high_water_mark / ring_buffer->size, ring_buffer->overruns);
+            if (rx_context->audio_output != NULL) {
+                audio_output_close(rx_context->audio_output);
+                rx_context->audio_output = NULL;
             }
+            ring_buffer_free(ring_buffer);
+            nbfm_free(rx_context->nbfm);
+            rx_context->nbfm = NULL;
+            free(rx_context->audio_discard);
+            rx_context->audio_discard = NULL;
         }
     }
 
-    for (int i = 0; i < 2; i++) {
+    FILE *json_fp = NULL;
+    if (json_file != NULL) {
+        json_fp = fopen(json_file, "w");
+        if (json_fp == NULL) {
+            fprintf(stderr, "fopen(%s) failed: %s\n", json_file, strerror(errno));
+        } else {
+            fprintf(json_fp, "{\"streaming_time\": %d, \"stats_interval\": %g, \"channels\": [", streaming_time, stats_interval);
+        }
+    }
+    for (int i = 0; i < num_channels; i++) {
         RXContext *rx_context = &rx_contexts[i];
         /* estimate actual sample rate */
         double elapsed_sec = (rx_context->latest_callback.tv_sec - rx_context->earliest_callback.tv_sec) + 1e-6 * (rx_context->latest_callback.tv_usec - rx_context->earliest_callback.tv_usec);
         double actual_sample_rate = (double)(rx_context->total_samples) / elapsed_sec;
+        /* the fitted rate is not affected by NTP, startup jitter, or drops */
+        double estimated_sample_rate = rate_estimator_rate(&rx_context->rate_estimator);
+        if (estimated_sample_rate > 0)
+            actual_sample_rate = estimated_sample_rate;
         int rounded_sample_rate_kHz = (int)(actual_sample_rate / 1000.0 + 0.5);
-        fprintf(stderr, "RX %c - total_samples=%llu actual_sample_rate=%.0lf rounded_sample_rate_kHz=%d\n", rx_context->rx_id, rx_context->total_samples, actual_sample_rate, rounded_sample_rate_kHz);
-        fprintf(stderr, "RX %c - I_range=[%hd,%hd] Q_range=[%hd,%hd]\n", rx_context->rx_id, rx_context->imin, rx_context->imax, rx_context->qmin, rx_context->qmax);
+        /* the file name gets the sample rate after the DDC */
+        int ddc_decimation = i % 2 == 0 ? ddc_decimation_A : ddc_decimation_B;
+        if (ddc_decimation > 1)
+            rounded_sample_rate_kHz = (int)(actual_sample_rate / ddc_decimation / 1000.0 + 0.5);
+        fprintf(stderr, "RX %s%c - total_samples=%llu actual_sample_rate=%.0lf rounded_sample_rate_kHz=%d\n", rx_context->device_prefix, rx_context->rx_id, rx_context->total_samples, actual_sample_rate, rounded_sample_rate_kHz);
+        fprintf(stderr, "RX %s%c - I_range=[%hd,%hd] Q_range=[%hd,%hd]\n", rx_context->device_prefix, rx_context->rx_id, rx_context->iq_range.imin, rx_context->iq_range.imax, rx_context->iq_range.qmin, rx_context->iq_range.qmax);
+        fprintf(stderr, "RX %s%c - dropped_events=%llu dropped_samples=%llu\n", rx_context->device_prefix, rx_context->rx_id, atomic_load(&rx_context->dropped_events), atomic_load(&rx_context->dropped_samples));
+        fprintf(stderr, "RX %s%c - estimated_sample_rate=%.3lf fit_residual_us=%.2lf blocks=%llu fit_restarts=%llu\n", rx_context->device_prefix, rx_context->rx_id, estimated_sample_rate, 1e-3 * rate_estimator_residual(&rx_context->rate_estimator), (unsigned long long)rx_context->rate_estimator.n, (unsigned long long)rx_context->rate_estimator.restarts);
+        if (rx_context->anchor_file != NULL) {
+            if (fclose(rx_context->anchor_file) != 0)
+                fprintf(stderr, "RX %s%c - anchor file close failed: %s\n", rx_context->device_prefix, rx_context->rx_id, strerror(errno));
+            rx_context->anchor_file = NULL;
+            ring_buffer_free(&rx_context->anchor_ring_buffer);
+        }
+        if (json_fp != NULL) {
+            fprintf(json_fp, "%s", i > 0 ? ", " : "");
+            stats_json(json_fp, rx_context, actual_sample_rate);
+        }
+        free(rx_context->histograms);
+        rx_context->histograms = NULL;
+        if (rx_context->ring_buffer.buffer != NULL) {
+            RingBuffer *ring_buffer = &rx_context->ring_buffer;
+            fprintf(stderr, "RX %s%c - ring_buffer_size=%zu high_water_mark=%zu (%.1lf%%) overruns=%llu (%llu bytes)\n", rx_context->device_prefix, rx_context->rx_id, ring_buffer->size, ring_buffer->high_water_mark, 100.0 * ring_buffer->high_water_mark / ring_buffer->size, ring_buffer->overruns, ring_buffer->overrun_bytes);
+            ring_buffer_free(ring_buffer);
+        }
         const char *samplerate_string = "SAMPLERATE";
-        if (output_file != NULL && strstr(output_file, samplerate_string)) {
+        /* the container is a single file: it gets the sample rate of A */
+        if (output_file != NULL && strstr(output_file, samplerate_string) && !(container_enable && i % 2 > 0)) {
             char old_filename[MAX_PATH_SIZE];
-            snprintf(old_filename, MAX_PATH_SIZE, output_file, rx_context->rx_id);
+            channel_filename(old_filename, MAX_PATH_SIZE, output_file, container_enable ? 'C' : rx_context->rx_id, rx_context->serial_number);
             char *p = strstr(old_filename, samplerate_string);
             int from = p - old_filename;
             int to = from + strlen(samplerate_string);
             char new_filename[MAX_PATH_SIZE];
             snprintf(new_filename, MAX_PATH_SIZE, "%.*s%d%s", from, old_filename, rounded_sample_rate_kHz, old_filename + to);
-            if (rename(old_filename, new_filename) == -1) {
+            if (rotation_enable) {
+                /* all the files of the channel */
+                for (int file_number = 0; file_number <= atomic_load(&rx_context->file_number); file_number++) {
+                    char old_sequenced_filename[MAX_PATH_SIZE];
+                    char new_sequenced_filename[MAX_PATH_SIZE];
+                    sequence_filename(old_sequenced_filename, MAX_PATH_SIZE, old_filename, file_number);
+                    sequence_filename(new_sequenced_filename, MAX_PATH_SIZE, new_filename, file_number);
+                    if (rename(old_sequenced_filename, new_sequenced_filename) == -1) {
+                        fprintf(stderr, "rename(%s, %s) failed: %s\n", old_sequenced_filename, new_sequenced_filename, strerror(errno));
+                    }
+                }
+            } else if (rename(old_filename, new_filename) == -1) {
                 fprintf(stderr, "rename(%s, %s) failed: %s\n", old_filename, new_filename, strerror(errno));
             }
+            if (trigger_enable) {
+                char old_trigger_log_filename[MAX_PATH_SIZE + 9];
+                char new_trigger_log_filename[MAX_PATH_SIZE + 9];
+                snprintf(old_trigger_log_filename, sizeof(old_trigger_log_filename), "%s.triggers", old_filename);
+                snprintf(new_trigger_log_filename, sizeof(new_trigger_log_filename), "%s.triggers", new_filename);
+                if (rename(old_trigger_log_filename, new_trigger_log_filename) == -1) {
+                    fprintf(stderr, "rename(%s, %s) failed: %s\n", old_trigger_log_filename, new_trigger_log_filename, strerror(errno));
+                }
+            }
+            if (scan_enable) {
+                char old_hop_log_filename[MAX_PATH_SIZE + 5];
+                char new_hop_log_filename[MAX_PATH_SIZE + 5];
+                snprintf(old_hop_log_filename, sizeof(old_hop_log_filename), "%s.hops", old_filename);
+                snprintf(new_hop_log_filename, sizeof(new_hop_log_filename), "%s.hops", new_filename);
+                if (rename(old_hop_log_filename, new_hop_log_filename) == -1) {
+                    fprintf(stderr, "rename(%s, %s) failed: %s\n", old_hop_log_filename, new_hop_log_filename, strerror(errno));
+                }
+            }
+            if (gap_fill != GAP_FILL_NONE) {
+                char old_gap_log_filename[MAX_PATH_SIZE + 5];
+                char new_gap_log_filename[MAX_PATH_SIZE + 5];
+                snprintf(old_gap_log_filename, sizeof(old_gap_log_filename), "%s.gaps", old_filename);
+                snprintf(new_gap_log_filename, sizeof(new_gap_log_filename), "%s.gaps", new_filename);
+                if (rename(old_gap_log_filename, new_gap_log_filename) == -1) {
+                    fprintf(stderr, "rename(%s, %s) failed: %s\n", old_gap_log_filename, new_gap_log_filename, strerror(errno));
+                }
+            }
         }
     }
 
-    err = sdrplay_api_ReleaseDevice(&device);
-    if (err != sdrplay_api_Success) {
-        fprintf(stderr, "sdrplay_api_ReleaseDevice() failed: %s\n", sdrplay_api_GetErrorString(err));
-        sdrplay_api_Close();
-        exit(1);
+    /* A and B share the sample clock: at the same sample number, the
+     * difference between the fitted times is the offset between them */
+    for (int d = 0; d < num_devices; d++) {
+        DeviceContext *device_context = &device_contexts[d];
+        const RXContext *device_rx_contexts = &rx_contexts[2 * d];
+        if (rate_estimator_rate(&device_rx_contexts[0].rate_estimator) > 0 && rate_estimator_rate(&device_rx_contexts[1].rate_estimator) > 0) {
+            const RateEstimator *rate_estimator = &device_rx_contexts[0].rate_estimator;
+            double sample_index = rate_estimator->x0 + rate_estimator->mean_x;
+            device_context->ab_time_offset_ns = rate_estimator_time(&device_rx_contexts[0].rate_estimator, sample_index) - rate_estimator_time(&device_rx_contexts[1].rate_estimator, sample_index);
+            fprintf(stderr, "%sA/B - time_offset_us=%.2lf sample_offset=%.2lf\n", device_context->prefix, 1e-3 * device_context->ab_time_offset_ns, 1e-9 * device_context->ab_time_offset_ns * rate_estimator_rate(rate_estimator));
+        }
+    }
+
+    if (trigger_enable) {
+        for (int d = 0; d < num_devices; d++) {
+            fprintf(stderr, "%ssquelch triggers=%llu\n", device_contexts[d].prefix, device_contexts[d].trigger.triggers);
+            trigger_free(&device_contexts[d].trigger);
+        }
+    }
+
+    /* the totals for each RSPduo */
+    if (json_fp != NULL)
+        fprintf(json_fp, "], \"devices\": [");
+    for (int d = 0; d < num_devices; d++) {
+        DeviceContext *device_context = &device_contexts[d];
+        unsigned long long total_samples = 0;
+        unsigned long long dropped_samples = 0;
+        for (int i = 2 * d; i < 2 * d + 2; i++) {
+            total_samples += rx_contexts[i].total_samples;
+            dropped_samples += atomic_load(&rx_contexts[i].dropped_samples);
+        }
+        double throughput = streaming_elapsed > 0 ? device_context->bytes_written / streaming_elapsed : 0.0;
+        /* from sdrplay_api_Open() to the first sample in both channels */
+        uint64_t first_sample_ns = 0;
+        for (int i = 2 * d; i < 2 * d + 2; i++)
+            if (rx_contexts[i].first_callback_ns > first_sample_ns)
+                first_sample_ns = rx_contexts[i].first_callback_ns;
+        double time_to_first_sample = first_sample_ns > 0 ? 1e-9 * (first_sample_ns - startup_ns) : 0.0;
+        fprintf(stderr, "%sstartup - quick_check_ms=%.1lf init_ms=%.1lf init_to_first_sample_ms=%.1lf time_to_first_sample_ms=%.1lf\n", device_context->prefix, 1e-6 * device_context->quick_check_ns, 1e-6 * device_context->init_ns, first_sample_ns > 0 ? 1e-6 * (first_sample_ns - device_context->init_start_ns) : 0.0, 1e3 * time_to_first_sample);
+        fprintf(stderr, "device %s - total_samples=%llu bytes_written=%lld dropped_samples=%llu throughput_MBps=%.2lf\n", device_context->device.SerNo, total_samples, device_context->bytes_written, dropped_samples, 1e-6 * throughput);
+        if (json_fp != NULL)
+            fprintf(json_fp, "%s{\"serial_number\": \"%s\", \"total_samples\": %llu, \"bytes_written\": %lld, \"dropped_samples\": %llu, \"throughput_bytes_per_second\": %.0lf, \"ab_time_offset_ns\": %.1lf, \"time_to_first_sample_ns\": %.0lf}", d > 0 ? ", " : "", device_context->device.SerNo, total_samples, device_context->bytes_written, dropped_samples, throughput, device_context->ab_time_offset_ns, 1e9 * time_to_first_sample);
+    }
+
+    if (json_fp != NULL) {
+        fprintf(json_fp, "], \"ab_time_offset_ns\": %.1lf}\n", device_contexts[0].ab_time_offset_ns);
+        if (fclose(json_fp) != 0)
+            fprintf(stderr, "fclose(%s) failed: %s\n", json_file, strerror(errno));
+    }
+    free(rx_contexts);
+
+    for (int d = 0; d < num_devices; d++) {
+        err = sdrplay_api_ReleaseDevice(&device_contexts[d].device);
+        if (err != sdrplay_api_Success) {
+            fprintf(stderr, "sdrplay_api_ReleaseDevice() failed: %s\n", sdrplay_api_GetErrorString(err));
+            sdrplay_api_Close();
+            exit(1);
+        }
     }
 
     /* all done: close SDRplay API */
@@ -712,7 +2188,7 @@ static void usage(const char* progname)
 {
     fprintf(stderr, "usage: %s [options...]\n", progname);
     fprintf(stderr, "options:\n");
-    fprintf(stderr, "    -s <serial number>\n");
+    fprintf(stderr, "    -s <serial number(s)> (a comma separated list to record from several RSPduo's at the same time) (default: the first RSPduo)\n");
     fprintf(stderr, "    -r <RSPduo sample rate>\n");
     fprintf(stderr, "    -d <decimation>\n");
     fprintf(stderr, "    -i <IF frequency>\n");
@@ -723,8 +2199,33 @@ static void usage(const char* progname)
     fprintf(stderr, "    -I disable post tuner I/Q balance compensation (default: enabled)\n");
     fprintf(stderr, "    -y tuner DC offset compensation parameters <dcCal,speedUp,trackTime,refeshRateTime> (default: 3,0,1,2048)\n");
     fprintf(stderr, "    -f <center frequency>\n");
-    fprintf(stderr, "    -x <streaming time (s)> (default: 10s)\n");
-    fprintf(stderr, "    -o <output file> ('%%c' will be replaced by the channel id (A or B) and 'SAMPLERATE' will be replaced by the estimated sample rate in kHz)\n");
+    fprintf(stderr, "    -H <scan frequency list> ('<A list>[/<B list>]', comma separated: step each tuner through its list while streaming, instead of -f; where each frequency starts is logged in '<output file>.hops') (default: none - B scans the same list as A)\n");
+    fprintf(stderr, "    -w <scan dwell> ('<dwell (s)>[,<settling time (s)>]': time at each frequency, and the samples skipped after each retune) (default: %.0lfs,%.2lfs)\n", SCAN_DEFAULT_DWELL, SCAN_DEFAULT_SETTLING_TIME);
+    fprintf(stderr, "    -x <streaming time (s)> (0 to stream until SIGINT or SIGTERM) (default: 10s)\n");
+    fprintf(stderr, "    -o <output file> ('%%c' will be replaced by the channel id (A or B), 'SERIAL' by the RSPduo serial number (required with more than one), and 'SAMPLERATE' by the estimated sample rate in kHz; a FIFO, or '-' for A on stdout, is streamed with the pipe engine)\n");
+    fprintf(stderr, "    -O <output format> ('cs16', 'cf32' for complex float normalized to +/-1.0, 'cs8[,<scale>]' for 8 bit, or 'cs12[,<scale>]' for 12 bit packed in 3 bytes per sample; the int16 samples are multiplied by the scale, rounded, and saturated; 'FORMAT' in the output file will be replaced by the format name) (default: cs16 - cs8 scale 1/256, cs12 scale 1/16)\n");
+    fprintf(stderr, "    -c write both channels to a single container file with a seek index ('%%c' in the output file will be replaced by 'C')\n");
+    fprintf(stderr, "    -z compress the output files (lossless; use iq_decompress to restore the raw I/Q samples)\n");
+    fprintf(stderr, "    -e <output engine> ('write', 'uring' for io_uring with O_DIRECT and preallocation, 'mmap' for memory mapped output, or 'pipe' for vmsplice() into a pipe or a FIFO - chosen automatically for them) (default: write)\n");
+    fprintf(stderr, "    -F <DDC frequency offset> (shift the channel of interest at this offset from the center frequency to 0Hz) (default: 0)\n");
+    fprintf(stderr, "    -W <DDC bandwidth> (default: half the DDC output sample rate)\n");
+    fprintf(stderr, "    -Z <DDC decimation> (filter and decimate the samples before writing them to the output file) (default: 1 - no DDC)\n");
+    fprintf(stderr, "    -A <audio output file> (demodulate NBFM at the DDC frequency offset live; '%%c' will be replaced by the channel id (A or B) for one mono file per channel, otherwise A and B are the left and right channels; '-' for raw PCM to stdout, '.wav' suffix for a WAV file) (default: none)\n");
+    fprintf(stderr, "    -v <volume> (NBFM audio volume) (default: %.1lf)\n", NBFM_DEFAULT_VOLUME);
+    fprintf(stderr, "    -S <stats interval (s)> (print the callback and write latency percentiles every interval) (default: 0 - only report the dropped samples once a second)\n");
+    fprintf(stderr, "    -J <JSON file> (write the latency histograms and the drop counters at exit) (default: none)\n");
+    fprintf(stderr, "    -T <anchor file> (write the sample number and time of each block to a sidecar file; '%%c' will be replaced by the channel id (A or B) and 'SERIAL' by the RSPduo serial number) (default: none)\n");
+    fprintf(stderr, "    -G <gap fill> (keep the sample index exact across the dropped samples: 'zero' to insert zeros (as holes in the file for large gaps), or 'flag' to insert %d in both I and Q; each insertion is logged in '<output file>.gaps') (default: none)\n", GAP_FLAG_VALUE);
+    fprintf(stderr, "    -R <rotation> (start a new pair of output files at the same sample number for A and B every '<n>M' or '<n>G' bytes (approximate: the files stay below that size, a few tenths of a second of samples short of it), or at every multiple of '<n>s', '<n>m', or '<n>h' of wall clock time (the first file is short, up to the first multiple); a '-NNNNNN' sequence number is added to the file names) (default: no rotation)\n");
+    fprintf(stderr, "    -Q <squelch> ('<threshold (dBFS)>[,<pre-trigger (s)>[,<hang time (s)>]]': only record the segments where the power of either tuner is above the threshold, in both, from the pre-trigger before to the hang time after; each segment is logged in '<output file>.triggers') (default: none - pre-trigger %.0lfs, hang time %.0lfs)\n", TRIGGER_DEFAULT_PRE_TRIGGER, TRIGGER_DEFAULT_HANG_TIME);
+    fprintf(stderr, "    -k <I/Q kernel> ('scalar', 'sse2', or 'avx2') (default: the fastest on this CPU)\n");
+    fprintf(stderr, "    -a <CPU list> (pin the writer threads to these CPUs, one per channel in order - A and B of the first RSPduo, then of the next one, and so on - starting over from the beginning of the list if it is shorter) (default: no affinity)\n");
+    fprintf(stderr, "    -P <real-time priority> (real-time mode: lock all the memory, back the sample ring buffers with huge pages (if reserved with vm.nr_hugepages), and run the writer threads with SCHED_FIFO at this priority (1-99); each of them is skipped if not permitted, and what took effect is reported at startup) (default: disabled)\n");
+    fprintf(stderr, "    -X <cross-correlation log file>[,<interval (s)>[,<FFT size>]] (cross-correlate A and B of each RSPduo while streaming, and log the lag, the normalized magnitude, and the phase of the peak every interval; 'SERIAL' will be replaced by the RSPduo serial number (required with more than one); A and B need the same sample rate) (default: none - interval %.0lfs, FFT size %d)\n", XCORR_DEFAULT_INTERVAL, XCORR_DEFAULT_SIZE);
+    fprintf(stderr, "    -M <PSD file>[,<FFT size>[,<interval (s)>[,<frames>]]] (live spectrum monitor: every interval average the power spectra of this many Hann windowed FFT frames (overlapping by half) of each channel, and write them in dBFS to a binary stream (see psd.h for the layout); '%%c' (required) will be replaced by the channel id (A or B), and 'SERIAL' by the RSPduo serial number (required with more than one)) (default: none - FFT size %d, interval %.1lfs, frames %d)\n", PSD_DEFAULT_SIZE, PSD_DEFAULT_INTERVAL, PSD_DEFAULT_FRAMES);
+    fprintf(stderr, "    -N [<address>:]<A port>[,<B port>] (serve the samples to any number of TCP clients, in frames of up to %d samples with their sample number and the drops (see iq_server.h and iq_server_load); 0 for the channel not served; one RSPduo only) (default: none - address %s, B port the A port + 1)\n", IQ_SERVER_BATCH_SAMPLES, SERVER_DEFAULT_ADDRESS);
+    fprintf(stderr, "    -m <shared memory ring>[,<size (MB)>] (publish the samples of each channel to a POSIX shared memory ring for any number of local readers (see shm_ring.h and iq_shm_reader); the name starts with '/', and '%%c' (required) will be replaced by the channel id (A or B), and 'SERIAL' by the RSPduo serial number (required with more than one)) (default: none - size %dMB)\n", SHM_RING_DEFAULT_SIZE_MB);
+    fprintf(stderr, "    -q fast start: skip the quick check sdrplay_api_Init()/Uninit() cycle, and check the settings after the sdrplay_api_Init() that starts streaming (default: disabled)\n");
     fprintf(stderr, "    -L enable SDRplay API debug log level (default: disabled)\n");
     fprintf(stderr, "    -h show usage\n");
 }
@@ -741,17 +2242,30 @@ static void rxB_callback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *para
 
 static void event_callback(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, sdrplay_api_EventParamsT *params, void *cbContext)
 {
-    UNUSED(eventId);
-    UNUSED(tuner);
     UNUSED(params);
-    UNUSED(cbContext);
-    /* do nothing for now */
+    /* a gain change while a scan retune settles restarts the settling
+     * (the stream callback takes care of it) */
+    if (eventId == sdrplay_api_GainChange) {
+        RXContext *rxContexts = (RXContext *)cbContext;
+        if (tuner == sdrplay_api_Tuner_A || tuner == sdrplay_api_Tuner_Both)
+            atomic_store_explicit(&rxContexts[0].gain_changed, 1, memory_order_relaxed);
+        if (tuner == sdrplay_api_Tuner_B || tuner == sdrplay_api_Tuner_Both)
+            atomic_store_explicit(&rxContexts[1].gain_changed, 1, memory_order_relaxed);
+    }
     return;
 }
 
 static void rx_callback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, RXContext *rxContext)
 {
-    UNUSED(reset);
+    uint64_t start_ns = monotonic_ns();
+    uint64_t raw_ns = monotonic_raw_ns();
+    if (rxContext->last_callback_ns != 0) {
+        histogram_record(&rxContext->histograms[RX_METRIC_CALLBACK_INTERVAL], start_ns - rxContext->last_callback_ns);
+    } else {
+        rxContext->first_callback_ns = start_ns;
+    }
+    rxContext->last_callback_ns = start_ns;
+    histogram_record(&rxContext->histograms[RX_METRIC_NUM_SAMPLES], numSamples);
 
     /* track callback timestamp */
     gettimeofday(&rxContext->latest_callback, NULL);
@@ -759,52 +2273,1280 @@ static void rx_callback(short *xi, short *xq, sdrplay_api_StreamCbParamsT *param
         rxContext->earliest_callback.tv_sec = rxContext->latest_callback.tv_sec;
         rxContext->earliest_callback.tv_usec = rxContext->latest_callback.tv_usec;
     }
+
     rxContext->total_samples += numSamples;
 
-    /* check for dropped samples */
-    if (rxContext->next_sample_num != 0xffffffff && params->firstSampleNum != rxContext->next_sample_num) {
-        unsigned int dropped_samples;
-        if (rxContext->next_sample_num < params->firstSampleNum) {
-            dropped_samples = params->firstSampleNum - rxContext->next_sample_num;
-        } else {
-            dropped_samples = UINT_MAX - (params->firstSampleNum - rxContext->next_sample_num) + 1;
-        }
-        fprintf(stderr, "RX %c - dropped %d samples\n", rxContext->rx_id, dropped_samples);
+    /* fit the sample rate */
+    uint64_t sample_index = rate_estimator_add(&rxContext->rate_estimator, params->firstSampleNum, numSamples, reset, raw_ns);
+
+    /* check for dropped samples; after a reset the sample numbers may
+     * start over: not a drop (nor a gap) */
+    if (rxContext->next_sample_num != 0xffffffff && params->firstSampleNum != rxContext->next_sample_num && !reset) {
+        /* the unsigned difference takes care of the wrap around */
+        unsigned int dropped_samples = params->firstSampleNum - rxContext->next_sample_num;
+        /* no printing here: the stats thread reports them */
+        atomic_fetch_add_explicit(&rxContext->dropped_events, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rxContext->dropped_samples, dropped_samples, memory_order_relaxed);
+        if (rxContext->gap_fill != GAP_FILL_NONE)
+            gap_queue(rxContext, sample_index - dropped_samples, dropped_samples);
     }
     rxContext->next_sample_num = params->firstSampleNum + numSamples;
 
-    short imin = SHRT_MAX;
-    short imax = SHRT_MIN;
-    short qmin = SHRT_MAX;
-    short qmax = SHRT_MIN;
-    for (unsigned int i = 0; i < numSamples; i++) {
-        imin = imin < xi[i] ? imin : xi[i];
-        imax = imax > xi[i] ? imax : xi[i];
-    }
-    for (unsigned int i = 0; i < numSamples; i++) {
-        qmin = qmin < xq[i] ? qmin : xq[i];
-        qmax = qmax > xq[i] ? qmax : xq[i];
-    }
-    rxContext->imin = rxContext->imin < imin ? rxContext->imin : imin;
-    rxContext->imax = rxContext->imax > imax ? rxContext->imax : imax;
-    rxContext->qmin = rxContext->qmin < qmin ? rxContext->qmin : qmin;
-    rxContext->qmax = rxContext->qmax > qmax ? rxContext->qmax : qmax;
-
-    /* write samples to output file */
-    if (rxContext->output_fd > 0) {
-        short samples[4096];
-        for (unsigned int i = 0; i < numSamples; i++) {
-            samples[2*i] = xi[i];
-        }
-        for (unsigned int i = 0; i < numSamples; i++) {
-            samples[2*i+1] = xq[i];
-        }
-        size_t count = numSamples * 2 * sizeof(short);
-        ssize_t nwritten = write(rxContext->output_fd, samples, count);
+    /* scan: skip the settling samples after a retune (they become a gap
+     * with the gap fill), and mark where the new frequency starts */
+    if (rxContext->scan_frequencies != NULL) {
+        unsigned int skip = scan_block(rxContext, params->rfChanged || reset, sample_index);
+        if (skip > numSamples)
+            skip = numSamples;
+        if (skip > 0) {
+            rxContext->settle_discarded += skip;
+            if (rxContext->gap_fill != GAP_FILL_NONE)
+                gap_queue(rxContext, sample_index, skip);
+            xi += skip;
+            xq += skip;
+            numSamples -= skip;
+            sample_index += skip;
+        }
+        if (rxContext->retune_marker_pending && numSamples > 0)
+            retune_push(rxContext, sample_index);
+    }
+
+    /* hand a copy to the xcorr thread */
+    if (rxContext->xcorr_enable && numSamples > 0)
+        tap_push(&rxContext->xcorr_ring_buffer, sample_index, xi, xq, numSamples);
+    if (rxContext->psd != NULL && numSamples > 0)
+        psd_tap(rxContext, sample_index, xi, xq, numSamples);
+
+    /* queue the anchor for the sidecar file */
+    if (rxContext->anchor_file != NULL) {
+        Anchor *anchor = ring_buffer_write_ptr(&rxContext->anchor_ring_buffer, sizeof(Anchor));
+        if (anchor != NULL) {
+            anchor->sample_index = sample_index;
+            anchor->file_sample = rxContext->file_samples;
+            anchor->timestamp_ns = raw_ns;
+            ring_buffer_commit(&rxContext->anchor_ring_buffer, sizeof(Anchor));
+        }
+    }
+
+    /* squelch trigger (shared with the other tuner) */
+    TriggerTransition transitions[TRIGGER_MAX_TRANSITIONS];
+    int num_transitions = 0;
+    if (rxContext->trigger != NULL && numSamples > 0) {
+        uint64_t energy = iq_energy(xi, xq, numSamples);
+        uint64_t power = energy / numSamples;
+        if (power > atomic_load_explicit(&rxContext->peak_power, memory_order_relaxed))
+            atomic_store_explicit(&rxContext->peak_power, power, memory_order_relaxed);
+        num_transitions = trigger_block(rxContext->trigger, &rxContext->trigger_channel, sample_index, numSamples, energy, transitions);
+    }
+
+    /* copy samples to the ring buffer (or straight into the file mapping
+     * with the mmap engine); the writer thread takes it from there */
+    short *samples = NULL;
+    size_t count = numSamples * 2 * sizeof(short);
+    int direct_mapped = 0;
+    if (rxContext->container != NULL) {
+        /* tag the block for the container */
+        count = CONTAINER_BLOCK_SIZE(numSamples);
+        ContainerBlockHeader *block_header = ring_buffer_write_ptr(&rxContext->ring_buffer, count);
+        if (block_header != NULL) {
+            block_header->timestamp_ns = start_ns;
+            block_header->first_sample_num = params->firstSampleNum;
+            block_header->num_samples = numSamples;
+            block_header->rx_id = rxContext->rx_id;
+            block_header->flags = (reset ? CONTAINER_BLOCK_RESET : 0) |
+                                  (params->grChanged ? CONTAINER_BLOCK_GR_CHANGED : 0) |
+                                  (params->rfChanged ? CONTAINER_BLOCK_RF_CHANGED : 0) |
+                                  (params->fsChanged ? CONTAINER_BLOCK_FS_CHANGED : 0);
+            samples = (short *)(block_header + 1);
+        }
+    } else if (rxContext->output != NULL && (rxContext->output->engine == OUTPUT_ENGINE_MMAP || rxContext->output->engine == OUTPUT_ENGINE_PIPE)) {
+        direct_mapped = 1;
+        samples = output_reserve(rxContext->output, count);
+    } else if (rxContext->ring_buffer.buffer != NULL) {
+        /* if the buffer is full, this block is lost (counted as an overrun) */
+        samples = ring_buffer_write_ptr(&rxContext->ring_buffer, count);
+    }
+
+    /* the local readers get the samples through the shared memory ring,
+     * and the TCP server through its own ring buffer (the first one of
+     * these and the output that takes them gets them straight from the
+     * interleaving, and the others get a copy) */
+    short *shm_samples = NULL;
+    if (rxContext->shm_ring != NULL && numSamples > 0)
+        shm_samples = shm_ring_write_ptr(rxContext->shm_ring, numSamples);
+    IqServerBlock *server_block = NULL;
+    if (rxContext->server_ring_buffer.buffer != NULL && numSamples > 0)
+        server_block = ring_buffer_write_ptr(&rxContext->server_ring_buffer, IQ_SERVER_BLOCK_SIZE(numSamples));
+    short *server_samples = server_block != NULL ? (short *)(server_block + 1) : NULL;
+    short *interleaved = samples != NULL ? samples : shm_samples != NULL ? shm_samples : server_samples;
+
+    /* track the I/Q range and interleave the samples in a single pass */
+    iq_interleave_minmax(xi, xq, interleaved, numSamples, &rxContext->iq_range);
+
+    if (server_block != NULL) {
+        if (server_samples != interleaved)
+            memcpy(server_samples, interleaved, numSamples * 2 * sizeof(short));
+        server_block->sample_index = sample_index;
+        server_block->first_sample_num = (uint32_t)sample_index;
+        server_block->num_samples = numSamples;
+        ring_buffer_commit(&rxContext->server_ring_buffer, IQ_SERVER_BLOCK_SIZE(numSamples));
+    }
+    if (shm_samples != NULL) {
+        if (shm_samples != interleaved)
+            memcpy(shm_samples, interleaved, numSamples * 2 * sizeof(short));
+        /* the frequency of the first sample kept after a retune */
+        double frequency = rxContext->scan_started ? rxContext->retune_marker.frequency : rxContext->frequency;
+        shm_ring_commit(rxContext->shm_ring, sample_index, (uint32_t)sample_index, numSamples, frequency);
+        rxContext->shm_blocks++;
+    }
+
+    /* a file rotation in this block is queued before the samples are
+     * committed, so the writer thread cannot go past it */
+    uint64_t rotation_target = atomic_load_explicit(&rxContext->rotation_target, memory_order_acquire);
+    int rotate = rotation_target != ROTATION_NONE && rotation_target < sample_index + numSamples;
+    unsigned int before_rotation = rotate && rotation_target > sample_index ? rotation_target - sample_index : 0;
+    size_t ring_offset = atomic_load_explicit(&rxContext->ring_buffer.head, memory_order_relaxed);
+    /* the start and the end of the recorded segments go in the stream at
+     * their sample (a start is usually in the pre-trigger, before this block) */
+    for (int k = 0; k < num_transitions; k++) {
+        int64_t offset = (int64_t)(transitions[k].sample_index - sample_index) * 2 * (int64_t)sizeof(short);
+        event_push(rxContext, transitions[k].type == TRIGGER_OPEN ? STREAM_EVENT_TRIGGER_OPEN : STREAM_EVENT_TRIGGER_CLOSE, ring_offset + offset, transitions[k].sample_index, 0);
+    }
+    if (samples != NULL) {
+        if (rotate)
+            event_push(rxContext, STREAM_EVENT_ROTATION, ring_offset + before_rotation * 2 * sizeof(short), sample_index + before_rotation, 0);
+        if (direct_mapped) {
+            output_commit(rxContext->output, count);
+        } else {
+            ring_buffer_commit(&rxContext->ring_buffer, count);
+        }
+        rxContext->file_samples += numSamples;
+    } else if (rxContext->gap_fill != GAP_FILL_NONE) {
+        /* the ring buffer is full: this block becomes a gap too */
+        gap_push(rxContext, sample_index, before_rotation);
+        if (rotate)
+            event_push(rxContext, STREAM_EVENT_ROTATION, ring_offset, sample_index + before_rotation, 0);
+        gap_push(rxContext, sample_index + before_rotation, numSamples - before_rotation);
+    } else if (rotate) {
+        event_push(rxContext, STREAM_EVENT_ROTATION, ring_offset, sample_index, 0);
+    }
+    if (rotate)
+        atomic_store_explicit(&rxContext->rotation_target, ROTATION_NONE, memory_order_relaxed);
+    atomic_store_explicit(&rxContext->last_sample_index, sample_index + numSamples, memory_order_relaxed);
+
+    histogram_record(&rxContext->histograms[RX_METRIC_CALLBACK_TIME], monotonic_ns() - start_ns);
+}
+
+static void *writer_thread(void *arg)
+{
+    RXContext *rxContext = (RXContext *)arg;
+    RingBuffer *ring_buffer = &rxContext->ring_buffer;
+    const struct timespec poll_interval = { 0, WRITER_POLL_INTERVAL_NS };
+    /* bytes at the start of the ring buffer already demodulated (if a
+     * write was partial) */
+    size_t demodulated = 0;
+    /* the disk writes go in large batches; the demodulator alone takes
+     * whatever there is, to keep the audio latency low */
+    size_t batch_size = rxContext->output != NULL ? WRITER_BATCH_SIZE : 1;
+    /* with the squelch trigger nothing is written until the first segment */
+    int recording = rxContext->trigger == NULL;
+
+    while (1) {
+        int stop = atomic_load(&rxContext->writer_stop);
+        if (rxContext->output != NULL && (rxContext->output->engine == OUTPUT_ENGINE_MMAP || rxContext->output->engine == OUTPUT_ENGINE_PIPE)) {
+            /* keep the next window of the file mapped ahead of the callback
+             * (or move the full buffers into the pipe) */
+            if (stop)
+                break;
+            if (output_service(rxContext->output) == -1)
+                fprintf(stderr, "RX %s%c - output %s failed: %s\n", rxContext->device_prefix, rxContext->rx_id, rxContext->output->engine == OUTPUT_ENGINE_PIPE ? "vmsplice()" : "window mapping", strerror(errno));
+            nanosleep(&poll_interval, NULL);
+            continue;
+        }
+        if (!recording) {
+            if (pre_trigger_service(rxContext, &recording, &demodulated) == 0) {
+                if (stop)
+                    break;
+                nanosleep(&poll_interval, NULL);
+            }
+            continue;
+        }
+        const void *data;
+        size_t available = ring_buffer_read_ptr(ring_buffer, &data);
+        /* with a gap, a rotation, the end of a segment, or a retune
+         * pending, write what comes before it, then fill the gap, switch
+         * to the next file, stop recording, or log the new frequency (an
+         * event that ended up behind the tail takes effect right away) */
+        const StreamEvent *event = NULL;
+        if (rxContext->event_ring_buffer.buffer != NULL) {
+            const void *ptr;
+            if (ring_buffer_read_ptr(&rxContext->event_ring_buffer, &ptr) >= sizeof(StreamEvent)) {
+                event = (const StreamEvent *)ptr;
+                int64_t before_event = event->ring_offset - atomic_load(&ring_buffer->tail);
+                if (before_event <= 0) {
+                    if (event->type == STREAM_EVENT_GAP) {
+                        gap_write(rxContext, event);
+                    } else if (event->type == STREAM_EVENT_ROTATION) {
+                        output_rotate(rxContext, event);
+                    } else if (event->type == STREAM_EVENT_TRIGGER_CLOSE) {
+                        trigger_log(rxContext, "stop", event->sample_index);
+                        recording = 0;
+                    } else if (event->type == STREAM_EVENT_RETUNE) {
+                        hop_log(rxContext, event);
+                    }
+                    /* a segment start here was already taken care of */
+                    ring_buffer_release(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+                    continue;
+                }
+                if (available > (size_t)before_event)
+                    available = before_event;
+            }
+        }
+        /* wait until there is enough for a large batch, unless stopping
+         * (or there is an event to get to) */
+        if (available < batch_size && !((stop || event != NULL) && available > 0)) {
+            if (stop)
+                break;
+            nanosleep(&poll_interval, NULL);
+            continue;
+        }
+        if (rxContext->nbfm != NULL && available > demodulated) {
+            nbfm_write(rxContext, (const char *)data + demodulated, available - demodulated);
+            demodulated = available;
+        }
+        ssize_t nwritten;
+        uint64_t start_ns = monotonic_ns();
+        if (rxContext->output == NULL) {
+            nwritten = available;
+        } else if (rxContext->ddc != NULL) {
+            nwritten = ddc_write(rxContext, data, available);
+        } else if (rxContext->compress_buffer != NULL || rxContext->format_buffer != NULL) {
+            samples_write(rxContext, (const short *)data, available / (2 * sizeof(short)));
+            nwritten = available;
+        } else {
+            nwritten = output_write(rxContext->output, data, available);
+        }
+        if (rxContext->output != NULL) {
+            histogram_record(&rxContext->histograms[RX_METRIC_WRITE_LATENCY], monotonic_ns() - start_ns);
+            atomic_store_explicit(&rxContext->output_bytes, rxContext->output->size, memory_order_relaxed);
+        }
         if (nwritten == -1) {
-            fprintf(stderr, "RX %c - write() failed: %s\n", rxContext->rx_id, strerror(errno));
-        } else if ((size_t)nwritten != count) {
-            fprintf(stderr, "RX %c - incomplete write() - expected: %ld bytes - actual: %ld bytes\n", rxContext->rx_id, count, nwritten);
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "RX %s%c - write() failed: %s\n", rxContext->device_prefix, rxContext->rx_id, strerror(errno));
+            /* discard the data, so the callback does not stall */
+            nwritten = available;
+        }
+        ring_buffer_release(ring_buffer, nwritten);
+        demodulated -= nwritten;
+    }
+
+    struct timespec cpu_time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time);
+    rxContext->writer_cpu_time = cpu_time.tv_sec + 1e-9 * cpu_time.tv_nsec;
+    return NULL;
+}
+
+/* merge the blocks from the A and B ring buffers in the order they were
+ * received, and append them to the container */
+static void *container_writer_thread(void *arg)
+{
+    RXContext *rxContexts = (RXContext *)arg;
+    Container *container = rxContexts[0].container;
+    const struct timespec poll_interval = { 0, WRITER_POLL_INTERVAL_NS };
+
+    while (1) {
+        int stop = atomic_load(&rxContexts[0].writer_stop);
+        const ContainerBlockHeader *block_headers[2] = { NULL, NULL };
+        for (int i = 0; i < 2; i++) {
+            const void *data;
+            if (ring_buffer_read_ptr(&rxContexts[i].ring_buffer, &data) >= sizeof(ContainerBlockHeader))
+                block_headers[i] = (const ContainerBlockHeader *)data;
+        }
+        int next;
+        if (block_headers[0] != NULL && block_headers[1] != NULL) {
+            next = block_headers[1]->timestamp_ns < block_headers[0]->timestamp_ns ? 1 : 0;
+        } else if (block_headers[0] != NULL || block_headers[1] != NULL) {
+            /* the other channel may be in the middle of a callback that
+             * started earlier, so a block on its own is held back until the
+             * other side catches up, the hold time runs out, or we stop */
+            next = block_headers[0] != NULL ? 0 : 1;
+            if (!stop && monotonic_ns() - block_headers[next]->timestamp_ns < CONTAINER_HOLD_NS) {
+                nanosleep(&poll_interval, NULL);
+                continue;
+            }
+        } else {
+            if (stop)
+                break;
+            nanosleep(&poll_interval, NULL);
+            continue;
+        }
+        const ContainerBlockHeader *block_header = block_headers[next];
+        uint64_t start_ns = monotonic_ns();
+        if (container_append(container, block_header, block_header + 1) == -1)
+            fprintf(stderr, "RX %s%c - container write failed\n", rxContexts[next].device_prefix, rxContexts[next].rx_id);
+        histogram_record(&rxContexts[next].histograms[RX_METRIC_WRITE_LATENCY], monotonic_ns() - start_ns);
+        ring_buffer_release(&rxContexts[next].ring_buffer, CONTAINER_BLOCK_SIZE(block_header->num_samples));
+    }
+
+    struct timespec cpu_time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time);
+    rxContexts[0].writer_cpu_time = cpu_time.tv_sec + 1e-9 * cpu_time.tv_nsec;
+    return NULL;
+}
+
+/* callback side: queue an event for the writer thread */
+static void event_push(RXContext *rxContext, StreamEventType type, uint64_t ring_offset, uint64_t sample_index, uint64_t num_samples)
+{
+    StreamEvent *event = ring_buffer_write_ptr(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+    if (event == NULL) {
+        rxContext->events_lost++;
+        return;
+    }
+    event->type = type;
+    event->ring_offset = ring_offset;
+    event->sample_index = sample_index;
+    event->num_samples = num_samples;
+    ring_buffer_commit(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+}
+
+/* callback side: queue a gap at the current position in the ring buffer */
+static void gap_push(RXContext *rxContext, uint64_t sample_index, uint64_t num_samples)
+{
+    if (num_samples == 0)
+        return;
+    event_push(rxContext, STREAM_EVENT_GAP, atomic_load_explicit(&rxContext->ring_buffer.head, memory_order_relaxed), sample_index, num_samples);
+    rxContext->file_samples += num_samples;
+}
+
+/* callback side: queue a gap, split at a file rotation that falls in it */
+static void gap_queue(RXContext *rxContext, uint64_t sample_index, uint64_t num_samples)
+{
+    uint64_t gap_end = sample_index + num_samples;
+    uint64_t rotation_target = atomic_load_explicit(&rxContext->rotation_target, memory_order_acquire);
+    if (rotation_target >= sample_index && rotation_target < gap_end) {
+        gap_push(rxContext, sample_index, rotation_target - sample_index);
+        event_push(rxContext, STREAM_EVENT_ROTATION, atomic_load_explicit(&rxContext->ring_buffer.head, memory_order_relaxed), rotation_target, 0);
+        atomic_store_explicit(&rxContext->rotation_target, ROTATION_NONE, memory_order_relaxed);
+        gap_push(rxContext, rotation_target, gap_end - rotation_target);
+    } else {
+        gap_push(rxContext, sample_index, num_samples);
+    }
+}
+
+/* the number of samples written so far to the current output file (before
+ * compression or conversion) */
+static unsigned long long output_position(const RXContext *rxContext)
+{
+    if (rxContext->compress_buffer != NULL)
+        return rxContext->compress_input_bytes / (2 * sizeof(short));
+    return (unsigned long long)rxContext->output->size / sample_format_size(rxContext->sample_format);
+}
+
+/* writer side: fill the gap and log it; the DDC gets zeros (its state
+ * has to follow the gap), the compressor gets the fill samples (which
+ * take almost no space), and large runs of zeros become holes in the file */
+static void gap_write(RXContext *rxContext, const StreamEvent *gap)
+{
+    unsigned long long output_sample = output_position(rxContext);
+    const char *method = "samples";
+    uint64_t remaining = gap->num_samples;
+    unsigned int max_samples = WRITER_BATCH_SIZE / (2 * sizeof(short));
+    size_t sample_size = sample_format_size(rxContext->sample_format);
+    if (rxContext->ddc == NULL && rxContext->compress_buffer == NULL && rxContext->gap_fill == GAP_FILL_ZERO && remaining * sample_size >= GAP_HOLE_MIN_SIZE) {
+        if (output_skip(rxContext->output, remaining * sample_size) == 0) {
+            method = "hole";
+            remaining = 0;
+        } else {
+            fprintf(stderr, "RX %s%c - output_skip() failed: %s\n", rxContext->device_prefix, rxContext->rx_id, strerror(errno));
+        }
+    }
+    while (remaining > 0) {
+        unsigned int n = remaining < max_samples ? remaining : max_samples;
+        if (rxContext->ddc != NULL) {
+            ddc_write(rxContext, rxContext->gap_buffer, n * 2 * sizeof(short));
+        } else {
+            samples_write(rxContext, rxContext->gap_buffer, n);
+        }
+        remaining -= n;
+    }
+    fprintf(rxContext->gap_log, "%llu %llu %llu %s\n", output_sample, (unsigned long long)gap->sample_index, (unsigned long long)gap->num_samples, method);
+}
+
+/* writer side: switch to the next output file (opened ahead of time by
+ * the rotation thread), and hand the old one over to the rotation thread
+ * to be closed, so the writer thread does not wait for the flush */
+static void output_rotate(RXContext *rxContext, const StreamEvent *rotation)
+{
+    Output *next_output = atomic_exchange(&rxContext->next_output, NULL);
+    if (next_output == NULL) {
+        fprintf(stderr, "RX %s%c - next output file not ready - rotation skipped\n", rxContext->device_prefix, rxContext->rx_id);
+        return;
+    }
+    if (rxContext->compress_buffer != NULL) {
+        IQCompressHeader header;
+        iq_compress_header(&header);
+        if (output_write(next_output, &header, sizeof(header)) != sizeof(header))
+            fprintf(stderr, "RX %s%c - compressed file header write failed\n", rxContext->device_prefix, rxContext->rx_id);
+        rxContext->compress_input_bytes = 0;
+    }
+    Output *expected = NULL;
+    if (!atomic_compare_exchange_strong(&rxContext->retired_output, &expected, rxContext->output)) {
+        /* the previous one is still waiting to be closed */
+        output_close(rxContext->output);
+    }
+    rxContext->rotated_bytes += rxContext->output->size;
+    rxContext->output = next_output;
+    atomic_store_explicit(&rxContext->output_bytes, next_output->size, memory_order_relaxed);
+    int file_number = atomic_load(&rxContext->file_number) + 1;
+    if (rxContext->gap_log != NULL)
+        fprintf(rxContext->gap_log, "# file %d starts at sample_index %llu\n", file_number, (unsigned long long)rotation->sample_index);
+    if (rxContext->hop_log != NULL)
+        fprintf(rxContext->hop_log, "# file %d starts at sample_index %llu\n", file_number, (unsigned long long)rotation->sample_index);
+    fprintf(stderr, "RX %s%c - file %d starts at sample_index=%llu\n", rxContext->device_prefix, rxContext->rx_id, file_number, (unsigned long long)rotation->sample_index);
+    atomic_store(&rxContext->file_number, file_number);
+}
+
+/* writer side, while the squelch is closed: only keep the last
+ * pre-trigger in the ring buffer (the audio is still demodulated live),
+ * until the callback queues the start of a segment; the events before
+ * the segment are dropped (except for the rotations), and the ones in
+ * it are left to the writer thread; returns 0 if there was nothing to do */
+static int pre_trigger_service(RXContext *rxContext, int *recording, size_t *demodulated)
+{
+    RingBuffer *ring_buffer = &rxContext->ring_buffer;
+    const void *data;
+    size_t available = ring_buffer_read_ptr(ring_buffer, &data);
+    size_t tail = atomic_load(&ring_buffer->tail);
+    if (rxContext->nbfm != NULL && available > *demodulated) {
+        nbfm_write(rxContext, (const char *)data + *demodulated, available - *demodulated);
+        *demodulated = available;
+    }
+
+    const void *ptr;
+    size_t num_events = ring_buffer_read_ptr(&rxContext->event_ring_buffer, &ptr) / sizeof(StreamEvent);
+    const StreamEvent *events = (const StreamEvent *)ptr;
+    const StreamEvent *open = NULL;
+    for (size_t k = 0; k < num_events && open == NULL; k++) {
+        if (events[k].type == STREAM_EVENT_TRIGGER_OPEN)
+            open = &events[k];
+    }
+    const StreamEvent *event = num_events > 0 ? &events[0] : NULL;
+    if (open != NULL && (int64_t)(event->ring_offset - open->ring_offset) >= 0)
+        event = open;
+
+    size_t excess = available > rxContext->pre_trigger_bytes ? available - rxContext->pre_trigger_bytes : 0;
+    size_t discard = excess;
+    if (event != NULL) {
+        int64_t before_event = event->ring_offset - tail;
+        if (before_event <= 0 && event == open) {
+            /* the segment starts here (or as far back as there is data) */
+            uint64_t sample_index = open->sample_index + (uint64_t)(-before_event) / (2 * sizeof(short));
+            trigger_log(rxContext, "start", sample_index);
+            rxContext->segments++;
+            *recording = 1;
+            if (open == &events[0])
+                ring_buffer_release(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+            return 1;
+        }
+        if (before_event <= 0) {
+            if (event->type == STREAM_EVENT_ROTATION)
+                output_rotate(rxContext, event);
+            ring_buffer_release(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+            return 1;
+        }
+        /* with a segment coming, get to it (or to the event before it) */
+        if (open != NULL || (size_t)before_event < discard)
+            discard = before_event;
+    }
+    if (discard > available)
+        discard = available;
+    if (discard == 0)
+        return 0;
+    ring_buffer_release(ring_buffer, discard);
+    *demodulated -= discard;
+    rxContext->discarded_bytes += discard;
+    return 1;
+}
+
+/* writer side: log the start or the end of a recorded segment */
+static void trigger_log(RXContext *rxContext, const char *what, uint64_t sample_index)
+{
+    unsigned long long output_sample = output_position(rxContext);
+    fprintf(rxContext->trigger_log, "%llu %llu %s\n", output_sample, (unsigned long long)sample_index, what);
+    fprintf(stderr, "RX %s%c - squelch %s at sample_index=%llu\n", rxContext->device_prefix, rxContext->rx_id, strcmp(what, "start") == 0 ? "open" : "closed", (unsigned long long)sample_index);
+}
+
+/* callback side, in scan mode: the first block after a retune request
+ * with rfChanged (or reset) is the first one at the new frequency; its
+ * settling starts over with a gain change before it is done; returns how
+ * many samples at the start of this block are still settling */
+static unsigned int scan_block(RXContext *rxContext, int changed, uint64_t sample_index)
+{
+    int gain_changed = atomic_exchange_explicit(&rxContext->gain_changed, 0, memory_order_relaxed);
+    uint64_t request_ns = atomic_load_explicit(&rxContext->retune_request_ns, memory_order_acquire);
+    if (changed && request_ns != 0 && atomic_compare_exchange_strong(&rxContext->retune_request_ns, &request_ns, 0)) {
+        /* a retune marker still waiting for its first sample goes first */
+        if (rxContext->retune_marker_pending)
+            retune_push(rxContext, sample_index);
+        double effective_ns = rate_estimator_time(&rxContext->rate_estimator, sample_index);
+        int64_t latency_ns = -1;
+        if (rxContext->scan_started) {
+            latency_ns = effective_ns > request_ns ? (int64_t)(effective_ns - request_ns) : 0;
+            histogram_record(&rxContext->histograms[RX_METRIC_RETUNE_LATENCY], latency_ns);
+            rxContext->hops++;
         }
+        rxContext->retune_marker.sample_index = sample_index;
+        rxContext->retune_marker.frequency = rxContext->scan_frequencies[atomic_load(&rxContext->scan_index)];
+        rxContext->retune_marker.latency_ns = latency_ns;
+        rxContext->retune_marker_pending = 1;
+        rxContext->settle_until = sample_index + rxContext->settle_samples;
+        rxContext->scan_started = 1;
+        atomic_store(&rxContext->retune_effective_ns, (uint64_t)effective_ns);
+    } else if (!rxContext->scan_started && request_ns == 0) {
+        /* the initial frequency */
+        rxContext->retune_marker.sample_index = sample_index;
+        rxContext->retune_marker.frequency = rxContext->scan_frequencies[0];
+        rxContext->retune_marker.latency_ns = -1;
+        rxContext->retune_marker_pending = 1;
+        rxContext->settle_until = sample_index;
+        rxContext->scan_started = 1;
+        atomic_store(&rxContext->retune_effective_ns, (uint64_t)rate_estimator_time(&rxContext->rate_estimator, sample_index));
+    } else if (gain_changed && rxContext->retune_marker_pending) {
+        if (sample_index + rxContext->settle_samples > rxContext->settle_until)
+            rxContext->settle_until = sample_index + rxContext->settle_samples;
+    }
+    if (rxContext->settle_until <= sample_index)
+        return 0;
+    uint64_t skip = rxContext->settle_until - sample_index;
+    return skip < UINT_MAX ? skip : UINT_MAX;
+}
+
+/* callback side: queue the retune marker, with sample_index the first
+ * sample kept at the new frequency */
+static void retune_push(RXContext *rxContext, uint64_t sample_index)
+{
+    rxContext->retune_marker_pending = 0;
+    StreamEvent *event = ring_buffer_write_ptr(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+    if (event == NULL) {
+        rxContext->events_lost++;
+        return;
+    }
+    *event = rxContext->retune_marker;
+    event->type = STREAM_EVENT_RETUNE;
+    event->ring_offset = atomic_load_explicit(&rxContext->ring_buffer.head, memory_order_relaxed);
+    event->num_samples = sample_index - rxContext->retune_marker.sample_index;
+    ring_buffer_commit(&rxContext->event_ring_buffer, sizeof(StreamEvent));
+}
+
+/* writer side: log where a new frequency starts; output_sample is the
+ * first sample kept (after the settling samples, which are either not in
+ * the output, or filled in as a gap) */
+static void hop_log(RXContext *rxContext, const StreamEvent *retune)
+{
+    unsigned long long output_sample = output_position(rxContext);
+    char latency_us[32] = "-";
+    if (retune->latency_ns >= 0)
+        snprintf(latency_us, sizeof(latency_us), "%.1lf", 1e-3 * retune->latency_ns);
+    fprintf(rxContext->hop_log, "%llu %llu %.0lf %s %llu\n", output_sample, (unsigned long long)retune->sample_index, retune->frequency, latency_us, (unsigned long long)retune->num_samples);
+}
+
+/* retune each channel with more than one frequency to the next one in its
+ * list a dwell after the first sample at the current one; the callback
+ * clears retune_request_ns when the new frequency shows up in the stream */
+static void *scan_thread(void *arg)
+{
+    ScanContext *scan_context = (ScanContext *)arg;
+    RXContext *rxContexts = scan_context->rx_contexts;
+    const struct timespec poll_interval = { 0, SCAN_POLL_INTERVAL_NS };
+    uint64_t dwell_ns = (uint64_t)(scan_context->dwell * 1e9);
+    /* the retunes requested here (only those time out) */
+    uint64_t requested_ns[MAX_CHANNELS] = { 0 };
+
+    while (!atomic_load(&scan_context->stop)) {
+        for (int i = 0; i < scan_context->num_channels; i++) {
+            RXContext *rx_context = &rxContexts[i];
+            if (rx_context->num_scan_frequencies < 2)
+                continue;
+            uint64_t now_ns = monotonic_raw_ns();
+            uint64_t request_ns = atomic_load_explicit(&rx_context->retune_request_ns, memory_order_acquire);
+            if (request_ns != 0) {
+                if (request_ns == requested_ns[i] && now_ns - request_ns > SCAN_RETUNE_TIMEOUT_NS && atomic_compare_exchange_strong(&rx_context->retune_request_ns, &request_ns, 0)) {
+                    rx_context->retune_timeouts++;
+                    fprintf(stderr, "RX %s%c - retune to %.0lf not seen in the stream - no marker\n", rx_context->device_prefix, rx_context->rx_id, rx_context->scan_frequencies[atomic_load(&rx_context->scan_index)]);
+                    atomic_store(&rx_context->retune_effective_ns, now_ns);
+                }
+                continue;
+            }
+            uint64_t effective_ns = atomic_load(&rx_context->retune_effective_ns);
+            if (effective_ns == 0 || now_ns < effective_ns + dwell_ns)
+                continue;
+            DeviceContext *device_context = &scan_context->device_contexts[i / 2];
+            sdrplay_api_RxChannelParamsT *rx_channel_params = i % 2 == 0 ? device_context->device_params->rxChannelA : device_context->device_params->rxChannelB;
+            int scan_index = (atomic_load(&rx_context->scan_index) + 1) % rx_context->num_scan_frequencies;
+            atomic_store(&rx_context->scan_index, scan_index);
+            rx_channel_params->tunerParams.rfFreq.rfHz = rx_context->scan_frequencies[scan_index];
+            requested_ns[i] = monotonic_raw_ns();
+            atomic_store_explicit(&rx_context->retune_request_ns, requested_ns[i], memory_order_release);
+            sdrplay_api_ErrT err = sdrplay_api_Update(device_context->device.dev, i % 2 == 0 ? sdrplay_api_Tuner_A : sdrplay_api_Tuner_B, sdrplay_api_Update_Tuner_Frf, sdrplay_api_Update_Ext1_None);
+            if (err != sdrplay_api_Success) {
+                /* try the next one after another dwell */
+                fprintf(stderr, "RX %s%c - sdrplay_api_Update(Frf=%.0lf) failed: %s\n", rx_context->device_prefix, rx_context->rx_id, rx_context->scan_frequencies[scan_index], sdrplay_api_GetErrorString(err));
+                uint64_t expected = requested_ns[i];
+                if (atomic_compare_exchange_strong(&rx_context->retune_request_ns, &expected, 0))
+                    atomic_store(&rx_context->retune_effective_ns, monotonic_raw_ns());
+            }
+        }
+        nanosleep(&poll_interval, NULL);
     }
+    return NULL;
+}
+
+/* run the samples through the DDC and write its output; all the input is
+ * always consumed (the DDC state cannot be rewound), so on a write error
+ * the rest of the output is discarded */
+static ssize_t ddc_write(RXContext *rxContext, const void *data, size_t count)
+{
+    const short *in = (const short *)data;
+    unsigned int remaining = count / (2 * sizeof(short));
+    unsigned int max_samples = WRITER_BATCH_SIZE / (2 * sizeof(short));
+    while (remaining > 0) {
+        /* at most max_samples / decimation + 1 output samples per call */
+        unsigned int n = remaining < max_samples - 1 ? remaining : max_samples - 1;
+        unsigned int nout = ddc_process(rxContext->ddc, in, n, rxContext->ddc_buffer);
+        in += 2 * n;
+        remaining -= n;
+        samples_write(rxContext, rxContext->ddc_buffer, nout);
+    }
+    return count;
+}
+
+/* write all the samples (compressed or converted to the output format if
+ * enabled); on a write error the rest of them is discarded */
+static void samples_write(RXContext *rxContext, const short *samples, unsigned int n)
+{
+    while (n > 0) {
+        unsigned int m = n;
+        const char *data = (const char *)samples;
+        size_t size = m * 2 * sizeof(short);
+        if (rxContext->compress_buffer != NULL) {
+            m = n < COMPRESS_CHUNK_SAMPLES ? n : COMPRESS_CHUNK_SAMPLES;
+            data = rxContext->compress_buffer;
+            size = iq_compress(samples, m, rxContext->compress_buffer);
+            rxContext->compress_input_bytes += m * 2 * sizeof(short);
+        } else if (rxContext->format_buffer != NULL) {
+            m = n < FORMAT_CHUNK_SAMPLES ? n : FORMAT_CHUNK_SAMPLES;
+            data = rxContext->format_buffer;
+            size = sample_format_convert(rxContext->sample_format, rxContext->sample_scale, samples, m, rxContext->format_buffer, &rxContext->clipped_values);
+        }
+        samples += 2 * m;
+        n -= m;
+        size_t written = 0;
+        while (written < size) {
+            ssize_t nwritten = output_write(rxContext->output, data + written, size - written);
+            if (nwritten == -1) {
+                if (errno == EINTR)
+                    continue;
+                fprintf(stderr, "RX %s%c - write() failed: %s\n", rxContext->device_prefix, rxContext->rx_id, strerror(errno));
+                break;
+            }
+            written += nwritten;
+        }
+    }
+}
+
+/* demodulate the samples straight into the audio ring buffer */
+static void nbfm_write(RXContext *rxContext, const void *data, size_t count)
+{
+    const short *in = (const short *)data;
+    unsigned int remaining = count / (2 * sizeof(short));
+    size_t max_audio_size = nbfm_max_audio_samples(rxContext->nbfm, AUDIO_INPUT_SAMPLES) * sizeof(short);
+    while (remaining > 0) {
+        unsigned int n = remaining < AUDIO_INPUT_SAMPLES ? remaining : AUDIO_INPUT_SAMPLES;
+        short *audio = ring_buffer_write_ptr(&rxContext->audio_ring_buffer, max_audio_size);
+        if (audio != NULL) {
+            unsigned int naudio = nbfm_process(rxContext->nbfm, in, n, audio);
+            ring_buffer_commit(&rxContext->audio_ring_buffer, naudio * sizeof(short));
+        } else {
+            /* the audio writer fell behind: the demodulator still has to
+             * run to keep its state, but this audio is lost */
+            nbfm_process(rxContext->nbfm, in, n, rxContext->audio_discard);
+        }
+        in += 2 * n;
+        remaining -= n;
+    }
+}
+
+/* write the audio from the demodulators: either one file per channel, or
+ * one stereo file with A and B interleaved (in A's audio_output) */
+static void *audio_writer_thread(void *arg)
+{
+    RXContext *rxContexts = (RXContext *)arg;
+    int stereo = rxContexts[1].audio_output == NULL;
+    const struct timespec poll_interval = { 0, WRITER_POLL_INTERVAL_NS };
+    short frames[2 * AUDIO_WRITER_FRAMES];
+
+    while (1) {
+        int stop = atomic_load(&rxContexts[0].audio_writer_stop);
+        size_t written = 0;
+        if (stereo) {
+            const void *data[2];
+            size_t available[2];
+            for (int i = 0; i < 2; i++)
+                available[i] = ring_buffer_read_ptr(&rxContexts[i].audio_ring_buffer, &data[i]);
+            size_t n = (available[0] < available[1] ? available[0] : available[1]) / sizeof(short);
+            if (n > AUDIO_WRITER_FRAMES)
+                n = AUDIO_WRITER_FRAMES;
+            for (size_t k = 0; k < n; k++) {
+                frames[2*k] = ((const short *)data[0])[k];
+                frames[2*k+1] = ((const short *)data[1])[k];
+            }
+            if (n > 0 && audio_output_write(rxContexts[0].audio_output, frames, n) == -1)
+                fprintf(stderr, "audio write failed\n");
+            for (int i = 0; i < 2; i++)
+                ring_buffer_release(&rxContexts[i].audio_ring_buffer, n * sizeof(short));
+            written = n;
+        } else {
+            for (int i = 0; i < 2; i++) {
+                const void *data;
+                size_t n = ring_buffer_read_ptr(&rxContexts[i].audio_ring_buffer, &data) / sizeof(short);
+                if (n > 0 && audio_output_write(rxContexts[i].audio_output, data, n) == -1)
+                    fprintf(stderr, "RX %s%c - audio write failed\n", rxContexts[i].device_prefix, rxContexts[i].rx_id);
+                ring_buffer_release(&rxContexts[i].audio_ring_buffer, n * sizeof(short));
+                written += n;
+            }
+        }
+        if (written == 0) {
+            /* in stereo, whatever is left over in only one channel at the
+             * end is dropped */
+            if (stop)
+                break;
+            nanosleep(&poll_interval, NULL);
+        }
+    }
+    return NULL;
+}
+
+static size_t tap_block_size(unsigned int num_samples)
+{
+    return sizeof(TapBlock) + ((num_samples * 2 * sizeof(short) + 7) & ~(size_t)7);
+}
+
+/* called by the stream callback: if the thread on the other side falls
+ * behind, the block is dropped (for the xcorr thread the other channel's
+ * copy of it is skipped later) */
+static void tap_push(RingBuffer *ring_buffer, uint64_t sample_index, const short *xi, const short *xq, unsigned int numSamples)
+{
+    size_t size = tap_block_size(numSamples);
+    TapBlock *block = ring_buffer_write_ptr(ring_buffer, size);
+    if (block == NULL)
+        return;
+    block->sample_index = sample_index;
+    block->num_samples = numSamples;
+    block->padding = 0;
+    short *samples = (short *)(block + 1);
+    memcpy(samples, xi, numSamples * sizeof(short));
+    memcpy(samples + numSamples, xq, numSamples * sizeof(short));
+    ring_buffer_commit(ring_buffer, size);
+}
+
+static void xcorr_log(XcorrContext *xcorr_context, const XcorrReport *report)
+{
+    if (xcorr_context->reports == 0)
+        xcorr_context->first_sample_index = report->sample_index;
+    double t = (report->sample_index - xcorr_context->first_sample_index) / xcorr_context->sample_rate;
+    fprintf(xcorr_context->log, "%llu %.6lf %.3lf %.4lf %.2lf %u\n", (unsigned long long)report->sample_index, t, report->lag, report->magnitude, report->phase, report->frames);
+    fprintf(stdout, "%sxcorr - time=%.3lfs lag=%.3lf magnitude=%.4lf phase=%.2lf\n", xcorr_context->prefix, t, report->lag, report->magnitude, report->phase);
+
+    if (xcorr_context->reports == 0) {
+        xcorr_context->lag_min = report->lag;
+        xcorr_context->lag_max = report->lag;
+        xcorr_context->unwrapped_phase = report->phase;
+    } else {
+        if (report->lag < xcorr_context->lag_min)
+            xcorr_context->lag_min = report->lag;
+        if (report->lag > xcorr_context->lag_max)
+            xcorr_context->lag_max = report->lag;
+        double delta = report->phase - xcorr_context->last_phase;
+        delta -= 360.0 * floor((delta + 180.0) / 360.0);
+        xcorr_context->unwrapped_phase += delta;
+    }
+    xcorr_context->last_phase = report->phase;
+    xcorr_context->lag_sum += report->lag;
+    xcorr_context->magnitude_sum += report->magnitude;
+    xcorr_context->sum_t += t;
+    xcorr_context->sum_p += xcorr_context->unwrapped_phase;
+    xcorr_context->sum_tt += t * t;
+    xcorr_context->sum_tp += t * xcorr_context->unwrapped_phase;
+    xcorr_context->reports++;
+}
+
+/* take the A and B blocks in sample order, skip what only one of them
+ * has (dropped samples, or blocks dropped from a full xcorr ring buffer),
+ * and feed the rest to the cross-correlation */
+static void *xcorr_thread(void *arg)
+{
+    XcorrContext *xcorr_context = (XcorrContext *)arg;
+    RXContext *rxContexts = xcorr_context->rx_contexts;
+    const struct timespec poll_interval = { 0, XCORR_POLL_INTERVAL_NS };
+    unsigned int consumed[2] = { 0, 0 };    /* samples already taken from the current blocks */
+
+    while (1) {
+        int stop = atomic_load(&xcorr_context->stop);
+        const TapBlock *blocks[2] = { NULL, NULL };
+        for (int i = 0; i < 2; i++) {
+            const void *data;
+            if (ring_buffer_read_ptr(&rxContexts[i].xcorr_ring_buffer, &data) >= sizeof(TapBlock))
+                blocks[i] = (const TapBlock *)data;
+        }
+        if (blocks[0] == NULL || blocks[1] == NULL) {
+            /* whatever is left over in only one channel at the end is dropped */
+            if (stop)
+                break;
+            nanosleep(&poll_interval, NULL);
+            continue;
+        }
+
+        uint64_t start[2];
+        uint64_t end[2];
+        for (int i = 0; i < 2; i++) {
+            start[i] = blocks[i]->sample_index + consumed[i];
+            end[i] = blocks[i]->sample_index + blocks[i]->num_samples;
+        }
+        if (start[0] != start[1]) {
+            int behind = start[0] < start[1] ? 0 : 1;
+            uint64_t until = end[behind] < start[1 - behind] ? end[behind] : start[1 - behind];
+            consumed[behind] += until - start[behind];
+            xcorr_context->skipped_samples += until - start[behind];
+        } else {
+            unsigned int n = end[0] - start[0] < end[1] - start[1] ? end[0] - start[0] : end[1] - start[1];
+            const short *a = (const short *)(blocks[0] + 1);
+            const short *b = (const short *)(blocks[1] + 1);
+            XcorrReport report;
+            int ready;
+            unsigned int taken = xcorr_process(xcorr_context->xcorr, start[0], a + consumed[0], a + blocks[0]->num_samples + consumed[0], b + consumed[1], b + blocks[1]->num_samples + consumed[1], n, &report, &ready);
+            consumed[0] += taken;
+            consumed[1] += taken;
+            if (ready)
+                xcorr_log(xcorr_context, &report);
+        }
+        for (int i = 0; i < 2; i++) {
+            if (consumed[i] == blocks[i]->num_samples) {
+                ring_buffer_release(&rxContexts[i].xcorr_ring_buffer, tap_block_size(blocks[i]->num_samples));
+                consumed[i] = 0;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void xcorr_summary(XcorrContext *xcorr_context)
+{
+    unsigned long long reports = xcorr_context->reports;
+    double lag_mean = reports > 0 ? xcorr_context->lag_sum / reports : 0.0;
+    double magnitude_mean = reports > 0 ? xcorr_context->magnitude_sum / reports : 0.0;
+    double denominator = reports * xcorr_context->sum_tt - xcorr_context->sum_t * xcorr_context->sum_t;
+    double phase_drift = reports > 1 && denominator > 0 ? (reports * xcorr_context->sum_tp - xcorr_context->sum_t * xcorr_context->sum_p) / denominator : 0.0;
+    unsigned long long tap_overflows = 0;
+    for (int i = 0; i < 2; i++)
+        tap_overflows += xcorr_context->rx_contexts[i].xcorr_ring_buffer.overruns;
+    fprintf(stderr, "%sxcorr - reports=%llu lag=%.3lf/%.3lf/%.3lf magnitude=%.4lf phase_drift_deg_per_s=%.4lf skipped_samples=%llu tap_overflows=%llu\n", xcorr_context->prefix, reports, xcorr_context->lag_min, lag_mean, xcorr_context->lag_max, magnitude_mean, phase_drift, xcorr_context->skipped_samples, tap_overflows);
+}
+
+/* called by the stream callback: the first samples of every PSD interval */
+static void psd_tap(RXContext *rxContext, uint64_t sample_index, const short *xi, const short *xq, unsigned int numSamples)
+{
+    if (sample_index >= rxContext->psd_next_sample_index) {
+        rxContext->psd_left = rxContext->psd_average_samples;
+        rxContext->psd_next_sample_index = sample_index + rxContext->psd_interval_samples;
+    }
+    if (rxContext->psd_left == 0)
+        return;
+    unsigned int n = numSamples < rxContext->psd_left ? numSamples : rxContext->psd_left;
+    tap_push(&rxContext->psd_ring_buffer, sample_index, xi, xq, n);
+    rxContext->psd_left -= n;
+}
+
+/* one thread for all the channels (at most a few frames per interval each) */
+static void *psd_thread(void *arg)
+{
+    PsdContext *psd_context = (PsdContext *)arg;
+    RXContext *rxContexts = psd_context->rx_contexts;
+    const struct timespec poll_interval = { 0, PSD_POLL_INTERVAL_NS };
+    unsigned int consumed[MAX_CHANNELS] = { 0 };
+
+    while (1) {
+        int stop = atomic_load(&psd_context->stop);
+        int busy = 0;
+        for (int i = 0; i < psd_context->num_channels; i++) {
+            RXContext *rxContext = &rxContexts[i];
+            const void *data;
+            if (ring_buffer_read_ptr(&rxContext->psd_ring_buffer, &data) < sizeof(TapBlock))
+                continue;
+            busy = 1;
+            const TapBlock *block = (const TapBlock *)data;
+            const short *samples = (const short *)(block + 1);
+            PsdReport report;
+            int ready;
+            consumed[i] += psd_process(rxContext->psd, block->sample_index + consumed[i], samples + consumed[i], samples + block->num_samples + consumed[i], block->num_samples - consumed[i], &report, &ready);
+            if (ready) {
+                struct timespec now;
+                clock_gettime(CLOCK_REALTIME, &now);
+                PsdRecord record = {
+                    .sample_index = report.sample_index,
+                    .timestamp_ns = now.tv_sec * 1000000000ULL + now.tv_nsec,
+                    .frames = report.frames
+                };
+                /* flushed right away for a live display */
+                if (fwrite(&record, sizeof(record), 1, rxContext->psd_file) != 1 ||
+                    fwrite(report.power, sizeof(float), psd_size(rxContext->psd), rxContext->psd_file) != psd_size(rxContext->psd) ||
+                    fflush(rxContext->psd_file) != 0)
+                    fprintf(stderr, "RX %s%c - PSD write failed: %s\n", rxContext->device_prefix, rxContext->rx_id, strerror(errno));
+                rxContext->psd_records++;
+            }
+            if (consumed[i] == block->num_samples) {
+                ring_buffer_release(&rxContext->psd_ring_buffer, tap_block_size(block->num_samples));
+                consumed[i] = 0;
+            }
+        }
+        if (!busy) {
+            if (stop)
+                break;
+            nanosleep(&poll_interval, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* every stats interval print the percentiles of the last interval for
+ * each channel; the dropped samples are reported (at most once a second)
+ * regardless */
+static void *stats_thread(void *arg)
+{
+    StatsContext *stats_context = (StatsContext *)arg;
+    RXContext *rxContexts = stats_context->rx_contexts;
+    const struct timespec poll_interval = { 0, STATS_POLL_INTERVAL_NS };
+    double interval = stats_context->interval > 0 ? stats_context->interval : STATS_DROPS_INTERVAL;
+    /* the histograms at the end of the previous interval (per channel),
+     * the current ones, and the difference */
+    int num_channels = stats_context->num_channels;
+    HistogramSnapshot *previous[MAX_CHANNELS];
+    for (int i = 0; i < num_channels; i++)
+        previous[i] = (HistogramSnapshot *)calloc(RX_METRICS, sizeof(HistogramSnapshot));
+    HistogramSnapshot *current = (HistogramSnapshot *)malloc(2 * RX_METRICS * sizeof(HistogramSnapshot));
+    HistogramSnapshot *delta = current + RX_METRICS;
+    unsigned long long previous_dropped_events[MAX_CHANNELS] = { 0 };
+    unsigned long long previous_dropped_samples[MAX_CHANNELS] = { 0 };
+
+    uint64_t start_ns = monotonic_ns();
+    uint64_t next_ns = start_ns + (uint64_t)(interval * 1e9);
+    while (!atomic_load(&stats_context->stop)) {
+        nanosleep(&poll_interval, NULL);
+        for (int i = 0; i < num_channels; i++)
+            anchors_write(&rxContexts[i]);
+        uint64_t now_ns = monotonic_ns();
+        if (now_ns < next_ns)
+            continue;
+        next_ns += (uint64_t)(interval * 1e9);
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rxContexts[i];
+            unsigned long long dropped_events = atomic_load(&rx_context->dropped_events);
+            unsigned long long dropped_samples = atomic_load(&rx_context->dropped_samples);
+            unsigned long long new_dropped_events = dropped_events - previous_dropped_events[i];
+            unsigned long long new_dropped_samples = dropped_samples - previous_dropped_samples[i];
+            previous_dropped_events[i] = dropped_events;
+            previous_dropped_samples[i] = dropped_samples;
+            if (stats_context->interval == 0) {
+                if (new_dropped_events > 0)
+                    fprintf(stderr, "RX %s%c - dropped %llu samples (%llu drops)\n", rx_context->device_prefix, rx_context->rx_id, new_dropped_samples, new_dropped_events);
+                continue;
+            }
+            for (int k = 0; k < RX_METRICS; k++) {
+                histogram_snapshot(&rx_context->histograms[k], &current[k]);
+                histogram_snapshot_delta(&current[k], &previous[i][k], &delta[k]);
+                previous[i][k] = current[k];
+            }
+            /* ring buffer fill level, as an early warning before the drops */
+            double ring_fill = 0.0;
+            if (rx_context->ring_buffer.buffer != NULL)
+                ring_fill = 100.0 * (atomic_load(&rx_context->ring_buffer.head) - atomic_load(&rx_context->ring_buffer.tail)) / rx_context->ring_buffer.size;
+            /* latencies as p50/p99/max over the last interval */
+            const HistogramSnapshot *callback_interval = &delta[RX_METRIC_CALLBACK_INTERVAL];
+            const HistogramSnapshot *callback_time = &delta[RX_METRIC_CALLBACK_TIME];
+            const HistogramSnapshot *write_latency = &delta[RX_METRIC_WRITE_LATENCY];
+            /* with the squelch, the loudest block (to set the threshold) */
+            char peak_power[32] = "";
+            if (rx_context->trigger != NULL)
+                snprintf(peak_power, sizeof(peak_power), " peak_power=%.1lfdBFS", trigger_power_dbfs(atomic_exchange(&rx_context->peak_power, 0), 1));
+            fprintf(stderr, "RX %s%c - stats t=%.1lfs callbacks=%llu num_samples=%llu interval_us=%.0lf/%.0lf/%.0lf callback_us=%.1lf/%.1lf/%.1lf write_ms=%.2lf/%.2lf/%.2lf ring_fill=%.1lf%% drops=%llu dropped_samples=%llu%s\n",
+                    rx_context->device_prefix, rx_context->rx_id, 1e-9 * (now_ns - start_ns),
+                    (unsigned long long)callback_time->total_count,
+                    (unsigned long long)histogram_percentile(&delta[RX_METRIC_NUM_SAMPLES], 50.0),
+                    1e-3 * histogram_percentile(callback_interval, 50.0), 1e-3 * histogram_percentile(callback_interval, 99.0), 1e-3 * histogram_max(callback_interval),
+                    1e-3 * histogram_percentile(callback_time, 50.0), 1e-3 * histogram_percentile(callback_time, 99.0), 1e-3 * histogram_max(callback_time),
+                    1e-6 * histogram_percentile(write_latency, 50.0), 1e-6 * histogram_percentile(write_latency, 99.0), 1e-6 * histogram_max(write_latency),
+                    ring_fill, new_dropped_events, new_dropped_samples, peak_power);
+        }
+    }
+
+    /* the callbacks are done by now: write out the last anchors */
+    for (int i = 0; i < num_channels; i++)
+        anchors_write(&rxContexts[i]);
+
+    for (int i = 0; i < num_channels; i++)
+        free(previous[i]);
+    free(current);
+    return NULL;
+}
+
+static void anchors_write(RXContext *rxContext)
+{
+    if (rxContext->anchor_file == NULL)
+        return;
+    const void *data;
+    size_t available = ring_buffer_read_ptr(&rxContext->anchor_ring_buffer, &data);
+    if (available == 0)
+        return;
+    if (fwrite(data, 1, available, rxContext->anchor_file) != available)
+        fprintf(stderr, "RX %s%c - anchor file write failed: %s\n", rxContext->device_prefix, rxContext->rx_id, strerror(errno));
+    ring_buffer_release(&rxContext->anchor_ring_buffer, available);
+}
+
+/* the whole run for one channel as a JSON object */
+static void stats_json(FILE *fp, const RXContext *rxContext, double actual_sample_rate)
+{
+    fprintf(fp, "{\"serial_number\": \"%s\", \"rx_id\": \"%c\", \"total_samples\": %llu, \"actual_sample_rate\": %.3lf, \"fit_residual_ns\": %.1lf, \"dropped_events\": %llu, \"dropped_samples\": %llu", rxContext->serial_number, rxContext->rx_id, rxContext->total_samples, actual_sample_rate, rate_estimator_residual(&rxContext->rate_estimator), atomic_load(&rxContext->dropped_events), atomic_load(&rxContext->dropped_samples));
+    if (rxContext->ring_buffer.buffer != NULL) {
+        const RingBuffer *ring_buffer = &rxContext->ring_buffer;
+        fprintf(fp, ", \"ring_buffer\": {\"size\": %zu, \"high_water_mark\": %zu, \"overruns\": %llu, \"overrun_bytes\": %llu}", ring_buffer->size, ring_buffer->high_water_mark, ring_buffer->overruns, ring_buffer->overrun_bytes);
+    }
+    if (rxContext->scan_frequencies != NULL)
+        fprintf(fp, ", \"scan\": {\"hops\": %llu, \"settling_samples\": %llu, \"retune_timeouts\": %llu}", rxContext->hops, rxContext->settle_discarded, rxContext->retune_timeouts);
+    HistogramSnapshot *snapshot = (HistogramSnapshot *)malloc(sizeof(HistogramSnapshot));
+    for (int k = 0; k < RX_METRICS; k++) {
+        histogram_snapshot(&rxContext->histograms[k], snapshot);
+        fprintf(fp, ", \"%s\": ", rx_metric_names[k]);
+        histogram_json(snapshot, fp);
+    }
+    free(snapshot);
+    fprintf(fp, "}");
+}
+
+/* open the next files ahead of time, and close the retired ones; when it
+ * is time to rotate (by size or at a wall clock boundary), pick a sample
+ * number a little ahead of both channels for the callbacks */
+static void *rotation_thread(void *arg)
+{
+    RotationContext *rotation_context = (RotationContext *)arg;
+    RXContext *rxContexts = rotation_context->rx_contexts;
+    int num_channels = rotation_context->num_channels;
+    const struct timespec poll_interval = { 0, ROTATION_POLL_INTERVAL_NS };
+    int rotations = 0;
+    double next_boundary = 0.0;
+    if (rotation_context->interval > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        next_boundary = ((long long)now.tv_sec / rotation_context->interval + 1) * (double)rotation_context->interval;
+    }
+
+    while (!atomic_load(&rotation_context->stop)) {
+        int ready = 1;
+        for (int i = 0; i < num_channels; i++) {
+            RXContext *rx_context = &rxContexts[i];
+            Output *retired_output = atomic_exchange(&rx_context->retired_output, NULL);
+            if (retired_output != NULL)
+                output_close(retired_output);
+            /* the previous rotation is done: get the next file ready */
+            if (atomic_load(&rx_context->file_number) == rotations && atomic_load(&rx_context->next_output) == NULL)
+                atomic_store(&rx_context->next_output, rotation_open(rotation_context, i, rotations + 1));
+            if (atomic_load(&rx_context->file_number) != rotations || atomic_load(&rx_context->next_output) == NULL || atomic_load(&rx_context->last_sample_index) == ROTATION_NONE)
+                ready = 0;
+        }
+        double lead_time = -1.0;
+        for (int i = 0; i < num_channels; i++)
+            if (rotation_context->size > 0 && atomic_load(&rxContexts[i].output_bytes) >= rotation_context->size_thresholds[i])
+                lead_time = ROTATION_LEAD_TIME;
+        if (rotation_context->interval > 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            double time_to_boundary = next_boundary - (now.tv_sec + 1e-9 * now.tv_nsec);
+            if (time_to_boundary <= 1.0) {
+                lead_time = time_to_boundary > ROTATION_LEAD_TIME ? time_to_boundary : ROTATION_LEAD_TIME;
+                if (ready) {
+                    while (next_boundary - (now.tv_sec + 1e-9 * now.tv_nsec) <= 1.0)
+                        next_boundary += rotation_context->interval;
+                }
+            }
+        }
+        if (ready && lead_time >= 0) {
+            /* the same sample number for both channels of each RSPduo
+             * (unless their sample rates are different); all the RSPduo's
+             * rotate together, but each has its own sample numbers */
+            uint64_t rotation_targets[MAX_CHANNELS];
+            for (int i = 0; i < num_channels; i++)
+                rotation_targets[i] = atomic_load(&rxContexts[i].last_sample_index) + (uint64_t)(lead_time * rotation_context->sample_rates[i]);
+            for (int i = 0; i < num_channels; i += 2) {
+                if (rotation_context->sample_rates[i] == rotation_context->sample_rates[i + 1]) {
+                    if (rotation_targets[i + 1] > rotation_targets[i])
+                        rotation_targets[i] = rotation_targets[i + 1];
+                    rotation_targets[i + 1] = rotation_targets[i];
+                }
+            }
+            rotations++;
+            for (int i = 0; i < num_channels; i++)
+                atomic_store_explicit(&rxContexts[i].rotation_target, rotation_targets[i], memory_order_release);
+        }
+        nanosleep(&poll_interval, NULL);
+    }
+
+    for (int i = 0; i < num_channels; i++) {
+        RXContext *rx_context = &rxContexts[i];
+        Output *retired_output = atomic_exchange(&rx_context->retired_output, NULL);
+        if (retired_output != NULL)
+            output_close(retired_output);
+        Output *next_output = atomic_exchange(&rx_context->next_output, NULL);
+        if (next_output != NULL) {
+            output_close(next_output);
+            char filename[MAX_PATH_SIZE];
+            sequence_filename(filename, MAX_PATH_SIZE, rotation_context->filenames[i], atomic_load(&rx_context->file_number) + 1);
+            unlink(filename);
+        }
+    }
+    return NULL;
+}
+
+static Output *rotation_open(RotationContext *rotation_context, int i, int file_number)
+{
+    char filename[MAX_PATH_SIZE];
+    sequence_filename(filename, MAX_PATH_SIZE, rotation_context->filenames[i], file_number);
+    return output_open(filename, rotation_context->output_engine, rotation_context->preallocate_sizes[i]);
+}
+
+/* add the file number before the extension (if there is one) */
+static void sequence_filename(char *sequenced, size_t size, const char *filename, int file_number)
+{
+    const char *basename = strrchr(filename, '/');
+    basename = basename != NULL ? basename + 1 : filename;
+    const char *extension = strrchr(basename, '.');
+    if (extension == NULL || extension == basename)
+        extension = basename + strlen(basename);
+    char sequence[16];
+    snprintf(sequence, sizeof(sequence), ROTATION_SEQUENCE_FORMAT, file_number);
+    snprintf(sequenced, size, "%.*s%s%s", (int)(extension - filename), filename, sequence, extension);
+}
+
+/* replace '%c' with the channel id and 'SERIAL' with the serial number */
+static void channel_filename(char *filename, size_t size, const char *format, char rx_id, const char *serial_number)
+{
+    char channel_format[MAX_PATH_SIZE];
+    snprintf(channel_format, MAX_PATH_SIZE, format, rx_id);
+    const char *serial_string = "SERIAL";
+    char *p = strstr(channel_format, serial_string);
+    if (p == NULL) {
+        snprintf(filename, size, "%s", channel_format);
+        return;
+    }
+    snprintf(filename, size, "%.*s%s%s", (int)(p - channel_format), channel_format, serial_number, p + strlen(serial_string));
+}
+
+/* the sample ring buffers are backed by huge pages in real-time mode */
+static int sample_ring_buffer_init(RingBuffer *ring_buffer, size_t size, RealtimeStatus *realtime_status)
+{
+    if (realtime_status->priority == 0)
+        return ring_buffer_init(ring_buffer, size);
+    if (ring_buffer_init_huge_pages(ring_buffer, size) == -1)
+        return -1;
+    realtime_status->ring_buffers++;
+    if (ring_buffer->huge_pages)
+        realtime_status->huge_page_ring_buffers++;
+    return 0;
+}
+
+static void writer_affinity(RXContext *rxContext, pthread_t thread)
+{
+    if (rxContext->cpu < 0)
+        return;
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(rxContext->cpu, &cpu_set);
+    int ret = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+    if (ret != 0) {
+        fprintf(stderr, "RX %s%c - pthread_setaffinity_np(%d) failed: %s\n", rxContext->device_prefix, rxContext->rx_id, rxContext->cpu, strerror(ret));
+        return;
+    }
+    fprintf(stdout, "RX %s%c - writer thread cpu=%d\n", rxContext->device_prefix, rxContext->rx_id, rxContext->cpu);
+}
+
+/* print the settings of an RSPduo after sdrplay_api_Init(), and check
+ * that they are the ones that were set */
+static int device_check(const DeviceContext *device_context, const ChannelParam *channel_params, int num_channel_params, double rspduo_sample_rate)
+{
+    const sdrplay_api_DeviceT *device = &device_context->device;
+    const sdrplay_api_DeviceParamsT *device_params = device_context->device_params;
+    const sdrplay_api_RxChannelParamsT *rx_channelA_params = device_params->rxChannelA;
+    const sdrplay_api_RxChannelParamsT *rx_channelB_params = device_params->rxChannelB;
+
+    /* print settings */
+    fprintf(stdout, "SerNo=%s hwVer=%d tuner=0x%02x rspDuoMode=0x%02x rspDuoSampleFreq=%.0lf\n", device->SerNo, device->hwVer, device->tuner, device->rspDuoMode, device->rspDuoSampleFreq);
+    fprintf(stdout, "RX %sA - LO=%.0lf BW=%d If=%d Dec=%d IFagc=%d IFgain=%d LNAgain=%d\n", device_context->prefix, rx_channelA_params->tunerParams.rfFreq.rfHz, rx_channelA_params->tunerParams.bwType, rx_channelA_params->tunerParams.ifType, rx_channelA_params->ctrlParams.decimation.decimationFactor, rx_channelA_params->ctrlParams.agc.enable, rx_channelA_params->tunerParams.gain.gRdB, rx_channelA_params->tunerParams.gain.LNAstate);
+    fprintf(stdout, "RX %sA - DCenable=%d IQenable=%d dcCal=%d speedUp=%d trackTime=%d refreshRateTime=%d\n", device_context->prefix, (int)(rx_channelA_params->ctrlParams.dcOffset.DCenable), (int)(rx_channelA_params->ctrlParams.dcOffset.IQenable), (int)(rx_channelA_params->tunerParams.dcOffsetTuner.dcCal), (int)(rx_channelA_params->tunerParams.dcOffsetTuner.speedUp), rx_channelA_params->tunerParams.dcOffsetTuner.trackTime, rx_channelA_params->tunerParams.dcOffsetTuner.refreshRateTime);
+    fprintf(stdout, "RX %sB - LO=%.0lf BW=%d If=%d Dec=%d IFagc=%d IFgain=%d LNAgain=%d\n", device_context->prefix, rx_channelB_params->tunerParams.rfFreq.rfHz, rx_channelB_params->tunerParams.bwType, rx_channelB_params->tunerParams.ifType, rx_channelB_params->ctrlParams.decimation.decimationFactor, rx_channelB_params->ctrlParams.agc.enable, rx_channelB_params->tunerParams.gain.gRdB, rx_channelB_params->tunerParams.gain.LNAstate);
+    fprintf(stdout, "RX %sB - DCenable=%d IQenable=%d dcCal=%d speedUp=%d trackTime=%d refreshRateTime=%d\n", device_context->prefix, (int)(rx_channelB_params->ctrlParams.dcOffset.DCenable), (int)(rx_channelB_params->ctrlParams.dcOffset.IQenable), (int)(rx_channelB_params->tunerParams.dcOffsetTuner.dcCal), (int)(rx_channelB_params->tunerParams.dcOffsetTuner.speedUp), rx_channelB_params->tunerParams.dcOffsetTuner.trackTime, rx_channelB_params->tunerParams.dcOffsetTuner.refreshRateTime);
+
+    int init_ok = 1;
+    if (device->tuner != sdrplay_api_Tuner_Both) {
+        fprintf(stderr, "unexpected change - tuner: 0x%02x -> 0x%02x\n", sdrplay_api_Tuner_Both, device->tuner);
+        init_ok = 0;
+    }
+    if (device->rspDuoMode != sdrplay_api_RspDuoMode_Dual_Tuner) {
+        fprintf(stderr, "unexpected change - rspDuoMode: 0x%02x -> 0x%02x\n", sdrplay_api_RspDuoMode_Dual_Tuner, device->rspDuoMode);
+        init_ok = 0;
+    }
+    if (device->rspDuoSampleFreq != rspduo_sample_rate) {
+        fprintf(stderr, "unexpected change - rspDuoSampleFreq: %.0lf -> %.0lf\n", rspduo_sample_rate, device->rspDuoSampleFreq);
+        init_ok = 0;
+    }
+    if (device_params->devParams->fsFreq.fsHz != rspduo_sample_rate) {
+        fprintf(stderr, "unexpected change - fsHz: %.0lf -> %.0lf\n", rspduo_sample_rate, device_params->devParams->fsFreq.fsHz);
+        init_ok = 0;
+    }
+    if (channel_params_verify(channel_params, num_channel_params, rx_channelA_params, 0, device_context->prefix, stderr) > 0)
+        init_ok = 0;
+    if (channel_params_verify(channel_params, num_channel_params, rx_channelB_params, 1, device_context->prefix, stderr) > 0)
+        init_ok = 0;
+    return init_ok;
+}
+
+/* before sdrplay_api_Close() on the error paths */
+static void release_devices(DeviceContext *device_contexts, int num_devices)
+{
+    for (int d = 0; d < num_devices; d++)
+        sdrplay_api_ReleaseDevice(&device_contexts[d].device);
+}
+
+static void stop_handler(int signum)
+{
+    UNUSED(signum);
+    stop_requested = 1;
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t monotonic_raw_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double output_sample_rate(double rspduo_sample_rate, sdrplay_api_If_kHzT if_frequency, int decimation)
+{
+    /* in dual tuner mode with a low IF the RSPduo output is always 2MHz */
+    double sample_rate = if_frequency == sdrplay_api_IF_Zero ? rspduo_sample_rate : 2e6;
+    return sample_rate / (decimation > 1 ? decimation : 1);
 }
@@ -0,0 +1,118 @@
+/* radix-2 complex FFT
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fft.h"
+
+struct Fft {
+    unsigned int size;
+    unsigned int *bit_reversed;
+    float *cos_table;          /* size / 2 twiddle factors */
+    float *sin_table;
+};
+
+static void fft_transform(const Fft *fft, float *re, float *im, float sign);
+
+
+Fft *fft_create(unsigned int size)
+{
+    if (size < 2 || (size & (size - 1)) != 0) {
+        fprintf(stderr, "invalid FFT size: %u (must be a power of two)\n", size);
+        return NULL;
+    }
+    Fft *fft = (Fft *)malloc(sizeof(Fft));
+    fft->size = size;
+    fft->bit_reversed = (unsigned int *)malloc(size * sizeof(unsigned int));
+    fft->cos_table = (float *)malloc(size / 2 * sizeof(float));
+    fft->sin_table = (float *)malloc(size / 2 * sizeof(float));
+    int bits = 0;
+    while ((1U << bits) < size)
+        bits++;
+    for (unsigned int i = 0; i < size; i++) {
+        unsigned int r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        fft->bit_reversed[i] = r;
+    }
+    for (unsigned int k = 0; k < size / 2; k++) {
+        fft->cos_table[k] = (float)cos(2.0 * M_PI * k / size);
+        fft->sin_table[k] = (float)sin(2.0 * M_PI * k / size);
+    }
+    return fft;
+}
+
+void fft_free(Fft *fft)
+{
+    if (fft == NULL)
+        return;
+    free(fft->bit_reversed);
+    free(fft->cos_table);
+    free(fft->sin_table);
+    free(fft);
+}
+
+unsigned int fft_size(const Fft *fft)
+{
+    return fft->size;
+}
+
+void fft_forward(const Fft *fft, float *re, float *im)
+{
+    fft_transform(fft, re, im, -1.0f);
+}
+
+void fft_inverse(const Fft *fft, float *re, float *im)
+{
+    fft_transform(fft, re, im, 1.0f);
+}
+
+double fft_hann_window(float *window, unsigned int n)
+{
+    double sum = 0.0;
+    for (unsigned int i = 0; i < n; i++) {
+        window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / n));
+        sum += window[i];
+    }
+    return sum;
+}
+
+/* iterative decimation in time: bit reversal permutation, then log2(size)
+ * passes of butterflies; the twiddle factor for span 'half' is entry
+ * k * (size / (2 * half)) of the tables */
+static void fft_transform(const Fft *fft, float *re, float *im, float sign)
+{
+    unsigned int size = fft->size;
+    for (unsigned int i = 0; i < size; i++) {
+        unsigned int j = fft->bit_reversed[i];
+        if (j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (unsigned int half = 1; half < size; half <<= 1) {
+        unsigned int stride = size / (2 * half);
+        for (unsigned int start = 0; start < size; start += 2 * half) {
+            for (unsigned int k = 0; k < half; k++) {
+                float wr = fft->cos_table[k * stride];
+                float wi = sign * fft->sin_table[k * stride];
+                unsigned int a = start + k;
+                unsigned int b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
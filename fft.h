@@ -0,0 +1,32 @@
+/* radix-2 complex FFT
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _FFT_H
+#define _FFT_H
+
+/* the twiddle factors and the bit reversal permutation for one size; it is
+ * not changed by the transforms, so one can be shared by several threads */
+typedef struct Fft Fft;
+
+/* returns NULL (after printing the reason) if size is not a power of two */
+Fft *fft_create(unsigned int size);
+void fft_free(Fft *fft);
+unsigned int fft_size(const Fft *fft);
+
+/* in place transforms of the complex samples with the real parts in re[]
+ * and the imaginary parts in im[] (like ddc_process_float()); neither of
+ * them is normalized, so fft_inverse(fft_forward(x)) is size * x */
+void fft_forward(const Fft *fft, float *re, float *im);
+void fft_inverse(const Fft *fft, float *re, float *im);
+
+/* a Hann window of n points; returns the sum of its coefficients (to
+ * normalize the power spectra) */
+double fft_hann_window(float *window, unsigned int n);
+
+#endif /* _FFT_H */
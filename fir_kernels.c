@@ -0,0 +1,156 @@
+/* vectorized FIR filter kernels and filter design
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIR_KERNELS_X86
+#endif
+
+#include "fir_kernels.h"
+
+static float dot_scalar(const float *taps, const float *x, unsigned int n);
+static void dot2_scalar(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq);
+#ifdef FIR_KERNELS_X86
+static float dot_sse2(const float *taps, const float *x, unsigned int n);
+static void dot2_sse2(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq);
+static float dot_avx2(const float *taps, const float *x, unsigned int n);
+static void dot2_avx2(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq);
+#endif
+
+FirDotFn fir_dot = dot_scalar;
+FirDot2Fn fir_dot2 = dot2_scalar;
+const char *fir_kernel_name = "scalar";
+
+
+void fir_kernels_init(void)
+{
+#ifdef FIR_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        fir_dot = dot_avx2;
+        fir_dot2 = dot2_avx2;
+        fir_kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        fir_dot = dot_sse2;
+        fir_dot2 = dot2_sse2;
+        fir_kernel_name = "sse2";
+    }
+#endif
+}
+
+void fir_lowpass(float *taps, int num_taps, double cutoff, double gain)
+{
+    double *h = (double *)malloc(num_taps * sizeof(double));
+    double sum = 0.0;
+    int m = num_taps / 2;
+    for (int k = 0; k < num_taps; k++) {
+        double x = 2 * cutoff * (k - m);
+        double sinc = k == m ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        double window = num_taps == 1 ? 1.0 : 0.42 - 0.5 * cos(2 * M_PI * k / (num_taps - 1)) + 0.08 * cos(4 * M_PI * k / (num_taps - 1));
+        h[k] = sinc * window;
+        sum += h[k];
+    }
+    for (int k = 0; k < num_taps; k++)
+        taps[k] = (float)(gain * h[k] / sum);
+    free(h);
+}
+
+int fir_lowpass_num_taps(double transition)
+{
+    return ((int)ceil(5.5 / transition)) | 1;
+}
+
+
+static float dot_scalar(const float *taps, const float *x, unsigned int n)
+{
+    float s = 0.0f;
+    for (unsigned int k = 0; k < n; k++)
+        s += taps[k] * x[k];
+    return s;
+}
+
+static void dot2_scalar(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq)
+{
+    float si = 0.0f;
+    float sq = 0.0f;
+    for (unsigned int k = 0; k < n; k++) {
+        si += taps[k] * xi[k];
+        sq += taps[k] * xq[k];
+    }
+    *yi = si;
+    *yq = sq;
+}
+
+#ifdef FIR_KERNELS_X86
+__attribute__((target("sse2")))
+static float hsum_ps(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+/* n is a multiple of 8 in all the following */
+__attribute__((target("sse2")))
+static float dot_sse2(const float *taps, const float *x, unsigned int n)
+{
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    for (unsigned int k = 0; k < n; k += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(taps + k), _mm_loadu_ps(x + k)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(taps + k + 4), _mm_loadu_ps(x + k + 4)));
+    }
+    return hsum_ps(_mm_add_ps(s0, s1));
+}
+
+__attribute__((target("sse2")))
+static void dot2_sse2(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq)
+{
+    __m128 si0 = _mm_setzero_ps();
+    __m128 si1 = _mm_setzero_ps();
+    __m128 sq0 = _mm_setzero_ps();
+    __m128 sq1 = _mm_setzero_ps();
+    for (unsigned int k = 0; k < n; k += 8) {
+        __m128 t0 = _mm_loadu_ps(taps + k);
+        __m128 t1 = _mm_loadu_ps(taps + k + 4);
+        si0 = _mm_add_ps(si0, _mm_mul_ps(t0, _mm_loadu_ps(xi + k)));
+        si1 = _mm_add_ps(si1, _mm_mul_ps(t1, _mm_loadu_ps(xi + k + 4)));
+        sq0 = _mm_add_ps(sq0, _mm_mul_ps(t0, _mm_loadu_ps(xq + k)));
+        sq1 = _mm_add_ps(sq1, _mm_mul_ps(t1, _mm_loadu_ps(xq + k + 4)));
+    }
+    *yi = hsum_ps(_mm_add_ps(si0, si1));
+    *yq = hsum_ps(_mm_add_ps(sq0, sq1));
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float *taps, const float *x, unsigned int n)
+{
+    __m256 s = _mm256_setzero_ps();
+    for (unsigned int k = 0; k < n; k += 8)
+        s = _mm256_fmadd_ps(_mm256_loadu_ps(taps + k), _mm256_loadu_ps(x + k), s);
+    return hsum_ps(_mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static void dot2_avx2(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq)
+{
+    __m256 si = _mm256_setzero_ps();
+    __m256 sq = _mm256_setzero_ps();
+    for (unsigned int k = 0; k < n; k += 8) {
+        __m256 t = _mm256_loadu_ps(taps + k);
+        si = _mm256_fmadd_ps(t, _mm256_loadu_ps(xi + k), si);
+        sq = _mm256_fmadd_ps(t, _mm256_loadu_ps(xq + k), sq);
+    }
+    *yi = hsum_ps(_mm_add_ps(_mm256_castps256_ps128(si), _mm256_extractf128_ps(si, 1)));
+    *yq = hsum_ps(_mm_add_ps(_mm256_castps256_ps128(sq), _mm256_extractf128_ps(sq, 1)));
+}
+#endif
@@ -0,0 +1,38 @@
+/* vectorized FIR filter kernels and filter design
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _FIR_KERNELS_H
+#define _FIR_KERNELS_H
+
+/* the kernels work on whole groups of this many taps: pad the taps with
+ * zeros, and make sure the data can be read that far */
+#define FIR_TAPS_PADDING 8
+
+/* dot product of the (real) taps with x[] */
+typedef float (*FirDotFn)(const float *taps, const float *x, unsigned int n);
+/* dot product of the (real) taps with the I and the Q samples at once */
+typedef void (*FirDot2Fn)(const float *taps, const float *xi, const float *xq, unsigned int n, float *yi, float *yq);
+
+/* the variants selected by fir_kernels_init() */
+extern FirDotFn fir_dot;
+extern FirDot2Fn fir_dot2;
+extern const char *fir_kernel_name;
+
+/* select the widest variant supported by this CPU (the FIR filters are
+ * compute bound, unlike the I/Q interleave); can be called more than once */
+void fir_kernels_init(void);
+
+/* windowed sinc (Blackman) low pass filter with the cutoff (-6dB) at
+ * 'cutoff' times the sample rate, and the given gain at DC; a Blackman
+ * window needs about 5.5 / transition taps (transition as a fraction of
+ * the sample rate) */
+void fir_lowpass(float *taps, int num_taps, double cutoff, double gain);
+int fir_lowpass_num_taps(double transition);
+
+#endif /* _FIR_KERNELS_H */
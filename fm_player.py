@@ -31,6 +31,7 @@ def usage():
     print('options:', file=sys.stderr)
     print('    -i <input file> - mandatory', file=sys.stderr)
     print('    -s <sample rate> - mandatory', file=sys.stderr)
+    print('    -F <input format> (\'cs16\', \'cf32\', or \'cs8\' - see the \'-O\' option of dual_tuner_recorder) - default: cs16', file=sys.stderr)
     print('    -o <frequency offset> - default: 0', file=sys.stderr)
     print('    -N (FM block: NBFM receive)', file=sys.stderr)
     print('    -D (FM block: FM demod)', file=sys.stderr)
@@ -51,6 +52,7 @@ def run_gnuradio_flowgraph(tb, wait_for_user_input):
 def main():
     input_file = None
     input_sample_rate = 0
+    input_format = 'cs16'
     frequency_offset = 0
     nbfm_receive = True
     volume = 0.3
@@ -58,7 +60,7 @@ def main():
     wait_for_user_input = False
 
     try:
-        opts, args = getopt.getopt(sys.argv[1:], 'i:s:o:NDv:f:Wh')
+        opts, args = getopt.getopt(sys.argv[1:], 'i:s:F:o:NDv:f:Wh')
     except getopt.GetoptError:
         usage()
         sys.exit(1)
@@ -67,6 +69,8 @@ def main():
             input_file = a
         elif o == '-s':
             input_sample_rate = float(a)
+        elif o == '-F':
+            input_format = a
         elif o == '-o':
             frequency_offset = float(a)
         elif o == '-N':
@@ -104,13 +108,23 @@ def main():
     ########################
     tb = gr.top_block()
 
-    file_source = blocks.file_source(gr.sizeof_short, input_file, False, 0, 0)
-
-    interleaved_short_to_complex = blocks.interleaved_short_to_complex(False, False, 32767)
-    tb.connect((file_source, 0), (interleaved_short_to_complex, 0))
-
     throttle = blocks.throttle(gr.sizeof_gr_complex, input_sample_rate, True)
-    tb.connect((interleaved_short_to_complex, 0), (throttle, 0))
+    if input_format == 'cf32':
+        file_source = blocks.file_source(gr.sizeof_gr_complex, input_file, False, 0, 0)
+        tb.connect((file_source, 0), (throttle, 0))
+    elif input_format == 'cs8':
+        file_source = blocks.file_source(gr.sizeof_char, input_file, False, 0, 0)
+        interleaved_char_to_complex = blocks.interleaved_char_to_complex(False, 127)
+        tb.connect((file_source, 0), (interleaved_char_to_complex, 0))
+        tb.connect((interleaved_char_to_complex, 0), (throttle, 0))
+    elif input_format == 'cs16':
+        file_source = blocks.file_source(gr.sizeof_short, input_file, False, 0, 0)
+        interleaved_short_to_complex = blocks.interleaved_short_to_complex(False, False, 32767)
+        tb.connect((file_source, 0), (interleaved_short_to_complex, 0))
+        tb.connect((interleaved_short_to_complex, 0), (throttle, 0))
+    else:
+        print('unsupported input format:', input_format, file=sys.stderr)
+        sys.exit(1)
 
     fir_filter_taps = firdes.low_pass(1.0, input_sample_rate, 15e3, 1.5e3, window.WIN_HAMMING, 6.76)
     if not frequency_offset:
@@ -0,0 +1,115 @@
+/* lock-free log-linear (HDR style) histograms
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include "histogram.h"
+
+static uint64_t bucket_value(unsigned int bucket);
+
+
+void histogram_init(Histogram *histogram)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+        atomic_init(&histogram->counts[i], 0);
+    atomic_init(&histogram->total_count, 0);
+    atomic_init(&histogram->sum, 0);
+}
+
+void histogram_snapshot(const Histogram *histogram, HistogramSnapshot *snapshot)
+{
+    /* the buckets are read one at a time while they are being updated, so
+     * total_count is the sum of the copied buckets (not the counter) */
+    uint64_t total_count = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        snapshot->counts[i] = atomic_load_explicit((_Atomic uint64_t *)&histogram->counts[i], memory_order_relaxed);
+        total_count += snapshot->counts[i];
+    }
+    snapshot->total_count = total_count;
+    snapshot->sum = atomic_load_explicit((_Atomic uint64_t *)&histogram->sum, memory_order_relaxed);
+}
+
+void histogram_snapshot_delta(const HistogramSnapshot *current, const HistogramSnapshot *previous, HistogramSnapshot *delta)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+        delta->counts[i] = current->counts[i] - previous->counts[i];
+    delta->total_count = current->total_count - previous->total_count;
+    delta->sum = current->sum - previous->sum;
+}
+
+uint64_t histogram_percentile(const HistogramSnapshot *snapshot, double percentile)
+{
+    if (snapshot->total_count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * snapshot->total_count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    uint64_t count = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        count += snapshot->counts[i];
+        if (count >= rank)
+            return bucket_value(i);
+    }
+    return histogram_max(snapshot);
+}
+
+uint64_t histogram_min(const HistogramSnapshot *snapshot)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (snapshot->counts[i] > 0)
+            return bucket_value(i);
+    }
+    return 0;
+}
+
+uint64_t histogram_max(const HistogramSnapshot *snapshot)
+{
+    for (int i = HISTOGRAM_BUCKETS - 1; i >= 0; i--) {
+        if (snapshot->counts[i] > 0)
+            return bucket_value(i);
+    }
+    return 0;
+}
+
+double histogram_mean(const HistogramSnapshot *snapshot)
+{
+    return snapshot->total_count > 0 ? (double)snapshot->sum / snapshot->total_count : 0.0;
+}
+
+void histogram_json(const HistogramSnapshot *snapshot, FILE *stream)
+{
+    fprintf(stream, "{\"count\": %llu, \"mean\": %.1lf, \"min\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p99.9\": %llu, \"max\": %llu, \"buckets\": [",
+            (unsigned long long)snapshot->total_count, histogram_mean(snapshot),
+            (unsigned long long)histogram_min(snapshot),
+            (unsigned long long)histogram_percentile(snapshot, 50.0),
+            (unsigned long long)histogram_percentile(snapshot, 90.0),
+            (unsigned long long)histogram_percentile(snapshot, 99.0),
+            (unsigned long long)histogram_percentile(snapshot, 99.9),
+            (unsigned long long)histogram_max(snapshot));
+    const char *separator = "";
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (snapshot->counts[i] > 0) {
+            fprintf(stream, "%s[%llu, %llu]", separator, (unsigned long long)bucket_value(i), (unsigned long long)snapshot->counts[i]);
+            separator = ", ";
+        }
+    }
+    fprintf(stream, "]}");
+}
+
+
+/* the middle of the range of values in the bucket */
+static uint64_t bucket_value(unsigned int bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+        return bucket;
+    unsigned int shift = (bucket - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_SUB_BUCKETS;
+    uint64_t sub = (bucket - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_SUB_BUCKETS;
+    uint64_t lowest = (HISTOGRAM_SUB_BUCKETS + sub) << shift;
+    return lowest + ((1ULL << shift) >> 1);
+}
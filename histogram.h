@@ -0,0 +1,73 @@
+/* lock-free log-linear (HDR style) histograms
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _HISTOGRAM_H
+#define _HISTOGRAM_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* the values below 2^HISTOGRAM_SUB_BITS have a bucket each; above that
+ * each power of two is split in 2^HISTOGRAM_SUB_BITS buckets, so any
+ * value is recorded with a relative error of at most about 3% */
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_BUCKETS + (64 - HISTOGRAM_SUB_BITS) * HISTOGRAM_SUB_BUCKETS)
+
+/* recorded from one (or more) threads while others take snapshots; the
+ * counters are only ever incremented, so no lock is needed */
+typedef struct {
+    _Atomic uint64_t counts[HISTOGRAM_BUCKETS];
+    _Atomic uint64_t total_count;
+    _Atomic uint64_t sum;
+} Histogram;
+
+/* a plain copy, to compute the statistics of an interval as the
+ * difference between two snapshots */
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total_count;
+    uint64_t sum;
+} HistogramSnapshot;
+
+void histogram_init(Histogram *histogram);
+
+static inline unsigned int histogram_bucket(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return value;
+    unsigned int magnitude = 63 - __builtin_clzll(value);
+    unsigned int shift = magnitude - HISTOGRAM_SUB_BITS;
+    return HISTOGRAM_SUB_BUCKETS + shift * HISTOGRAM_SUB_BUCKETS + ((value >> shift) - HISTOGRAM_SUB_BUCKETS);
+}
+
+/* safe to call from the stream callbacks: no locks, no system calls */
+static inline void histogram_record(Histogram *histogram, uint64_t value)
+{
+    atomic_fetch_add_explicit(&histogram->counts[histogram_bucket(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->total_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+}
+
+void histogram_snapshot(const Histogram *histogram, HistogramSnapshot *snapshot);
+/* delta = current - previous (delta may be the same as current) */
+void histogram_snapshot_delta(const HistogramSnapshot *current, const HistogramSnapshot *previous, HistogramSnapshot *delta);
+
+/* the value at the given percentile (0 to 100); 0 if empty */
+uint64_t histogram_percentile(const HistogramSnapshot *snapshot, double percentile);
+uint64_t histogram_min(const HistogramSnapshot *snapshot);
+uint64_t histogram_max(const HistogramSnapshot *snapshot);
+double histogram_mean(const HistogramSnapshot *snapshot);
+
+/* a JSON object with the count, the mean, min, max, the main percentiles,
+ * and the non empty buckets (as [value, count] pairs) */
+void histogram_json(const HistogramSnapshot *snapshot, FILE *stream);
+
+#endif /* _HISTOGRAM_H */
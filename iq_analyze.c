@@ -0,0 +1,614 @@
+/* multithreaded offline analyzer for recorded I/Q files
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "fft.h"
+
+#define MAX_PATH_SIZE 1024
+#define DEFAULT_CHUNK_SAMPLES (4 * 1024 * 1024)
+#define DEFAULT_FFT_SIZE 1024
+#define DEFAULT_CLIP_LEVEL SHRT_MAX
+#define DEFAULT_SPECTROGRAM_MIN_DB -120.0
+#define DEFAULT_SPECTROGRAM_MAX_DB 0.0
+#define FULL_SCALE 32768.0
+
+/* one recorded channel, mapped in memory; its chunks are the jobs from
+ * first_job to first_job + num_chunks - 1 */
+typedef struct {
+    char rx_id;
+    const short *samples;
+    size_t num_samples;
+    size_t mapped_size;
+    size_t first_job;
+    size_t num_chunks;
+    int spectrogram_fd;        /* -1 if not used */
+    size_t spectrogram_header_size;
+} Channel;
+
+typedef struct {
+    size_t num_samples;
+    short min_i;
+    short max_i;
+    short min_q;
+    short max_q;
+    double sum_i;              /* for the DC offset */
+    double sum_q;
+    double sum_power;          /* I^2 + Q^2 */
+    unsigned long long clipped;
+    int psd_frames;            /* 0 if the chunk is shorter than the FFT */
+    int peak_bin;              /* with the negative frequencies first */
+    double peak_db;
+    double noise_floor_db;     /* the median of the PSD */
+} ChunkStats;
+
+/* the chunks not taken yet by the worker that owns them: the owner takes
+ * them from the front, and the others steal them from the back */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} WorkQueue;
+
+typedef struct {
+    Channel channels[2];
+    int num_channels;
+    size_t chunk_samples;
+    size_t num_jobs;
+    ChunkStats *stats;         /* one per job */
+    const Fft *fft;
+    const float *window;
+    double window_sum;
+    int clip_level;
+    double spectrogram_min_db;
+    double spectrogram_max_db;
+    WorkQueue *queues;         /* one per worker */
+    int num_workers;
+} Analysis;
+
+typedef struct {
+    Analysis *analysis;
+    int id;
+    pthread_t thread;
+    unsigned long long chunks;
+    unsigned long long steals;
+} Worker;
+
+static void usage(const char* progname);
+static void channel_filename(char *filename, size_t size, const char *format, char rx_id);
+static int channel_open(Channel *channel, const char *filename, char rx_id);
+static int spectrogram_open(Channel *channel, const char *filename, unsigned int width);
+static double guess_sample_rate(const char *filename);
+static void *worker_thread(void *arg);
+static int work_take(Analysis *analysis, int id, size_t *job);
+static int work_steal(Analysis *analysis, int id, size_t *job);
+static void analyze_chunk(Analysis *analysis, size_t job, float *re, float *im, float *psd, float *sorted, unsigned char *row);
+static void stats_merge(ChunkStats *total, const ChunkStats *stats);
+static void stats_print(FILE *fp, const ChunkStats *stats, double sample_rate, unsigned int fft_size);
+static int compare_float(const void *a, const void *b);
+static double now(void);
+
+
+int main(int argc, char *argv[])
+{
+    size_t chunk_samples = DEFAULT_CHUNK_SAMPLES;
+    unsigned int fft_size = DEFAULT_FFT_SIZE;
+    int num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *summary_file = NULL;
+    const char *spectrogram_file = NULL;
+    double spectrogram_min_db = DEFAULT_SPECTROGRAM_MIN_DB;
+    double spectrogram_max_db = DEFAULT_SPECTROGRAM_MAX_DB;
+    int clip_level = DEFAULT_CLIP_LEVEL;
+    double sample_rate = 0.0;
+
+    int c;
+    while ((c = getopt(argc, argv, "n:N:j:o:p:d:l:s:h")) != -1) {
+        switch (c) {
+            case 'n':
+                if (sscanf(optarg, "%zu", &chunk_samples) != 1 || chunk_samples == 0) {
+                    fprintf(stderr, "invalid chunk size: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'N':
+                if (sscanf(optarg, "%u", &fft_size) != 1) {
+                    fprintf(stderr, "invalid FFT size: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'j':
+                if (sscanf(optarg, "%d", &num_workers) != 1 || num_workers < 1) {
+                    fprintf(stderr, "invalid number of threads: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'o':
+                summary_file = optarg;
+                break;
+            case 'p':
+                spectrogram_file = optarg;
+                break;
+            case 'd':
+                if (sscanf(optarg, "%lg,%lg", &spectrogram_min_db, &spectrogram_max_db) != 2 || spectrogram_min_db >= spectrogram_max_db) {
+                    fprintf(stderr, "invalid spectrogram range: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'l':
+                if (sscanf(optarg, "%d", &clip_level) != 1 || clip_level < 1 || clip_level > SHRT_MAX) {
+                    fprintf(stderr, "invalid clip level: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 's':
+                if (sscanf(optarg, "%lg", &sample_rate) != 1 || sample_rate <= 0) {
+                    fprintf(stderr, "invalid sample rate: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        exit(1);
+    }
+    const char *input_file = argv[optind];
+    int both_channels = strstr(input_file, "%c") != NULL;
+    if (spectrogram_file != NULL && both_channels && strstr(spectrogram_file, "%c") == NULL) {
+        fprintf(stderr, "with '%%c' in the input file name the spectrogram file name needs '%%c' too\n");
+        exit(1);
+    }
+
+    Fft *fft = fft_create(fft_size);
+    if (fft == NULL)
+        exit(1);
+    float *window = (float *)malloc(fft_size * sizeof(float));
+    double window_sum = fft_hann_window(window, fft_size);
+
+    Analysis analysis = {
+        .num_channels = both_channels ? 2 : 1,
+        .chunk_samples = chunk_samples,
+        .num_jobs = 0,
+        .fft = fft,
+        .window = window,
+        .window_sum = window_sum,
+        .clip_level = clip_level,
+        .spectrogram_min_db = spectrogram_min_db,
+        .spectrogram_max_db = spectrogram_max_db,
+        .num_workers = num_workers
+    };
+    char filenames[2][MAX_PATH_SIZE];
+    for (int i = 0; i < analysis.num_channels; i++) {
+        Channel *channel = &analysis.channels[i];
+        char rx_id = both_channels ? 'A' + i : '-';
+        channel_filename(filenames[i], MAX_PATH_SIZE, input_file, both_channels ? rx_id : 0);
+        if (channel_open(channel, filenames[i], rx_id) == -1)
+            exit(1);
+        channel->first_job = analysis.num_jobs;
+        channel->num_chunks = (channel->num_samples + chunk_samples - 1) / chunk_samples;
+        analysis.num_jobs += channel->num_chunks;
+        if (spectrogram_file != NULL) {
+            char filename[MAX_PATH_SIZE];
+            channel_filename(filename, MAX_PATH_SIZE, spectrogram_file, both_channels ? rx_id : 0);
+            if (spectrogram_open(channel, filename, fft_size) == -1)
+                exit(1);
+        }
+    }
+    if (sample_rate == 0.0)
+        sample_rate = guess_sample_rate(filenames[0]);
+
+    /* the chunks are dealt out in contiguous runs, one per worker */
+    analysis.stats = (ChunkStats *)calloc(analysis.num_jobs, sizeof(ChunkStats));
+    analysis.queues = (WorkQueue *)malloc(num_workers * sizeof(WorkQueue));
+    for (int w = 0; w < num_workers; w++) {
+        pthread_mutex_init(&analysis.queues[w].lock, NULL);
+        analysis.queues[w].next = analysis.num_jobs * w / num_workers;
+        analysis.queues[w].end = analysis.num_jobs * (w + 1) / num_workers;
+    }
+
+    double start = now();
+    Worker *workers = (Worker *)calloc(num_workers, sizeof(Worker));
+    for (int w = 0; w < num_workers; w++) {
+        workers[w].analysis = &analysis;
+        workers[w].id = w;
+        int ret = pthread_create(&workers[w].thread, NULL, worker_thread, &workers[w]);
+        if (ret != 0) {
+            fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+            exit(1);
+        }
+    }
+    unsigned long long steals = 0;
+    for (int w = 0; w < num_workers; w++) {
+        pthread_join(workers[w].thread, NULL);
+        steals += workers[w].steals;
+    }
+    double elapsed = now() - start;
+
+    FILE *fp = stdout;
+    if (summary_file != NULL && strcmp(summary_file, "-") != 0) {
+        fp = fopen(summary_file, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "fopen(%s) failed: %s\n", summary_file, strerror(errno));
+            exit(1);
+        }
+    }
+    fprintf(fp, "# iq_analyze %s sample_rate=%.0lf chunk_samples=%zu fft_size=%u clip_level=%d\n", input_file, sample_rate, chunk_samples, fft_size, clip_level);
+    fprintf(fp, "# channel chunk first_sample samples min_I max_I min_Q max_Q dc_I dc_Q rms_dBFS clipped %s peak_dB noise_floor_dB\n", sample_rate > 0 ? "peak_Hz" : "peak_bin");
+    unsigned long long total_samples = 0;
+    for (int i = 0; i < analysis.num_channels; i++) {
+        const Channel *channel = &analysis.channels[i];
+        ChunkStats total = { .min_i = SHRT_MAX, .max_i = SHRT_MIN, .min_q = SHRT_MAX, .max_q = SHRT_MIN };
+        for (size_t k = 0; k < channel->num_chunks; k++) {
+            const ChunkStats *stats = &analysis.stats[channel->first_job + k];
+            fprintf(fp, "%c %zu %zu ", channel->rx_id, k, k * chunk_samples);
+            stats_print(fp, stats, sample_rate, fft_size);
+            stats_merge(&total, stats);
+        }
+        /* the PSD columns are the ones of the loudest chunk */
+        fprintf(fp, "# total %c - - ", channel->rx_id);
+        stats_print(fp, &total, sample_rate, fft_size);
+        total_samples += channel->num_samples;
+    }
+    if (fp != stdout)
+        fclose(fp);
+
+    double total_bytes = (double)total_samples * 2 * sizeof(short);
+    fprintf(stderr, "analyzed %zu chunks (%llu samples, %.1lfMB) in %.3lfs - %.1lfMB/s threads=%d steals=%llu\n", analysis.num_jobs, total_samples, total_bytes / 1e6, elapsed, total_bytes / 1e6 / elapsed, num_workers, steals);
+
+    for (int i = 0; i < analysis.num_channels; i++) {
+        Channel *channel = &analysis.channels[i];
+        munmap((void *)channel->samples, channel->mapped_size);
+        if (channel->spectrogram_fd >= 0)
+            close(channel->spectrogram_fd);
+    }
+    for (int w = 0; w < num_workers; w++)
+        pthread_mutex_destroy(&analysis.queues[w].lock);
+    free(workers);
+    free(analysis.queues);
+    free(analysis.stats);
+    free(window);
+    fft_free(fft);
+    return 0;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...] <input file>\n", progname);
+    fprintf(stderr, "    ('%%c' in the input file name will be replaced by the channel id, to analyze both A and B)\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -o <summary file> ('-' for stdout) (default: stdout)\n");
+    fprintf(stderr, "    -p <spectrogram file> (a PGM image with the PSD of one chunk per row; '%%c' will be replaced by the channel id) (default: none)\n");
+    fprintf(stderr, "    -d <spectrogram range> ('<min dB>,<max dB>': the PSD levels shown as black and white) (default: %.0lf,%.0lf)\n", DEFAULT_SPECTROGRAM_MIN_DB, DEFAULT_SPECTROGRAM_MAX_DB);
+    fprintf(stderr, "    -n <samples per chunk> (default: %d)\n", DEFAULT_CHUNK_SAMPLES);
+    fprintf(stderr, "    -N <FFT size> (a power of two) (default: %d)\n", DEFAULT_FFT_SIZE);
+    fprintf(stderr, "    -l <clip level> (the I or Q values at or beyond it are counted as clipped) (default: %d)\n", DEFAULT_CLIP_LEVEL);
+    fprintf(stderr, "    -s <sample rate> (for the peak frequency) (default: from a '<n>k' in the file name, like the one written by dual_tuner_recorder for 'SAMPLERATE')\n");
+    fprintf(stderr, "    -j <number of threads> (default: the number of CPUs)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+/* replace '%c' with the channel id (the name is used as is without one) */
+static void channel_filename(char *filename, size_t size, const char *format, char rx_id)
+{
+    if (rx_id == 0) {
+        snprintf(filename, size, "%s", format);
+        return;
+    }
+    const char *p = strstr(format, "%c");
+    snprintf(filename, size, "%.*s%c%s", p != NULL ? (int)(p - format) : (int)strlen(format), format, rx_id, p != NULL ? p + 2 : "");
+}
+
+static int channel_open(Channel *channel, const char *filename, char rx_id)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "open(%s) failed: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        fprintf(stderr, "fstat(%s) failed: %s\n", filename, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    size_t num_samples = st.st_size / (2 * sizeof(short));
+    if (num_samples == 0) {
+        fprintf(stderr, "%s: no samples\n", filename);
+        close(fd);
+        return -1;
+    }
+    void *samples = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (samples == MAP_FAILED) {
+        fprintf(stderr, "mmap(%s) failed: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    channel->rx_id = rx_id;
+    channel->samples = (const short *)samples;
+    channel->num_samples = num_samples;
+    channel->mapped_size = st.st_size;
+    channel->spectrogram_fd = -1;
+    return 0;
+}
+
+/* the workers write their rows directly at their place in the file */
+static int spectrogram_open(Channel *channel, const char *filename, unsigned int width)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "open(%s) failed: %s\n", filename, strerror(errno));
+        return -1;
+    }
+    char header[64];
+    int header_size = snprintf(header, sizeof(header), "P5\n%u %zu\n255\n", width, channel->num_chunks);
+    if (write(fd, header, header_size) != header_size || ftruncate(fd, header_size + (off_t)width * channel->num_chunks) == -1) {
+        fprintf(stderr, "%s: write failed: %s\n", filename, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    channel->spectrogram_fd = fd;
+    channel->spectrogram_header_size = header_size;
+    return 0;
+}
+
+/* a '<n>k' between separators (like '-2000k-'), or 0 if there is none */
+static double guess_sample_rate(const char *filename)
+{
+    const char *basename = strrchr(filename, '/');
+    basename = basename != NULL ? basename + 1 : filename;
+    for (const char *p = basename; *p != '\0'; p++) {
+        if (p > basename && strchr("-_.", p[-1]) == NULL)
+            continue;
+        char *end;
+        long kHz = strtol(p, &end, 10);
+        if (end > p && *p >= '0' && *p <= '9' && *end == 'k' && strchr("-_.", end[1]) != NULL && end[1] != '\0' && kHz > 0)
+            return kHz * 1e3;
+    }
+    return 0.0;
+}
+
+static void *worker_thread(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+    Analysis *analysis = worker->analysis;
+    unsigned int size = fft_size(analysis->fft);
+    float *re = (float *)malloc(size * sizeof(float));
+    float *im = (float *)malloc(size * sizeof(float));
+    float *psd = (float *)malloc(size * sizeof(float));
+    float *sorted = (float *)malloc(size * sizeof(float));
+    unsigned char *row = (unsigned char *)malloc(size);
+    size_t job;
+    for (;;) {
+        if (work_take(analysis, worker->id, &job) == -1) {
+            if (work_steal(analysis, worker->id, &job) == -1)
+                break;
+            worker->steals++;
+        }
+        analyze_chunk(analysis, job, re, im, psd, sorted, row);
+        worker->chunks++;
+    }
+    free(re);
+    free(im);
+    free(psd);
+    free(sorted);
+    free(row);
+    return NULL;
+}
+
+static int work_take(Analysis *analysis, int id, size_t *job)
+{
+    WorkQueue *queue = &analysis->queues[id];
+    int ret = -1;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->next < queue->end) {
+        *job = queue->next++;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+/* from the back of the worker with the most chunks left */
+static int work_steal(Analysis *analysis, int id, size_t *job)
+{
+    for (;;) {
+        int victim = -1;
+        size_t most = 0;
+        for (int w = 0; w < analysis->num_workers; w++) {
+            if (w == id)
+                continue;
+            WorkQueue *queue = &analysis->queues[w];
+            pthread_mutex_lock(&queue->lock);
+            size_t left = queue->end - queue->next;
+            pthread_mutex_unlock(&queue->lock);
+            if (left > most) {
+                most = left;
+                victim = w;
+            }
+        }
+        if (victim == -1)
+            return -1;
+        WorkQueue *queue = &analysis->queues[victim];
+        int ret = -1;
+        pthread_mutex_lock(&queue->lock);
+        if (queue->next < queue->end) {
+            *job = --queue->end;
+            ret = 0;
+        }
+        pthread_mutex_unlock(&queue->lock);
+        if (ret == 0)
+            return 0;
+        /* taken in the meantime: look again */
+    }
+}
+
+static void analyze_chunk(Analysis *analysis, size_t job, float *re, float *im, float *psd, float *sorted, unsigned char *row)
+{
+    int c = analysis->num_channels > 1 && job >= analysis->channels[1].first_job ? 1 : 0;
+    const Channel *channel = &analysis->channels[c];
+    size_t chunk = job - channel->first_job;
+    size_t first = chunk * analysis->chunk_samples;
+    size_t n = channel->num_samples - first < analysis->chunk_samples ? channel->num_samples - first : analysis->chunk_samples;
+    const short *samples = channel->samples + 2 * first;
+
+    /* read the whole chunk ahead, and drop it from the mapping afterwards
+     * (so a long file does not fill up the resident set) */
+    long page_size = sysconf(_SC_PAGESIZE);
+    char *region = (char *)((uintptr_t)samples & ~(uintptr_t)(page_size - 1));
+    size_t region_size = (const char *)(samples + 2 * n) - region;
+    madvise(region, region_size, MADV_WILLNEED);
+
+    ChunkStats *stats = &analysis->stats[job];
+    short min_i = SHRT_MAX, max_i = SHRT_MIN, min_q = SHRT_MAX, max_q = SHRT_MIN;
+    int64_t sum_i = 0, sum_q = 0;
+    double sum_power = 0.0;
+    unsigned long long clipped = 0;
+    int clip_level = analysis->clip_level;
+    for (size_t k = 0; k < n; k++) {
+        int xi = samples[2*k];
+        int xq = samples[2*k+1];
+        min_i = xi < min_i ? xi : min_i;
+        max_i = xi > max_i ? xi : max_i;
+        min_q = xq < min_q ? xq : min_q;
+        max_q = xq > max_q ? xq : max_q;
+        sum_i += xi;
+        sum_q += xq;
+        sum_power += (double)(xi * xi + xq * xq);
+        clipped += (xi >= clip_level || xi <= -clip_level) + (xq >= clip_level || xq <= -clip_level);
+    }
+    stats->num_samples = n;
+    stats->min_i = min_i;
+    stats->max_i = max_i;
+    stats->min_q = min_q;
+    stats->max_q = max_q;
+    stats->sum_i = (double)sum_i;
+    stats->sum_q = (double)sum_q;
+    stats->sum_power = sum_power;
+    stats->clipped = clipped;
+
+    /* averaged PSD over the non overlapping FFT frames in the chunk (a
+     * full scale tone is 0dB) */
+    unsigned int size = fft_size(analysis->fft);
+    size_t frames = n / size;
+    stats->psd_frames = (int)frames;
+    if (frames > 0) {
+        memset(psd, 0, size * sizeof(float));
+        for (size_t f = 0; f < frames; f++) {
+            const short *frame = samples + 2 * f * size;
+            for (unsigned int k = 0; k < size; k++) {
+                re[k] = frame[2*k] * analysis->window[k];
+                im[k] = frame[2*k+1] * analysis->window[k];
+            }
+            fft_forward(analysis->fft, re, im);
+            for (unsigned int k = 0; k < size; k++)
+                psd[k] += re[k] * re[k] + im[k] * im[k];
+        }
+        double scale = FULL_SCALE * analysis->window_sum;
+        double db_offset = -10.0 * log10((double)frames * scale * scale);
+        stats->peak_db = -INFINITY;
+        for (unsigned int k = 0; k < size; k++) {
+            /* negative frequencies first */
+            unsigned int bin = (k + size / 2) % size;
+            float db = (float)(10.0 * log10(psd[bin] + 1e-30) + db_offset);
+            sorted[k] = db;
+            if (db > stats->peak_db) {
+                stats->peak_db = db;
+                stats->peak_bin = (int)k;
+            }
+            double level = (db - analysis->spectrogram_min_db) / (analysis->spectrogram_max_db - analysis->spectrogram_min_db);
+            row[k] = level <= 0.0 ? 0 : level >= 1.0 ? 255 : (unsigned char)(level * 255.0 + 0.5);
+        }
+        qsort(sorted, size, sizeof(float), compare_float);
+        stats->noise_floor_db = sorted[size / 2];
+    } else {
+        memset(row, 0, size);
+    }
+    if (channel->spectrogram_fd >= 0) {
+        off_t offset = channel->spectrogram_header_size + (off_t)chunk * size;
+        if (pwrite(channel->spectrogram_fd, row, size, offset) != (ssize_t)size)
+            fprintf(stderr, "RX %c - spectrogram write failed: %s\n", channel->rx_id, strerror(errno));
+    }
+
+    madvise(region, region_size, MADV_DONTNEED);
+}
+
+static void stats_merge(ChunkStats *total, const ChunkStats *stats)
+{
+    total->num_samples += stats->num_samples;
+    total->min_i = stats->min_i < total->min_i ? stats->min_i : total->min_i;
+    total->max_i = stats->max_i > total->max_i ? stats->max_i : total->max_i;
+    total->min_q = stats->min_q < total->min_q ? stats->min_q : total->min_q;
+    total->max_q = stats->max_q > total->max_q ? stats->max_q : total->max_q;
+    total->sum_i += stats->sum_i;
+    total->sum_q += stats->sum_q;
+    total->sum_power += stats->sum_power;
+    total->clipped += stats->clipped;
+    if (stats->psd_frames > 0 && (total->psd_frames == 0 || stats->peak_db > total->peak_db)) {
+        total->peak_bin = stats->peak_bin;
+        total->peak_db = stats->peak_db;
+        total->noise_floor_db = stats->noise_floor_db;
+    }
+    total->psd_frames += stats->psd_frames;
+}
+
+static void stats_print(FILE *fp, const ChunkStats *stats, double sample_rate, unsigned int fft_size)
+{
+    double n = (double)stats->num_samples;
+    double rms_db = 10.0 * log10(stats->sum_power / n / (FULL_SCALE * FULL_SCALE) + 1e-30);
+    fprintf(fp, "%zu %d %d %d %d %.2lf %.2lf %.2lf %llu ", stats->num_samples, stats->min_i, stats->max_i, stats->min_q, stats->max_q, stats->sum_i / n, stats->sum_q / n, rms_db, stats->clipped);
+    if (stats->psd_frames == 0) {
+        fprintf(fp, "- - -\n");
+        return;
+    }
+    int bin = stats->peak_bin - (int)(fft_size / 2);
+    if (sample_rate > 0) {
+        fprintf(fp, "%.0lf", bin * sample_rate / fft_size);
+    } else {
+        fprintf(fp, "%d", bin);
+    }
+    fprintf(fp, " %.2lf %.2lf\n", stats->peak_db, stats->noise_floor_db);
+}
+
+static int compare_float(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
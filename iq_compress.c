@@ -0,0 +1,359 @@
+/* lossless compression of interleaved 16 bit I/Q samples
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IQ_COMPRESS_X86
+#endif
+
+#include "iq_compress.h"
+
+#define LANES 8
+#define MAX_BITS 16
+
+/* pack/unpack 'groups' groups of LANES values with 'bits' bits each */
+typedef void (*PackFn)(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+typedef void (*UnpackFn)(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+
+static void pack_scalar(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+static void unpack_scalar(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+#ifdef IQ_COMPRESS_X86
+static void pack_sse2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+static void unpack_sse2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+static void pack_avx2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+static void unpack_avx2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out);
+#endif
+
+static PackFn pack = pack_scalar;
+static UnpackFn unpack = unpack_scalar;
+const char *iq_compress_kernel_name = "scalar";
+
+static size_t encode_component(const short *samples, unsigned int n, IQCompressComponent *component, uint32_t *out);
+static size_t packed_size(unsigned int n, unsigned int bits);
+static unsigned int bit_width(uint32_t range);
+
+
+void iq_compress_init(void)
+{
+#ifdef IQ_COMPRESS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        pack = pack_avx2;
+        unpack = unpack_avx2;
+        iq_compress_kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        pack = pack_sse2;
+        unpack = unpack_sse2;
+        iq_compress_kernel_name = "sse2";
+    }
+#endif
+}
+
+void iq_compress_header(IQCompressHeader *header)
+{
+    memset(header, 0, sizeof(IQCompressHeader));
+    memcpy(header->magic, IQ_COMPRESS_MAGIC, sizeof(header->magic));
+    header->version = IQ_COMPRESS_VERSION;
+    header->block_samples = IQ_COMPRESS_BLOCK_SAMPLES;
+}
+
+int iq_compress_check_header(const IQCompressHeader *header)
+{
+    if (memcmp(header->magic, IQ_COMPRESS_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "not a compressed I/Q file\n");
+        return -1;
+    }
+    if (header->version != IQ_COMPRESS_VERSION || header->block_samples > IQ_COMPRESS_BLOCK_SAMPLES) {
+        fprintf(stderr, "unsupported compressed I/Q file version %u (block_samples=%u)\n", header->version, header->block_samples);
+        return -1;
+    }
+    return 0;
+}
+
+size_t iq_compress(const short *samples, unsigned int n, void *out)
+{
+    char *p = (char *)out;
+    while (n > 0) {
+        unsigned int m = n < IQ_COMPRESS_BLOCK_SAMPLES ? n : IQ_COMPRESS_BLOCK_SAMPLES;
+        IQCompressBlockHeader *header = (IQCompressBlockHeader *)p;
+        char *payload = p + sizeof(IQCompressBlockHeader);
+        size_t size = encode_component(samples, m, &header->component[0], (uint32_t *)payload);
+        size += encode_component(samples + 1, m, &header->component[1], (uint32_t *)(payload + size));
+        header->num_samples = m;
+        header->size = size;
+        p = payload + size;
+        samples += 2 * m;
+        n -= m;
+    }
+    return p - (char *)out;
+}
+
+size_t iq_compress_bound(unsigned int n)
+{
+    unsigned int blocks = (n + IQ_COMPRESS_BLOCK_SAMPLES - 1) / IQ_COMPRESS_BLOCK_SAMPLES;
+    return blocks * (sizeof(IQCompressBlockHeader) + 2 * packed_size(IQ_COMPRESS_BLOCK_SAMPLES, MAX_BITS));
+}
+
+ssize_t iq_decompress_block(const void *in, size_t size, short *out, unsigned int *num_samples)
+{
+    if (size < sizeof(IQCompressBlockHeader))
+        return 0;
+    const IQCompressBlockHeader *header = (const IQCompressBlockHeader *)in;
+    unsigned int n = header->num_samples;
+    if (n == 0 || n > IQ_COMPRESS_BLOCK_SAMPLES ||
+        header->component[0].bits > MAX_BITS || header->component[1].bits > MAX_BITS ||
+        header->size != packed_size(n, header->component[0].bits) + packed_size(n, header->component[1].bits))
+        return -1;
+    if (size < sizeof(IQCompressBlockHeader) + header->size)
+        return 0;
+
+    const char *payload = (const char *)(header + 1);
+    uint32_t values[IQ_COMPRESS_BLOCK_SAMPLES];
+    unsigned int groups = (n + LANES - 1) / LANES;
+    for (int c = 0; c < 2; c++) {
+        const IQCompressComponent *component = &header->component[c];
+        if (component->bits == 0) {
+            memset(values, 0, groups * LANES * sizeof(uint32_t));
+        } else {
+            unpack((const uint32_t *)payload, groups, component->bits, values);
+        }
+        payload += packed_size(n, component->bits);
+        int32_t base = component->base;
+        if (component->delta) {
+            int32_t x = component->first;
+            for (unsigned int k = 0; k < n; k++) {
+                x += (int32_t)values[k] + base;
+                out[2*k+c] = (short)x;
+            }
+        } else {
+            for (unsigned int k = 0; k < n; k++)
+                out[2*k+c] = (short)((int32_t)values[k] + base);
+        }
+    }
+    *num_samples = n;
+    return sizeof(IQCompressBlockHeader) + header->size;
+}
+
+
+/* one component (every other short) of n samples; the first pass (which
+ * the compiler vectorizes) finds the range of both the samples and their
+ * differences, then the one that needs fewer bits is packed */
+static size_t encode_component(const short *samples, unsigned int n, IQCompressComponent *component, uint32_t *out)
+{
+    int32_t x[IQ_COMPRESS_BLOCK_SAMPLES];
+    int32_t d[IQ_COMPRESS_BLOCK_SAMPLES];
+    for (unsigned int k = 0; k < n; k++)
+        x[k] = samples[2*k];
+    d[0] = 0;
+    for (unsigned int k = 1; k < n; k++)
+        d[k] = x[k] - x[k-1];
+    int32_t xmin = x[0];
+    int32_t xmax = x[0];
+    int32_t dmin = 0;
+    int32_t dmax = 0;
+    for (unsigned int k = 0; k < n; k++) {
+        xmin = x[k] < xmin ? x[k] : xmin;
+        xmax = x[k] > xmax ? x[k] : xmax;
+        dmin = d[k] < dmin ? d[k] : dmin;
+        dmax = d[k] > dmax ? d[k] : dmax;
+    }
+    unsigned int xbits = bit_width(xmax - xmin);
+    unsigned int dbits = bit_width(dmax - dmin);
+    int delta = dbits < xbits;
+    const int32_t *v = delta ? d : x;
+    int32_t base = delta ? dmin : xmin;
+    unsigned int bits = delta ? dbits : xbits;
+    component->base = base;
+    component->first = delta ? (int16_t)x[0] : 0;
+    component->bits = bits;
+    component->delta = delta;
+    if (bits == 0)
+        return 0;
+
+    /* the padding values must be zeros */
+    uint32_t values[IQ_COMPRESS_BLOCK_SAMPLES];
+    unsigned int groups = (n + LANES - 1) / LANES;
+    for (unsigned int k = 0; k < n; k++)
+        values[k] = (uint32_t)(v[k] - base);
+    for (unsigned int k = n; k < groups * LANES; k++)
+        values[k] = 0;
+    pack(values, groups, bits, out);
+    return packed_size(n, bits);
+}
+
+static size_t packed_size(unsigned int n, unsigned int bits)
+{
+    unsigned int groups = (n + LANES - 1) / LANES;
+    unsigned int words = (groups * bits + 31) / 32;
+    return words * LANES * sizeof(uint32_t);
+}
+
+static unsigned int bit_width(uint32_t range)
+{
+    return range == 0 ? 0 : 32 - __builtin_clz(range);
+}
+
+
+static void pack_scalar(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out)
+{
+    for (unsigned int l = 0; l < LANES; l++) {
+        uint64_t acc = 0;
+        unsigned int shift = 0;
+        unsigned int w = 0;
+        for (unsigned int g = 0; g < groups; g++) {
+            acc |= (uint64_t)in[g*LANES+l] << shift;
+            shift += bits;
+            if (shift >= 32) {
+                out[w*LANES+l] = (uint32_t)acc;
+                acc >>= 32;
+                shift -= 32;
+                w++;
+            }
+        }
+        if (shift > 0)
+            out[w*LANES+l] = (uint32_t)acc;
+    }
+}
+
+static void unpack_scalar(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out)
+{
+    uint32_t mask = (1U << bits) - 1;
+    unsigned int words = (groups * bits + 31) / 32;
+    for (unsigned int l = 0; l < LANES; l++) {
+        uint64_t acc = in[l];
+        unsigned int shift = 0;
+        unsigned int w = 0;
+        for (unsigned int g = 0; g < groups; g++) {
+            if (shift + bits > 32 && w + 1 < words)
+                acc |= (uint64_t)in[(w+1)*LANES+l] << 32;
+            out[g*LANES+l] = (uint32_t)(acc >> shift) & mask;
+            shift += bits;
+            if (shift >= 32) {
+                w++;
+                shift -= 32;
+                acc = w < words ? in[w*LANES+l] : 0;
+            }
+        }
+    }
+}
+
+#ifdef IQ_COMPRESS_X86
+/* the same algorithm as above, LANES at once; the shift counts are the
+ * same for all the lanes */
+__attribute__((target("sse2")))
+static void pack_sse2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out)
+{
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    unsigned int shift = 0;
+    unsigned int w = 0;
+    for (unsigned int g = 0; g < groups; g++) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(in + g * LANES));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(in + g * LANES + 4));
+        __m128i count = _mm_cvtsi32_si128(shift);
+        acc0 = _mm_or_si128(acc0, _mm_sll_epi32(v0, count));
+        acc1 = _mm_or_si128(acc1, _mm_sll_epi32(v1, count));
+        shift += bits;
+        if (shift >= 32) {
+            _mm_storeu_si128((__m128i *)(out + w * LANES), acc0);
+            _mm_storeu_si128((__m128i *)(out + w * LANES + 4), acc1);
+            w++;
+            shift -= 32;
+            /* the bits that did not fit */
+            __m128i rest = _mm_cvtsi32_si128(bits - shift);
+            acc0 = shift > 0 ? _mm_srl_epi32(v0, rest) : _mm_setzero_si128();
+            acc1 = shift > 0 ? _mm_srl_epi32(v1, rest) : _mm_setzero_si128();
+        }
+    }
+    if (shift > 0) {
+        _mm_storeu_si128((__m128i *)(out + w * LANES), acc0);
+        _mm_storeu_si128((__m128i *)(out + w * LANES + 4), acc1);
+    }
+}
+
+__attribute__((target("sse2")))
+static void unpack_sse2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out)
+{
+    const __m128i mask = _mm_set1_epi32((1U << bits) - 1);
+    unsigned int words = (groups * bits + 31) / 32;
+    __m128i cur0 = _mm_loadu_si128((const __m128i *)in);
+    __m128i cur1 = _mm_loadu_si128((const __m128i *)(in + 4));
+    unsigned int shift = 0;
+    unsigned int w = 0;
+    for (unsigned int g = 0; g < groups; g++) {
+        __m128i count = _mm_cvtsi32_si128(shift);
+        __m128i v0 = _mm_srl_epi32(cur0, count);
+        __m128i v1 = _mm_srl_epi32(cur1, count);
+        shift += bits;
+        if (shift >= 32) {
+            w++;
+            shift -= 32;
+            if (w < words) {
+                cur0 = _mm_loadu_si128((const __m128i *)(in + w * LANES));
+                cur1 = _mm_loadu_si128((const __m128i *)(in + w * LANES + 4));
+            }
+            if (shift > 0) {
+                /* the high bits are in the next word */
+                __m128i high = _mm_cvtsi32_si128(bits - shift);
+                v0 = _mm_or_si128(v0, _mm_sll_epi32(cur0, high));
+                v1 = _mm_or_si128(v1, _mm_sll_epi32(cur1, high));
+            }
+        }
+        _mm_storeu_si128((__m128i *)(out + g * LANES), _mm_and_si128(v0, mask));
+        _mm_storeu_si128((__m128i *)(out + g * LANES + 4), _mm_and_si128(v1, mask));
+    }
+}
+
+__attribute__((target("avx2")))
+static void pack_avx2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out)
+{
+    __m256i acc = _mm256_setzero_si256();
+    unsigned int shift = 0;
+    unsigned int w = 0;
+    for (unsigned int g = 0; g < groups; g++) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + g * LANES));
+        acc = _mm256_or_si256(acc, _mm256_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+        shift += bits;
+        if (shift >= 32) {
+            _mm256_storeu_si256((__m256i *)(out + w * LANES), acc);
+            w++;
+            shift -= 32;
+            acc = shift > 0 ? _mm256_srl_epi32(v, _mm_cvtsi32_si128(bits - shift)) : _mm256_setzero_si256();
+        }
+    }
+    if (shift > 0)
+        _mm256_storeu_si256((__m256i *)(out + w * LANES), acc);
+}
+
+__attribute__((target("avx2")))
+static void unpack_avx2(const uint32_t *in, unsigned int groups, unsigned int bits, uint32_t *out)
+{
+    const __m256i mask = _mm256_set1_epi32((1U << bits) - 1);
+    unsigned int words = (groups * bits + 31) / 32;
+    __m256i cur = _mm256_loadu_si256((const __m256i *)in);
+    unsigned int shift = 0;
+    unsigned int w = 0;
+    for (unsigned int g = 0; g < groups; g++) {
+        __m256i v = _mm256_srl_epi32(cur, _mm_cvtsi32_si128(shift));
+        shift += bits;
+        if (shift >= 32) {
+            w++;
+            shift -= 32;
+            if (w < words)
+                cur = _mm256_loadu_si256((const __m256i *)(in + w * LANES));
+            if (shift > 0)
+                v = _mm256_or_si256(v, _mm256_sll_epi32(cur, _mm_cvtsi32_si128(bits - shift)));
+        }
+        _mm256_storeu_si256((__m256i *)(out + g * LANES), _mm256_and_si256(v, mask));
+    }
+}
+#endif
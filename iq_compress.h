@@ -0,0 +1,77 @@
+/* lossless compression of interleaved 16 bit I/Q samples
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _IQ_COMPRESS_H
+#define _IQ_COMPRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* file layout (all the fields are in the host byte order):
+ *   - an IQCompressHeader
+ *   - blocks of up to block_samples I/Q samples; each block starts with an
+ *     IQCompressBlockHeader followed by the packed I values and then the
+ *     packed Q values
+ * each component of a block is stored either as is or as the differences
+ * between consecutive samples (first order prediction), whichever needs
+ * fewer bits; the values are stored as offsets from the smallest one
+ * ('base'), using just enough bits for the largest one ('bits', 0 to 16)
+ * the packed values are in 8 interleaved lanes of 32 bit words: value k
+ * goes to lane k % 8, and each lane is packed LSB first into its own
+ * sequence of words (word w of lane l is at word index 8 * w + l), so
+ * that eight values are packed or unpacked at once with SIMD shifts; the
+ * values past num_samples (up to a multiple of 8) are zeros
+ * the blocks are independent, so a file can be decoded from any block */
+
+#define IQ_COMPRESS_MAGIC "IQ16PACK"
+#define IQ_COMPRESS_VERSION 1
+#define IQ_COMPRESS_BLOCK_SAMPLES 4096
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_samples;
+} IQCompressHeader;
+
+typedef struct {
+    int32_t base;
+    int16_t first;             /* first sample (delta only) */
+    uint8_t bits;
+    uint8_t delta;
+} IQCompressComponent;
+
+typedef struct {
+    uint32_t num_samples;
+    uint32_t size;             /* bytes of packed values (I and Q) */
+    IQCompressComponent component[2];
+} IQCompressBlockHeader;
+
+/* the bit packer variant selected by iq_compress_init() */
+extern const char *iq_compress_kernel_name;
+
+/* select the widest bit packer supported by this CPU */
+void iq_compress_init(void);
+
+void iq_compress_header(IQCompressHeader *header);
+/* returns -1 (after printing the reason) if this is not a valid header */
+int iq_compress_check_header(const IQCompressHeader *header);
+
+/* compress n interleaved I/Q samples (as blocks of block_samples) into
+ * out[], which must have room for iq_compress_bound(n) bytes; returns the
+ * number of bytes stored */
+size_t iq_compress(const short *samples, unsigned int n, void *out);
+size_t iq_compress_bound(unsigned int n);
+
+/* decompress one block from in[] (at most IQ_COMPRESS_BLOCK_SAMPLES
+ * samples into out[]); returns the number of bytes consumed, 0 if in[]
+ * does not hold a whole block, or -1 if the block is not valid */
+ssize_t iq_decompress_block(const void *in, size_t size, short *out, unsigned int *num_samples);
+
+#endif /* _IQ_COMPRESS_H */
@@ -0,0 +1,197 @@
+/* decompress (or compress) I/Q files in the lossless block format
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "iq_compress.h"
+
+#define COMPRESS_CHUNK_SAMPLES 65536
+
+static void usage(const char* progname);
+static int compress_file(const char *input, size_t size, FILE *output, unsigned long long *num_samples, size_t *compressed_size, double *elapsed);
+static int decompress_file(const char *input, size_t size, FILE *output, unsigned long long *num_samples, double *elapsed);
+static double now(void);
+
+
+int main(int argc, char *argv[])
+{
+    int compress = 0;
+    const char *output_file = NULL;
+
+    int c;
+    while ((c = getopt(argc, argv, "co:h")) != -1) {
+        switch (c) {
+            case 'c':
+                compress = 1;
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    const char *input_file = argv[optind];
+    int fd = open(input_file, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "open(%s) failed: %s\n", input_file, strerror(errno));
+        exit(1);
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        fprintf(stderr, "fstat(%s) failed: %s\n", input_file, strerror(errno));
+        close(fd);
+        exit(1);
+    }
+    size_t size = st.st_size;
+    const char *input = NULL;
+    if (size > 0) {
+        input = (const char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (input == MAP_FAILED) {
+            fprintf(stderr, "mmap(%s) failed: %s\n", input_file, strerror(errno));
+            close(fd);
+            exit(1);
+        }
+        madvise((void *)input, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    /* without an output file only check the file and time the codec */
+    FILE *output = NULL;
+    if (output_file != NULL) {
+        output = strcmp(output_file, "-") == 0 ? stdout : fopen(output_file, "w");
+        if (output == NULL) {
+            fprintf(stderr, "fopen(%s) failed: %s\n", output_file, strerror(errno));
+            exit(1);
+        }
+    }
+
+    iq_compress_init();
+    unsigned long long num_samples = 0;
+    size_t compressed_size = size;
+    double elapsed = 0.0;
+    int ret;
+    if (compress) {
+        ret = compress_file(input, size, output, &num_samples, &compressed_size, &elapsed);
+    } else {
+        ret = decompress_file(input, size, output, &num_samples, &elapsed);
+    }
+    if (output != NULL && fclose(output) != 0) {
+        fprintf(stderr, "fclose() failed: %s\n", strerror(errno));
+        ret = -1;
+    }
+    if (ret == 0) {
+        size_t raw_size = num_samples * 2 * sizeof(short);
+        fprintf(stderr, "samples=%llu raw_bytes=%zu compressed_bytes=%zu ratio=%.3lf %s_time=%.3lfs (%.1lf MSps) kernel=%s\n", num_samples, raw_size, compressed_size, raw_size > 0 ? (double)compressed_size / raw_size : 0.0, compress ? "compress" : "decompress", elapsed, elapsed > 0 ? 1e-6 * num_samples / elapsed : 0.0, iq_compress_kernel_name);
+    }
+    if (size > 0)
+        munmap((void *)input, size);
+    return ret == 0 ? 0 : 1;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...] <input file>\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -c compress a raw I/Q file (default: decompress)\n");
+    fprintf(stderr, "    -o <output file> ('-' for stdout) (default: only check the input and time the compression or decompression)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+static int compress_file(const char *input, size_t size, FILE *output, unsigned long long *num_samples, size_t *compressed_size, double *elapsed)
+{
+    /* the block format has whole samples only: a partial one at the end
+     * would not make it through the round trip */
+    if (size % (2 * sizeof(short)) != 0) {
+        fprintf(stderr, "the input size (%zu bytes) is not a multiple of %zu bytes (one int16 I/Q sample)\n", size, 2 * sizeof(short));
+        return -1;
+    }
+    char *buffer = (char *)malloc(iq_compress_bound(COMPRESS_CHUNK_SAMPLES));
+    IQCompressHeader header;
+    iq_compress_header(&header);
+    if (output != NULL && fwrite(&header, sizeof(header), 1, output) != 1) {
+        fprintf(stderr, "fwrite() failed: %s\n", strerror(errno));
+        free(buffer);
+        return -1;
+    }
+    *compressed_size = sizeof(header);
+    const short *samples = (const short *)input;
+    unsigned long long remaining = size / (2 * sizeof(short));
+    *num_samples = remaining;
+    while (remaining > 0) {
+        unsigned int n = remaining < COMPRESS_CHUNK_SAMPLES ? remaining : COMPRESS_CHUNK_SAMPLES;
+        double start = now();
+        size_t count = iq_compress(samples, n, buffer);
+        *elapsed += now() - start;
+        if (output != NULL && fwrite(buffer, 1, count, output) != count) {
+            fprintf(stderr, "fwrite() failed: %s\n", strerror(errno));
+            free(buffer);
+            return -1;
+        }
+        *compressed_size += count;
+        samples += 2 * n;
+        remaining -= n;
+    }
+    free(buffer);
+    return 0;
+}
+
+static int decompress_file(const char *input, size_t size, FILE *output, unsigned long long *num_samples, double *elapsed)
+{
+    if (size < sizeof(IQCompressHeader) || iq_compress_check_header((const IQCompressHeader *)input) == -1)
+        return -1;
+    short samples[2 * IQ_COMPRESS_BLOCK_SAMPLES];
+    size_t offset = sizeof(IQCompressHeader);
+    while (offset < size) {
+        unsigned int n;
+        double start = now();
+        ssize_t count = iq_decompress_block(input + offset, size - offset, samples, &n);
+        *elapsed += now() - start;
+        if (count <= 0) {
+            /* a recording that was cut short ends with a partial block */
+            fprintf(stderr, "%s block at offset %zu\n", count == 0 ? "truncated" : "invalid", offset);
+            return count == 0 ? 0 : -1;
+        }
+        if (output != NULL && fwrite(samples, 2 * sizeof(short), n, output) != n) {
+            fprintf(stderr, "fwrite() failed: %s\n", strerror(errno));
+            return -1;
+        }
+        *num_samples += n;
+        offset += count;
+    }
+    return 0;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
@@ -0,0 +1,289 @@
+/* vectorized kernels for the I/Q samples hot path
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IQ_KERNELS_X86
+#endif
+
+#include "iq_kernels.h"
+
+#define CALIBRATION_SAMPLES 1008
+#define CALIBRATION_ROUNDS 200
+
+static const IQKernel *calibrate(void);
+static void interleave_minmax_scalar(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range);
+static uint64_t energy_scalar(const short *xi, const short *xq, unsigned int n);
+#ifdef IQ_KERNELS_X86
+static void interleave_minmax_sse2(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range);
+static void interleave_minmax_avx2(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range);
+static uint64_t energy_sse2(const short *xi, const short *xq, unsigned int n);
+static uint64_t energy_avx2(const short *xi, const short *xq, unsigned int n);
+#endif
+
+static const IQKernel kernel_scalar = { "scalar", interleave_minmax_scalar, energy_scalar };
+#ifdef IQ_KERNELS_X86
+static const IQKernel kernel_sse2 = { "sse2", interleave_minmax_sse2, energy_sse2 };
+static const IQKernel kernel_avx2 = { "avx2", interleave_minmax_avx2, energy_avx2 };
+#endif
+
+const IQKernel *iq_kernels[3];
+int iq_kernels_count = 0;
+
+IQInterleaveMinMaxFn iq_interleave_minmax = interleave_minmax_scalar;
+IQEnergyFn iq_energy = energy_scalar;
+const char *iq_kernel_name = "scalar";
+
+
+int iq_kernels_init(const char *name)
+{
+    iq_kernels_count = 0;
+    iq_kernels[iq_kernels_count++] = &kernel_scalar;
+#ifdef IQ_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        iq_kernels[iq_kernels_count++] = &kernel_sse2;
+    if (__builtin_cpu_supports("avx2"))
+        iq_kernels[iq_kernels_count++] = &kernel_avx2;
+#endif
+
+    const IQKernel *selected;
+    if (name == NULL) {
+        selected = calibrate();
+    } else {
+        selected = NULL;
+        for (int i = 0; i < iq_kernels_count; i++) {
+            if (strcmp(iq_kernels[i]->name, name) == 0)
+                selected = iq_kernels[i];
+        }
+        if (selected == NULL)
+            return -1;
+    }
+    iq_interleave_minmax = selected->interleave_minmax;
+    iq_energy = selected->energy;
+    iq_kernel_name = selected->name;
+    return 0;
+}
+
+/* the widest vectors are not always the fastest (on some CPUs 256 bit
+ * instructions are split in two, or they lower the clock), so time all
+ * the supported variants on a typical block and pick the fastest one */
+static const IQKernel *calibrate(void)
+{
+    static short xi[CALIBRATION_SAMPLES];
+    static short xq[CALIBRATION_SAMPLES];
+    static short out[2 * CALIBRATION_SAMPLES];
+    for (int i = 0; i < CALIBRATION_SAMPLES; i++) {
+        xi[i] = (short)(i * 7919 % 4096 - 2048);
+        xq[i] = (short)(i * 6271 % 4096 - 2048);
+    }
+
+    const IQKernel *fastest = iq_kernels[iq_kernels_count - 1];
+    double fastest_time = 0.0;
+    for (int k = iq_kernels_count - 1; k >= 0; k--) {
+        IQRange range = { SHRT_MAX, SHRT_MIN, SHRT_MAX, SHRT_MIN };
+        /* warm up, then take the best of a few runs */
+        iq_kernels[k]->interleave_minmax(xi, xq, out, CALIBRATION_SAMPLES, &range);
+        double best_time = 0.0;
+        for (int run = 0; run < 5; run++) {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int i = 0; i < CALIBRATION_ROUNDS; i++)
+                iq_kernels[k]->interleave_minmax(xi, xq, out, CALIBRATION_SAMPLES, &range);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double elapsed = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+            if (run == 0 || elapsed < best_time)
+                best_time = elapsed;
+        }
+        /* prefer the wider variant unless the narrower one is clearly faster */
+        if (k == iq_kernels_count - 1 || best_time < 0.9 * fastest_time) {
+            fastest = iq_kernels[k];
+            fastest_time = best_time;
+        }
+    }
+    return fastest;
+}
+
+
+static void interleave_minmax_scalar(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range)
+{
+    short imin = range->imin;
+    short imax = range->imax;
+    short qmin = range->qmin;
+    short qmax = range->qmax;
+    for (unsigned int i = 0; i < n; i++) {
+        short vi = xi[i];
+        short vq = xq[i];
+        imin = imin < vi ? imin : vi;
+        imax = imax > vi ? imax : vi;
+        qmin = qmin < vq ? qmin : vq;
+        qmax = qmax > vq ? qmax : vq;
+        if (out != NULL) {
+            out[2*i] = vi;
+            out[2*i+1] = vq;
+        }
+    }
+    range->imin = imin;
+    range->imax = imax;
+    range->qmin = qmin;
+    range->qmax = qmax;
+}
+
+static uint64_t energy_scalar(const short *xi, const short *xq, unsigned int n)
+{
+    uint64_t energy = 0;
+    for (unsigned int i = 0; i < n; i++)
+        energy += (uint32_t)(xi[i] * xi[i]) + (uint32_t)(xq[i] * xq[i]);
+    return energy;
+}
+
+#ifdef IQ_KERNELS_X86
+__attribute__((target("sse2")))
+static short hmin_epi16(__m128i v)
+{
+    v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_min_epi16(v, _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (short)_mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("sse2")))
+static short hmax_epi16(__m128i v)
+{
+    v = _mm_max_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_epi16(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_epi16(v, _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (short)_mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("sse2")))
+static void interleave_minmax_sse2(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range)
+{
+    __m128i vimin = _mm_set1_epi16(range->imin);
+    __m128i vimax = _mm_set1_epi16(range->imax);
+    __m128i vqmin = _mm_set1_epi16(range->qmin);
+    __m128i vqmax = _mm_set1_epi16(range->qmax);
+    unsigned int i = 0;
+    if (out != NULL) {
+        for (; i + 8 <= n; i += 8) {
+            __m128i vi = _mm_loadu_si128((const __m128i *)(xi + i));
+            __m128i vq = _mm_loadu_si128((const __m128i *)(xq + i));
+            vimin = _mm_min_epi16(vimin, vi);
+            vimax = _mm_max_epi16(vimax, vi);
+            vqmin = _mm_min_epi16(vqmin, vq);
+            vqmax = _mm_max_epi16(vqmax, vq);
+            _mm_storeu_si128((__m128i *)(out + 2*i), _mm_unpacklo_epi16(vi, vq));
+            _mm_storeu_si128((__m128i *)(out + 2*i + 8), _mm_unpackhi_epi16(vi, vq));
+        }
+    } else {
+        for (; i + 8 <= n; i += 8) {
+            __m128i vi = _mm_loadu_si128((const __m128i *)(xi + i));
+            __m128i vq = _mm_loadu_si128((const __m128i *)(xq + i));
+            vimin = _mm_min_epi16(vimin, vi);
+            vimax = _mm_max_epi16(vimax, vi);
+            vqmin = _mm_min_epi16(vqmin, vq);
+            vqmax = _mm_max_epi16(vqmax, vq);
+        }
+    }
+    range->imin = hmin_epi16(vimin);
+    range->imax = hmax_epi16(vimax);
+    range->qmin = hmin_epi16(vqmin);
+    range->qmax = hmax_epi16(vqmax);
+    interleave_minmax_scalar(xi + i, xq + i, out != NULL ? out + 2*i : NULL, n - i, range);
+}
+
+__attribute__((target("avx2")))
+static void interleave_minmax_avx2(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range)
+{
+    __m256i vimin = _mm256_set1_epi16(range->imin);
+    __m256i vimax = _mm256_set1_epi16(range->imax);
+    __m256i vqmin = _mm256_set1_epi16(range->qmin);
+    __m256i vqmax = _mm256_set1_epi16(range->qmax);
+    unsigned int i = 0;
+    if (out != NULL) {
+        for (; i + 16 <= n; i += 16) {
+            __m256i vi = _mm256_loadu_si256((const __m256i *)(xi + i));
+            __m256i vq = _mm256_loadu_si256((const __m256i *)(xq + i));
+            vimin = _mm256_min_epi16(vimin, vi);
+            vimax = _mm256_max_epi16(vimax, vi);
+            vqmin = _mm256_min_epi16(vqmin, vq);
+            vqmax = _mm256_max_epi16(vqmax, vq);
+            /* unpack works within each 128 bit lane: lo has samples 0-3
+             * and 8-11, hi has 4-7 and 12-15; put the halves back in order */
+            __m256i lo = _mm256_unpacklo_epi16(vi, vq);
+            __m256i hi = _mm256_unpackhi_epi16(vi, vq);
+            _mm256_storeu_si256((__m256i *)(out + 2*i), _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)(out + 2*i + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+    } else {
+        for (; i + 16 <= n; i += 16) {
+            __m256i vi = _mm256_loadu_si256((const __m256i *)(xi + i));
+            __m256i vq = _mm256_loadu_si256((const __m256i *)(xq + i));
+            vimin = _mm256_min_epi16(vimin, vi);
+            vimax = _mm256_max_epi16(vimax, vi);
+            vqmin = _mm256_min_epi16(vqmin, vq);
+            vqmax = _mm256_max_epi16(vqmax, vq);
+        }
+    }
+    range->imin = hmin_epi16(_mm_min_epi16(_mm256_castsi256_si128(vimin), _mm256_extracti128_si256(vimin, 1)));
+    range->imax = hmax_epi16(_mm_max_epi16(_mm256_castsi256_si128(vimax), _mm256_extracti128_si256(vimax, 1)));
+    range->qmin = hmin_epi16(_mm_min_epi16(_mm256_castsi256_si128(vqmin), _mm256_extracti128_si256(vqmin, 1)));
+    range->qmax = hmax_epi16(_mm_max_epi16(_mm256_castsi256_si128(vqmax), _mm256_extracti128_si256(vqmax, 1)));
+    interleave_minmax_scalar(xi + i, xq + i, out != NULL ? out + 2*i : NULL, n - i, range);
+}
+
+/* pmaddwd adds the squares of two adjacent samples: at most 2*32768^2 =
+ * 2^31, which only fits a 32 bit lane as unsigned, so each product is
+ * widened to 64 bits before it is accumulated */
+__attribute__((target("sse2")))
+static uint64_t energy_sse2(const short *xi, const short *xq, unsigned int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i vi = _mm_loadu_si128((const __m128i *)(xi + i));
+        __m128i vq = _mm_loadu_si128((const __m128i *)(xq + i));
+        __m128i ei = _mm_madd_epi16(vi, vi);
+        __m128i eq = _mm_madd_epi16(vq, vq);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(ei, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(ei, zero));
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(eq, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(eq, zero));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + energy_scalar(xi + i, xq + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t energy_avx2(const short *xi, const short *xq, unsigned int n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    unsigned int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i vi = _mm256_loadu_si256((const __m256i *)(xi + i));
+        __m256i vq = _mm256_loadu_si256((const __m256i *)(xq + i));
+        __m256i ei = _mm256_madd_epi16(vi, vi);
+        __m256i eq = _mm256_madd_epi16(vq, vq);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(ei)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(ei, 1)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(eq)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(eq, 1)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + energy_scalar(xi + i, xq + i, n - i);
+}
+#endif
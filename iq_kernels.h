@@ -0,0 +1,49 @@
+/* vectorized kernels for the I/Q samples hot path
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _IQ_KERNELS_H
+#define _IQ_KERNELS_H
+
+#include <stdint.h>
+
+typedef struct {
+    short imin, imax;
+    short qmin, qmax;
+} IQRange;
+
+/* in one pass over xi[] and xq[]: widen 'range' to include all the samples
+ * and, if 'out' is not NULL, store them interleaved (I,Q,I,Q,...) in out[] */
+typedef void (*IQInterleaveMinMaxFn)(const short *xi, const short *xq, short *out, unsigned int n, IQRange *range);
+
+/* the energy of a block: the sum of I^2+Q^2 over xi[] and xq[] (exact
+ * for any n up to 2^32 samples) */
+typedef uint64_t (*IQEnergyFn)(const short *xi, const short *xq, unsigned int n);
+
+typedef struct {
+    const char *name;
+    IQInterleaveMinMaxFn interleave_minmax;
+    IQEnergyFn energy;
+} IQKernel;
+
+/* all the variants, slowest (scalar) first; only the ones supported by
+ * this CPU are listed */
+extern const IQKernel *iq_kernels[];
+extern int iq_kernels_count;
+
+/* the variant selected by iq_kernels_init() */
+extern IQInterleaveMinMaxFn iq_interleave_minmax;
+extern IQEnergyFn iq_energy;
+extern const char *iq_kernel_name;
+
+/* select the variant named 'name', or if NULL the one that runs fastest
+ * on this CPU (after a brief calibration run of all the supported ones);
+ * returns -1 if 'name' is unknown or not supported */
+int iq_kernels_init(const char *name);
+
+#endif /* _IQ_KERNELS_H */
@@ -0,0 +1,219 @@
+/* microbenchmark for the I/Q samples hot path kernels
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#include "iq_kernels.h"
+#include "sample_format.h"
+
+static void usage(const char* progname);
+static double now(void);
+static unsigned int format_convert(const SampleFormatKernel *kernel, SampleFormat format, const short *in, unsigned int n, void *out);
+
+/* the results go here, so the calls are not optimized away */
+static volatile uint64_t energy_sink;
+
+
+int main(int argc, char *argv[])
+{
+    unsigned int num_samples = 1008;
+    double duration = 1.0;
+
+    int c;
+    while ((c = getopt(argc, argv, "n:t:h")) != -1) {
+        switch (c) {
+            case 'n':
+                if (sscanf(optarg, "%u", &num_samples) != 1 || num_samples == 0) {
+                    fprintf(stderr, "invalid number of samples: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 't':
+                if (sscanf(optarg, "%lg", &duration) != 1) {
+                    fprintf(stderr, "invalid duration: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    iq_kernels_init(NULL);
+
+    short *xi = malloc(num_samples * sizeof(short));
+    short *xq = malloc(num_samples * sizeof(short));
+    short *reference = malloc(num_samples * 2 * sizeof(short));
+    short *out = malloc(num_samples * 2 * sizeof(short));
+    unsigned int seed = 1;
+    for (unsigned int i = 0; i < num_samples; i++) {
+        xi[i] = (short)(rand_r(&seed) % 4096 - 2048);
+        xq[i] = (short)(rand_r(&seed) % 4096 - 2048);
+    }
+    IQRange reference_range = { SHRT_MAX, SHRT_MIN, SHRT_MAX, SHRT_MIN };
+    iq_kernels[0]->interleave_minmax(xi, xq, reference, num_samples, &reference_range);
+    uint64_t reference_energy = iq_kernels[0]->energy(xi, xq, num_samples);
+
+    fprintf(stdout, "samples per call: %u - selected at runtime: %s\n", num_samples, iq_kernel_name);
+    for (int k = 0; k < iq_kernels_count; k++) {
+        const IQKernel *kernel = iq_kernels[k];
+
+        /* check the result against the scalar version first */
+        IQRange range = { SHRT_MAX, SHRT_MIN, SHRT_MAX, SHRT_MIN };
+        memset(out, 0, num_samples * 2 * sizeof(short));
+        kernel->interleave_minmax(xi, xq, out, num_samples, &range);
+        int ok = memcmp(out, reference, num_samples * 2 * sizeof(short)) == 0 &&
+                 memcmp(&range, &reference_range, sizeof(range)) == 0;
+
+        for (int with_output = 1; with_output >= 0; with_output--) {
+            short *dst = with_output ? out : NULL;
+            unsigned long long calls = 0;
+            double start = now();
+            double elapsed;
+#ifdef HAVE_RDTSC
+            unsigned long long tsc_start = __rdtsc();
+#endif
+            do {
+                for (int i = 0; i < 1000; i++)
+                    kernel->interleave_minmax(xi, xq, dst, num_samples, &range);
+                calls += 1000;
+                elapsed = now() - start;
+            } while (elapsed < duration);
+            double samples = (double)calls * num_samples;
+#ifdef HAVE_RDTSC
+            double cycles_per_sample = (__rdtsc() - tsc_start) / samples;
+#else
+            double cycles_per_sample = 0.0;
+#endif
+            fprintf(stdout, "%-8s %-18s %s cycles/sample=%.3lf ns/sample=%.3lf Msamples/s=%.1lf\n", kernel->name, with_output ? "interleave+minmax" : "minmax", ok ? "ok" : "MISMATCH", cycles_per_sample, 1e9 * elapsed / samples, samples / elapsed / 1e6);
+        }
+
+        /* the block energy (for the squelch trigger) */
+        ok = kernel->energy(xi, xq, num_samples) == reference_energy;
+        unsigned long long calls = 0;
+        double start = now();
+        double elapsed;
+#ifdef HAVE_RDTSC
+        unsigned long long tsc_start = __rdtsc();
+#endif
+        do {
+            for (int i = 0; i < 1000; i++)
+                energy_sink = kernel->energy(xi, xq, num_samples);
+            calls += 1000;
+            elapsed = now() - start;
+        } while (elapsed < duration);
+        double samples = (double)calls * num_samples;
+#ifdef HAVE_RDTSC
+        double cycles_per_sample = (__rdtsc() - tsc_start) / samples;
+#else
+        double cycles_per_sample = 0.0;
+#endif
+        fprintf(stdout, "%-8s %-18s %s cycles/sample=%.3lf ns/sample=%.3lf Msamples/s=%.1lf\n", kernel->name, "energy", ok ? "ok" : "MISMATCH", cycles_per_sample, 1e9 * elapsed / samples, samples / elapsed / 1e6);
+    }
+
+    /* the output format conversions, over the full int16 range (so the
+     * saturation is exercised too) */
+    sample_format_init();
+    short *in = malloc(num_samples * 2 * sizeof(short));
+    for (unsigned int i = 0; i < 2 * num_samples; i++)
+        in[i] = (short)(rand_r(&seed) % 65536 - 32768);
+    size_t out_size = num_samples * 2 * sizeof(float) + SAMPLE_FORMAT_PADDING;
+    char *format_reference = malloc(out_size);
+    char *format_out = malloc(out_size);
+    fprintf(stdout, "output formats - selected at runtime: %s\n", sample_format_kernel->name);
+    for (SampleFormat format = SAMPLE_FORMAT_CF32; format <= SAMPLE_FORMAT_CS12; format++) {
+        size_t size = num_samples * sample_format_size(format);
+        unsigned int reference_clipped = format_convert(sample_format_kernels[0], format, in, num_samples, format_reference);
+        for (int k = 0; k < sample_format_kernels_count; k++) {
+            const SampleFormatKernel *kernel = sample_format_kernels[k];
+            memset(format_out, 0, out_size);
+            unsigned int clipped = format_convert(kernel, format, in, num_samples, format_out);
+            int ok = memcmp(format_out, format_reference, size) == 0 && clipped == reference_clipped;
+            unsigned long long calls = 0;
+            double start = now();
+            double elapsed;
+#ifdef HAVE_RDTSC
+            unsigned long long tsc_start = __rdtsc();
+#endif
+            do {
+                for (int i = 0; i < 1000; i++)
+                    energy_sink = format_convert(kernel, format, in, num_samples, format_out);
+                calls += 1000;
+                elapsed = now() - start;
+            } while (elapsed < duration);
+            double samples = (double)calls * num_samples;
+#ifdef HAVE_RDTSC
+            double cycles_per_sample = (__rdtsc() - tsc_start) / samples;
+#else
+            double cycles_per_sample = 0.0;
+#endif
+            char label[32];
+            snprintf(label, sizeof(label), "to_%s", sample_format_name(format));
+            fprintf(stdout, "%-8s %-18s %s cycles/sample=%.3lf ns/sample=%.3lf Msamples/s=%.1lf\n", kernel->name, label, ok ? "ok" : "MISMATCH", cycles_per_sample, 1e9 * elapsed / samples, samples / elapsed / 1e6);
+        }
+    }
+
+    free(xi);
+    free(xq);
+    free(reference);
+    free(out);
+    free(in);
+    free(format_reference);
+    free(format_out);
+    return 0;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...]\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -n <samples per call> (default: 1008)\n");
+    fprintf(stderr, "    -t <duration of each run (s)> (default: 1s)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+/* returns the number of saturated values */
+static unsigned int format_convert(const SampleFormatKernel *kernel, SampleFormat format, const short *in, unsigned int n, void *out)
+{
+    switch (format) {
+        case SAMPLE_FORMAT_CF32:
+            kernel->to_cf32(in, n, (float *)out);
+            return 0;
+        case SAMPLE_FORMAT_CS8:
+            return kernel->to_cs8(in, n, (float)sample_format_default_scale(format), out);
+        case SAMPLE_FORMAT_CS12:
+            return kernel->to_cs12(in, n, (float)sample_format_default_scale(format), out);
+        default:
+            return 0;
+    }
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
@@ -0,0 +1,642 @@
+/* TCP I/Q server: framed batches of samples for any number of clients
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "iq_server.h"
+
+#define IQ_SERVER_MAX_CHANNELS 2
+#define IQ_SERVER_MAX_CLIENTS 64
+#define IQ_SERVER_QUEUE_SIZE 32                    /* frames per client */
+#define IQ_SERVER_SNDBUF (4 * 1024 * 1024)
+#define IQ_SERVER_FLUSH_NS 20000000                /* a partial batch goes out after 20ms */
+#define IQ_SERVER_POLL_MS 2
+#define IQ_SERVER_DRAIN_NS 1000000000              /* at stop, for the clients to take what is queued */
+#define IQ_SERVER_ZEROCOPY_MIN (16 * 1024)         /* below this a copy is cheaper */
+
+/* a batch of samples, shared by all the clients of a channel */
+typedef struct Batch {
+    struct Batch *next_free;
+    int refs;
+    uint64_t sequence;
+    uint32_t flags;
+    uint64_t sample_index;
+    uint32_t first_sample_num;
+    uint32_t num_samples;
+    uint64_t gap_samples;
+    uint64_t start_ns;
+    short *samples;            /* page aligned */
+} Batch;
+
+/* the frame header is per client (the drops are); the batch stays here
+ * until the kernel is done with it */
+typedef struct {
+    Batch *batch;
+    IqFrameHeader header;
+    size_t offset;             /* bytes of the header and the samples sent */
+    int zerocopy;              /* a zerocopy send still holds it */
+    uint32_t zerocopy_id;      /* of the last one */
+} QueueEntry;
+
+typedef struct {
+    int fd;
+    int channel;
+    /* head: the oldest one not released yet, send: the next one to send
+     * (or that was sent in part), tail: where the next one goes */
+    QueueEntry queue[IQ_SERVER_QUEUE_SIZE];
+    uint64_t head;
+    uint64_t send;
+    uint64_t tail;
+    int epollout;
+    int zerocopy;              /* SO_ZEROCOPY accepted by the socket */
+    uint32_t zerocopy_next;    /* the id of the next zerocopy send */
+    uint32_t zerocopy_done;    /* all the ones before this are complete */
+    uint64_t dropped_samples;  /* for the next frame */
+    uint32_t dropped_flags;
+} Client;
+
+typedef struct {
+    int listen_fd;
+    char rx_id;
+    double sample_rate;
+    double frequency;
+    RingBuffer *source;
+    unsigned int block_offset; /* samples of the current block already taken */
+    uint64_t next_sample_index;
+    uint64_t gap_samples;      /* for the next batch */
+    Batch *current;            /* being filled */
+    uint64_t sequence;
+    int num_clients;
+    IqServerStats stats;
+} Channel;
+
+struct IqServer {
+    int epoll_fd;
+    Channel channels[IQ_SERVER_MAX_CHANNELS];
+    int num_channels;
+    Client *clients[IQ_SERVER_MAX_CLIENTS];
+    int num_clients;
+    Batch *free_batches;
+    pthread_t thread;
+    int running;
+    atomic_int stop;
+};
+
+static void *server_thread(void *arg);
+static int server_drained(const IqServer *server);
+static void channel_accept(IqServer *server, int channel_index);
+static void channel_source(IqServer *server, Channel *channel, uint64_t now_ns, int flush);
+static void channel_publish(IqServer *server, Channel *channel);
+static Client *client_find(IqServer *server, int fd);
+static void client_enqueue(IqServer *server, Client *client, Batch *batch);
+static int client_send(IqServer *server, Client *client);
+static void client_reap(IqServer *server, Client *client);
+static void client_release(IqServer *server, Client *client);
+static void client_close(IqServer *server, Client *client);
+static Batch *batch_get(IqServer *server);
+static void batch_unref(IqServer *server, Batch *batch);
+static uint64_t monotonic_ns(void);
+
+
+IqServer *iq_server_create(void)
+{
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+        fprintf(stderr, "epoll_create1() failed: %s\n", strerror(errno));
+        return NULL;
+    }
+    IqServer *server = (IqServer *)calloc(1, sizeof(IqServer));
+    server->epoll_fd = epoll_fd;
+    atomic_init(&server->stop, 0);
+    return server;
+}
+
+int iq_server_add_channel(IqServer *server, const char *address, int port, char rx_id, double sample_rate, double frequency, RingBuffer *source)
+{
+    if (server->num_channels == IQ_SERVER_MAX_CHANNELS)
+        return -1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        fprintf(stderr, "invalid server address: %s\n", address);
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        fprintf(stderr, "socket() failed: %s\n", strerror(errno));
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, 16) == -1) {
+        fprintf(stderr, "bind(%s:%d) failed: %s\n", address, port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    struct epoll_event event = { .events = EPOLLIN, .data.fd = fd };
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        fprintf(stderr, "epoll_ctl() failed: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    Channel *channel = &server->channels[server->num_channels++];
+    memset(channel, 0, sizeof(Channel));
+    channel->listen_fd = fd;
+    channel->rx_id = rx_id;
+    channel->sample_rate = sample_rate;
+    channel->frequency = frequency;
+    channel->source = source;
+    channel->next_sample_index = UINT64_MAX;
+    return 0;
+}
+
+int iq_server_start(IqServer *server)
+{
+    int ret = pthread_create(&server->thread, NULL, server_thread, server);
+    if (ret != 0) {
+        fprintf(stderr, "pthread_create(server) failed: %s\n", strerror(ret));
+        return -1;
+    }
+    server->running = 1;
+    return 0;
+}
+
+void iq_server_stop(IqServer *server)
+{
+    if (!server->running)
+        return;
+    atomic_store(&server->stop, 1);
+    pthread_join(server->thread, NULL);
+    server->running = 0;
+}
+
+void iq_server_stats(const IqServer *server, int channel, IqServerStats *stats)
+{
+    *stats = server->channels[channel].stats;
+}
+
+void iq_server_free(IqServer *server)
+{
+    if (server == NULL)
+        return;
+    iq_server_stop(server);
+    while (server->num_clients > 0)
+        client_close(server, server->clients[0]);
+    for (int i = 0; i < server->num_channels; i++) {
+        Channel *channel = &server->channels[i];
+        close(channel->listen_fd);
+        if (channel->current != NULL)
+            batch_unref(server, channel->current);
+    }
+    while (server->free_batches != NULL) {
+        Batch *batch = server->free_batches;
+        server->free_batches = batch->next_free;
+        free(batch->samples);
+        free(batch);
+    }
+    close(server->epoll_fd);
+    free(server);
+}
+
+
+/* the event loop: new clients, room in the socket buffers (and the
+ * zerocopy completions), and the new samples in the ring buffers, every
+ * few milliseconds */
+static void *server_thread(void *arg)
+{
+    IqServer *server = (IqServer *)arg;
+    struct epoll_event events[IQ_SERVER_MAX_CLIENTS + IQ_SERVER_MAX_CHANNELS];
+    uint64_t drain_until = 0;
+
+    while (1) {
+        int stop = atomic_load(&server->stop);
+        int n = epoll_wait(server->epoll_fd, events, sizeof(events) / sizeof(events[0]), IQ_SERVER_POLL_MS);
+        if (n == -1 && errno != EINTR) {
+            fprintf(stderr, "epoll_wait() failed: %s\n", strerror(errno));
+            break;
+        }
+        for (int k = 0; k < n; k++) {
+            int fd = events[k].data.fd;
+            int channel_index = -1;
+            for (int i = 0; i < server->num_channels; i++)
+                if (server->channels[i].listen_fd == fd)
+                    channel_index = i;
+            if (channel_index >= 0) {
+                channel_accept(server, channel_index);
+                continue;
+            }
+            Client *client = client_find(server, fd);
+            if (client == NULL)
+                continue;
+            /* the zerocopy completions come through the error queue (and
+             * a real error is still there after them) */
+            if (events[k].events & EPOLLERR) {
+                client_reap(server, client);
+                int error = 0;
+                socklen_t error_len = sizeof(error);
+                if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_len) == -1 || error != 0) {
+                    client_close(server, client);
+                    continue;
+                }
+            }
+            if (events[k].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+                /* the clients are not supposed to send anything: this is
+                 * the end of the connection (or the end of the client) */
+                char discard[256];
+                ssize_t nread = recv(fd, discard, sizeof(discard), MSG_DONTWAIT);
+                if (nread == 0 || (nread == -1 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    client_close(server, client);
+                    continue;
+                }
+            }
+            if ((events[k].events & EPOLLOUT) && client_send(server, client) == -1)
+                client_close(server, client);
+        }
+
+        uint64_t now_ns = monotonic_ns();
+        for (int i = 0; i < server->num_channels; i++)
+            channel_source(server, &server->channels[i], now_ns, stop);
+
+        if (stop) {
+            if (drain_until == 0)
+                drain_until = now_ns + IQ_SERVER_DRAIN_NS;
+            if (server_drained(server) || now_ns >= drain_until)
+                break;
+        }
+    }
+
+    while (server->num_clients > 0)
+        client_close(server, server->clients[0]);
+    return NULL;
+}
+
+static int server_drained(const IqServer *server)
+{
+    for (int i = 0; i < server->num_clients; i++)
+        if (server->clients[i]->send < server->clients[i]->tail)
+            return 0;
+    return 1;
+}
+
+static void channel_accept(IqServer *server, int channel_index)
+{
+    Channel *channel = &server->channels[channel_index];
+    while (1) {
+        struct sockaddr_in addr;
+        socklen_t addrlen = sizeof(addr);
+        int fd = accept4(channel->listen_fd, (struct sockaddr *)&addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                fprintf(stderr, "server %c - accept() failed: %s\n", channel->rx_id, strerror(errno));
+            return;
+        }
+        if (server->num_clients == IQ_SERVER_MAX_CLIENTS) {
+            fprintf(stderr, "server %c - too many clients\n", channel->rx_id);
+            close(fd);
+            continue;
+        }
+        /* the frames are large, so TCP_NODELAY only makes sure the last
+         * segment of each one does not wait for an ACK */
+        int one = 1;
+        int sndbuf = IQ_SERVER_SNDBUF;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        Client *client = (Client *)calloc(1, sizeof(Client));
+        client->fd = fd;
+        client->channel = channel_index;
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+        client->zerocopy = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+#endif
+
+        /* the socket buffer is empty: the stream header goes right away */
+        IqStreamHeader header = {
+            .magic = IQ_STREAM_MAGIC,
+            .version = IQ_STREAM_VERSION,
+            .rx_id = channel->rx_id,
+            .format = "cs16",
+            .frame_header_size = sizeof(IqFrameHeader),
+            .batch_samples = IQ_SERVER_BATCH_SAMPLES,
+            .sample_rate = channel->sample_rate,
+            .frequency = channel->frequency
+        };
+        struct epoll_event event = { .events = EPOLLIN | EPOLLRDHUP, .data.fd = fd };
+        if (send(fd, &header, sizeof(header), MSG_DONTWAIT | MSG_NOSIGNAL) != sizeof(header) ||
+            epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            fprintf(stderr, "server %c - client setup failed: %s\n", channel->rx_id, strerror(errno));
+            close(fd);
+            free(client);
+            continue;
+        }
+        server->clients[server->num_clients++] = client;
+        channel->num_clients++;
+        channel->stats.clients++;
+        char address[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &addr.sin_addr, address, sizeof(address));
+        fprintf(stderr, "server %c - client %s:%d connected (zerocopy=%d)\n", channel->rx_id, address, ntohs(addr.sin_port), client->zerocopy);
+    }
+}
+
+/* batch the new samples; a gap, a full batch, or a batch that has been
+ * waiting long enough (or the stop) sends it */
+static void channel_source(IqServer *server, Channel *channel, uint64_t now_ns, int flush)
+{
+    const void *ptr;
+    while (ring_buffer_read_ptr(channel->source, &ptr) >= sizeof(IqServerBlock)) {
+        const IqServerBlock *block = (const IqServerBlock *)ptr;
+        uint64_t sample_index = block->sample_index + channel->block_offset;
+        if (channel->next_sample_index != UINT64_MAX && sample_index > channel->next_sample_index) {
+            if (channel->current != NULL)
+                channel_publish(server, channel);
+            channel->gap_samples += sample_index - channel->next_sample_index;
+        }
+        unsigned int n = block->num_samples - channel->block_offset;
+        /* without clients only the sample numbers are tracked */
+        if (channel->num_clients > 0) {
+            if (channel->current == NULL) {
+                Batch *batch = batch_get(server);
+                batch->flags = channel->gap_samples > 0 ? IQ_FRAME_GAP : 0;
+                batch->sample_index = sample_index;
+                batch->first_sample_num = block->first_sample_num + channel->block_offset;
+                batch->gap_samples = channel->gap_samples;
+                batch->start_ns = now_ns;
+                channel->gap_samples = 0;
+                channel->current = batch;
+            }
+            Batch *batch = channel->current;
+            if (n > IQ_SERVER_BATCH_SAMPLES - batch->num_samples)
+                n = IQ_SERVER_BATCH_SAMPLES - batch->num_samples;
+            memcpy(batch->samples + batch->num_samples * 2, (const short *)(block + 1) + channel->block_offset * 2, n * 2 * sizeof(short));
+            batch->num_samples += n;
+            if (batch->num_samples == IQ_SERVER_BATCH_SAMPLES)
+                channel_publish(server, channel);
+        } else {
+            channel->gap_samples = 0;
+        }
+        channel->next_sample_index = sample_index + n;
+        channel->block_offset += n;
+        if (channel->block_offset == block->num_samples) {
+            ring_buffer_release(channel->source, IQ_SERVER_BLOCK_SIZE(block->num_samples));
+            channel->block_offset = 0;
+        }
+    }
+    if (channel->current != NULL && (flush || channel->num_clients == 0 || now_ns - channel->current->start_ns >= IQ_SERVER_FLUSH_NS))
+        channel_publish(server, channel);
+}
+
+static void channel_publish(IqServer *server, Channel *channel)
+{
+    Batch *batch = channel->current;
+    channel->current = NULL;
+    batch->sequence = channel->sequence++;
+    channel->stats.frames++;
+    int channel_index = channel - server->channels;
+    for (int i = 0; i < server->num_clients; i++) {
+        Client *client = server->clients[i];
+        if (client->channel != channel_index)
+            continue;
+        client_enqueue(server, client, batch);
+        if (client_send(server, client) == -1) {
+            client_close(server, client);
+            i--;
+        }
+    }
+    batch_unref(server, batch);
+}
+
+static Client *client_find(IqServer *server, int fd)
+{
+    for (int i = 0; i < server->num_clients; i++)
+        if (server->clients[i]->fd == fd)
+            return server->clients[i];
+    return NULL;
+}
+
+/* with a full queue the oldest frame not sent yet is dropped (the ones
+ * sent, even in part, stay until the kernel is done with them); the frame
+ * right after it tells the client */
+static void client_enqueue(IqServer *server, Client *client, Batch *batch)
+{
+    Channel *channel = &server->channels[client->channel];
+    if (client->tail - client->head == IQ_SERVER_QUEUE_SIZE) {
+        uint64_t oldest = client->send;
+        if (oldest < client->tail && client->queue[oldest % IQ_SERVER_QUEUE_SIZE].offset > 0)
+            oldest++;
+        channel->stats.frames_dropped++;
+        if (oldest == client->tail) {
+            /* all of them are still in the hands of the kernel: this one
+             * goes instead */
+            client->dropped_samples += batch->gap_samples + batch->num_samples;
+            client->dropped_flags |= batch->flags | IQ_FRAME_CLIENT_DROP;
+            return;
+        }
+        QueueEntry *dropped = &client->queue[oldest % IQ_SERVER_QUEUE_SIZE];
+        uint64_t dropped_samples = dropped->header.dropped_samples + dropped->header.num_samples;
+        uint32_t dropped_flags = dropped->header.flags | IQ_FRAME_CLIENT_DROP;
+        batch_unref(server, dropped->batch);
+        for (uint64_t k = oldest; k + 1 < client->tail; k++)
+            client->queue[k % IQ_SERVER_QUEUE_SIZE] = client->queue[(k + 1) % IQ_SERVER_QUEUE_SIZE];
+        client->tail--;
+        if (oldest < client->tail) {
+            QueueEntry *next = &client->queue[oldest % IQ_SERVER_QUEUE_SIZE];
+            next->header.dropped_samples += dropped_samples;
+            next->header.flags |= dropped_flags;
+        } else {
+            client->dropped_samples += dropped_samples;
+            client->dropped_flags |= dropped_flags;
+        }
+    }
+    QueueEntry *entry = &client->queue[client->tail % IQ_SERVER_QUEUE_SIZE];
+    entry->batch = batch;
+    batch->refs++;
+    entry->header.magic = IQ_FRAME_MAGIC;
+    entry->header.flags = batch->flags | client->dropped_flags;
+    entry->header.sequence = batch->sequence;
+    entry->header.sample_index = batch->sample_index;
+    entry->header.first_sample_num = batch->first_sample_num;
+    entry->header.num_samples = batch->num_samples;
+    entry->header.dropped_samples = batch->gap_samples + client->dropped_samples;
+    entry->offset = 0;
+    entry->zerocopy = 0;
+    client->dropped_samples = 0;
+    client->dropped_flags = 0;
+    client->tail++;
+}
+
+/* as much as the socket takes without blocking; returns -1 if the
+ * connection is gone */
+static int client_send(IqServer *server, Client *client)
+{
+    Channel *channel = &server->channels[client->channel];
+    while (client->send < client->tail) {
+        QueueEntry *entry = &client->queue[client->send % IQ_SERVER_QUEUE_SIZE];
+        size_t header_size = sizeof(IqFrameHeader);
+        size_t frame_size = header_size + entry->header.num_samples * 2 * sizeof(short);
+        struct iovec iov[2];
+        int iovcnt = 0;
+        if (entry->offset < header_size) {
+            iov[iovcnt].iov_base = (char *)&entry->header + entry->offset;
+            iov[iovcnt++].iov_len = header_size - entry->offset;
+            iov[iovcnt].iov_base = entry->batch->samples;
+            iov[iovcnt++].iov_len = frame_size - header_size;
+        } else {
+            iov[iovcnt].iov_base = (char *)entry->batch->samples + (entry->offset - header_size);
+            iov[iovcnt++].iov_len = frame_size - entry->offset;
+        }
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iovcnt };
+        int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+        int zerocopy = 0;
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+        zerocopy = client->zerocopy && frame_size - header_size >= IQ_SERVER_ZEROCOPY_MIN;
+        if (zerocopy && entry->offset < header_size) {
+            /* the header is copied on its own: only the batches are given
+             * to the kernel, since they outlive the client */
+            msg.msg_iovlen = 1;
+            flags |= MSG_MORE;
+            zerocopy = 0;
+        }
+#endif
+        ssize_t sent = sendmsg(client->fd, &msg, flags | (zerocopy ? MSG_ZEROCOPY : 0));
+        if (sent == -1 && zerocopy && errno == ENOBUFS) {
+            /* out of socket memory for the notifications: copy this time */
+            zerocopy = 0;
+            sent = sendmsg(client->fd, &msg, flags);
+        }
+        if (sent == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return -1;
+        }
+        if (zerocopy) {
+            entry->zerocopy = 1;
+            entry->zerocopy_id = client->zerocopy_next++;
+            channel->stats.zerocopy_sends++;
+        }
+        entry->offset += sent;
+        channel->stats.bytes_sent += sent;
+        if (entry->offset == frame_size) {
+            client->send++;
+            channel->stats.frames_sent++;
+        }
+    }
+    client_release(server, client);
+
+    /* EPOLLOUT only while there is something waiting */
+    int epollout = client->send < client->tail;
+    if (epollout != client->epollout) {
+        struct epoll_event event = { .events = EPOLLIN | EPOLLRDHUP | (epollout ? EPOLLOUT : 0), .data.fd = client->fd };
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+        client->epollout = epollout;
+    }
+    return 0;
+}
+
+/* the zerocopy completions: ranges of send ids the kernel is done with */
+static void client_reap(IqServer *server, Client *client)
+{
+    Channel *channel = &server->channels[client->channel];
+    while (1) {
+        char control[256];
+        struct msghdr msg = { .msg_control = control, .msg_controllen = sizeof(control) };
+        if (recvmsg(client->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+            break;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+                !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+                continue;
+            struct sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            if ((int32_t)(err.ee_data + 1 - client->zerocopy_done) > 0)
+                client->zerocopy_done = err.ee_data + 1;
+            if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                channel->stats.zerocopy_copied += err.ee_data - err.ee_info + 1;
+        }
+    }
+    client_release(server, client);
+}
+
+/* the frames sent, whose pages the kernel does not hold anymore */
+static void client_release(IqServer *server, Client *client)
+{
+    while (client->head < client->send) {
+        QueueEntry *entry = &client->queue[client->head % IQ_SERVER_QUEUE_SIZE];
+        if (entry->zerocopy && (int32_t)(client->zerocopy_done - entry->zerocopy_id) <= 0)
+            break;
+        batch_unref(server, entry->batch);
+        entry->batch = NULL;
+        client->head++;
+    }
+}
+
+/* the batches still held by the kernel for this socket are only read by
+ * it, and they are never unmapped, so they can go back to the pool */
+static void client_close(IqServer *server, Client *client)
+{
+    Channel *channel = &server->channels[client->channel];
+    for (uint64_t k = client->head; k < client->tail; k++)
+        batch_unref(server, client->queue[k % IQ_SERVER_QUEUE_SIZE].batch);
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    fprintf(stderr, "server %c - client disconnected\n", channel->rx_id);
+    channel->num_clients--;
+    for (int i = 0; i < server->num_clients; i++) {
+        if (server->clients[i] == client) {
+            server->clients[i] = server->clients[--server->num_clients];
+            break;
+        }
+    }
+    free(client);
+}
+
+static Batch *batch_get(IqServer *server)
+{
+    Batch *batch = server->free_batches;
+    if (batch != NULL) {
+        server->free_batches = batch->next_free;
+    } else {
+        batch = (Batch *)malloc(sizeof(Batch));
+        batch->samples = (short *)aligned_alloc(4096, IQ_SERVER_BATCH_SAMPLES * 2 * sizeof(short));
+    }
+    batch->next_free = NULL;
+    batch->refs = 1;
+    batch->num_samples = 0;
+    return batch;
+}
+
+static void batch_unref(IqServer *server, Batch *batch)
+{
+    if (--batch->refs > 0)
+        return;
+    batch->next_free = server->free_batches;
+    server->free_batches = batch;
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
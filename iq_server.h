@@ -0,0 +1,92 @@
+/* TCP I/Q server: framed batches of samples for any number of clients
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _IQ_SERVER_H
+#define _IQ_SERVER_H
+
+#include <stdint.h>
+
+#include "ring_buffer.h"
+
+/* each client gets an IqStreamHeader when it connects, then a sequence of
+ * frames: an IqFrameHeader followed by num_samples interleaved int16 I/Q
+ * samples (in the host byte order); the frames of a channel are the same
+ * batches of samples for all the clients, but a client that does not keep
+ * up has the oldest frames still waiting in its queue dropped, and the
+ * next one it gets says so */
+
+#define IQ_STREAM_MAGIC "IQSTREAM"
+#define IQ_STREAM_VERSION 1
+#define IQ_FRAME_MAGIC 0x52465149      /* 'IQFR' in little endian */
+#define IQ_SERVER_BATCH_SAMPLES (64 * 1024)     /* the largest frames (256kB) */
+
+#define IQ_FRAME_GAP         0x01      /* samples missing before this frame at
+                                        * the source (dropped by the RSPduo,
+                                        * or by the recorder) */
+#define IQ_FRAME_CLIENT_DROP 0x02      /* frames dropped for this client
+                                        * before this one */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    char rx_id;
+    char reserved[3];
+    char format[8];            /* 'cs16' */
+    uint32_t frame_header_size;
+    uint32_t batch_samples;    /* the maximum samples per frame */
+    double sample_rate;
+    double frequency;
+} IqStreamHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t sequence;         /* frame number (the same for all the clients) */
+    uint64_t sample_index;     /* the unwrapped sample number of the first sample */
+    uint32_t first_sample_num; /* the same, as received from the SDRplay API */
+    uint32_t num_samples;
+    uint64_t dropped_samples;  /* missing since the previous frame sent to
+                                * this client (both the gaps and the drops) */
+} IqFrameHeader;
+
+/* the stream callbacks queue the samples for the server thread in a ring
+ * buffer per channel: this header, then num_samples interleaved samples */
+typedef struct {
+    uint64_t sample_index;
+    uint32_t first_sample_num;
+    uint32_t num_samples;
+} IqServerBlock;
+
+#define IQ_SERVER_BLOCK_SIZE(num_samples) ((sizeof(IqServerBlock) + (num_samples) * 2 * sizeof(short) + 7) & ~(size_t)7)
+
+typedef struct IqServer IqServer;
+
+typedef struct {
+    unsigned long long clients;        /* accepted since the start */
+    unsigned long long frames;         /* batches */
+    unsigned long long frames_sent;    /* to all the clients */
+    unsigned long long bytes_sent;
+    unsigned long long frames_dropped; /* for the clients that did not keep up */
+    unsigned long long zerocopy_sends;
+    unsigned long long zerocopy_copied;/* the kernel had to copy them anyway
+                                        * (always the case over loopback) */
+} IqServerStats;
+
+IqServer *iq_server_create(void);
+/* listen on address:port for the samples of a channel, taken from source;
+ * returns -1 (after printing the reason) if that fails */
+int iq_server_add_channel(IqServer *server, const char *address, int port, char rx_id, double sample_rate, double frequency, RingBuffer *source);
+/* the event loop runs in its own thread; stop takes what is still in the
+ * ring buffers, and closes all the connections */
+int iq_server_start(IqServer *server);
+void iq_server_stop(IqServer *server);
+void iq_server_stats(const IqServer *server, int channel, IqServerStats *stats);
+void iq_server_free(IqServer *server);
+
+#endif /* _IQ_SERVER_H */
@@ -0,0 +1,338 @@
+/* load generating client for the TCP I/Q server of dual_tuner_recorder
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "iq_server.h"
+
+#define MAX_CONNECTIONS 64
+#define MAX_PORTS 2
+#define DEFAULT_ADDRESS "127.0.0.1"
+#define DEFAULT_CONNECTIONS 4
+#define DEFAULT_STREAMING_TIME 10.0
+#define CONNECT_TIMEOUT 5.0
+#define RECEIVE_TIMEOUT_MS 200
+
+typedef struct {
+    int id;
+    const char *address;
+    int port;
+    double wait_ms;            /* after each frame (0 for a fast client) */
+    pthread_t thread;
+    atomic_int done;
+    /* the results */
+    int connected;
+    char rx_id;
+    double sample_rate;
+    double elapsed;
+    unsigned long long frames;
+    unsigned long long bytes;
+    unsigned long long dropped_frames;     /* from the frame numbers */
+    unsigned long long client_drop_frames; /* with IQ_FRAME_CLIENT_DROP */
+    unsigned long long gap_frames;         /* with IQ_FRAME_GAP */
+    unsigned long long dropped_samples;
+    unsigned long long continuity_errors;
+} Connection;
+
+static void usage(const char* progname);
+static void *connection_thread(void *arg);
+static int connect_retry(const char *address, int port);
+static int recv_all(int fd, void *buffer, size_t size);
+static void stop_handler(int signum);
+static double now(void);
+
+static atomic_int stop = 0;
+
+
+int main(int argc, char *argv[])
+{
+    const char *address = DEFAULT_ADDRESS;
+    int num_connections = DEFAULT_CONNECTIONS;
+    double streaming_time = DEFAULT_STREAMING_TIME;
+    double wait_ms = 0.0;
+    int num_slow = -1;
+
+    int c;
+    while ((c = getopt(argc, argv, "a:c:x:w:s:h")) != -1) {
+        switch (c) {
+            case 'a':
+                address = optarg;
+                break;
+            case 'c':
+                if (sscanf(optarg, "%d", &num_connections) != 1 || num_connections < 1 || num_connections > MAX_CONNECTIONS) {
+                    fprintf(stderr, "invalid number of connections: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'x':
+                if (sscanf(optarg, "%lg", &streaming_time) != 1 || streaming_time < 0) {
+                    fprintf(stderr, "invalid streaming time: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'w':
+                if (sscanf(optarg, "%lg", &wait_ms) != 1 || wait_ms < 0) {
+                    fprintf(stderr, "invalid wait: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 's':
+                if (sscanf(optarg, "%d", &num_slow) != 1 || num_slow < 0) {
+                    fprintf(stderr, "invalid number of slow connections: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        exit(1);
+    }
+    int ports[MAX_PORTS];
+    int num_ports = sscanf(argv[optind], "%d,%d", &ports[0], &ports[1]);
+    if (num_ports < 1) {
+        fprintf(stderr, "invalid ports: %s\n", argv[optind]);
+        exit(1);
+    }
+    if (num_slow < 0 || num_slow > num_connections)
+        num_slow = num_connections;
+
+    struct sigaction stop_action = { .sa_handler = stop_handler };
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+
+    /* the connections go round robin to the ports */
+    Connection *connections = (Connection *)calloc(num_connections, sizeof(Connection));
+    for (int i = 0; i < num_connections; i++) {
+        Connection *connection = &connections[i];
+        connection->id = i;
+        connection->address = address;
+        connection->port = ports[i % num_ports];
+        connection->wait_ms = i < num_slow ? wait_ms : 0.0;
+        atomic_init(&connection->done, 0);
+        int ret = pthread_create(&connection->thread, NULL, connection_thread, connection);
+        if (ret != 0) {
+            fprintf(stderr, "pthread_create() failed: %s\n", strerror(ret));
+            exit(1);
+        }
+    }
+
+    double start = now();
+    const struct timespec poll_interval = { 0, 100000000 };
+    while (!atomic_load(&stop) && (streaming_time == 0 || now() - start < streaming_time)) {
+        /* with no time limit, until the server closes all the connections */
+        int running = 0;
+        for (int i = 0; i < num_connections; i++)
+            running += !atomic_load(&connections[i].done);
+        if (running == 0)
+            break;
+        nanosleep(&poll_interval, NULL);
+    }
+    atomic_store(&stop, 1);
+    for (int i = 0; i < num_connections; i++)
+        pthread_join(connections[i].thread, NULL);
+
+    Connection total = { 0 };
+    int connected = 0;
+    double throughput = 0.0;
+    for (int i = 0; i < num_connections; i++) {
+        Connection *connection = &connections[i];
+        if (!connection->connected)
+            continue;
+        double MBps = connection->elapsed > 0 ? connection->bytes / connection->elapsed / 1e6 : 0.0;
+        fprintf(stderr, "connection %d - port=%d rx_id=%c wait_ms=%.1lf frames=%llu bytes=%llu throughput_MBps=%.1lf dropped_frames=%llu client_drop_frames=%llu gap_frames=%llu dropped_samples=%llu continuity_errors=%llu\n", connection->id, connection->port, connection->rx_id, connection->wait_ms, connection->frames, connection->bytes, MBps, connection->dropped_frames, connection->client_drop_frames, connection->gap_frames, connection->dropped_samples, connection->continuity_errors);
+        connected++;
+        throughput += MBps;
+        total.frames += connection->frames;
+        total.bytes += connection->bytes;
+        total.dropped_frames += connection->dropped_frames;
+        total.dropped_samples += connection->dropped_samples;
+        total.continuity_errors += connection->continuity_errors;
+    }
+    fprintf(stderr, "total - connections=%d/%d frames=%llu bytes=%llu throughput_MBps=%.1lf dropped_frames=%llu dropped_samples=%llu continuity_errors=%llu\n", connected, num_connections, total.frames, total.bytes, throughput, total.dropped_frames, total.dropped_samples, total.continuity_errors);
+
+    free(connections);
+    return connected == num_connections && total.continuity_errors == 0 ? 0 : 1;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...] <A port>[,<B port>]\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -a <server address> (default: %s)\n", DEFAULT_ADDRESS);
+    fprintf(stderr, "    -c <number of connections> (round robin to the ports) (default: %d)\n", DEFAULT_CONNECTIONS);
+    fprintf(stderr, "    -x <streaming time (s)> (default: %.0lf - 0 until the server closes the connections)\n", DEFAULT_STREAMING_TIME);
+    fprintf(stderr, "    -w <wait after each frame (ms)> (to emulate slow clients) (default: 0)\n");
+    fprintf(stderr, "    -s <number of slow connections> (the first ones wait after each frame) (default: all of them)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+/* read the frames, and check them: the frame numbers, and the sample
+ * numbers with the drops */
+static void *connection_thread(void *arg)
+{
+    Connection *connection = (Connection *)arg;
+    int fd = connect_retry(connection->address, connection->port);
+    if (fd == -1) {
+        atomic_store(&connection->done, 1);
+        return NULL;
+    }
+    struct timeval timeout = { 0, RECEIVE_TIMEOUT_MS * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    IqStreamHeader header;
+    int ret = recv_all(fd, &header, sizeof(header));
+    if (ret != 1) {
+        if (!atomic_load(&stop))
+            fprintf(stderr, "connection %d - closed by the server before the stream header\n", connection->id);
+        close(fd);
+        atomic_store(&connection->done, 1);
+        return NULL;
+    }
+    if (memcmp(header.magic, IQ_STREAM_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != IQ_STREAM_VERSION || header.frame_header_size != sizeof(IqFrameHeader)) {
+        fprintf(stderr, "connection %d - invalid stream header\n", connection->id);
+        close(fd);
+        atomic_store(&connection->done, 1);
+        return NULL;
+    }
+    connection->connected = 1;
+    connection->rx_id = header.rx_id;
+    connection->sample_rate = header.sample_rate;
+    size_t buffer_size = header.batch_samples * 2 * sizeof(short);
+    short *samples = (short *)malloc(buffer_size);
+    struct timespec wait = { (time_t)(connection->wait_ms / 1000), (long)(connection->wait_ms * 1e6) % 1000000000 };
+
+    double start = now();
+    int first = 1;
+    uint64_t next_sequence = 0;
+    uint64_t next_sample_index = 0;
+    while (!atomic_load(&stop)) {
+        IqFrameHeader frame;
+        if (recv_all(fd, &frame, sizeof(frame)) != 1)
+            break;
+        if (frame.magic != IQ_FRAME_MAGIC || frame.num_samples * 2 * sizeof(short) > buffer_size) {
+            fprintf(stderr, "connection %d - invalid frame header\n", connection->id);
+            break;
+        }
+        if (recv_all(fd, samples, frame.num_samples * 2 * sizeof(short)) != 1)
+            break;
+        if (!first) {
+            if (frame.sequence != next_sequence)
+                connection->dropped_frames += frame.sequence - next_sequence;
+            if (frame.sample_index != next_sample_index + frame.dropped_samples)
+                connection->continuity_errors++;
+        }
+        first = 0;
+        next_sequence = frame.sequence + 1;
+        next_sample_index = frame.sample_index + frame.num_samples;
+        connection->frames++;
+        connection->bytes += sizeof(frame) + frame.num_samples * 2 * sizeof(short);
+        connection->dropped_samples += frame.dropped_samples;
+        if (frame.flags & IQ_FRAME_GAP)
+            connection->gap_frames++;
+        if (frame.flags & IQ_FRAME_CLIENT_DROP)
+            connection->client_drop_frames++;
+        if (connection->wait_ms > 0)
+            nanosleep(&wait, NULL);
+    }
+    connection->elapsed = now() - start;
+    free(samples);
+    close(fd);
+    atomic_store(&connection->done, 1);
+    return NULL;
+}
+
+static int connect_retry(const char *address, int port)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        fprintf(stderr, "invalid server address: %s\n", address);
+        return -1;
+    }
+    /* the server may still be starting */
+    double start = now();
+    const struct timespec retry_interval = { 0, 100000000 };
+    while (!atomic_load(&stop)) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            fprintf(stderr, "socket() failed: %s\n", strerror(errno));
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+            return fd;
+        int error = errno;
+        close(fd);
+        if (error != ECONNREFUSED || now() - start >= CONNECT_TIMEOUT) {
+            fprintf(stderr, "connect(%s:%d) failed: %s\n", address, port, strerror(error));
+            return -1;
+        }
+        nanosleep(&retry_interval, NULL);
+    }
+    return -1;
+}
+
+/* returns 1 when all of it is there, 0 at the end of the stream (or at
+ * the stop), and -1 on an error */
+static int recv_all(int fd, void *buffer, size_t size)
+{
+    size_t received = 0;
+    while (received < size) {
+        ssize_t n = recv(fd, (char *)buffer + received, size - received, 0);
+        if (n == 0)
+            return 0;
+        if (n == -1) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (atomic_load(&stop))
+                    return 0;
+                continue;
+            }
+            return -1;
+        }
+        received += n;
+    }
+    return 1;
+}
+
+static void stop_handler(int signum)
+{
+    (void)signum;
+    atomic_store(&stop, 1);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
@@ -0,0 +1,164 @@
+/* reader for the shared memory I/Q rings published by dual_tuner_recorder
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "shm_ring.h"
+
+#define READ_SAMPLES (64 * 1024)
+#define POLL_INTERVAL_NS 1000000
+
+static void usage(const char* progname);
+static void stop_handler(int signum);
+static double now(void);
+
+static volatile sig_atomic_t stop_requested = 0;
+
+
+int main(int argc, char *argv[])
+{
+    const char *output_file = NULL;
+    double streaming_time = 0.0;
+    double read_delay_ms = 0.0;
+
+    int c;
+    while ((c = getopt(argc, argv, "o:x:w:h")) != -1) {
+        switch (c) {
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'x':
+                if (sscanf(optarg, "%lg", &streaming_time) != 1 || streaming_time < 0) {
+                    fprintf(stderr, "invalid streaming time: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'w':
+                if (sscanf(optarg, "%lg", &read_delay_ms) != 1 || read_delay_ms < 0) {
+                    fprintf(stderr, "invalid read delay: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        exit(1);
+    }
+    const char *name = argv[optind];
+
+    ShmRingReader *reader = shm_ring_attach(name);
+    if (reader == NULL)
+        exit(1);
+    const ShmRingHeader *header = shm_ring_header(reader);
+    fprintf(stderr, "%s - rx_id=%c format=%s sample_rate=%.0lf frequency=%.0lf capacity=%llu producer_pid=%d\n", name, header->rx_id, header->format, header->sample_rate, header->frequency, (unsigned long long)header->capacity, header->producer_pid);
+
+    FILE *fp = NULL;
+    if (output_file != NULL) {
+        fp = strcmp(output_file, "-") == 0 ? stdout : fopen(output_file, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "fopen(%s) failed\n", output_file);
+            shm_ring_detach(reader);
+            exit(1);
+        }
+    }
+
+    struct sigaction stop_action = { .sa_handler = stop_handler };
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+
+    short *samples = (short *)malloc(READ_SAMPLES * 2 * sizeof(short));
+    const struct timespec poll_interval = { 0, POLL_INTERVAL_NS };
+    const struct timespec read_delay = { (time_t)(read_delay_ms / 1000), (long)(read_delay_ms * 1e6) % 1000000000 };
+    unsigned long long total_samples = 0;
+    unsigned long long dropped_events = 0;     /* by the recorder */
+    unsigned long long dropped_samples = 0;
+    uint64_t next_sample_index = UINT64_MAX;
+    double frequency = header->frequency;
+    unsigned long long retunes = 0;
+    double start = now();
+    while (!stop_requested && (streaming_time == 0 || now() - start < streaming_time)) {
+        ShmRingRead read;
+        int n = shm_ring_read(reader, samples, READ_SAMPLES, &read);
+        if (n == -1)
+            break;
+        if (n == 0) {
+            nanosleep(&poll_interval, NULL);
+            continue;
+        }
+        /* the gaps the reader did not cause are the recorder's */
+        if (next_sample_index != UINT64_MAX && read.sample_index != next_sample_index && read.lost_samples == 0) {
+            dropped_events++;
+            dropped_samples += read.sample_index - next_sample_index;
+        }
+        next_sample_index = read.sample_index + n;
+        if (read.frequency != frequency) {
+            frequency = read.frequency;
+            retunes++;
+        }
+        total_samples += n;
+        if (fp != NULL && fwrite(samples, 2 * sizeof(short), n, fp) != (size_t)n) {
+            fprintf(stderr, "fwrite(%s) failed\n", output_file);
+            break;
+        }
+        if (read_delay_ms > 0)
+            nanosleep(&read_delay, NULL);
+    }
+    double elapsed = now() - start;
+
+    unsigned long long lost_samples;
+    unsigned long long lags = shm_ring_lags(reader, &lost_samples);
+    fprintf(stderr, "%s - total_samples=%llu sample_rate=%.0lf lags=%llu lost_samples=%llu recorder_dropped_events=%llu recorder_dropped_samples=%llu retunes=%llu\n", name, total_samples, elapsed > 0 ? total_samples / elapsed : 0.0, lags, lost_samples, dropped_events, dropped_samples, retunes);
+
+    if (fp != NULL && fp != stdout)
+        fclose(fp);
+    free(samples);
+    shm_ring_detach(reader);
+    return 0;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...] <shared memory ring name>\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -o <output file> (the interleaved int16 samples; '-' for stdout) (default: none - only count them)\n");
+    fprintf(stderr, "    -x <streaming time (s)> (default: 0 - until the recorder stops)\n");
+    fprintf(stderr, "    -w <wait after each read (ms)> (to emulate a slow reader) (default: 0)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+static void stop_handler(int signum)
+{
+    (void)signum;
+    stop_requested = 1;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
@@ -0,0 +1,453 @@
+/* stand-in for the subset of the SDRplay API v3 header used by
+ * dual_tuner_recorder; only used when the real SDRplay API is not
+ * installed and the hardware-free mock is built (see mock_sdrplay_api.c)
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SDRPLAY_API_H
+#define SDRPLAY_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SDRPLAY_API_VERSION                   (float)(3.07)
+
+#define SDRPLAY_MAX_DEVICES                   (16)
+#define SDRPLAY_MAX_TUNERS_PER_DEVICE         (2)
+#define SDRPLAY_MAX_SER_NO_LEN                (64)
+#define SDRPLAY_MAX_ROOT_NM_LEN               (32)
+
+#define SDRPLAY_RSP1_ID                       (1)
+#define SDRPLAY_RSP1A_ID                      (255)
+#define SDRPLAY_RSP2_ID                       (2)
+#define SDRPLAY_RSPduo_ID                     (3)
+#define SDRPLAY_RSPdx_ID                      (4)
+
+#define MAX_BB_GR                             (59)
+
+typedef void *HANDLE;
+
+typedef enum
+{
+    sdrplay_api_Success               = 0,
+    sdrplay_api_Fail                  = 1,
+    sdrplay_api_InvalidParam          = 2,
+    sdrplay_api_OutOfRange            = 3,
+    sdrplay_api_GainUpdateError       = 4,
+    sdrplay_api_RfUpdateError         = 5,
+    sdrplay_api_FsUpdateError         = 6,
+    sdrplay_api_HwError               = 7,
+    sdrplay_api_AliasingError         = 8,
+    sdrplay_api_AlreadyInitialised    = 9,
+    sdrplay_api_NotInitialised        = 10,
+    sdrplay_api_NotEnabled            = 11,
+    sdrplay_api_HwVerError            = 12,
+    sdrplay_api_OutOfMemError         = 13,
+    sdrplay_api_ServiceNotResponding  = 14,
+    sdrplay_api_StartPending          = 15,
+    sdrplay_api_StopPending           = 16,
+    sdrplay_api_InvalidMode           = 17,
+    sdrplay_api_FailedVerification1   = 18,
+    sdrplay_api_FailedVerification2   = 19,
+    sdrplay_api_FailedVerification3   = 20,
+    sdrplay_api_FailedVerification4   = 21,
+    sdrplay_api_FailedVerification5   = 22,
+    sdrplay_api_FailedVerification6   = 23,
+    sdrplay_api_InvalidServiceVersion = 24
+} sdrplay_api_ErrT;
+
+typedef enum
+{
+    sdrplay_api_Update_None                        = 0x00000000,
+
+    // Reasons for master only mode
+    sdrplay_api_Update_Dev_Fs                      = 0x00000001,
+    sdrplay_api_Update_Dev_Ppm                     = 0x00000002,
+    sdrplay_api_Update_Dev_SyncUpdate              = 0x00000004,
+    sdrplay_api_Update_Dev_ResetFlags              = 0x00000008,
+
+    sdrplay_api_Update_Rsp1a_BiasTControl          = 0x00000010,
+    sdrplay_api_Update_Rsp1a_RfNotchControl        = 0x00000020,
+    sdrplay_api_Update_Rsp1a_RfDabNotchControl     = 0x00000040,
+
+    sdrplay_api_Update_Rsp2_BiasTControl           = 0x00000080,
+    sdrplay_api_Update_Rsp2_AmPortSelect           = 0x00000100,
+    sdrplay_api_Update_Rsp2_AntennaControl         = 0x00000200,
+    sdrplay_api_Update_Rsp2_RfNotchControl         = 0x00000400,
+    sdrplay_api_Update_Rsp2_ExtRefControl          = 0x00000800,
+
+    sdrplay_api_Update_RspDuo_ExtRefControl        = 0x00001000,
+
+    sdrplay_api_Update_Master_Spare_1              = 0x00002000,
+    sdrplay_api_Update_Master_Spare_2              = 0x00004000,
+
+    // Reasons for master and slave mode
+    sdrplay_api_Update_Tuner_Gr                    = 0x00008000,
+    sdrplay_api_Update_Tuner_GrLimits              = 0x00010000,
+    sdrplay_api_Update_Tuner_Frf                   = 0x00020000,
+    sdrplay_api_Update_Tuner_BwType                = 0x00040000,
+    sdrplay_api_Update_Tuner_IfType                = 0x00080000,
+    sdrplay_api_Update_Tuner_DcOffset              = 0x00100000,
+    sdrplay_api_Update_Tuner_LoMode                = 0x00200000,
+
+    sdrplay_api_Update_Ctrl_DCoffsetIQimbalance    = 0x00400000,
+    sdrplay_api_Update_Ctrl_Decimation             = 0x00800000,
+    sdrplay_api_Update_Ctrl_Agc                    = 0x01000000,
+    sdrplay_api_Update_Ctrl_AdsbMode               = 0x02000000,
+    sdrplay_api_Update_Ctrl_OverloadMsgAck         = 0x04000000,
+
+    sdrplay_api_Update_RspDuo_BiasTControl         = 0x08000000,
+    sdrplay_api_Update_RspDuo_AmPortSelect         = 0x10000000,
+    sdrplay_api_Update_RspDuo_Tuner1AmNotchControl = 0x20000000,
+    sdrplay_api_Update_RspDuo_RfNotchControl       = 0x40000000,
+    sdrplay_api_Update_RspDuo_RfDabNotchControl    = (int)0x80000000
+} sdrplay_api_ReasonForUpdateT;
+
+typedef enum
+{
+    sdrplay_api_Update_Ext1_None                   = 0x00000000,
+
+    // Reasons for master only mode
+    sdrplay_api_Update_RspDx_HdrEnable             = 0x00000001,
+    sdrplay_api_Update_RspDx_BiasTControl          = 0x00000002,
+    sdrplay_api_Update_RspDx_AntennaControl        = 0x00000004,
+    sdrplay_api_Update_RspDx_RfNotchControl        = 0x00000008,
+    sdrplay_api_Update_RspDx_RfDabNotchControl     = 0x00000010,
+    sdrplay_api_Update_RspDx_HdrBw                 = 0x00000020
+} sdrplay_api_ReasonForUpdateExtension1T;
+
+typedef enum
+{
+    sdrplay_api_DbgLvl_Disable = 0,
+    sdrplay_api_DbgLvl_Verbose = 1,
+    sdrplay_api_DbgLvl_Warning = 2,
+    sdrplay_api_DbgLvl_Error   = 3,
+    sdrplay_api_DbgLvl_Message = 4
+} sdrplay_api_DbgLvl_t;
+
+/* tuner parameters */
+typedef enum
+{
+    sdrplay_api_BW_Undefined = 0,
+    sdrplay_api_BW_0_200     = 200,
+    sdrplay_api_BW_0_300     = 300,
+    sdrplay_api_BW_0_600     = 600,
+    sdrplay_api_BW_1_536     = 1536,
+    sdrplay_api_BW_5_000     = 5000,
+    sdrplay_api_BW_6_000     = 6000,
+    sdrplay_api_BW_7_000     = 7000,
+    sdrplay_api_BW_8_000     = 8000
+} sdrplay_api_Bw_MHzT;
+
+typedef enum
+{
+    sdrplay_api_IF_Undefined = -1,
+    sdrplay_api_IF_Zero      = 0,
+    sdrplay_api_IF_0_450     = 450,
+    sdrplay_api_IF_1_620     = 1620,
+    sdrplay_api_IF_2_048     = 2048
+} sdrplay_api_If_kHzT;
+
+typedef enum
+{
+    sdrplay_api_LO_Undefined = 0,
+    sdrplay_api_LO_Auto      = 1,
+    sdrplay_api_LO_120MHz    = 2,
+    sdrplay_api_LO_144MHz    = 3,
+    sdrplay_api_LO_168MHz    = 4
+} sdrplay_api_LoModeT;
+
+typedef enum
+{
+    sdrplay_api_EXTENDED_MIN_GR = 0,
+    sdrplay_api_NORMAL_MIN_GR   = 20
+} sdrplay_api_MinGainReductionT;
+
+typedef enum
+{
+    sdrplay_api_Tuner_Neither = 0,
+    sdrplay_api_Tuner_A       = 1,
+    sdrplay_api_Tuner_B       = 2,
+    sdrplay_api_Tuner_Both    = 3
+} sdrplay_api_TunerSelectT;
+
+typedef struct
+{
+    float curr;
+    float max;
+    float min;
+} sdrplay_api_GainValuesT;
+
+typedef struct
+{
+    int gRdB;
+    unsigned char LNAstate;
+    unsigned char syncUpdate;
+    sdrplay_api_MinGainReductionT minGr;
+    sdrplay_api_GainValuesT gainVals;
+} sdrplay_api_GainT;
+
+typedef struct
+{
+    double rfHz;
+    unsigned char syncUpdate;
+} sdrplay_api_RfFreqT;
+
+typedef struct
+{
+    unsigned char dcCal;
+    unsigned char speedUp;
+    int trackTime;
+    int refreshRateTime;
+} sdrplay_api_DcOffsetTunerT;
+
+typedef struct
+{
+    sdrplay_api_Bw_MHzT bwType;
+    sdrplay_api_If_kHzT ifType;
+    sdrplay_api_LoModeT loMode;
+    sdrplay_api_GainT gain;
+    sdrplay_api_RfFreqT rfFreq;
+    sdrplay_api_DcOffsetTunerT dcOffsetTuner;
+} sdrplay_api_TunerParamsT;
+
+/* control parameters */
+typedef struct
+{
+    unsigned char DCenable;
+    unsigned char IQenable;
+} sdrplay_api_DcOffsetT;
+
+typedef struct
+{
+    unsigned char enable;
+    unsigned char decimationFactor;
+    unsigned char wideBandSignal;
+} sdrplay_api_DecimationT;
+
+typedef enum
+{
+    sdrplay_api_AGC_DISABLE  = 0,
+    sdrplay_api_AGC_100HZ    = 1,
+    sdrplay_api_AGC_50HZ     = 2,
+    sdrplay_api_AGC_5HZ      = 3,
+    sdrplay_api_AGC_CTRL_EN  = 4
+} sdrplay_api_AgcControlT;
+
+typedef struct
+{
+    sdrplay_api_AgcControlT enable;
+    int setPoint_dBfs;
+    unsigned short attack_ms;
+    unsigned short decay_ms;
+    unsigned short decay_delay_ms;
+    unsigned short decay_threshold_dB;
+    int syncUpdate;
+} sdrplay_api_AgcT;
+
+typedef enum
+{
+    sdrplay_api_ADSB_DECIMATION                  = 0,
+    sdrplay_api_ADSB_NO_DECIMATION_LOWPASS       = 1,
+    sdrplay_api_ADSB_NO_DECIMATION_BANDPASS_2MHZ = 2,
+    sdrplay_api_ADSB_NO_DECIMATION_BANDPASS_3MHZ = 3
+} sdrplay_api_AdsbModeT;
+
+typedef struct
+{
+    sdrplay_api_DcOffsetT dcOffset;
+    sdrplay_api_DecimationT decimation;
+    sdrplay_api_AgcT agc;
+    sdrplay_api_AdsbModeT adsbMode;
+} sdrplay_api_ControlParamsT;
+
+/* RSPduo parameters */
+typedef enum
+{
+    sdrplay_api_RspDuoMode_Unknown      = 0,
+    sdrplay_api_RspDuoMode_Single_Tuner = 1,
+    sdrplay_api_RspDuoMode_Dual_Tuner   = 2,
+    sdrplay_api_RspDuoMode_Master       = 4,
+    sdrplay_api_RspDuoMode_Slave        = 8
+} sdrplay_api_RspDuoModeT;
+
+typedef enum
+{
+    sdrplay_api_RspDuo_AMPORT_1 = 1,
+    sdrplay_api_RspDuo_AMPORT_2 = 0
+} sdrplay_api_RspDuo_AmPortSelectT;
+
+typedef struct
+{
+    int extRefOutputEn;
+} sdrplay_api_RspDuoParamsT;
+
+typedef struct
+{
+    int biasTEnable;
+    sdrplay_api_RspDuo_AmPortSelectT tuner1AmPortSel;
+    unsigned char tuner1AmNotchEnable;
+    unsigned char rfNotchEnable;
+    unsigned char rfDabNotchEnable;
+} sdrplay_api_RspDuoTunerParamsT;
+
+/* device parameters */
+typedef struct
+{
+    double fsHz;
+    unsigned char syncUpdate;
+    unsigned char reCal;
+} sdrplay_api_FsFreqT;
+
+typedef struct
+{
+    unsigned int sampleNum;
+    unsigned int period;
+} sdrplay_api_SyncUpdateT;
+
+typedef struct
+{
+    unsigned char resetGainUpdate;
+    unsigned char resetRfUpdate;
+    unsigned char resetFsUpdate;
+} sdrplay_api_ResetFlagsT;
+
+typedef enum
+{
+    sdrplay_api_ISOCH = 0,
+    sdrplay_api_BULK  = 1
+} sdrplay_api_TransferModeT;
+
+typedef struct
+{
+    double ppm;
+    sdrplay_api_FsFreqT fsFreq;
+    sdrplay_api_SyncUpdateT syncUpdate;
+    sdrplay_api_ResetFlagsT resetFlags;
+    sdrplay_api_TransferModeT mode;
+    unsigned int samplesPerPkt;
+    sdrplay_api_RspDuoParamsT rspDuoParams;
+} sdrplay_api_DevParamsT;
+
+typedef struct
+{
+    sdrplay_api_TunerParamsT tunerParams;
+    sdrplay_api_ControlParamsT ctrlParams;
+    sdrplay_api_RspDuoTunerParamsT rspDuoTunerParams;
+} sdrplay_api_RxChannelParamsT;
+
+typedef struct
+{
+    sdrplay_api_DevParamsT *devParams;
+    sdrplay_api_RxChannelParamsT *rxChannelA;
+    sdrplay_api_RxChannelParamsT *rxChannelB;
+} sdrplay_api_DeviceParamsT;
+
+typedef struct
+{
+    char SerNo[SDRPLAY_MAX_SER_NO_LEN];
+    unsigned char hwVer;
+    sdrplay_api_TunerSelectT tuner;
+    sdrplay_api_RspDuoModeT rspDuoMode;
+    unsigned char valid;
+    double rspDuoSampleFreq;
+    HANDLE dev;
+} sdrplay_api_DeviceT;
+
+/* callbacks */
+typedef enum
+{
+    sdrplay_api_Overload_Detected   = 0,
+    sdrplay_api_Overload_Corrected  = 1
+} sdrplay_api_PowerOverloadCbEventIdT;
+
+typedef enum
+{
+    sdrplay_api_MasterInitialised   = 0,
+    sdrplay_api_SlaveAttached       = 1,
+    sdrplay_api_SlaveDetached       = 2,
+    sdrplay_api_SlaveInitialised    = 3,
+    sdrplay_api_SlaveUninitialised  = 4,
+    sdrplay_api_MasterDllDisappeared = 5,
+    sdrplay_api_SlaveDllDisappeared = 6
+} sdrplay_api_RspDuoModeCbEventIdT;
+
+typedef enum
+{
+    sdrplay_api_GainChange          = 0,
+    sdrplay_api_PowerOverloadChange = 1,
+    sdrplay_api_DeviceRemoved       = 2,
+    sdrplay_api_RspDuoModeChange    = 3,
+    sdrplay_api_DeviceFailure       = 4
+} sdrplay_api_EventT;
+
+typedef struct
+{
+    unsigned int gRdB;
+    unsigned int lnaGRdB;
+    double currGain;
+} sdrplay_api_GainCbParamT;
+
+typedef struct
+{
+    sdrplay_api_PowerOverloadCbEventIdT powerOverloadChangeType;
+} sdrplay_api_PowerOverloadCbParamT;
+
+typedef struct
+{
+    sdrplay_api_RspDuoModeCbEventIdT modeChangeType;
+} sdrplay_api_RspDuoModeCbParamT;
+
+typedef union
+{
+    sdrplay_api_GainCbParamT          gainParams;
+    sdrplay_api_PowerOverloadCbParamT powerOverloadParams;
+    sdrplay_api_RspDuoModeCbParamT    rspDuoModeParams;
+} sdrplay_api_EventParamsT;
+
+typedef struct
+{
+    unsigned int firstSampleNum;
+    int grChanged;
+    int rfChanged;
+    int fsChanged;
+    unsigned int numSamples;
+} sdrplay_api_StreamCbParamsT;
+
+typedef void (*sdrplay_api_StreamCallback_t)(short *xi, short *xq, sdrplay_api_StreamCbParamsT *params, unsigned int numSamples, unsigned int reset, void *cbContext);
+typedef void (*sdrplay_api_EventCallback_t)(sdrplay_api_EventT eventId, sdrplay_api_TunerSelectT tuner, sdrplay_api_EventParamsT *params, void *cbContext);
+
+typedef struct
+{
+    sdrplay_api_StreamCallback_t StreamACbFn;
+    sdrplay_api_StreamCallback_t StreamBCbFn;
+    sdrplay_api_EventCallback_t  EventCbFn;
+} sdrplay_api_CallbackFnsT;
+
+/* API functions */
+sdrplay_api_ErrT sdrplay_api_Open(void);
+sdrplay_api_ErrT sdrplay_api_Close(void);
+sdrplay_api_ErrT sdrplay_api_ApiVersion(float *apiVer);
+sdrplay_api_ErrT sdrplay_api_LockDeviceApi(void);
+sdrplay_api_ErrT sdrplay_api_UnlockDeviceApi(void);
+sdrplay_api_ErrT sdrplay_api_GetDevices(sdrplay_api_DeviceT *devices, unsigned int *numDevs, unsigned int maxDevs);
+sdrplay_api_ErrT sdrplay_api_SelectDevice(sdrplay_api_DeviceT *device);
+sdrplay_api_ErrT sdrplay_api_ReleaseDevice(sdrplay_api_DeviceT *device);
+const char*      sdrplay_api_GetErrorString(sdrplay_api_ErrT err);
+sdrplay_api_ErrT sdrplay_api_DebugEnable(HANDLE dev, sdrplay_api_DbgLvl_t dbgLvl);
+sdrplay_api_ErrT sdrplay_api_GetDeviceParams(HANDLE dev, sdrplay_api_DeviceParamsT **deviceParams);
+sdrplay_api_ErrT sdrplay_api_Init(HANDLE dev, sdrplay_api_CallbackFnsT *callbackFns, void *cbContext);
+sdrplay_api_ErrT sdrplay_api_Uninit(HANDLE dev);
+sdrplay_api_ErrT sdrplay_api_Update(HANDLE dev, sdrplay_api_TunerSelectT tuner, sdrplay_api_ReasonForUpdateT reasonForUpdate, sdrplay_api_ReasonForUpdateExtension1T reasonForUpdateExt1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SDRPLAY_API_H */
@@ -0,0 +1,702 @@
+/* hardware-free stand-in for the SDRplay API used by dual_tuner_recorder
+ * it emulates one or more RSPduo's in dual tuner mode and drives the
+ * stream callbacks from an internal thread with synthetic I/Q data
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* the mock is configured with the SDRPLAY_MOCK environment variable, which
+ * is a comma separated list of <key>=<value> settings:
+ *     devices=<number of RSPduo's> (default: 1)
+ *     rate=<output sample rate per channel> (default: from fsHz, IF and decimation)
+ *     packet=<samples per packet> (default: 1008)
+ *     signal=<tone|noise|both> (default: both)
+ *     tone=<tone frequency offset in Hz> (default: 100000)
+ *     amplitude=<tone amplitude> (default: 1000)
+ *     noise=<noise amplitude> (default: 100)
+ *     common=<amplitude of a noise common to A and B> (to check the A/B cross-correlation) (default: 0)
+ *     delay=<samples A is behind B in the common noise> (default: 0)
+ *     phase=<phase of A relative to B in the common noise in degrees> (default: 0)
+ *     burst=<on>/<period> (the tone is only there for the first <on> seconds of every <period> seconds) (default: always on)
+ *     burstrx=<A|B|both> (the tuners that get the tone bursts; the others only get the noise) (default: both)
+ *     init=<time sdrplay_api_Init() takes in ms> (default: 0)
+ *     retune=<time for a frequency change to take effect in ms> (the first packet at the new frequency has rfChanged set, and it is followed by a gain change event) (default: 0 - the next packet)
+ *     gap=<inject a gap (packets lost, in the sample numbers and in time) every this many packets> (default: 0 - never)
+ *     gaplen=<length of each injected gap in samples, rounded up to whole packets> (default: 1008)
+ *     restart=<the sample numbers start over from 0, with the reset flag set, every this many packets> (default: 0 - never)
+ *     skew=<microseconds the channel B callbacks are behind the channel A ones> (A and B are then called from two separate threads, so their delivery is not interleaved) (default: 0 - A and B from the same thread)
+ *     buffer=<packets the emulated USB buffer can hold> (default: 64)
+ *     stats=<file> (write the stream statistics to this file at Uninit)
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sdrplay_api.h>
+
+#define MOCK_MAX_DEVICES 8
+#define MOCK_TABLE_SIZE 65536
+#define MOCK_MAX_PACKET 16384
+
+typedef struct {
+    unsigned long long packets;
+    unsigned long long samples;
+    unsigned long long dropped_samples;
+    unsigned long long injected_gap_samples;
+    unsigned long long restarts;
+    unsigned long long cpu_ns;
+    unsigned long long max_callback_ns;
+} MockStreamStats;
+
+struct MockDevice;
+
+/* a stream thread drives the callbacks of channels first_rx..last_rx */
+typedef struct {
+    struct MockDevice *mock_device;
+    int first_rx;
+    int last_rx;
+    unsigned long long offset_ns;
+    pthread_t thread;
+} MockStream;
+
+typedef struct MockDevice {
+    sdrplay_api_DeviceT device;
+    sdrplay_api_DevParamsT dev_params;
+    sdrplay_api_RxChannelParamsT rx_channelA_params;
+    sdrplay_api_RxChannelParamsT rx_channelB_params;
+    sdrplay_api_DeviceParamsT device_params;
+    int selected;
+    int initialized;
+    sdrplay_api_CallbackFnsT callback_fns;
+    void *cb_context;
+    MockStream streams[2];
+    int num_streams;
+    unsigned long long start_ns;       /* the common time base of the stream threads */
+    atomic_int stop;
+    _Atomic unsigned long long rf_change_ns[2];  /* when the new frequency takes effect (0 if none) */
+    atomic_int gr_changed[2];
+    double elapsed_sec;
+    MockStreamStats stats[2];
+} MockDevice;
+
+static struct {
+    int ndevices;
+    double rate;
+    unsigned int packet;
+    int tone_enable;
+    int noise_enable;
+    double tone;
+    double amplitude;
+    double noise;
+    double common;
+    int delay;
+    double phase;
+    double burst_on;
+    double burst_period;
+    int burst_rx[2];
+    double init;
+    double retune;
+    unsigned int gap;
+    unsigned int gaplen;
+    unsigned int restart;
+    double skew;
+    unsigned int buffer;
+    const char *stats_file;
+} mock_config = {
+    .ndevices = 1,
+    .rate = 0.0,
+    .packet = 1008,
+    .tone_enable = 1,
+    .noise_enable = 1,
+    .tone = 100000.0,
+    .amplitude = 1000.0,
+    .noise = 100.0,
+    .common = 0.0,
+    .delay = 0,
+    .phase = 0.0,
+    .burst_on = 0.0,
+    .burst_period = 0.0,
+    .burst_rx = { 1, 1 },
+    .init = 0.0,
+    .retune = 0.0,
+    .gap = 0,
+    .gaplen = 1008,
+    .restart = 0,
+    .skew = 0.0,
+    .buffer = 64,
+    .stats_file = NULL
+};
+
+static MockDevice mock_devices[MOCK_MAX_DEVICES];
+static int mock_open = 0;
+static pthread_mutex_t mock_api_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void mock_configure(void);
+static double mock_output_sample_rate(const MockDevice *mock_device, const sdrplay_api_RxChannelParamsT *rx_channel_params);
+static void mock_fill_table(short *xi, short *xq, double sample_rate, unsigned int seed, int tone_enable, int rx);
+static void *mock_stream_thread(void *arg);
+static void mock_write_stats(const MockDevice *mock_device);
+static unsigned long long timespec_ns(const struct timespec *ts);
+static MockDevice *mock_find_device(HANDLE dev);
+
+
+sdrplay_api_ErrT sdrplay_api_Open(void)
+{
+    if (mock_open)
+        return sdrplay_api_AlreadyInitialised;
+    mock_configure();
+    for (int i = 0; i < mock_config.ndevices; i++) {
+        MockDevice *mock_device = &mock_devices[i];
+        memset(mock_device, 0, sizeof(*mock_device));
+        snprintf(mock_device->device.SerNo, SDRPLAY_MAX_SER_NO_LEN, "MOCK%04d", i + 1);
+        mock_device->device.hwVer = SDRPLAY_RSPduo_ID;
+        mock_device->device.tuner = sdrplay_api_Tuner_Both;
+        mock_device->device.rspDuoMode = sdrplay_api_RspDuoMode_Single_Tuner | sdrplay_api_RspDuoMode_Dual_Tuner | sdrplay_api_RspDuoMode_Master;
+        mock_device->device.valid = 1;
+        mock_device->device.dev = mock_device;
+    }
+    mock_open = 1;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_Close(void)
+{
+    if (!mock_open)
+        return sdrplay_api_NotInitialised;
+    mock_open = 0;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_ApiVersion(float *apiVer)
+{
+    *apiVer = SDRPLAY_API_VERSION;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_LockDeviceApi(void)
+{
+    pthread_mutex_lock(&mock_api_lock);
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_UnlockDeviceApi(void)
+{
+    pthread_mutex_unlock(&mock_api_lock);
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_GetDevices(sdrplay_api_DeviceT *devices, unsigned int *numDevs, unsigned int maxDevs)
+{
+    if (!mock_open)
+        return sdrplay_api_NotInitialised;
+    unsigned int n = 0;
+    for (int i = 0; i < mock_config.ndevices && n < maxDevs; i++) {
+        if (mock_devices[i].selected)
+            continue;
+        devices[n++] = mock_devices[i].device;
+    }
+    *numDevs = n;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_SelectDevice(sdrplay_api_DeviceT *device)
+{
+    MockDevice *mock_device = mock_find_device(device->dev);
+    if (mock_device == NULL)
+        return sdrplay_api_InvalidParam;
+    if (mock_device->selected)
+        return sdrplay_api_Fail;
+    if (device->tuner != sdrplay_api_Tuner_Both || device->rspDuoMode != sdrplay_api_RspDuoMode_Dual_Tuner)
+        return sdrplay_api_InvalidMode;
+    if (device->rspDuoSampleFreq != 6e6 && device->rspDuoSampleFreq != 8e6)
+        return sdrplay_api_OutOfRange;
+    mock_device->selected = 1;
+    mock_device->device.tuner = device->tuner;
+    mock_device->device.rspDuoMode = device->rspDuoMode;
+    mock_device->device.rspDuoSampleFreq = device->rspDuoSampleFreq;
+
+    /* default parameters */
+    mock_device->dev_params.fsFreq.fsHz = device->rspDuoSampleFreq;
+    mock_device->dev_params.samplesPerPkt = mock_config.packet;
+    for (int i = 0; i < 2; i++) {
+        sdrplay_api_RxChannelParamsT *rx_channel_params = i == 0 ? &mock_device->rx_channelA_params : &mock_device->rx_channelB_params;
+        rx_channel_params->tunerParams.bwType = sdrplay_api_BW_0_200;
+        rx_channel_params->tunerParams.ifType = device->rspDuoSampleFreq == 8e6 ? sdrplay_api_IF_2_048 : sdrplay_api_IF_1_620;
+        rx_channel_params->tunerParams.loMode = sdrplay_api_LO_Auto;
+        rx_channel_params->tunerParams.gain.gRdB = 50;
+        rx_channel_params->tunerParams.gain.LNAstate = 0;
+        rx_channel_params->tunerParams.rfFreq.rfHz = 200e6;
+        rx_channel_params->tunerParams.dcOffsetTuner.dcCal = 3;
+        rx_channel_params->tunerParams.dcOffsetTuner.speedUp = 0;
+        rx_channel_params->tunerParams.dcOffsetTuner.trackTime = 1;
+        rx_channel_params->tunerParams.dcOffsetTuner.refreshRateTime = 2048;
+        rx_channel_params->ctrlParams.dcOffset.DCenable = 1;
+        rx_channel_params->ctrlParams.dcOffset.IQenable = 1;
+        rx_channel_params->ctrlParams.decimation.enable = 0;
+        rx_channel_params->ctrlParams.decimation.decimationFactor = 1;
+        rx_channel_params->ctrlParams.agc.enable = sdrplay_api_AGC_50HZ;
+        rx_channel_params->ctrlParams.agc.setPoint_dBfs = -60;
+    }
+    mock_device->device_params.devParams = &mock_device->dev_params;
+    mock_device->device_params.rxChannelA = &mock_device->rx_channelA_params;
+    mock_device->device_params.rxChannelB = &mock_device->rx_channelB_params;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_ReleaseDevice(sdrplay_api_DeviceT *device)
+{
+    MockDevice *mock_device = mock_find_device(device->dev);
+    if (mock_device == NULL || !mock_device->selected)
+        return sdrplay_api_InvalidParam;
+    if (mock_device->initialized)
+        sdrplay_api_Uninit(device->dev);
+    mock_device->selected = 0;
+    return sdrplay_api_Success;
+}
+
+const char* sdrplay_api_GetErrorString(sdrplay_api_ErrT err)
+{
+    switch (err) {
+        case sdrplay_api_Success:               return "sdrplay_api_Success";
+        case sdrplay_api_Fail:                  return "sdrplay_api_Fail";
+        case sdrplay_api_InvalidParam:          return "sdrplay_api_InvalidParam";
+        case sdrplay_api_OutOfRange:            return "sdrplay_api_OutOfRange";
+        case sdrplay_api_AlreadyInitialised:    return "sdrplay_api_AlreadyInitialised";
+        case sdrplay_api_NotInitialised:        return "sdrplay_api_NotInitialised";
+        case sdrplay_api_InvalidMode:           return "sdrplay_api_InvalidMode";
+        default:                                return "sdrplay_api_Unknown";
+    }
+}
+
+sdrplay_api_ErrT sdrplay_api_DebugEnable(HANDLE dev, sdrplay_api_DbgLvl_t dbgLvl)
+{
+    if (mock_find_device(dev) == NULL)
+        return sdrplay_api_InvalidParam;
+    if (dbgLvl != sdrplay_api_DbgLvl_Disable)
+        fprintf(stderr, "sdrplay_api mock - debug log enabled\n");
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_GetDeviceParams(HANDLE dev, sdrplay_api_DeviceParamsT **deviceParams)
+{
+    MockDevice *mock_device = mock_find_device(dev);
+    if (mock_device == NULL || !mock_device->selected)
+        return sdrplay_api_InvalidParam;
+    *deviceParams = &mock_device->device_params;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_Init(HANDLE dev, sdrplay_api_CallbackFnsT *callbackFns, void *cbContext)
+{
+    MockDevice *mock_device = mock_find_device(dev);
+    if (mock_device == NULL || !mock_device->selected)
+        return sdrplay_api_InvalidParam;
+    if (mock_device->initialized)
+        return sdrplay_api_AlreadyInitialised;
+
+    /* like the real API, in dual tuner mode sdrplay_api_Init() resets
+     * the channel B settings to the channel A values */
+    mock_device->rx_channelB_params.tunerParams = mock_device->rx_channelA_params.tunerParams;
+    mock_device->rx_channelB_params.ctrlParams = mock_device->rx_channelA_params.ctrlParams;
+    mock_device->device.rspDuoSampleFreq = mock_device->dev_params.fsFreq.fsHz;
+    if (mock_config.init > 0) {
+        /* the firmware download and the tuner setup */
+        struct timespec init_time = { (time_t)(mock_config.init / 1000), (long)(fmod(mock_config.init, 1000) * 1e6) };
+        nanosleep(&init_time, NULL);
+    }
+
+    mock_device->callback_fns = *callbackFns;
+    mock_device->cb_context = cbContext;
+    memset(mock_device->stats, 0, sizeof(mock_device->stats));
+    atomic_store(&mock_device->stop, 0);
+    mock_device->initialized = 1;
+
+    /* the quick check Init has no stream callbacks */
+    if (callbackFns->StreamACbFn == NULL && callbackFns->StreamBCbFn == NULL)
+        return sdrplay_api_Success;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    mock_device->start_ns = timespec_ns(&start);
+    if (mock_config.skew > 0) {
+        mock_device->streams[0] = (MockStream){ .mock_device = mock_device, .first_rx = 0, .last_rx = 0, .offset_ns = 0 };
+        mock_device->streams[1] = (MockStream){ .mock_device = mock_device, .first_rx = 1, .last_rx = 1, .offset_ns = (unsigned long long)(mock_config.skew * 1000) };
+        mock_device->num_streams = 2;
+    } else {
+        mock_device->streams[0] = (MockStream){ .mock_device = mock_device, .first_rx = 0, .last_rx = 1, .offset_ns = 0 };
+        mock_device->num_streams = 1;
+    }
+    for (int k = 0; k < mock_device->num_streams; k++) {
+        int ret = pthread_create(&mock_device->streams[k].thread, NULL, mock_stream_thread, &mock_device->streams[k]);
+        if (ret != 0) {
+            fprintf(stderr, "sdrplay_api mock - pthread_create() failed: %s\n", strerror(ret));
+            atomic_store(&mock_device->stop, 1);
+            for (int j = 0; j < k; j++)
+                pthread_join(mock_device->streams[j].thread, NULL);
+            mock_device->initialized = 0;
+            return sdrplay_api_Fail;
+        }
+    }
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_Uninit(HANDLE dev)
+{
+    MockDevice *mock_device = mock_find_device(dev);
+    if (mock_device == NULL || !mock_device->initialized)
+        return sdrplay_api_NotInitialised;
+    if (mock_device->callback_fns.StreamACbFn != NULL || mock_device->callback_fns.StreamBCbFn != NULL) {
+        atomic_store(&mock_device->stop, 1);
+        for (int k = 0; k < mock_device->num_streams; k++)
+            pthread_join(mock_device->streams[k].thread, NULL);
+        mock_write_stats(mock_device);
+    }
+    mock_device->initialized = 0;
+    return sdrplay_api_Success;
+}
+
+sdrplay_api_ErrT sdrplay_api_Update(HANDLE dev, sdrplay_api_TunerSelectT tuner, sdrplay_api_ReasonForUpdateT reasonForUpdate, sdrplay_api_ReasonForUpdateExtension1T reasonForUpdateExt1)
+{
+    (void)reasonForUpdateExt1;
+    MockDevice *mock_device = mock_find_device(dev);
+    if (mock_device == NULL || !mock_device->initialized)
+        return sdrplay_api_NotInitialised;
+    for (int i = 0; i < 2; i++) {
+        if (!(tuner & (i == 0 ? sdrplay_api_Tuner_A : sdrplay_api_Tuner_B)))
+            continue;
+        if (reasonForUpdate & sdrplay_api_Update_Tuner_Frf) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            atomic_store(&mock_device->rf_change_ns[i], timespec_ns(&now) + (unsigned long long)(1e6 * mock_config.retune));
+        }
+        if (reasonForUpdate & sdrplay_api_Update_Tuner_Gr)
+            atomic_store(&mock_device->gr_changed[i], 1);
+    }
+    return sdrplay_api_Success;
+}
+
+
+static void mock_configure(void)
+{
+    const char *env = getenv("SDRPLAY_MOCK");
+    if (env == NULL)
+        return;
+    /* the stats file name is kept around, so this copy is never freed */
+    char *config = strdup(env);
+    for (char *saveptr, *token = strtok_r(config, ",", &saveptr); token != NULL; token = strtok_r(NULL, ",", &saveptr)) {
+        char *value = strchr(token, '=');
+        if (value == NULL) {
+            fprintf(stderr, "sdrplay_api mock - invalid setting: %s\n", token);
+            continue;
+        }
+        *value++ = '\0';
+        if (strcmp(token, "devices") == 0) {
+            mock_config.ndevices = atoi(value);
+            if (mock_config.ndevices < 0 || mock_config.ndevices > MOCK_MAX_DEVICES)
+                mock_config.ndevices = MOCK_MAX_DEVICES;
+        } else if (strcmp(token, "rate") == 0) {
+            mock_config.rate = atof(value);
+        } else if (strcmp(token, "packet") == 0) {
+            mock_config.packet = atoi(value);
+            if (mock_config.packet < 1 || mock_config.packet > MOCK_MAX_PACKET)
+                mock_config.packet = 1008;
+        } else if (strcmp(token, "signal") == 0) {
+            mock_config.tone_enable = strcmp(value, "noise") != 0;
+            mock_config.noise_enable = strcmp(value, "tone") != 0;
+        } else if (strcmp(token, "tone") == 0) {
+            mock_config.tone = atof(value);
+        } else if (strcmp(token, "amplitude") == 0) {
+            mock_config.amplitude = atof(value);
+        } else if (strcmp(token, "noise") == 0) {
+            mock_config.noise = atof(value);
+        } else if (strcmp(token, "common") == 0) {
+            mock_config.common = atof(value);
+        } else if (strcmp(token, "delay") == 0) {
+            mock_config.delay = atoi(value);
+        } else if (strcmp(token, "phase") == 0) {
+            mock_config.phase = atof(value);
+        } else if (strcmp(token, "burst") == 0) {
+            if (sscanf(value, "%lg/%lg", &mock_config.burst_on, &mock_config.burst_period) != 2 || mock_config.burst_period <= 0) {
+                fprintf(stderr, "sdrplay_api mock - invalid burst: %s\n", value);
+                mock_config.burst_period = 0.0;
+            }
+        } else if (strcmp(token, "burstrx") == 0) {
+            mock_config.burst_rx[0] = strcmp(value, "B") != 0;
+            mock_config.burst_rx[1] = strcmp(value, "A") != 0;
+        } else if (strcmp(token, "init") == 0) {
+            mock_config.init = atof(value);
+        } else if (strcmp(token, "retune") == 0) {
+            mock_config.retune = atof(value);
+        } else if (strcmp(token, "gap") == 0) {
+            mock_config.gap = atoi(value);
+        } else if (strcmp(token, "gaplen") == 0) {
+            mock_config.gaplen = atoi(value);
+        } else if (strcmp(token, "restart") == 0) {
+            mock_config.restart = atoi(value);
+        } else if (strcmp(token, "skew") == 0) {
+            mock_config.skew = atof(value);
+        } else if (strcmp(token, "buffer") == 0) {
+            mock_config.buffer = atoi(value);
+        } else if (strcmp(token, "stats") == 0) {
+            mock_config.stats_file = value;
+        } else {
+            fprintf(stderr, "sdrplay_api mock - unknown setting: %s\n", token);
+        }
+    }
+}
+
+static double mock_output_sample_rate(const MockDevice *mock_device, const sdrplay_api_RxChannelParamsT *rx_channel_params)
+{
+    int decimation = rx_channel_params->ctrlParams.decimation.enable ? rx_channel_params->ctrlParams.decimation.decimationFactor : 1;
+    if (decimation < 1)
+        decimation = 1;
+    if (mock_config.rate > 0)
+        return mock_config.rate / decimation;
+    /* in dual tuner mode the RSPduo low IF output is always 2MHz */
+    if (rx_channel_params->tunerParams.ifType != sdrplay_api_IF_Zero)
+        return 2e6 / decimation;
+    return mock_device->dev_params.fsFreq.fsHz / decimation;
+}
+
+/* the synthetic signal is precomputed in a table, so that generating it
+ * does not add to the cost measured for the callbacks; the tone frequency
+ * is rounded to a table bin, so that it is continuous across the wrap */
+static void mock_fill_table(short *xi, short *xq, double sample_rate, unsigned int seed, int tone_enable, int rx)
+{
+    double bin = round(mock_config.tone * MOCK_TABLE_SIZE / sample_rate);
+    /* the common noise is the same table in A and B (periodic, so the
+     * delay wraps around), with A delayed and rotated */
+    float *common_i = NULL;
+    float *common_q = NULL;
+    if (mock_config.common > 0) {
+        common_i = malloc(MOCK_TABLE_SIZE * sizeof(float));
+        common_q = malloc(MOCK_TABLE_SIZE * sizeof(float));
+        unsigned int common_seed = 54321;
+        for (unsigned int k = 0; k < MOCK_TABLE_SIZE; k++) {
+            common_i[k] = mock_config.common * (2.0 * rand_r(&common_seed) / RAND_MAX - 1.0);
+            common_q[k] = mock_config.common * (2.0 * rand_r(&common_seed) / RAND_MAX - 1.0);
+        }
+    }
+    double common_phase = rx == 0 ? mock_config.phase * M_PI / 180.0 : 0.0;
+    int common_delay = rx == 0 ? mock_config.delay : 0;
+    for (unsigned int i = 0; i < MOCK_TABLE_SIZE + MOCK_MAX_PACKET; i++) {
+        unsigned int k = i % MOCK_TABLE_SIZE;
+        double phase = 2.0 * M_PI * bin * k / MOCK_TABLE_SIZE;
+        double vi = 0.0;
+        double vq = 0.0;
+        if (tone_enable) {
+            vi += mock_config.amplitude * cos(phase);
+            vq += mock_config.amplitude * sin(phase);
+        }
+        if (mock_config.noise_enable && i < MOCK_TABLE_SIZE) {
+            vi += mock_config.noise * (2.0 * rand_r(&seed) / RAND_MAX - 1.0);
+            vq += mock_config.noise * (2.0 * rand_r(&seed) / RAND_MAX - 1.0);
+        }
+        if (common_i != NULL && i < MOCK_TABLE_SIZE) {
+            unsigned int d = (unsigned int)(((int)k - common_delay) % MOCK_TABLE_SIZE + MOCK_TABLE_SIZE) % MOCK_TABLE_SIZE;
+            vi += common_i[d] * cos(common_phase) - common_q[d] * sin(common_phase);
+            vq += common_i[d] * sin(common_phase) + common_q[d] * cos(common_phase);
+        }
+        if (i >= MOCK_TABLE_SIZE) {
+            xi[i] = xi[k];
+            xq[i] = xq[k];
+            continue;
+        }
+        xi[i] = vi > SHRT_MAX ? SHRT_MAX : vi < SHRT_MIN ? SHRT_MIN : (short)lrint(vi);
+        xq[i] = vq > SHRT_MAX ? SHRT_MAX : vq < SHRT_MIN ? SHRT_MIN : (short)lrint(vq);
+    }
+    free(common_i);
+    free(common_q);
+}
+
+static void *mock_stream_thread(void *arg)
+{
+    const MockStream *stream = (const MockStream *)arg;
+    MockDevice *mock_device = stream->mock_device;
+    const sdrplay_api_RxChannelParamsT *rx_channel_params[2] = { &mock_device->rx_channelA_params, &mock_device->rx_channelB_params };
+    sdrplay_api_StreamCallback_t stream_callbacks[2] = { mock_device->callback_fns.StreamACbFn, mock_device->callback_fns.StreamBCbFn };
+
+    short *xi[2] = { NULL, NULL };
+    short *xq[2] = { NULL, NULL };
+    short *noise_xi[2] = { NULL, NULL };   /* between the bursts */
+    short *noise_xq[2] = { NULL, NULL };
+    unsigned int num_samples[2];
+    unsigned int first_sample_num[2] = { 0, 0 };
+    unsigned int table_pos[2] = { 0, 0 };
+    double sample_rate[2];
+    for (int i = 0; i < 2; i++)
+        sample_rate[i] = mock_output_sample_rate(mock_device, rx_channel_params[i]);
+    for (int i = stream->first_rx; i <= stream->last_rx; i++) {
+        xi[i] = malloc((MOCK_TABLE_SIZE + MOCK_MAX_PACKET) * sizeof(short));
+        xq[i] = malloc((MOCK_TABLE_SIZE + MOCK_MAX_PACKET) * sizeof(short));
+        mock_fill_table(xi[i], xq[i], sample_rate[i], 12345 + i, mock_config.tone_enable && (mock_config.burst_period == 0 || mock_config.burst_rx[i]), i);
+        if (mock_config.burst_period > 0 && mock_config.burst_rx[i]) {
+            noise_xi[i] = malloc((MOCK_TABLE_SIZE + MOCK_MAX_PACKET) * sizeof(short));
+            noise_xq[i] = malloc((MOCK_TABLE_SIZE + MOCK_MAX_PACKET) * sizeof(short));
+            mock_fill_table(noise_xi[i], noise_xq[i], sample_rate[i], 12345 + i, 0, i);
+        }
+    }
+    /* the packet rate is driven by the faster channel; a decimated channel
+     * gets proportionally fewer samples per packet */
+    double base_rate = sample_rate[0] > sample_rate[1] ? sample_rate[0] : sample_rate[1];
+    for (int i = 0; i < 2; i++) {
+        num_samples[i] = (unsigned int)(mock_config.packet * sample_rate[i] / base_rate + 0.5);
+        if (num_samples[i] < 1)
+            num_samples[i] = 1;
+    }
+    unsigned long long packet_period_ns = (unsigned long long)(1e9 * mock_config.packet / base_rate);
+
+    unsigned long long start_ns = mock_device->start_ns + stream->offset_ns;
+    unsigned long long packet_num = 0;
+    unsigned long long next_gap_packet = mock_config.gap;
+    unsigned long long next_restart_packet = mock_config.restart;
+    int first_packet = 1;
+    while (!atomic_load(&mock_device->stop)) {
+        unsigned long long deadline_ns = start_ns + packet_num * packet_period_ns;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        unsigned long long now_ns = timespec_ns(&now);
+        if (now_ns < deadline_ns) {
+            struct timespec deadline = { deadline_ns / 1000000000, deadline_ns % 1000000000 };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        } else if (now_ns - deadline_ns > mock_config.buffer * packet_period_ns) {
+            /* the emulated USB buffer overflowed - drop the oldest packets */
+            unsigned long long lost_packets = (now_ns - deadline_ns) / packet_period_ns - mock_config.buffer;
+            if (lost_packets > 0) {
+                for (int i = stream->first_rx; i <= stream->last_rx; i++) {
+                    first_sample_num[i] += lost_packets * num_samples[i];
+                    mock_device->stats[i].dropped_samples += lost_packets * num_samples[i];
+                }
+                packet_num += lost_packets;
+            }
+        }
+
+        if (mock_config.gap > 0 && packet_num >= next_gap_packet) {
+            /* like a real drop, the missing packets take their time: no
+             * callbacks until the one due after the gap */
+            unsigned long long gap_packets = (mock_config.gaplen + mock_config.packet - 1) / mock_config.packet;
+            if (gap_packets < 1)
+                gap_packets = 1;
+            for (int i = stream->first_rx; i <= stream->last_rx; i++) {
+                first_sample_num[i] += gap_packets * num_samples[i];
+                mock_device->stats[i].injected_gap_samples += gap_packets * num_samples[i];
+                table_pos[i] = (table_pos[i] + gap_packets * num_samples[i]) % MOCK_TABLE_SIZE;
+            }
+            packet_num += gap_packets;
+            next_gap_packet = packet_num + mock_config.gap;
+            continue;
+        }
+
+        int restarted = mock_config.restart > 0 && packet_num >= next_restart_packet;
+        if (restarted) {
+            for (int i = stream->first_rx; i <= stream->last_rx; i++) {
+                first_sample_num[i] = 0;
+                mock_device->stats[i].restarts++;
+            }
+            next_restart_packet = packet_num + mock_config.restart;
+        }
+
+        for (int i = stream->first_rx; i <= stream->last_rx; i++) {
+            if (stream_callbacks[i] == NULL)
+                continue;
+            /* a frequency change takes effect with the first packet due
+             * after the retune time */
+            unsigned long long rf_change_ns = atomic_load(&mock_device->rf_change_ns[i]);
+            int rf_changed = rf_change_ns != 0 && deadline_ns >= rf_change_ns && atomic_compare_exchange_strong(&mock_device->rf_change_ns[i], &rf_change_ns, 0);
+            sdrplay_api_StreamCbParamsT params = {
+                .firstSampleNum = first_sample_num[i],
+                .grChanged = atomic_exchange(&mock_device->gr_changed[i], 0),
+                .rfChanged = rf_changed,
+                .fsChanged = 0,
+                .numSamples = num_samples[i]
+            };
+            unsigned int reset = first_packet || params.rfChanged || restarted;
+            short *packet_xi = xi[i];
+            short *packet_xq = xq[i];
+            if (noise_xi[i] != NULL && fmod(packet_num * packet_period_ns * 1e-9, mock_config.burst_period) >= mock_config.burst_on) {
+                packet_xi = noise_xi[i];
+                packet_xq = noise_xq[i];
+            }
+            struct timespec cpu_before, cpu_after;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_before);
+            stream_callbacks[i](packet_xi + table_pos[i], packet_xq + table_pos[i], &params, num_samples[i], reset, mock_device->cb_context);
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_after);
+            unsigned long long callback_ns = timespec_ns(&cpu_after) - timespec_ns(&cpu_before);
+            MockStreamStats *stats = &mock_device->stats[i];
+            stats->cpu_ns += callback_ns;
+            if (callback_ns > stats->max_callback_ns)
+                stats->max_callback_ns = callback_ns;
+            stats->packets++;
+            stats->samples += num_samples[i];
+            if (rf_changed && mock_device->callback_fns.EventCbFn != NULL) {
+                /* the gain is applied again for the new frequency */
+                sdrplay_api_EventParamsT event_params;
+                memset(&event_params, 0, sizeof(event_params));
+                event_params.gainParams.gRdB = rx_channel_params[i]->tunerParams.gain.gRdB;
+                mock_device->callback_fns.EventCbFn(sdrplay_api_GainChange, i == 0 ? sdrplay_api_Tuner_A : sdrplay_api_Tuner_B, &event_params, mock_device->cb_context);
+            }
+            first_sample_num[i] += num_samples[i];
+            table_pos[i] = (table_pos[i] + num_samples[i]) % MOCK_TABLE_SIZE;
+        }
+        first_packet = 0;
+        packet_num++;
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (stream->first_rx == 0)
+        mock_device->elapsed_sec = 1e-9 * (timespec_ns(&end) - start_ns);
+
+    for (int i = 0; i < 2; i++) {
+        free(xi[i]);
+        free(xq[i]);
+        free(noise_xi[i]);
+        free(noise_xq[i]);
+    }
+    return NULL;
+}
+
+static void mock_write_stats(const MockDevice *mock_device)
+{
+    FILE *fp = stderr;
+    if (mock_config.stats_file != NULL) {
+        fp = fopen(mock_config.stats_file, "a");
+        if (fp == NULL) {
+            fprintf(stderr, "sdrplay_api mock - fopen(%s) failed: %s\n", mock_config.stats_file, strerror(errno));
+            return;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        const MockStreamStats *stats = &mock_device->stats[i];
+        fprintf(fp, "sdrplay_api mock - %s RX %c - elapsed_sec=%.3lf packets=%llu samples=%llu dropped_samples=%llu injected_gap_samples=%llu restarts=%llu cpu_ns=%llu max_callback_ns=%llu\n", mock_device->device.SerNo, 'A' + i, mock_device->elapsed_sec, stats->packets, stats->samples, stats->dropped_samples, stats->injected_gap_samples, stats->restarts, stats->cpu_ns, stats->max_callback_ns);
+    }
+    if (fp != stderr)
+        fclose(fp);
+}
+
+static unsigned long long timespec_ns(const struct timespec *ts)
+{
+    return (unsigned long long)ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+static MockDevice *mock_find_device(HANDLE dev)
+{
+    for (int i = 0; i < mock_config.ndevices; i++) {
+        if (dev == &mock_devices[i])
+            return &mock_devices[i];
+    }
+    return NULL;
+}
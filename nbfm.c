@@ -0,0 +1,267 @@
+/* native NBFM demodulator: channel filter, quadrature demodulator,
+ * de-emphasis and rational resampler to the audio sample rate
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ddc.h"
+#include "fir_kernels.h"
+#include "nbfm.h"
+
+#define NBFM_SLICE_SAMPLES 8192
+#define NBFM_DEVIATION 5e3
+#define NBFM_TAU 75e-6
+/* audio filter (in the resampler): flat to 3.5kHz, stopband from 6.5kHz */
+#define NBFM_AUDIO_CUTOFF 5e3
+#define NBFM_AUDIO_TRANSITION 3e3
+#define NBFM_MAX_INTERPOLATION 160
+#define NBFM_MAX_RESAMPLER_TAPS 65535
+
+struct Nbfm {
+    double sample_rate;
+    double offset;
+    double bandwidth;
+    int audio_sample_rate;
+    /* channel filter and decimation to the quadrature rate */
+    Ddc *ddc;
+    int decimation;
+    double quadrature_sample_rate;
+    float *bi;
+    float *bq;
+    /* quadrature demodulator: last sample of the previous slice */
+    float last_i;
+    float last_q;
+    float demod_gain;
+    /* de-emphasis (single pole IIR) */
+    float deemph_alpha;
+    float deemph_state;
+    /* polyphase rational resampler: interpolation by L, decimation by M;
+     * each of the L phases has its taps reversed and padded to
+     * phase_taps, so each output sample is a single dot product */
+    int interpolation;
+    int resampler_decimation;
+    unsigned int taps_per_phase;
+    unsigned int phase_taps;
+    float *phases;
+    float *x;                          /* history followed by the new samples */
+    unsigned int length;
+    unsigned int start;                /* start of the next output window */
+    int phase;                         /* phase of the next output sample */
+};
+
+static double gcd(double a, double b);
+static inline float fast_atan2(float y, float x);
+static void demodulate(Nbfm *nbfm, const float *bi, const float *bq, unsigned int n, float *out);
+static short saturate(float v);
+
+
+Nbfm *nbfm_create(double sample_rate, double offset, double bandwidth, int audio_sample_rate, double volume)
+{
+    if (bandwidth < 2 * NBFM_DEVIATION) {
+        fprintf(stderr, "invalid NBFM channel bandwidth: %.0lf\n", bandwidth);
+        return NULL;
+    }
+    if (audio_sample_rate < 2 * (NBFM_AUDIO_CUTOFF + NBFM_AUDIO_TRANSITION / 2)) {
+        fprintf(stderr, "invalid audio sample rate: %d\n", audio_sample_rate);
+        return NULL;
+    }
+
+    /* the quadrature rate should be about twice the channel bandwidth
+     * (enough for the demodulator and a short channel filter), and it must
+     * be an exact rational multiple of the audio rate, with a small
+     * interpolation factor to keep the resampler filter bank small */
+    int decimation = (int)(sample_rate / (2 * bandwidth));
+    int interpolation = 0;
+    int resampler_decimation = 0;
+    for (; decimation >= 1; decimation--) {
+        double quadrature_sample_rate = sample_rate / decimation;
+        if (quadrature_sample_rate != floor(quadrature_sample_rate))
+            continue;
+        double g = gcd(quadrature_sample_rate, audio_sample_rate);
+        if (audio_sample_rate / g <= NBFM_MAX_INTERPOLATION) {
+            interpolation = (int)(audio_sample_rate / g);
+            resampler_decimation = (int)(quadrature_sample_rate / g);
+            break;
+        }
+    }
+    if (decimation < 1) {
+        fprintf(stderr, "no suitable NBFM resampling ratio for sample rate %.0lf and audio sample rate %d\n", sample_rate, audio_sample_rate);
+        return NULL;
+    }
+
+    Ddc *ddc = ddc_create(sample_rate, offset, bandwidth, decimation);
+    if (ddc == NULL)
+        return NULL;
+
+    /* the resampler filter runs at the interpolated rate */
+    double resampler_rate = (double)(sample_rate / decimation) * interpolation;
+    int num_taps = fir_lowpass_num_taps(NBFM_AUDIO_TRANSITION / resampler_rate);
+    if (num_taps > NBFM_MAX_RESAMPLER_TAPS) {
+        fprintf(stderr, "NBFM resampler filter too long (%d taps)\n", num_taps);
+        ddc_free(ddc);
+        return NULL;
+    }
+
+    Nbfm *nbfm = (Nbfm *)calloc(1, sizeof(Nbfm));
+    nbfm->sample_rate = sample_rate;
+    nbfm->offset = offset;
+    nbfm->bandwidth = bandwidth;
+    nbfm->audio_sample_rate = audio_sample_rate;
+    nbfm->ddc = ddc;
+    nbfm->decimation = decimation;
+    nbfm->quadrature_sample_rate = sample_rate / decimation;
+    nbfm->bi = (float *)malloc((NBFM_SLICE_SAMPLES / decimation + 1) * sizeof(float));
+    nbfm->bq = (float *)malloc((NBFM_SLICE_SAMPLES / decimation + 1) * sizeof(float));
+    nbfm->last_i = 0.0f;
+    nbfm->last_q = 0.0f;
+    /* full deviation -> 1.0 */
+    nbfm->demod_gain = (float)(nbfm->quadrature_sample_rate / (2 * M_PI * NBFM_DEVIATION));
+    nbfm->deemph_alpha = (float)(1.0 - exp(-1.0 / (nbfm->quadrature_sample_rate * NBFM_TAU)));
+    nbfm->deemph_state = 0.0f;
+
+    nbfm->interpolation = interpolation;
+    nbfm->resampler_decimation = resampler_decimation;
+    unsigned int taps_per_phase = (num_taps + interpolation - 1) / interpolation;
+    nbfm->taps_per_phase = taps_per_phase;
+    nbfm->phase_taps = (taps_per_phase + FIR_TAPS_PADDING - 1) & ~(FIR_TAPS_PADDING - 1);
+    nbfm->phases = (float *)calloc((size_t)interpolation * nbfm->phase_taps, sizeof(float));
+    /* a gain of L makes up for the zeros inserted by the interpolation */
+    float *taps = (float *)calloc((size_t)interpolation * taps_per_phase, sizeof(float));
+    fir_lowpass(taps, num_taps, NBFM_AUDIO_CUTOFF / resampler_rate, interpolation * volume * 32767.0);
+    for (int p = 0; p < interpolation; p++) {
+        float *phase = nbfm->phases + (size_t)p * nbfm->phase_taps;
+        for (unsigned int k = 0; k < taps_per_phase; k++)
+            phase[taps_per_phase - 1 - k] = taps[p + k * interpolation];
+    }
+    free(taps);
+
+    size_t capacity = nbfm->phase_taps + NBFM_SLICE_SAMPLES / decimation + 1 + FIR_TAPS_PADDING;
+    nbfm->x = (float *)calloc(capacity, sizeof(float));
+    /* start with a full window of zeros, so the first output is at t=0 */
+    nbfm->length = taps_per_phase - 1;
+    nbfm->start = 0;
+    nbfm->phase = 0;
+    return nbfm;
+}
+
+void nbfm_free(Nbfm *nbfm)
+{
+    ddc_free(nbfm->ddc);
+    free(nbfm->bi);
+    free(nbfm->bq);
+    free(nbfm->phases);
+    free(nbfm->x);
+    free(nbfm);
+}
+
+unsigned int nbfm_process(Nbfm *nbfm, const short *iq, unsigned int n, short *audio)
+{
+    unsigned int nout = 0;
+    while (n > 0) {
+        unsigned int m = n < NBFM_SLICE_SAMPLES ? n : NBFM_SLICE_SAMPLES;
+        unsigned int nq = ddc_process_float(nbfm->ddc, iq, m, nbfm->bi, nbfm->bq);
+        iq += 2 * m;
+        n -= m;
+
+        /* demodulate and de-emphasize straight into the resampler input */
+        float *x = nbfm->x + nbfm->length;
+        demodulate(nbfm, nbfm->bi, nbfm->bq, nq, x);
+        float state = nbfm->deemph_state;
+        float alpha = nbfm->deemph_alpha;
+        for (unsigned int i = 0; i < nq; i++) {
+            state += alpha * (x[i] - state);
+            x[i] = state;
+        }
+        nbfm->deemph_state = state;
+        nbfm->length += nq;
+
+        /* output k is at k * M / L input samples: only the phase of the
+         * filter bank that lines up with it is computed */
+        while (nbfm->start + nbfm->taps_per_phase <= nbfm->length) {
+            const float *phase = nbfm->phases + (size_t)nbfm->phase * nbfm->phase_taps;
+            audio[nout++] = saturate(fir_dot(phase, nbfm->x + nbfm->start, nbfm->phase_taps));
+            nbfm->phase += nbfm->resampler_decimation;
+            nbfm->start += nbfm->phase / nbfm->interpolation;
+            nbfm->phase %= nbfm->interpolation;
+        }
+
+        /* keep what the next windows need */
+        unsigned int keep = nbfm->length > nbfm->start ? nbfm->length - nbfm->start : 0;
+        if (keep > 0)
+            memmove(nbfm->x, nbfm->x + nbfm->start, keep * sizeof(float));
+        nbfm->start -= nbfm->length - keep;
+        nbfm->length = keep;
+    }
+    return nout;
+}
+
+unsigned int nbfm_max_audio_samples(const Nbfm *nbfm, unsigned int n)
+{
+    /* each slice may yield one more quadrature sample than n / decimation */
+    unsigned long long quadrature_samples = n / nbfm->decimation + n / NBFM_SLICE_SAMPLES + 1;
+    return (unsigned int)(quadrature_samples * nbfm->interpolation / nbfm->resampler_decimation + 1);
+}
+
+void nbfm_print(const Nbfm *nbfm, FILE *stream)
+{
+    fprintf(stream, "NBFM offset=%.0lf bandwidth=%.0lf decimation=%d quadrature_rate=%.0lf channel_taps=%d resampler=%d/%d audio_rate=%d kernel=%s\n", nbfm->offset, nbfm->bandwidth, nbfm->decimation, nbfm->quadrature_sample_rate, ddc_num_taps(nbfm->ddc), nbfm->interpolation, nbfm->resampler_decimation, nbfm->audio_sample_rate, ddc_kernel_name(nbfm->ddc));
+}
+
+
+static double gcd(double a, double b)
+{
+    while (b != 0) {
+        double t = fmod(a, b);
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* branchless polynomial approximation (max error about 1e-5 rad), so the
+ * loops that use it can be vectorized */
+static inline float fast_atan2(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float mx = ax > ay ? ax : ay;
+    float mn = ax > ay ? ay : ax;
+    float a = mn / (mx + 1e-30f);
+    float s = a * a;
+    float r = ((((-0.0117212f * s + 0.05265332f) * s - 0.11643287f) * s + 0.19354346f) * s - 0.33262347f) * s * a + 0.99997726f * a;
+    r = ay > ax ? 1.57079633f - r : r;
+    r = x < 0 ? 3.14159265f - r : r;
+    return y < 0 ? -r : r;
+}
+
+/* phase difference between consecutive samples: arg(x[n] * conj(x[n-1])) */
+static void demodulate(Nbfm *nbfm, const float *bi, const float *bq, unsigned int n, float *out)
+{
+    if (n == 0)
+        return;
+    float gain = nbfm->demod_gain;
+    out[0] = gain * fast_atan2(bq[0] * nbfm->last_i - bi[0] * nbfm->last_q, bi[0] * nbfm->last_i + bq[0] * nbfm->last_q);
+    for (unsigned int i = 1; i < n; i++)
+        out[i] = gain * fast_atan2(bq[i] * bi[i-1] - bi[i] * bq[i-1], bi[i] * bi[i-1] + bq[i] * bq[i-1]);
+    nbfm->last_i = bi[n-1];
+    nbfm->last_q = bq[n-1];
+}
+
+static short saturate(float v)
+{
+    v = v >= 0 ? v + 0.5f : v - 0.5f;
+    if (v >= 32767.0f)
+        return 32767;
+    if (v <= -32768.0f)
+        return -32768;
+    return (short)v;
+}
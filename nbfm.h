@@ -0,0 +1,38 @@
+/* native NBFM demodulator: channel filter, quadrature demodulator,
+ * de-emphasis and rational resampler to the audio sample rate
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _NBFM_H
+#define _NBFM_H
+
+#include <stdio.h>
+
+#define NBFM_DEFAULT_BANDWIDTH 25000.0
+#define NBFM_DEFAULT_AUDIO_SAMPLE_RATE 48000
+#define NBFM_DEFAULT_VOLUME 0.3
+
+typedef struct Nbfm Nbfm;
+
+/* demodulate the NBFM signal at 'offset' Hz from the center with the
+ * given channel bandwidth; the audio is scaled so that the full (5kHz)
+ * deviation times 'volume' is full scale; returns NULL (after printing
+ * the reason) if the parameters are not valid */
+Nbfm *nbfm_create(double sample_rate, double offset, double bandwidth, int audio_sample_rate, double volume);
+void nbfm_free(Nbfm *nbfm);
+
+/* process n interleaved I/Q samples from iq[]; the audio samples (at most
+ * nbfm_max_audio_samples(n)) are stored in audio[] and their number is
+ * returned; the state is kept from one call to the next */
+unsigned int nbfm_process(Nbfm *nbfm, const short *iq, unsigned int n, short *audio);
+unsigned int nbfm_max_audio_samples(const Nbfm *nbfm, unsigned int n);
+
+/* print the demodulator parameters (one line) */
+void nbfm_print(const Nbfm *nbfm, FILE *stream);
+
+#endif /* _NBFM_H */
@@ -0,0 +1,200 @@
+/* demodulate NBFM from recorded I/Q files (one channel, or A and B as
+ * stereo) to 16 bit PCM audio - a native replacement for fm_player
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_output.h"
+#include "nbfm.h"
+
+#define MAX_PATH_SIZE 1024
+#define INPUT_BLOCK_SAMPLES 65536
+
+static void usage(const char* progname);
+
+
+int main(int argc, char *argv[])
+{
+    const char *input_file = NULL;
+    double sample_rate = 0.0;
+    double offset_A = 0.0;
+    double offset_B = 0.0;
+    double bandwidth = NBFM_DEFAULT_BANDWIDTH;
+    double volume = NBFM_DEFAULT_VOLUME;
+    int audio_sample_rate = NBFM_DEFAULT_AUDIO_SAMPLE_RATE;
+    const char *output_file = "-";
+
+    int c;
+    int n;
+    while ((c = getopt(argc, argv, "i:s:o:b:v:a:w:h")) != -1) {
+        switch (c) {
+            case 'i':
+                input_file = optarg;
+                break;
+            case 's':
+                if (sscanf(optarg, "%lg", &sample_rate) != 1 || sample_rate <= 0) {
+                    fprintf(stderr, "invalid sample rate: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'o':
+                n = sscanf(optarg, "%lg,%lg", &offset_A, &offset_B);
+                if (n < 1) {
+                    fprintf(stderr, "invalid frequency offset: %s\n", optarg);
+                    exit(1);
+                }
+                if (n == 1)
+                    offset_B = offset_A;
+                break;
+            case 'b':
+                if (sscanf(optarg, "%lg", &bandwidth) != 1) {
+                    fprintf(stderr, "invalid channel bandwidth: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'v':
+                if (sscanf(optarg, "%lg", &volume) != 1 || volume <= 0) {
+                    fprintf(stderr, "invalid volume: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'a':
+                if (sscanf(optarg, "%d", &audio_sample_rate) != 1) {
+                    fprintf(stderr, "invalid audio sample rate: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'w':
+                output_file = optarg;
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (input_file == NULL || sample_rate == 0.0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    /* '%c' in the input file name means both channels (A left, B right) */
+    int channels = strstr(input_file, "%c") != NULL ? 2 : 1;
+    FILE *inputs[2] = { NULL, NULL };
+    Nbfm *nbfms[2] = { NULL, NULL };
+    for (int i = 0; i < channels; i++) {
+        char filename[MAX_PATH_SIZE];
+        snprintf(filename, MAX_PATH_SIZE, input_file, 'A' + i);
+        inputs[i] = fopen(filename, "r");
+        if (inputs[i] == NULL) {
+            fprintf(stderr, "fopen(%s) failed: %s\n", filename, strerror(errno));
+            exit(1);
+        }
+        nbfms[i] = nbfm_create(sample_rate, i == 0 ? offset_A : offset_B, bandwidth, audio_sample_rate, volume);
+        if (nbfms[i] == NULL)
+            exit(1);
+        if (channels == 2)
+            fprintf(stderr, "RX %c - ", 'A' + i);
+        nbfm_print(nbfms[i], stderr);
+    }
+
+    AudioOutput *audio_output = audio_output_open(output_file, channels, audio_sample_rate);
+    if (audio_output == NULL)
+        exit(1);
+
+    short *iq[2];
+    short *audio[2];
+    unsigned int max_audio_samples = nbfm_max_audio_samples(nbfms[0], INPUT_BLOCK_SAMPLES);
+    for (int i = 0; i < channels; i++) {
+        iq[i] = (short *)malloc(INPUT_BLOCK_SAMPLES * 2 * sizeof(short));
+        audio[i] = (short *)malloc(max_audio_samples * sizeof(short));
+    }
+    short *frames = (short *)malloc(max_audio_samples * channels * sizeof(short));
+
+    struct timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    unsigned long long input_samples = 0;
+    unsigned long long audio_frames = 0;
+    int ret = 0;
+    while (ret == 0) {
+        /* stop at the end of the shorter input */
+        size_t nread = INPUT_BLOCK_SAMPLES;
+        for (int i = 0; i < channels; i++) {
+            size_t m = fread(iq[i], 2 * sizeof(short), INPUT_BLOCK_SAMPLES, inputs[i]);
+            if (m < nread)
+                nread = m;
+        }
+        if (nread == 0)
+            break;
+        /* both channels have the same rates, so the same number of input
+         * samples yields the same number of audio samples */
+        unsigned int naudio = 0;
+        for (int i = 0; i < channels; i++)
+            naudio = nbfm_process(nbfms[i], iq[i], nread, channels == 1 ? frames : audio[i]);
+        if (channels == 2) {
+            for (unsigned int k = 0; k < naudio; k++) {
+                frames[2*k] = audio[0][k];
+                frames[2*k+1] = audio[1][k];
+            }
+        }
+        if (audio_output_write(audio_output, frames, naudio) == -1)
+            ret = -1;
+        input_samples += nread;
+        audio_frames += naudio;
+        if (nread < INPUT_BLOCK_SAMPLES)
+            break;
+    }
+    for (int i = 0; i < channels; i++) {
+        if (ferror(inputs[i])) {
+            fprintf(stderr, "fread() failed: %s\n", strerror(errno));
+            ret = -1;
+        }
+    }
+
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    double elapsed = (end_time.tv_sec - start_time.tv_sec) + 1e-9 * (end_time.tv_nsec - start_time.tv_nsec);
+    double duration = input_samples / sample_rate;
+    fprintf(stderr, "input_samples=%llu audio_frames=%llu duration=%.3lfs processing_time=%.3lfs realtime_factor=%.1lf\n", input_samples, audio_frames, duration, elapsed, elapsed > 0 ? duration / elapsed : 0.0);
+
+    if (audio_output_close(audio_output) == -1)
+        ret = -1;
+    for (int i = 0; i < channels; i++) {
+        fclose(inputs[i]);
+        nbfm_free(nbfms[i]);
+        free(iq[i]);
+        free(audio[i]);
+    }
+    free(frames);
+    return ret == 0 ? 0 : 1;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...]\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -i <input file> ('%%c' will be replaced by the channel id (A or B) and both channels will be demodulated as stereo) - mandatory\n");
+    fprintf(stderr, "    -s <sample rate> - mandatory\n");
+    fprintf(stderr, "    -o <frequency offset> (A,B for different offsets) (default: 0)\n");
+    fprintf(stderr, "    -b <channel bandwidth> (default: %.0lf)\n", NBFM_DEFAULT_BANDWIDTH);
+    fprintf(stderr, "    -v <volume> (default: %.1lf)\n", NBFM_DEFAULT_VOLUME);
+    fprintf(stderr, "    -a <audio sample rate> (default: %d)\n", NBFM_DEFAULT_AUDIO_SAMPLE_RATE);
+    fprintf(stderr, "    -w <audio output file> ('-' for raw PCM to stdout, '.wav' suffix for a WAV file) (default: -)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
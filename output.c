@@ -0,0 +1,874 @@
+/* output engines for the recorded I/Q streams
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+#include "output.h"
+
+#define OUTPUT_DIRECT_ALIGNMENT 4096
+#define OUTPUT_URING_NBUFFERS 8
+#define OUTPUT_URING_BUFFER_SIZE (1024 * 1024)
+#define OUTPUT_MMAP_WINDOW_SIZE (64 * 1024 * 1024)
+#define OUTPUT_MMAP_WINDOW_OVERLAP (1024 * 1024)
+#define OUTPUT_PIPE_NBUFFERS 64
+#define OUTPUT_PIPE_BUFFER_SIZE (64 * 1024)
+#define OUTPUT_PIPE_SIZE (1024 * 1024)
+#define OUTPUT_PIPE_CLOSE_TIMEOUT_MS 1000
+
+/* window k maps the file range [k*WINDOW_SIZE, (k+1)*WINDOW_SIZE+OVERLAP);
+ * a block starting in window k always fits in its mapping, because each
+ * window extends into the next one by more than the largest block */
+struct OutputMmap {
+    char *windows[2];                  /* window k is mapped at windows[k%2] */
+    _Atomic long current;              /* window used by the producer */
+    _Atomic long prepared;             /* highest window mapped so far */
+};
+
+static OutputMmap *mmap_setup(int fd);
+static int mmap_map_window(int fd, OutputMmap *output_mmap, long index);
+static void mmap_unmap_window(char **window);
+
+/* the buffers are used in sequence (buffer n is at n % NBUFFERS); the
+ * producer fills them, and output_service() vmsplice()s them into the pipe;
+ * the pipe only takes references to their pages, so a buffer is recycled
+ * once the reader has consumed all of it (what is still in the pipe is
+ * given by FIONREAD); a reader that splice()s the data on (instead of
+ * reading it) would see the buffers change under it */
+struct OutputPipe {
+    char *buffers;
+    size_t lengths[OUTPUT_PIPE_NBUFFERS];      /* set by the producer before 'filled' */
+    uint64_t end_bytes[OUTPUT_PIPE_NBUFFERS];  /* spliced_bytes at the end of each buffer */
+    _Atomic uint64_t filled;                   /* buffers completed by the producer */
+    _Atomic uint64_t recycled;                 /* buffers the producer can fill again */
+    size_t fill;                               /* producer: bytes in the current buffer */
+    /* the following are only used by output_service() */
+    uint64_t spliced;                          /* buffers in the pipe (or dropped) */
+    size_t splice_offset;                      /* bytes of buffer 'spliced' already in the pipe */
+    uint64_t spliced_bytes;
+    size_t pipe_size;
+    int closed;                                /* the reader went away */
+    unsigned long long dropped_buffers;
+    unsigned long long dropped_bytes;
+};
+
+static OutputPipe *pipe_setup(int fd);
+static void *pipe_reserve(Output *output, size_t count);
+static int pipe_service(Output *output);
+static size_t pipe_recycle(Output *output);
+static void pipe_drop(OutputPipe *output_pipe, size_t length);
+static void pipe_flush(Output *output);
+
+#ifdef HAVE_LINUX_IO_URING_H
+struct OutputUring {
+    int ring_fd;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    char *buffers[OUTPUT_URING_NBUFFERS];
+    size_t buffer_len[OUTPUT_URING_NBUFFERS];     /* 0 if the buffer is free */
+    off_t buffer_offset[OUTPUT_URING_NBUFFERS];
+    int current;
+    size_t fill;
+    unsigned inflight;
+    off_t submit_offset;
+};
+
+static OutputUring *uring_setup(void);
+static void uring_free(OutputUring *uring);
+static int uring_submit(Output *output, int index, size_t len);
+static int uring_reap(Output *output, int wait);
+static ssize_t uring_write(Output *output, const void *data, size_t count);
+static int uring_skip(Output *output, off_t count);
+static int uring_flush(Output *output);
+#endif
+
+
+int output_engine_from_string(const char *name, OutputEngine *engine)
+{
+    if (strcmp(name, "write") == 0) {
+        *engine = OUTPUT_ENGINE_WRITE;
+    } else if (strcmp(name, "uring") == 0) {
+        *engine = OUTPUT_ENGINE_IO_URING;
+    } else if (strcmp(name, "mmap") == 0) {
+        *engine = OUTPUT_ENGINE_MMAP;
+    } else if (strcmp(name, "pipe") == 0) {
+        *engine = OUTPUT_ENGINE_PIPE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+const char *output_engine_name(OutputEngine engine)
+{
+    switch (engine) {
+        case OUTPUT_ENGINE_WRITE:
+            return "write";
+        case OUTPUT_ENGINE_IO_URING:
+            return "uring";
+        case OUTPUT_ENGINE_MMAP:
+            return "mmap";
+        case OUTPUT_ENGINE_PIPE:
+            return "pipe";
+    }
+    return "unknown";
+}
+
+Output *output_open(const char *filename, OutputEngine engine, off_t preallocate_size)
+{
+    /* a shared writable mapping needs the file opened for reading too */
+    int flags = (engine == OUTPUT_ENGINE_MMAP ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+    int direct = 0;
+    if (engine == OUTPUT_ENGINE_IO_URING) {
+        flags |= O_DIRECT;
+        direct = 1;
+    }
+    int fd;
+    if (strcmp(filename, "-") == 0) {
+        /* take over stdout, so nothing else printed there gets mixed with
+         * the samples (what is still in the stdio buffer goes to stderr) */
+        fd = dup(STDOUT_FILENO);
+        if (fd == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+            fprintf(stderr, "dup(stdout) failed: %s\n", strerror(errno));
+            return NULL;
+        }
+        direct = 0;
+    } else if (engine == OUTPUT_ENGINE_PIPE) {
+        /* opening a FIFO for writing blocks until there is a reader */
+        fd = open(filename, O_WRONLY | O_NONBLOCK);
+        if (fd == -1 && errno == ENXIO) {
+            fprintf(stderr, "waiting for a reader on %s\n", filename);
+            fd = open(filename, O_WRONLY);
+        } else if (fd != -1) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        }
+    } else {
+        fd = open(filename, flags, 0644);
+    }
+    if (fd == -1 && direct && errno == EINVAL) {
+        /* some filesystems (tmpfs for instance) do not support O_DIRECT */
+        fprintf(stderr, "open(%s) with O_DIRECT not supported - using buffered I/O\n", filename);
+        flags &= ~O_DIRECT;
+        direct = 0;
+        fd = open(filename, flags, 0644);
+    }
+    if (fd == -1) {
+        fprintf(stderr, "open(%s) for writing failed: %s\n", filename, strerror(errno));
+        return NULL;
+    }
+
+    Output *output = (Output *)malloc(sizeof(Output));
+    output->engine = engine;
+    output->fd = fd;
+    output->direct = direct;
+    output->size = 0;
+    output->overruns = 0;
+    output->uring = NULL;
+    output->mmap = NULL;
+    output->pipe = NULL;
+
+    if (engine == OUTPUT_ENGINE_IO_URING) {
+#ifdef HAVE_LINUX_IO_URING_H
+        output->uring = uring_setup();
+#else
+        fprintf(stderr, "io_uring support not compiled in\n");
+#endif
+        if (output->uring == NULL) {
+            fprintf(stderr, "io_uring output engine not available - falling back to write()\n");
+            output->engine = OUTPUT_ENGINE_WRITE;
+            if (direct) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+                output->direct = 0;
+            }
+        } else if (preallocate_size > 0) {
+            /* reserve the blocks up front so the file does not fragment
+             * and the writes do not have to allocate; the size is trimmed
+             * to what was actually written in output_close() */
+            if (fallocate(fd, 0, 0, preallocate_size) == -1) {
+                fprintf(stderr, "fallocate(%s, %lld) failed: %s\n", filename, (long long)preallocate_size, strerror(errno));
+            }
+        }
+    } else if (engine == OUTPUT_ENGINE_MMAP) {
+        output->mmap = mmap_setup(fd);
+        if (output->mmap == NULL) {
+            close(fd);
+            free(output);
+            return NULL;
+        }
+    } else if (engine == OUTPUT_ENGINE_PIPE) {
+        struct stat st;
+        if (fstat(fd, &st) == -1 || !S_ISFIFO(st.st_mode)) {
+            fprintf(stderr, "%s is not a pipe or a FIFO\n", filename);
+            close(fd);
+            free(output);
+            return NULL;
+        }
+        output->pipe = pipe_setup(fd);
+        if (output->pipe == NULL) {
+            close(fd);
+            free(output);
+            return NULL;
+        }
+    }
+
+    return output;
+}
+
+ssize_t output_write(Output *output, const void *data, size_t count)
+{
+    switch (output->engine) {
+        case OUTPUT_ENGINE_WRITE: {
+            ssize_t nwritten = write(output->fd, data, count);
+            if (nwritten > 0)
+                output->size += nwritten;
+            return nwritten;
+        }
+        case OUTPUT_ENGINE_IO_URING:
+#ifdef HAVE_LINUX_IO_URING_H
+            return uring_write(output, data, count);
+#else
+            break;
+#endif
+        case OUTPUT_ENGINE_MMAP:
+        case OUTPUT_ENGINE_PIPE: {
+            void *ptr = output_reserve(output, count);
+            if (ptr == NULL) {
+                errno = EAGAIN;
+                return -1;
+            }
+            memcpy(ptr, data, count);
+            output_commit(output, count);
+            return count;
+        }
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+int output_skip(Output *output, off_t count)
+{
+    switch (output->engine) {
+        case OUTPUT_ENGINE_WRITE:
+            /* the file is not preallocated, so seeking past the end is
+             * enough; a hole at the end is taken care of in output_close() */
+            if (lseek(output->fd, count, SEEK_CUR) == -1)
+                return -1;
+            output->size += count;
+            return 0;
+        case OUTPUT_ENGINE_IO_URING:
+#ifdef HAVE_LINUX_IO_URING_H
+            return uring_skip(output, count);
+#else
+            break;
+#endif
+        case OUTPUT_ENGINE_MMAP:
+        case OUTPUT_ENGINE_PIPE:
+            break;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+int output_is_pipe(const char *filename)
+{
+    struct stat st;
+    if (strcmp(filename, "-") == 0)
+        return fstat(STDOUT_FILENO, &st) == 0 && S_ISFIFO(st.st_mode);
+    return stat(filename, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+void *output_reserve(Output *output, size_t count)
+{
+    if (output->pipe != NULL)
+        return pipe_reserve(output, count);
+    OutputMmap *output_mmap = output->mmap;
+    if (count > OUTPUT_MMAP_WINDOW_OVERLAP) {
+        output->overruns++;
+        return NULL;
+    }
+    long index = output->size / OUTPUT_MMAP_WINDOW_SIZE;
+    if (index != atomic_load_explicit(&output_mmap->current, memory_order_relaxed)) {
+        if (index > atomic_load_explicit(&output_mmap->prepared, memory_order_acquire)) {
+            /* the next window is not ready - drop this block */
+            output->overruns++;
+            return NULL;
+        }
+        atomic_store_explicit(&output_mmap->current, index, memory_order_release);
+    }
+    return output_mmap->windows[index % 2] + (output->size - (off_t)index * OUTPUT_MMAP_WINDOW_SIZE);
+}
+
+void output_commit(Output *output, size_t count)
+{
+    if (output->pipe != NULL)
+        output->pipe->fill += count;
+    output->size += count;
+}
+
+int output_service(Output *output)
+{
+    if (output->pipe != NULL)
+        return pipe_service(output);
+    OutputMmap *output_mmap = output->mmap;
+    if (output_mmap == NULL)
+        return 0;
+    long current = atomic_load_explicit(&output_mmap->current, memory_order_acquire);
+    long prepared = atomic_load_explicit(&output_mmap->prepared, memory_order_relaxed);
+    if (prepared > current)
+        return 0;
+    /* the producer moved to the last prepared window: retire the previous
+     * one (which shares the slot with the next one) and map the next one */
+    char **window = &output_mmap->windows[(current + 1) % 2];
+    if (*window != NULL)
+        mmap_unmap_window(window);
+    if (mmap_map_window(output->fd, output_mmap, current + 1) == -1)
+        return -1;
+    atomic_store_explicit(&output_mmap->prepared, current + 1, memory_order_release);
+    return 0;
+}
+
+void output_pipe_drops(const Output *output, unsigned long long *buffers, unsigned long long *bytes)
+{
+    *buffers = output->pipe != NULL ? output->pipe->dropped_buffers : 0;
+    *bytes = output->pipe != NULL ? output->pipe->dropped_bytes : 0;
+}
+
+int output_close(Output *output)
+{
+    int ret = 0;
+#ifdef HAVE_LINUX_IO_URING_H
+    if (output->uring != NULL) {
+        if (uring_flush(output) == -1)
+            ret = -1;
+        uring_free(output->uring);
+        /* drop the O_DIRECT padding and whatever was preallocated */
+        if (ftruncate(output->fd, output->size) == -1) {
+            fprintf(stderr, "ftruncate(%d, %lld) failed: %s\n", output->fd, (long long)output->size, strerror(errno));
+            ret = -1;
+        }
+    }
+#endif
+    if (output->mmap != NULL) {
+        for (int i = 0; i < 2; i++) {
+            if (output->mmap->windows[i] != NULL)
+                mmap_unmap_window(&output->mmap->windows[i]);
+        }
+        free(output->mmap);
+        /* the file was grown a window at a time - trim it to the exact size */
+        if (ftruncate(output->fd, output->size) == -1) {
+            fprintf(stderr, "ftruncate(%d, %lld) failed: %s\n", output->fd, (long long)output->size, strerror(errno));
+            ret = -1;
+        }
+    }
+    if (output->pipe != NULL) {
+        pipe_flush(output);
+        munmap(output->pipe->buffers, OUTPUT_PIPE_NBUFFERS * OUTPUT_PIPE_BUFFER_SIZE);
+        free(output->pipe);
+    }
+    off_t end = output->engine == OUTPUT_ENGINE_WRITE ? lseek(output->fd, 0, SEEK_END) : -1;
+    if (end != -1 && end < output->size) {
+        /* the file ends with a hole (see output_skip()) */
+        if (ftruncate(output->fd, output->size) == -1) {
+            fprintf(stderr, "ftruncate(%d, %lld) failed: %s\n", output->fd, (long long)output->size, strerror(errno));
+            ret = -1;
+        }
+    }
+    if (close(output->fd) == -1) {
+        fprintf(stderr, "close(%d) failed: %s\n", output->fd, strerror(errno));
+        ret = -1;
+    }
+    free(output);
+    return ret;
+}
+
+
+#ifdef HAVE_LINUX_IO_URING_H
+/* io_uring engine - no liburing, just the three system calls */
+static OutputUring *uring_setup(void)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = syscall(__NR_io_uring_setup, OUTPUT_URING_NBUFFERS, &params);
+    if (ring_fd == -1) {
+        fprintf(stderr, "io_uring_setup() failed: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    OutputUring *uring = (OutputUring *)calloc(1, sizeof(OutputUring));
+    uring->ring_fd = ring_fd;
+    uring->current = -1;
+    uring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sq_ptr = mmap(NULL, uring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    uring->cq_ptr = mmap(NULL, uring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (uring->sq_ptr == MAP_FAILED || uring->cq_ptr == MAP_FAILED || uring->sqes == MAP_FAILED) {
+        fprintf(stderr, "io_uring mmap() failed: %s\n", strerror(errno));
+        uring_free(uring);
+        return NULL;
+    }
+    uring->sq_tail = (unsigned *)((char *)uring->sq_ptr + params.sq_off.tail);
+    uring->sq_mask = (unsigned *)((char *)uring->sq_ptr + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned *)((char *)uring->sq_ptr + params.sq_off.array);
+    uring->cq_head = (unsigned *)((char *)uring->cq_ptr + params.cq_off.head);
+    uring->cq_tail = (unsigned *)((char *)uring->cq_ptr + params.cq_off.tail);
+    uring->cq_mask = (unsigned *)((char *)uring->cq_ptr + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe *)((char *)uring->cq_ptr + params.cq_off.cqes);
+
+    /* page aligned buffers (as required by O_DIRECT) registered with the
+     * kernel, so they are not mapped and unmapped for every write */
+    struct iovec iovecs[OUTPUT_URING_NBUFFERS];
+    for (int i = 0; i < OUTPUT_URING_NBUFFERS; i++) {
+        uring->buffers[i] = mmap(NULL, OUTPUT_URING_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (uring->buffers[i] == MAP_FAILED) {
+            fprintf(stderr, "mmap(%d) failed: %s\n", OUTPUT_URING_BUFFER_SIZE, strerror(errno));
+            uring->buffers[i] = NULL;
+            uring_free(uring);
+            return NULL;
+        }
+        iovecs[i].iov_base = uring->buffers[i];
+        iovecs[i].iov_len = OUTPUT_URING_BUFFER_SIZE;
+    }
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, iovecs, OUTPUT_URING_NBUFFERS) == -1) {
+        fprintf(stderr, "io_uring_register(IORING_REGISTER_BUFFERS) failed: %s\n", strerror(errno));
+        uring_free(uring);
+        return NULL;
+    }
+
+    return uring;
+}
+
+static void uring_free(OutputUring *uring)
+{
+    for (int i = 0; i < OUTPUT_URING_NBUFFERS; i++) {
+        if (uring->buffers[i] != NULL)
+            munmap(uring->buffers[i], OUTPUT_URING_BUFFER_SIZE);
+    }
+    if (uring->sqes != NULL && uring->sqes != MAP_FAILED)
+        munmap(uring->sqes, uring->sqes_size);
+    if (uring->cq_ptr != NULL && uring->cq_ptr != MAP_FAILED)
+        munmap(uring->cq_ptr, uring->cq_size);
+    if (uring->sq_ptr != NULL && uring->sq_ptr != MAP_FAILED)
+        munmap(uring->sq_ptr, uring->sq_size);
+    close(uring->ring_fd);
+    free(uring);
+}
+
+static int uring_submit(Output *output, int index, size_t len)
+{
+    OutputUring *uring = output->uring;
+    unsigned tail = *uring->sq_tail;
+    unsigned sq_index = tail & *uring->sq_mask;
+    struct io_uring_sqe *sqe = &uring->sqes[sq_index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = output->fd;
+    sqe->addr = (unsigned long)uring->buffers[index];
+    sqe->len = len;
+    sqe->off = uring->submit_offset;
+    sqe->buf_index = index;
+    sqe->user_data = index;
+    uring->sq_array[sq_index] = sq_index;
+    __atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    uring->buffer_len[index] = len;
+    uring->buffer_offset[index] = uring->submit_offset;
+    uring->submit_offset += len;
+    uring->inflight++;
+
+    while (syscall(__NR_io_uring_enter, uring->ring_fd, 1, 0, 0, NULL, 0) == -1) {
+        if (errno != EINTR && errno != EAGAIN) {
+            fprintf(stderr, "io_uring_enter() failed: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* process the completions; if wait is set, block until at least one is available */
+static int uring_reap(Output *output, int wait)
+{
+    OutputUring *uring = output->uring;
+    int ret = 0;
+    unsigned head = *uring->cq_head;
+    if (wait && head == __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE)) {
+        while (syscall(__NR_io_uring_enter, uring->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) == -1) {
+            if (errno != EINTR) {
+                fprintf(stderr, "io_uring_enter() failed: %s\n", strerror(errno));
+                return -1;
+            }
+        }
+    }
+    while (head != __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+        int index = (int)cqe->user_data;
+        size_t len = uring->buffer_len[index];
+        if (cqe->res < 0) {
+            fprintf(stderr, "io_uring write failed: %s\n", strerror(-cqe->res));
+            ret = -1;
+        } else if ((size_t)cqe->res < len) {
+            /* short writes are rare - just complete them synchronously;
+             * with O_DIRECT from the last block boundary (the buffers, the
+             * offsets and the lengths are all aligned), so the rest of
+             * the block is written again */
+            size_t alignment = output->direct ? OUTPUT_DIRECT_ALIGNMENT : 1;
+            size_t done = cqe->res & ~(alignment - 1);
+            while (done < len) {
+                ssize_t nwritten = pwrite(output->fd, uring->buffers[index] + done, len - done, uring->buffer_offset[index] + done);
+                size_t next = nwritten > 0 ? (done + nwritten) & ~(alignment - 1) : done;
+                if (next == done) {
+                    fprintf(stderr, "pwrite() failed: %s\n", nwritten == -1 ? strerror(errno) : "short write");
+                    ret = -1;
+                    break;
+                }
+                done = next;
+            }
+        }
+        uring->buffer_len[index] = 0;
+        uring->inflight--;
+        head++;
+    }
+    __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+    return ret;
+}
+
+static ssize_t uring_write(Output *output, const void *data, size_t count)
+{
+    OutputUring *uring = output->uring;
+    size_t consumed = 0;
+    while (consumed < count) {
+        if (uring->current == -1) {
+            if (uring_reap(output, 0) == -1)
+                return -1;
+            for (int i = 0; i < OUTPUT_URING_NBUFFERS; i++) {
+                if (uring->buffer_len[i] == 0) {
+                    uring->current = i;
+                    uring->fill = 0;
+                    break;
+                }
+            }
+            if (uring->current == -1) {
+                /* all the buffers are in flight */
+                if (uring_reap(output, 1) == -1)
+                    return -1;
+                continue;
+            }
+        }
+        size_t n = count - consumed;
+        if (n > OUTPUT_URING_BUFFER_SIZE - uring->fill)
+            n = OUTPUT_URING_BUFFER_SIZE - uring->fill;
+        memcpy(uring->buffers[uring->current] + uring->fill, (const char *)data + consumed, n);
+        uring->fill += n;
+        consumed += n;
+        if (uring->fill == OUTPUT_URING_BUFFER_SIZE) {
+            if (uring_submit(output, uring->current, OUTPUT_URING_BUFFER_SIZE) == -1)
+                return -1;
+            uring->current = -1;
+        }
+    }
+    output->size += consumed;
+    return consumed;
+}
+
+/* O_DIRECT writes have to start at aligned offsets: write zeros up to the
+ * next aligned offset and submit what is buffered, then move the submit
+ * offset past the aligned part of the hole (giving back any preallocated
+ * blocks there), and write the rest as zeros */
+static int uring_skip(Output *output, off_t count)
+{
+    static const char zeros[OUTPUT_DIRECT_ALIGNMENT];
+    OutputUring *uring = output->uring;
+    off_t head = (OUTPUT_DIRECT_ALIGNMENT - output->size % OUTPUT_DIRECT_ALIGNMENT) % OUTPUT_DIRECT_ALIGNMENT;
+    if (head > count)
+        head = count;
+    if (head > 0 && uring_write(output, zeros, head) == -1)
+        return -1;
+    count -= head;
+    off_t hole = count & ~(off_t)(OUTPUT_DIRECT_ALIGNMENT - 1);
+    if (hole > 0) {
+        if (uring->current != -1 && uring->fill > 0) {
+            if (uring_submit(output, uring->current, uring->fill) == -1)
+                return -1;
+            uring->current = -1;
+        }
+        if (fallocate(output->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, uring->submit_offset, hole) == -1 && errno != EOPNOTSUPP)
+            fprintf(stderr, "fallocate(%d, PUNCH_HOLE) failed: %s\n", output->fd, strerror(errno));
+        uring->submit_offset += hole;
+        output->size += hole;
+        count -= hole;
+    }
+    while (count > 0) {
+        size_t n = count < OUTPUT_DIRECT_ALIGNMENT ? count : OUTPUT_DIRECT_ALIGNMENT;
+        if (uring_write(output, zeros, n) == -1)
+            return -1;
+        count -= n;
+    }
+    return 0;
+}
+
+static int uring_flush(Output *output)
+{
+    OutputUring *uring = output->uring;
+    int ret = 0;
+    if (uring->current != -1 && uring->fill > 0) {
+        size_t len = uring->fill;
+        if (output->direct) {
+            /* O_DIRECT needs whole blocks; the padding is truncated later */
+            size_t padded_len = (len + OUTPUT_DIRECT_ALIGNMENT - 1) & ~(size_t)(OUTPUT_DIRECT_ALIGNMENT - 1);
+            memset(uring->buffers[uring->current] + len, 0, padded_len - len);
+            len = padded_len;
+        }
+        if (uring_submit(output, uring->current, len) == -1)
+            ret = -1;
+        uring->current = -1;
+    }
+    while (uring->inflight > 0) {
+        if (uring_reap(output, 1) == -1) {
+            ret = -1;
+            break;
+        }
+    }
+    return ret;
+}
+#endif
+
+
+/* mmap engine */
+static OutputMmap *mmap_setup(int fd)
+{
+    OutputMmap *output_mmap = (OutputMmap *)calloc(1, sizeof(OutputMmap));
+    if (mmap_map_window(fd, output_mmap, 0) == -1) {
+        free(output_mmap);
+        return NULL;
+    }
+    atomic_init(&output_mmap->current, 0);
+    atomic_init(&output_mmap->prepared, 0);
+    return output_mmap;
+}
+
+static int mmap_map_window(int fd, OutputMmap *output_mmap, long index)
+{
+    off_t offset = (off_t)index * OUTPUT_MMAP_WINDOW_SIZE;
+    size_t length = OUTPUT_MMAP_WINDOW_SIZE + OUTPUT_MMAP_WINDOW_OVERLAP;
+    if (ftruncate(fd, offset + length) == -1) {
+        fprintf(stderr, "ftruncate(%d, %lld) failed: %s\n", fd, (long long)(offset + length), strerror(errno));
+        return -1;
+    }
+    char *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "mmap(%d, %lld) failed: %s\n", fd, (long long)offset, strerror(errno));
+        return -1;
+    }
+#ifdef MADV_POPULATE_WRITE
+    /* prefault the pages for writing here, not in the producer */
+    madvise(base, length, MADV_POPULATE_WRITE);
+#endif
+    output_mmap->windows[index % 2] = base;
+    return 0;
+}
+
+static void mmap_unmap_window(char **window)
+{
+    size_t length = OUTPUT_MMAP_WINDOW_SIZE + OUTPUT_MMAP_WINDOW_OVERLAP;
+    if (msync(*window, length, MS_ASYNC) == -1)
+        fprintf(stderr, "msync() failed: %s\n", strerror(errno));
+    if (munmap(*window, length) == -1)
+        fprintf(stderr, "munmap() failed: %s\n", strerror(errno));
+    *window = NULL;
+}
+
+
+/* pipe engine */
+static OutputPipe *pipe_setup(int fd)
+{
+    /* a larger pipe holds more buffers (it is only a hint: the limit for
+     * unprivileged users is in /proc/sys/fs/pipe-max-size) */
+    fcntl(fd, F_SETPIPE_SZ, OUTPUT_PIPE_SIZE);
+    OutputPipe *output_pipe = (OutputPipe *)calloc(1, sizeof(OutputPipe));
+    int pipe_size = fcntl(fd, F_GETPIPE_SZ);
+    output_pipe->pipe_size = pipe_size > 0 ? pipe_size : OUTPUT_PIPE_BUFFER_SIZE;
+    /* page aligned, and faulted in now rather than in the callbacks */
+    output_pipe->buffers = mmap(NULL, OUTPUT_PIPE_NBUFFERS * OUTPUT_PIPE_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (output_pipe->buffers == MAP_FAILED) {
+        fprintf(stderr, "pipe buffers mmap() failed: %s\n", strerror(errno));
+        free(output_pipe);
+        return NULL;
+    }
+    atomic_init(&output_pipe->filled, 0);
+    atomic_init(&output_pipe->recycled, 0);
+    return output_pipe;
+}
+
+static void *pipe_reserve(Output *output, size_t count)
+{
+    OutputPipe *output_pipe = output->pipe;
+    if (count > OUTPUT_PIPE_BUFFER_SIZE) {
+        output->overruns++;
+        return NULL;
+    }
+    uint64_t current = atomic_load_explicit(&output_pipe->filled, memory_order_relaxed);
+    if (output_pipe->fill + count > OUTPUT_PIPE_BUFFER_SIZE) {
+        /* this one is done: hand it over */
+        output_pipe->lengths[current % OUTPUT_PIPE_NBUFFERS] = output_pipe->fill;
+        atomic_store_explicit(&output_pipe->filled, ++current, memory_order_release);
+        output_pipe->fill = 0;
+    }
+    if (current - atomic_load_explicit(&output_pipe->recycled, memory_order_acquire) >= OUTPUT_PIPE_NBUFFERS) {
+        /* all the buffers are still in use - drop this block */
+        output->overruns++;
+        return NULL;
+    }
+    return output_pipe->buffers + (current % OUTPUT_PIPE_NBUFFERS) * OUTPUT_PIPE_BUFFER_SIZE + output_pipe->fill;
+}
+
+/* hand the full buffers to the pipe, without blocking; if the reader does
+ * not keep up, the oldest full buffers are dropped, so that the producer
+ * gets fresh buffers (and the reader fresh samples) when it catches up */
+static int pipe_service(Output *output)
+{
+    OutputPipe *output_pipe = output->pipe;
+    int error = 0;
+    size_t queued = pipe_recycle(output);
+    uint64_t filled = atomic_load_explicit(&output_pipe->filled, memory_order_acquire);
+    while (output_pipe->spliced < filled) {
+        size_t length = output_pipe->lengths[output_pipe->spliced % OUTPUT_PIPE_NBUFFERS];
+        if (!output_pipe->closed) {
+            /* whole buffers only, so that a slow reader leaves none of
+             * them half way in the pipe (and they can be dropped) */
+            if (output_pipe->splice_offset == 0 && queued + length > output_pipe->pipe_size)
+                break;
+            struct iovec iov = {
+                .iov_base = output_pipe->buffers + (output_pipe->spliced % OUTPUT_PIPE_NBUFFERS) * OUTPUT_PIPE_BUFFER_SIZE + output_pipe->splice_offset,
+                .iov_len = length - output_pipe->splice_offset
+            };
+            ssize_t nspliced = vmsplice(output->fd, &iov, 1, SPLICE_F_NONBLOCK);
+            if (nspliced == -1) {
+                if (errno == EAGAIN)
+                    break;
+                if (errno == EINTR)
+                    continue;
+                /* the reader went away (or worse): from now on everything
+                 * is dropped */
+                output_pipe->closed = 1;
+                error = errno;
+                continue;
+            }
+            output_pipe->splice_offset += nspliced;
+            output_pipe->spliced_bytes += nspliced;
+            queued += nspliced;
+            if (output_pipe->splice_offset < length)
+                continue;
+        } else {
+            pipe_drop(output_pipe, length - output_pipe->splice_offset);
+        }
+        output_pipe->end_bytes[output_pipe->spliced % OUTPUT_PIPE_NBUFFERS] = output_pipe->spliced_bytes;
+        output_pipe->spliced++;
+        output_pipe->splice_offset = 0;
+    }
+    uint64_t recycled = atomic_load_explicit(&output_pipe->recycled, memory_order_relaxed);
+    if (filled - recycled > OUTPUT_PIPE_NBUFFERS * 3 / 4 && output_pipe->splice_offset == 0) {
+        while (filled - output_pipe->spliced > OUTPUT_PIPE_NBUFFERS / 4) {
+            pipe_drop(output_pipe, output_pipe->lengths[output_pipe->spliced % OUTPUT_PIPE_NBUFFERS]);
+            output_pipe->end_bytes[output_pipe->spliced % OUTPUT_PIPE_NBUFFERS] = output_pipe->spliced_bytes;
+            output_pipe->spliced++;
+        }
+        pipe_recycle(output);
+    }
+    if (error == EPIPE) {
+        fprintf(stderr, "the reader closed the pipe - dropping the samples from now on\n");
+    } else if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+/* the buffers whose bytes have all left the pipe can be filled again;
+ * returns the bytes still in the pipe */
+static size_t pipe_recycle(Output *output)
+{
+    OutputPipe *output_pipe = output->pipe;
+    int queued = 0;
+    if (!output_pipe->closed && ioctl(output->fd, FIONREAD, &queued) == -1)
+        queued = 0;
+    uint64_t consumed = output_pipe->spliced_bytes - queued;
+    uint64_t recycled = atomic_load_explicit(&output_pipe->recycled, memory_order_relaxed);
+    while (recycled < output_pipe->spliced && output_pipe->end_bytes[recycled % OUTPUT_PIPE_NBUFFERS] <= consumed)
+        recycled++;
+    atomic_store_explicit(&output_pipe->recycled, recycled, memory_order_release);
+    return queued;
+}
+
+static void pipe_drop(OutputPipe *output_pipe, size_t length)
+{
+    output_pipe->dropped_buffers++;
+    output_pipe->dropped_bytes += length;
+}
+
+/* the producer is done: hand over the last (partial) buffer, and give the
+ * reader a little time to make room for the rest */
+static void pipe_flush(Output *output)
+{
+    OutputPipe *output_pipe = output->pipe;
+    if (output_pipe->fill > 0) {
+        uint64_t current = atomic_load_explicit(&output_pipe->filled, memory_order_relaxed);
+        output_pipe->lengths[current % OUTPUT_PIPE_NBUFFERS] = output_pipe->fill;
+        atomic_store_explicit(&output_pipe->filled, current + 1, memory_order_release);
+        output_pipe->fill = 0;
+    }
+    int waited_ms = 0;
+    while (1) {
+        pipe_service(output);
+        uint64_t filled = atomic_load_explicit(&output_pipe->filled, memory_order_relaxed);
+        if (output_pipe->spliced == filled || waited_ms >= OUTPUT_PIPE_CLOSE_TIMEOUT_MS)
+            break;
+        struct pollfd pfd = { .fd = output->fd, .events = POLLOUT };
+        poll(&pfd, 1, 100);
+        waited_ms += 100;
+    }
+    /* whatever the reader did not make room for */
+    uint64_t filled = atomic_load_explicit(&output_pipe->filled, memory_order_relaxed);
+    if (output_pipe->spliced < filled)
+        fprintf(stderr, "the reader did not take the last %llu pipe buffers - dropped\n", (unsigned long long)(filled - output_pipe->spliced));
+    while (output_pipe->spliced < filled) {
+        pipe_drop(output_pipe, output_pipe->lengths[output_pipe->spliced % OUTPUT_PIPE_NBUFFERS] - output_pipe->splice_offset);
+        output_pipe->spliced++;
+        output_pipe->splice_offset = 0;
+    }
+}
@@ -0,0 +1,79 @@
+/* output engines for the recorded I/Q streams
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _OUTPUT_H
+#define _OUTPUT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef enum {
+    OUTPUT_ENGINE_WRITE,       /* plain write() through the page cache */
+    OUTPUT_ENGINE_IO_URING,    /* io_uring with registered buffers and O_DIRECT */
+    OUTPUT_ENGINE_MMAP,        /* samples stored directly into a mapping of the file */
+    OUTPUT_ENGINE_PIPE         /* samples stored directly into page aligned buffers
+                                * that are vmsplice()d into a pipe or a FIFO */
+} OutputEngine;
+
+typedef struct OutputUring OutputUring;
+typedef struct OutputMmap OutputMmap;
+typedef struct OutputPipe OutputPipe;
+
+typedef struct {
+    OutputEngine engine;
+    int fd;
+    int direct;                /* file opened with O_DIRECT */
+    off_t size;                /* bytes written so far */
+    unsigned long long overruns;
+    OutputUring *uring;
+    OutputMmap *mmap;
+    OutputPipe *pipe;
+} Output;
+
+/* parse an output engine name ('write', 'uring', 'mmap', or 'pipe'); returns -1 if invalid */
+int output_engine_from_string(const char *name, OutputEngine *engine);
+const char *output_engine_name(OutputEngine engine);
+
+/* preallocate_size is a hint for fallocate() (0 to skip); if the io_uring
+ * engine is not available, fall back to the write() engine; the pipe engine
+ * needs a pipe or a FIFO ('-' is stdout, which is taken over so nothing
+ * else printed there gets mixed with the samples), and it waits for a
+ * reader to open a FIFO */
+Output *output_open(const char *filename, OutputEngine engine, off_t preallocate_size);
+/* returns the number of bytes consumed, or -1 on error */
+ssize_t output_write(Output *output, const void *data, size_t count);
+
+/* leave a hole of 'count' bytes (that reads back as zeros) in the file
+ * instead of writing them; not supported by the mmap engine */
+int output_skip(Output *output, off_t count);
+
+/* true if the target of the file name is a pipe or a FIFO ('-' is stdout) */
+int output_is_pipe(const char *filename);
+
+/* mmap and pipe engines only: the producer gets a pointer into the mapped
+ * file (or into a pipe buffer) for 'count' bytes (NULL, and an overrun is
+ * accounted for, if the next window is not mapped yet, or if all the pipe
+ * buffers are still in use), fills it, then commits it; output_service()
+ * must be called periodically from another thread to map the next window
+ * ahead of time and retire the old one (or to vmsplice() the full buffers
+ * into the pipe and recycle the ones the reader is done with), so the
+ * producer never makes a syscall */
+void *output_reserve(Output *output, size_t count);
+void output_commit(Output *output, size_t count);
+int output_service(Output *output);
+
+/* pipe engine only: the full buffers dropped by output_service() because
+ * the reader was not keeping up (or was gone) */
+void output_pipe_drops(const Output *output, unsigned long long *buffers, unsigned long long *bytes);
+
+/* flush, truncate the file to the exact size written, and close it (the
+ * pipe engine waits a little for the reader to take the last buffers) */
+int output_close(Output *output);
+
+#endif /* _OUTPUT_H */
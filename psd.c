@@ -0,0 +1,262 @@
+/* streaming Welch power spectral density
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PSD_X86
+#endif
+
+#include "fft.h"
+#include "psd.h"
+
+/* the int16 full scale */
+#define PSD_FULL_SCALE 32768.0
+
+/* the window applied to the int16 I and Q samples, as floats */
+typedef void (*PsdWindowFn)(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im);
+/* power[k] += re[k]^2 + im[k]^2 */
+typedef void (*PsdPowerFn)(const float *re, const float *im, unsigned int n, float *power);
+
+struct Psd {
+    Fft *fft;
+    unsigned int size;
+    unsigned int hop;
+    unsigned int frames_per_average;
+    float *window;
+    double window_sum;
+    PsdWindowFn window_fn;
+    PsdPowerFn power_fn;
+    const char *kernel_name;
+    /* the last 'size' samples */
+    short *xi;
+    short *xq;
+    unsigned int fill;
+    uint64_t next_sample_index;
+    /* the FFT work buffers */
+    float *re;
+    float *im;
+    /* accumulated over the average */
+    float *power;
+    unsigned int frames;
+    uint64_t average_start;
+    float *power_dB;
+};
+
+static void psd_frame(Psd *psd);
+static void psd_report(Psd *psd, PsdReport *report);
+static void window_scalar(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im);
+static void power_scalar(const float *re, const float *im, unsigned int n, float *power);
+#ifdef PSD_X86
+static void window_sse2(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im);
+static void power_sse2(const float *re, const float *im, unsigned int n, float *power);
+static void window_avx2(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im);
+static void power_avx2(const float *re, const float *im, unsigned int n, float *power);
+#endif
+
+
+Psd *psd_create(unsigned int size, unsigned int frames)
+{
+    Fft *fft = fft_create(size);
+    if (fft == NULL)
+        return NULL;
+    Psd *psd = (Psd *)calloc(1, sizeof(Psd));
+    psd->fft = fft;
+    psd->size = size;
+    psd->hop = size / 2;
+    psd->frames_per_average = frames;
+    psd->window = (float *)malloc(size * sizeof(float));
+    psd->window_sum = fft_hann_window(psd->window, size);
+    psd->window_fn = window_scalar;
+    psd->power_fn = power_scalar;
+    psd->kernel_name = "scalar";
+#ifdef PSD_X86
+    /* the kernels work on groups of 8 samples */
+    __builtin_cpu_init();
+    if (size >= 8 && __builtin_cpu_supports("avx2")) {
+        psd->window_fn = window_avx2;
+        psd->power_fn = power_avx2;
+        psd->kernel_name = "avx2";
+    } else if (size >= 8 && __builtin_cpu_supports("sse2")) {
+        psd->window_fn = window_sse2;
+        psd->power_fn = power_sse2;
+        psd->kernel_name = "sse2";
+    }
+#endif
+    psd->xi = (short *)malloc(size * sizeof(short));
+    psd->xq = (short *)malloc(size * sizeof(short));
+    psd->fill = 0;
+    psd->next_sample_index = UINT64_MAX;
+    psd->re = (float *)malloc(size * sizeof(float));
+    psd->im = (float *)malloc(size * sizeof(float));
+    psd->power = (float *)calloc(size, sizeof(float));
+    psd->power_dB = (float *)malloc(size * sizeof(float));
+    return psd;
+}
+
+void psd_free(Psd *psd)
+{
+    if (psd == NULL)
+        return;
+    fft_free(psd->fft);
+    free(psd->window);
+    free(psd->xi);
+    free(psd->xq);
+    free(psd->re);
+    free(psd->im);
+    free(psd->power);
+    free(psd->power_dB);
+    free(psd);
+}
+
+unsigned int psd_size(const Psd *psd)
+{
+    return psd->size;
+}
+
+const char *psd_kernel_name(const Psd *psd)
+{
+    return psd->kernel_name;
+}
+
+unsigned int psd_average_samples(const Psd *psd)
+{
+    return (psd->frames_per_average + 1) * psd->hop;
+}
+
+unsigned int psd_process(Psd *psd, uint64_t sample_index, const short *xi, const short *xq, unsigned int n, PsdReport *report, int *ready)
+{
+    *ready = 0;
+    if (sample_index != psd->next_sample_index)
+        psd->fill = 0;
+    unsigned int taken = 0;
+    while (taken < n) {
+        if (psd->fill == 0 && psd->frames == 0)
+            psd->average_start = sample_index + taken;
+        unsigned int m = n - taken < psd->size - psd->fill ? n - taken : psd->size - psd->fill;
+        memcpy(psd->xi + psd->fill, xi + taken, m * sizeof(short));
+        memcpy(psd->xq + psd->fill, xq + taken, m * sizeof(short));
+        psd->fill += m;
+        taken += m;
+        if (psd->fill == psd->size) {
+            psd_frame(psd);
+            /* keep the second half for the next frame */
+            memmove(psd->xi, psd->xi + psd->hop, (psd->size - psd->hop) * sizeof(short));
+            memmove(psd->xq, psd->xq + psd->hop, (psd->size - psd->hop) * sizeof(short));
+            psd->fill -= psd->hop;
+            if (psd->frames == psd->frames_per_average) {
+                psd_report(psd, report);
+                *ready = 1;
+                break;
+            }
+        }
+    }
+    psd->next_sample_index = sample_index + taken;
+    return taken;
+}
+
+static void psd_frame(Psd *psd)
+{
+    psd->window_fn(psd->xi, psd->xq, psd->window, psd->size, psd->re, psd->im);
+    fft_forward(psd->fft, psd->re, psd->im);
+    psd->power_fn(psd->re, psd->im, psd->size, psd->power);
+    psd->frames++;
+}
+
+/* to dBFS, with the negative frequencies (the upper half of the FFT) first */
+static void psd_report(Psd *psd, PsdReport *report)
+{
+    unsigned int size = psd->size;
+    double full_scale = PSD_FULL_SCALE * psd->window_sum;
+    double normalization = 1.0 / (psd->frames * full_scale * full_scale);
+    for (unsigned int k = 0; k < size; k++) {
+        double power = psd->power[(k + size / 2) % size] * normalization;
+        psd->power_dB[k] = (float)(10.0 * log10(power + 1e-20));
+    }
+    report->sample_index = psd->average_start;
+    report->frames = psd->frames;
+    report->power = psd->power_dB;
+
+    memset(psd->power, 0, size * sizeof(float));
+    psd->frames = 0;
+}
+
+static void window_scalar(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im)
+{
+    for (unsigned int k = 0; k < n; k++) {
+        re[k] = xi[k] * window[k];
+        im[k] = xq[k] * window[k];
+    }
+}
+
+static void power_scalar(const float *re, const float *im, unsigned int n, float *power)
+{
+    for (unsigned int k = 0; k < n; k++)
+        power[k] += re[k] * re[k] + im[k] * im[k];
+}
+
+#ifdef PSD_X86
+/* n is a multiple of 8 in all the following */
+__attribute__((target("sse2")))
+static void window_sse2(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im)
+{
+    for (unsigned int k = 0; k < n; k += 8) {
+        __m128i vi = _mm_loadu_si128((const __m128i *)(xi + k));
+        __m128i vq = _mm_loadu_si128((const __m128i *)(xq + k));
+        __m128 w0 = _mm_loadu_ps(window + k);
+        __m128 w1 = _mm_loadu_ps(window + k + 4);
+        /* sign extend by unpacking into the upper halves and shifting back */
+        __m128 i0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(vi, vi), 16));
+        __m128 i1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(vi, vi), 16));
+        __m128 q0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(vq, vq), 16));
+        __m128 q1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(vq, vq), 16));
+        _mm_storeu_ps(re + k, _mm_mul_ps(i0, w0));
+        _mm_storeu_ps(re + k + 4, _mm_mul_ps(i1, w1));
+        _mm_storeu_ps(im + k, _mm_mul_ps(q0, w0));
+        _mm_storeu_ps(im + k + 4, _mm_mul_ps(q1, w1));
+    }
+}
+
+__attribute__((target("sse2")))
+static void power_sse2(const float *re, const float *im, unsigned int n, float *power)
+{
+    for (unsigned int k = 0; k < n; k += 4) {
+        __m128 r = _mm_loadu_ps(re + k);
+        __m128 i = _mm_loadu_ps(im + k);
+        __m128 p = _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(i, i));
+        _mm_storeu_ps(power + k, _mm_add_ps(_mm_loadu_ps(power + k), p));
+    }
+}
+
+__attribute__((target("avx2")))
+static void window_avx2(const short *xi, const short *xq, const float *window, unsigned int n, float *re, float *im)
+{
+    for (unsigned int k = 0; k < n; k += 8) {
+        __m256 w = _mm256_loadu_ps(window + k);
+        __m256 i = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(xi + k))));
+        __m256 q = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(xq + k))));
+        _mm256_storeu_ps(re + k, _mm256_mul_ps(i, w));
+        _mm256_storeu_ps(im + k, _mm256_mul_ps(q, w));
+    }
+}
+
+__attribute__((target("avx2")))
+static void power_avx2(const float *re, const float *im, unsigned int n, float *power)
+{
+    for (unsigned int k = 0; k < n; k += 8) {
+        __m256 r = _mm256_loadu_ps(re + k);
+        __m256 i = _mm256_loadu_ps(im + k);
+        __m256 p = _mm256_add_ps(_mm256_mul_ps(r, r), _mm256_mul_ps(i, i));
+        _mm256_storeu_ps(power + k, _mm256_add_ps(_mm256_loadu_ps(power + k), p));
+    }
+}
+#endif
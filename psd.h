@@ -0,0 +1,74 @@
+/* streaming Welch power spectral density
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _PSD_H
+#define _PSD_H
+
+#include <stdint.h>
+
+/* the samples are cut into Hann windowed FFT frames overlapping by half,
+ * and the power spectra of 'frames' of them are averaged; the samples do
+ * not need to be contiguous across the averages (a live monitor only
+ * looks at a fraction of the stream) */
+typedef struct Psd Psd;
+
+typedef struct {
+    uint64_t sample_index;     /* of the first sample in the average */
+    unsigned int frames;
+    const float *power;        /* dBFS per bin (0 dBFS is a full scale complex
+                                * sine in one bin), from the most negative
+                                * frequency to the most positive one; valid
+                                * until the next call */
+} PsdReport;
+
+/* returns NULL (after printing the reason) if size is not a power of two */
+Psd *psd_create(unsigned int size, unsigned int frames);
+void psd_free(Psd *psd);
+unsigned int psd_size(const Psd *psd);
+const char *psd_kernel_name(const Psd *psd);
+
+/* n samples (I and Q in separate arrays, like the stream callbacks),
+ * starting at sample_index (if that is not where the previous ones ended,
+ * the current frame starts over); returns how many samples were taken,
+ * stopping early when an average is ready (then *ready is set) */
+unsigned int psd_process(Psd *psd, uint64_t sample_index, const short *xi, const short *xq, unsigned int n, PsdReport *report, int *ready);
+
+/* the number of contiguous samples for one average */
+unsigned int psd_average_samples(const Psd *psd);
+
+
+/* PSD stream layout (all the fields are in the host byte order; the stream
+ * can be a FIFO for a live display):
+ *   - a PsdFileHeader
+ *   - one PsdRecord per average, each followed by fft_size floats (the
+ *     PsdReport power, in dBFS) */
+
+#define PSD_MAGIC "IQPSDMON"
+#define PSD_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    char rx_id;
+    char reserved[3];
+    uint32_t fft_size;
+    uint32_t frames;           /* per average */
+    double sample_rate;        /* nominal */
+    double frequency;          /* center frequency at the start */
+    double interval;           /* between the averages, in seconds */
+} PsdFileHeader;
+
+typedef struct {
+    uint64_t sample_index;     /* of the first sample in the average */
+    uint64_t timestamp_ns;     /* CLOCK_REALTIME when the average was done */
+    uint32_t frames;
+    uint32_t reserved;
+} PsdRecord;
+
+#endif /* _PSD_H */
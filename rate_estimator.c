@@ -0,0 +1,84 @@
+/* streaming sample rate estimator and sample/time anchors
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+
+#include "rate_estimator.h"
+
+
+void rate_estimator_init(RateEstimator *rate_estimator)
+{
+    *rate_estimator = (RateEstimator){ 0 };
+}
+
+uint64_t rate_estimator_add(RateEstimator *rate_estimator, uint32_t first_sample_num, unsigned int num_samples, int reset, uint64_t timestamp_ns)
+{
+    RateEstimator *re = rate_estimator;
+    uint64_t sample_index;
+    if (!re->started) {
+        sample_index = first_sample_num;
+        re->started = 1;
+    } else if (reset && first_sample_num != re->next_sample_num) {
+        /* the sample numbers started over: no unwrapping across that */
+        sample_index = re->next_sample_index;
+        re->n = 0;
+        re->restarts++;
+    } else {
+        /* the unsigned difference takes care of the 32 bit wrap around */
+        sample_index = re->next_sample_index + (uint32_t)(first_sample_num - re->next_sample_num);
+    }
+    if (re->n == 0) {
+        re->x0 = sample_index;
+        re->t0 = timestamp_ns;
+        re->mean_x = 0.0;
+        re->mean_t = 0.0;
+        re->cxx = 0.0;
+        re->cxt = 0.0;
+        re->ctt = 0.0;
+    }
+    re->next_sample_index = sample_index + num_samples;
+    re->next_sample_num = first_sample_num + num_samples;
+
+    double x = (double)(sample_index - re->x0);
+    double t = (double)(int64_t)(timestamp_ns - re->t0);
+    re->n++;
+    double dx = x - re->mean_x;
+    double dt = t - re->mean_t;
+    re->mean_x += dx / re->n;
+    re->mean_t += dt / re->n;
+    re->cxx += dx * (x - re->mean_x);
+    re->cxt += dx * (t - re->mean_t);
+    re->ctt += dt * (t - re->mean_t);
+    return sample_index;
+}
+
+double rate_estimator_rate(const RateEstimator *rate_estimator)
+{
+    const RateEstimator *re = rate_estimator;
+    if (re->n < 2 || re->cxx <= 0 || re->cxt <= 0)
+        return 0.0;
+    /* the slope is in ns per sample */
+    return 1e9 * re->cxx / re->cxt;
+}
+
+double rate_estimator_time(const RateEstimator *rate_estimator, double sample_index)
+{
+    const RateEstimator *re = rate_estimator;
+    double slope = re->cxx > 0 ? re->cxt / re->cxx : 0.0;
+    return re->t0 + re->mean_t + slope * (sample_index - re->x0 - re->mean_x);
+}
+
+double rate_estimator_residual(const RateEstimator *rate_estimator)
+{
+    const RateEstimator *re = rate_estimator;
+    if (re->n < 3 || re->cxx <= 0)
+        return 0.0;
+    double sse = re->ctt - re->cxt * re->cxt / re->cxx;
+    return sse > 0 ? sqrt(sse / (re->n - 2)) : 0.0;
+}
@@ -0,0 +1,80 @@
+/* streaming sample rate estimator and sample/time anchors
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _RATE_ESTIMATOR_H
+#define _RATE_ESTIMATOR_H
+
+#include <stdint.h>
+
+/* least squares fit of the callback timestamps (CLOCK_MONOTONIC_RAW, so
+ * NTP steps and slewing do not affect it) against the sample number of
+ * the first sample of each block; the sample numbers are unwrapped to 64
+ * bits, and since they keep counting across the dropped samples, the
+ * drops do not bias the estimate; after a reset the sample numbers may
+ * start over, so then the sample index carries on from the previous block
+ * instead, and the fit starts again (the time of the samples lost, if
+ * any, is not known); the state is a few running moments (updated with
+ * Welford's method), so it is O(1) in time and memory and cheap enough
+ * for the stream callbacks */
+typedef struct {
+    int started;
+    uint64_t n;                /* blocks in the fit */
+    uint64_t restarts;         /* of the fit, after a reset */
+    uint64_t next_sample_index;/* unwrapped sample number after the last block */
+    uint32_t next_sample_num;  /* the same, as firstSampleNum */
+    uint64_t x0;               /* first sample index and timestamp (the */
+    uint64_t t0;               /* moments are relative to them) */
+    double mean_x;
+    double mean_t;
+    double cxx;
+    double cxt;
+    double ctt;
+} RateEstimator;
+
+void rate_estimator_init(RateEstimator *rate_estimator);
+
+/* returns the unwrapped sample index of first_sample_num; reset is the
+ * flag of the stream callback */
+uint64_t rate_estimator_add(RateEstimator *rate_estimator, uint32_t first_sample_num, unsigned int num_samples, int reset, uint64_t timestamp_ns);
+
+/* the estimated sample rate (in Hz), or 0 with fewer than two blocks */
+double rate_estimator_rate(const RateEstimator *rate_estimator);
+/* the fitted time (CLOCK_MONOTONIC_RAW in ns) of a sample index */
+double rate_estimator_time(const RateEstimator *rate_estimator, double sample_index);
+/* the RMS of the residuals of the fit (in ns): the callback jitter */
+double rate_estimator_residual(const RateEstimator *rate_estimator);
+
+
+/* anchor sidecar file layout (all the fields are in the host byte order):
+ *   - an AnchorFileHeader
+ *   - one Anchor per block, in the order the blocks were received
+ * sample_index is the unwrapped firstSampleNum of the block, file_sample
+ * is the position of its first sample in the recording (as received from
+ * the RSPduo, i.e. before the DDC), and timestamp_ns the CLOCK_MONOTONIC_RAW
+ * time of its callback; any gap between consecutive sample indexes that
+ * is not matched in file_sample is dropped samples */
+
+#define ANCHOR_MAGIC "IQANCHOR"
+#define ANCHOR_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    char rx_id;
+    char reserved[3];
+    double sample_rate;        /* nominal */
+} AnchorFileHeader;
+
+typedef struct {
+    uint64_t sample_index;
+    uint64_t file_sample;
+    uint64_t timestamp_ns;
+} Anchor;
+
+#endif /* _RATE_ESTIMATOR_H */
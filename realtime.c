@@ -0,0 +1,52 @@
+/* opt-in real-time mode: memory locking and SCHED_FIFO threads
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "realtime.h"
+
+void realtime_init(RealtimeStatus *status, int priority)
+{
+    memset(status, 0, sizeof(*status));
+    status->priority = priority;
+}
+
+void realtime_lock_memory(RealtimeStatus *status)
+{
+    struct rlimit rlimit;
+    if (getrlimit(RLIMIT_MEMLOCK, &rlimit) == 0 && rlimit.rlim_cur != RLIM_INFINITY) {
+        struct rlimit unlimited = { RLIM_INFINITY, RLIM_INFINITY };
+        if (setrlimit(RLIMIT_MEMLOCK, &unlimited) == -1) {
+            snprintf(status->memory_error, sizeof(status->memory_error), "RLIMIT_MEMLOCK=%llukB", (unsigned long long)rlimit.rlim_cur / 1024);
+            return;
+        }
+    }
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+        snprintf(status->memory_error, sizeof(status->memory_error), "%s", strerror(errno));
+        return;
+    }
+    status->memory_locked = 1;
+}
+
+void realtime_thread(RealtimeStatus *status, pthread_t thread)
+{
+    status->threads++;
+    struct sched_param sched_param = { .sched_priority = status->priority };
+    int ret = pthread_setschedparam(thread, SCHED_FIFO, &sched_param);
+    if (ret != 0) {
+        status->thread_error = ret;
+        return;
+    }
+    status->fifo_threads++;
+}
@@ -0,0 +1,41 @@
+/* opt-in real-time mode: memory locking and SCHED_FIFO threads
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _REALTIME_H
+#define _REALTIME_H
+
+#include <pthread.h>
+
+/* each part is best effort: what actually took effect is recorded here,
+ * so the same binary runs (and says so) with or without the privileges
+ * (CAP_IPC_LOCK/CAP_SYS_RESOURCE for the memory, CAP_SYS_NICE or an
+ * RLIMIT_RTPRIO for the priorities, and reserved huge pages) */
+typedef struct {
+    int priority;              /* SCHED_FIFO priority (0 if disabled) */
+    int memory_locked;
+    char memory_error[128];
+    int ring_buffers;
+    int huge_page_ring_buffers;
+    int threads;
+    int fifo_threads;
+    int thread_error;          /* the last pthread_setschedparam() error */
+} RealtimeStatus;
+
+void realtime_init(RealtimeStatus *status, int priority);
+
+/* lock all the current and future pages (the thread stacks and the buffers
+ * allocated later are then also faulted in when they are created); with
+ * a finite RLIMIT_MEMLOCK (that cannot be raised) this is skipped, since
+ * with MCL_FUTURE every allocation past the limit would fail */
+void realtime_lock_memory(RealtimeStatus *status);
+
+/* switch one of the recorder threads to SCHED_FIFO at the priority */
+void realtime_thread(RealtimeStatus *status, pthread_t thread);
+
+#endif /* _REALTIME_H */
@@ -0,0 +1,266 @@
+/* benchmark for the dual_tuner_recorder callback and writer path
+ * it runs dual_tuner_recorder linked against the SDRplay API mock at
+ * increasing sample rates to find the highest rate sustained without drops
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define MAX_PATH_SIZE 1024
+#define MAX_LINE_SIZE 1024
+#define MAX_COMMAND_SIZE 4096
+
+typedef struct {
+    double elapsed_sec;
+    unsigned long long samples;
+    unsigned long long dropped_samples;
+    unsigned long long cpu_ns;
+    unsigned long long max_callback_ns;
+    unsigned long long overruns;
+    double writer_cpu_time;
+} ChannelResult;
+
+typedef struct {
+    const char *recorder;
+    const char *output_file;
+    const char *output_engine;
+    const char *extra_args;
+    unsigned int packet;
+    int streaming_time;
+} BenchConfig;
+
+static void usage(const char* progname);
+static int run_recorder(const BenchConfig *config, double rate, ChannelResult results[2]);
+static int report(double rate, const ChannelResult results[2]);
+
+
+int main(int argc, char *argv[])
+{
+    char default_recorder[MAX_PATH_SIZE];
+    char progpath[MAX_PATH_SIZE];
+    snprintf(progpath, MAX_PATH_SIZE, "%s", argv[0]);
+    snprintf(default_recorder, MAX_PATH_SIZE, "%s/dual_tuner_recorder_mock", dirname(progpath));
+
+    BenchConfig config = {
+        .recorder = default_recorder,
+        .output_file = "/dev/null",
+        .output_engine = "write",
+        .extra_args = NULL,
+        .packet = 1008,
+        .streaming_time = 3
+    };
+    double start_rate = 2e6;
+    double max_rate = 500e6;
+    double precision = 0.05;
+
+    int c;
+    while ((c = getopt(argc, argv, "p:o:e:a:n:x:r:m:P:h")) != -1) {
+        switch (c) {
+            case 'p':
+                config.recorder = optarg;
+                break;
+            case 'o':
+                config.output_file = optarg;
+                break;
+            case 'e':
+                config.output_engine = optarg;
+                break;
+            case 'a':
+                config.extra_args = optarg;
+                break;
+            case 'n':
+                if (sscanf(optarg, "%u", &config.packet) != 1) {
+                    fprintf(stderr, "invalid packet size: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'x':
+                if (sscanf(optarg, "%d", &config.streaming_time) != 1) {
+                    fprintf(stderr, "invalid streaming time: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'r':
+                if (sscanf(optarg, "%lg", &start_rate) != 1) {
+                    fprintf(stderr, "invalid start rate: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'm':
+                if (sscanf(optarg, "%lg", &max_rate) != 1) {
+                    fprintf(stderr, "invalid max rate: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'P':
+                if (sscanf(optarg, "%lg", &precision) != 1) {
+                    fprintf(stderr, "invalid precision: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            // help
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+            case '?':
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    fprintf(stdout, "recorder=%s output=%s engine=%s packet=%u streaming_time=%ds\n", config.recorder, config.output_file, config.output_engine, config.packet, config.streaming_time);
+
+    /* double the rate until there are drops, then bisect */
+    ChannelResult results[2];
+    double good_rate = 0.0;
+    ChannelResult good_results[2];
+    double bad_rate = 0.0;
+    for (double rate = start_rate; rate <= max_rate; rate *= 2) {
+        if (run_recorder(&config, rate, results) == -1)
+            exit(1);
+        if (report(rate, results) != 0) {
+            bad_rate = rate;
+            break;
+        }
+        good_rate = rate;
+        memcpy(good_results, results, sizeof(good_results));
+    }
+    if (good_rate == 0.0) {
+        fprintf(stdout, "drops already at the start rate (%.0lf)\n", start_rate);
+        exit(1);
+    }
+    if (bad_rate == 0.0) {
+        fprintf(stdout, "no drops up to the max rate (%.0lf)\n", max_rate);
+    } else {
+        while (bad_rate - good_rate > precision * good_rate) {
+            double rate = (good_rate + bad_rate) / 2;
+            if (run_recorder(&config, rate, results) == -1)
+                exit(1);
+            if (report(rate, results) != 0) {
+                bad_rate = rate;
+            } else {
+                good_rate = rate;
+                memcpy(good_results, results, sizeof(good_results));
+            }
+        }
+    }
+
+    fprintf(stdout, "max sustained sample rate per channel: %.0lf\n", good_rate);
+    for (int i = 0; i < 2; i++) {
+        const ChannelResult *result = &good_results[i];
+        fprintf(stdout, "RX %c - callback_cpu=%.1lf%% writer_cpu=%.1lf%% callback_ns_per_sample=%.2lf max_callback_us=%.1lf\n", 'A' + i, 100.0 * 1e-9 * result->cpu_ns / result->elapsed_sec, 100.0 * result->writer_cpu_time / result->elapsed_sec, (double)result->cpu_ns / result->samples, 1e-3 * result->max_callback_ns);
+    }
+    return 0;
+}
+
+static void usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [options...]\n", progname);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "    -p <path to dual_tuner_recorder_mock> (default: in the same directory as this program)\n");
+    fprintf(stderr, "    -o <output file> (default: /dev/null)\n");
+    fprintf(stderr, "    -e <output engine> (default: write)\n");
+    fprintf(stderr, "    -a <extra dual_tuner_recorder arguments>\n");
+    fprintf(stderr, "    -n <samples per packet> (default: 1008)\n");
+    fprintf(stderr, "    -x <streaming time for each rate (s)> (default: 3s)\n");
+    fprintf(stderr, "    -r <start sample rate> (default: 2000000)\n");
+    fprintf(stderr, "    -m <max sample rate> (default: 500000000)\n");
+    fprintf(stderr, "    -P <relative precision of the result> (default: 0.05)\n");
+    fprintf(stderr, "    -h show usage\n");
+}
+
+static int run_recorder(const BenchConfig *config, double rate, ChannelResult results[2])
+{
+    char stats_file[] = "/tmp/recorder_bench_XXXXXX";
+    int stats_fd = mkstemp(stats_file);
+    if (stats_fd == -1) {
+        fprintf(stderr, "mkstemp() failed: %s\n", strerror(errno));
+        return -1;
+    }
+    close(stats_fd);
+
+    char mock_config[MAX_LINE_SIZE];
+    snprintf(mock_config, MAX_LINE_SIZE, "rate=%.0lf,packet=%u,stats=%s", rate, config->packet, stats_file);
+    char command[MAX_COMMAND_SIZE];
+    snprintf(command, MAX_COMMAND_SIZE, "SDRPLAY_MOCK='%s' '%s' -r 8e6 -i 2048 -b 1536 -x %d -e %s -o '%s' %s 2>&1 >/dev/null", mock_config, config->recorder, config->streaming_time, config->output_engine, config->output_file, config->extra_args != NULL ? config->extra_args : "");
+
+    memset(results, 0, 2 * sizeof(ChannelResult));
+
+    /* the recorder reports overruns and the writer CPU time on stderr */
+    FILE *fp = popen(command, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "popen(%s) failed: %s\n", command, strerror(errno));
+        unlink(stats_file);
+        return -1;
+    }
+    char line[MAX_LINE_SIZE];
+    while (fgets(line, MAX_LINE_SIZE, fp) != NULL) {
+        char rx_id;
+        if (sscanf(line, "RX %c - ", &rx_id) != 1 || (rx_id != 'A' && rx_id != 'B'))
+            continue;
+        ChannelResult *result = &results[rx_id - 'A'];
+        const char *p;
+        unsigned long long overruns;
+        if ((p = strstr(line, "overruns=")) != NULL && sscanf(p, "overruns=%llu", &overruns) == 1)
+            result->overruns += overruns;
+        if ((p = strstr(line, "writer_cpu_time=")) != NULL)
+            sscanf(p, "writer_cpu_time=%lf", &result->writer_cpu_time);
+    }
+    int status = pclose(fp);
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s failed (status=%d)\n", config->recorder, status);
+        unlink(stats_file);
+        return -1;
+    }
+
+    /* the mock reports the stream statistics in the stats file */
+    fp = fopen(stats_file, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "fopen(%s) failed: %s\n", stats_file, strerror(errno));
+        unlink(stats_file);
+        return -1;
+    }
+    while (fgets(line, MAX_LINE_SIZE, fp) != NULL) {
+        char rx_id;
+        const char *p = strstr(line, " RX ");
+        if (p == NULL || sscanf(p, " RX %c - ", &rx_id) != 1 || (rx_id != 'A' && rx_id != 'B'))
+            continue;
+        ChannelResult *result = &results[rx_id - 'A'];
+        sscanf(strstr(p, "elapsed_sec="), "elapsed_sec=%lf packets=%*u samples=%llu dropped_samples=%llu injected_gap_samples=%*u restarts=%*u cpu_ns=%llu max_callback_ns=%llu", &result->elapsed_sec, &result->samples, &result->dropped_samples, &result->cpu_ns, &result->max_callback_ns);
+    }
+    fclose(fp);
+    unlink(stats_file);
+    return 0;
+}
+
+/* returns the number of channels with drops */
+static int report(double rate, const ChannelResult results[2])
+{
+    int channels_with_drops = 0;
+    fprintf(stdout, "rate=%.0lf", rate);
+    for (int i = 0; i < 2; i++) {
+        const ChannelResult *result = &results[i];
+        double elapsed_sec = result->elapsed_sec > 0 ? result->elapsed_sec : 1.0;
+        fprintf(stdout, " - RX %c dropped_samples=%llu overruns=%llu callback_cpu=%.1lf%% writer_cpu=%.1lf%%", 'A' + i, result->dropped_samples, result->overruns, 100.0 * 1e-9 * result->cpu_ns / elapsed_sec, 100.0 * result->writer_cpu_time / elapsed_sec);
+        if (result->dropped_samples > 0 || result->overruns > 0 || result->samples == 0)
+            channels_with_drops++;
+    }
+    fprintf(stdout, "\n");
+    fflush(stdout);
+    return channels_with_drops;
+}
@@ -0,0 +1,154 @@
+/* single-producer/single-consumer lock-free ring buffer
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "ring_buffer.h"
+
+/* the default huge page size from /proc/meminfo (0 if not available) */
+static size_t huge_page_size(void)
+{
+    FILE *fp = fopen("/proc/meminfo", "r");
+    if (fp == NULL)
+        return 0;
+    char line[256];
+    size_t size_kB = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "Hugepagesize: %zu kB", &size_kB) == 1)
+            break;
+    }
+    fclose(fp);
+    return size_kB * 1024;
+}
+
+/* with huge pages the failures are not reported, since the caller falls
+ * back to regular pages */
+static int ring_buffer_map(RingBuffer *ring_buffer, size_t size, int huge_pages)
+{
+    size_t page_size = huge_pages ? huge_page_size() : (size_t)sysconf(_SC_PAGESIZE);
+    if (page_size == 0)
+        return -1;
+    size_t rounded_size = page_size;
+    while (rounded_size < size)
+        rounded_size <<= 1;
+
+    int fd = memfd_create("ring_buffer", MFD_CLOEXEC | (huge_pages ? MFD_HUGETLB : 0));
+    if (fd == -1) {
+        if (!huge_pages)
+            fprintf(stderr, "memfd_create() failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, rounded_size) == -1) {
+        if (!huge_pages)
+            fprintf(stderr, "ftruncate(%zu) failed: %s\n", rounded_size, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    /* reserve twice the address space (aligned to the page size, which
+     * matters for the huge pages), then map the same pages twice */
+    size_t reserved_size = 2 * rounded_size + page_size;
+    char *reserved = mmap(NULL, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        fprintf(stderr, "mmap(%zu) failed: %s\n", reserved_size, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    char *buffer = (char *)(((uintptr_t)reserved + page_size - 1) & ~(uintptr_t)(page_size - 1));
+    if (buffer > reserved)
+        munmap(reserved, buffer - reserved);
+    if (reserved + reserved_size > buffer + 2 * rounded_size)
+        munmap(buffer + 2 * rounded_size, reserved + reserved_size - (buffer + 2 * rounded_size));
+    for (int i = 0; i < 2; i++) {
+        /* the huge pages are reserved here (ENOMEM if there are not enough) */
+        if (mmap(buffer + i * rounded_size, rounded_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            if (!huge_pages)
+                fprintf(stderr, "mmap(%zu) failed: %s\n", rounded_size, strerror(errno));
+            munmap(buffer, 2 * rounded_size);
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+
+    /* prefault all the pages, so the producer never takes a page fault */
+    memset(buffer, 0, rounded_size);
+
+    ring_buffer->buffer = buffer;
+    ring_buffer->size = rounded_size;
+    ring_buffer->huge_pages = huge_pages;
+    atomic_init(&ring_buffer->head, 0);
+    atomic_init(&ring_buffer->tail, 0);
+    ring_buffer->high_water_mark = 0;
+    ring_buffer->overruns = 0;
+    ring_buffer->overrun_bytes = 0;
+    return 0;
+}
+
+int ring_buffer_init(RingBuffer *ring_buffer, size_t size)
+{
+    return ring_buffer_map(ring_buffer, size, 0);
+}
+
+int ring_buffer_init_huge_pages(RingBuffer *ring_buffer, size_t size)
+{
+    if (ring_buffer_map(ring_buffer, size, 1) == 0)
+        return 0;
+    return ring_buffer_map(ring_buffer, size, 0);
+}
+
+void ring_buffer_free(RingBuffer *ring_buffer)
+{
+    if (ring_buffer->buffer != NULL) {
+        munmap(ring_buffer->buffer, 2 * ring_buffer->size);
+        ring_buffer->buffer = NULL;
+    }
+}
+
+void *ring_buffer_write_ptr(RingBuffer *ring_buffer, size_t count)
+{
+    size_t head = atomic_load_explicit(&ring_buffer->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring_buffer->tail, memory_order_acquire);
+    if (head - tail + count > ring_buffer->size) {
+        ring_buffer->overruns++;
+        ring_buffer->overrun_bytes += count;
+        return NULL;
+    }
+    return ring_buffer->buffer + (head & (ring_buffer->size - 1));
+}
+
+void ring_buffer_commit(RingBuffer *ring_buffer, size_t count)
+{
+    size_t head = atomic_load_explicit(&ring_buffer->head, memory_order_relaxed) + count;
+    atomic_store_explicit(&ring_buffer->head, head, memory_order_release);
+    size_t used = head - atomic_load_explicit(&ring_buffer->tail, memory_order_relaxed);
+    if (used > ring_buffer->high_water_mark)
+        ring_buffer->high_water_mark = used;
+}
+
+size_t ring_buffer_read_ptr(RingBuffer *ring_buffer, const void **ptr)
+{
+    size_t tail = atomic_load_explicit(&ring_buffer->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring_buffer->head, memory_order_acquire);
+    *ptr = ring_buffer->buffer + (tail & (ring_buffer->size - 1));
+    return head - tail;
+}
+
+void ring_buffer_release(RingBuffer *ring_buffer, size_t count)
+{
+    size_t tail = atomic_load_explicit(&ring_buffer->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring_buffer->tail, tail + count, memory_order_release);
+}
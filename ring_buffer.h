@@ -0,0 +1,51 @@
+/* single-producer/single-consumer lock-free ring buffer
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _RING_BUFFER_H
+#define _RING_BUFFER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* the ring buffer memory is mapped twice back to back (a 'mirrored' ring),
+ * so that any region of up to 'size' bytes starting anywhere in the ring
+ * is contiguous in memory; this way the producer can interleave samples
+ * directly into it and the consumer can hand it to write() in one call
+ */
+typedef struct {
+    char *buffer;
+    size_t size;
+    int huge_pages;           /* backed by huge pages */
+    _Atomic size_t head;      /* total bytes written by the producer */
+    _Atomic size_t tail;      /* total bytes consumed by the consumer */
+    /* the following are only updated by the producer */
+    size_t high_water_mark;
+    unsigned long long overruns;
+    unsigned long long overrun_bytes;
+} RingBuffer;
+
+/* size is rounded up to a power of two multiple of the page size */
+int ring_buffer_init(RingBuffer *ring_buffer, size_t size);
+/* the same, backed by huge pages if there are enough of them reserved
+ * (vm.nr_hugepages), with size rounded up to a multiple of the huge page
+ * size; otherwise with regular pages */
+int ring_buffer_init_huge_pages(RingBuffer *ring_buffer, size_t size);
+void ring_buffer_free(RingBuffer *ring_buffer);
+
+/* producer side: get a pointer to 'count' free bytes (NULL and an overrun
+ * is accounted for if there is not enough room), then commit them */
+void *ring_buffer_write_ptr(RingBuffer *ring_buffer, size_t count);
+void ring_buffer_commit(RingBuffer *ring_buffer, size_t count);
+
+/* consumer side: get a pointer to the bytes available for reading and how
+ * many they are, then release them once they have been consumed */
+size_t ring_buffer_read_ptr(RingBuffer *ring_buffer, const void **ptr);
+void ring_buffer_release(RingBuffer *ring_buffer, size_t count);
+
+#endif /* _RING_BUFFER_H */
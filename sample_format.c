@@ -0,0 +1,347 @@
+/* output sample formats and their vectorized conversion kernels
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SAMPLE_FORMAT_X86
+#endif
+
+#include "sample_format.h"
+
+/* the int16 full scale */
+#define CF32_SCALE (1.0f / 32768.0f)
+
+static void to_cf32_scalar(const short *in, unsigned int n, float *out);
+static unsigned int to_cs8_scalar(const short *in, unsigned int n, float scale, void *out);
+static unsigned int to_cs12_scalar(const short *in, unsigned int n, float scale, void *out);
+#ifdef SAMPLE_FORMAT_X86
+static void to_cf32_sse2(const short *in, unsigned int n, float *out);
+static unsigned int to_cs8_sse2(const short *in, unsigned int n, float scale, void *out);
+static unsigned int to_cs12_sse2(const short *in, unsigned int n, float scale, void *out);
+static void to_cf32_avx2(const short *in, unsigned int n, float *out);
+static unsigned int to_cs8_avx2(const short *in, unsigned int n, float scale, void *out);
+static unsigned int to_cs12_avx2(const short *in, unsigned int n, float scale, void *out);
+#endif
+
+static const SampleFormatKernel kernel_scalar = { "scalar", to_cf32_scalar, to_cs8_scalar, to_cs12_scalar };
+#ifdef SAMPLE_FORMAT_X86
+static const SampleFormatKernel kernel_sse2 = { "sse2", to_cf32_sse2, to_cs8_sse2, to_cs12_sse2 };
+static const SampleFormatKernel kernel_avx2 = { "avx2", to_cf32_avx2, to_cs8_avx2, to_cs12_avx2 };
+#endif
+
+const SampleFormatKernel *sample_format_kernels[3] = { &kernel_scalar };
+int sample_format_kernels_count = 1;
+
+const SampleFormatKernel *sample_format_kernel = &kernel_scalar;
+
+static const char *sample_format_names[] = { "cs16", "cf32", "cs8", "cs12" };
+
+
+void sample_format_init(void)
+{
+    sample_format_kernels_count = 0;
+    sample_format_kernels[sample_format_kernels_count++] = &kernel_scalar;
+#ifdef SAMPLE_FORMAT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        sample_format_kernels[sample_format_kernels_count++] = &kernel_sse2;
+    if (__builtin_cpu_supports("avx2"))
+        sample_format_kernels[sample_format_kernels_count++] = &kernel_avx2;
+#endif
+    sample_format_kernel = sample_format_kernels[sample_format_kernels_count - 1];
+}
+
+int sample_format_from_string(const char *string, SampleFormat *format, double *scale)
+{
+    size_t len = strcspn(string, ",");
+    for (int i = 0; i < (int)(sizeof(sample_format_names) / sizeof(sample_format_names[0])); i++) {
+        if (strlen(sample_format_names[i]) == len && strncmp(string, sample_format_names[i], len) == 0) {
+            *format = (SampleFormat)i;
+            *scale = sample_format_default_scale(*format);
+            if (string[len] == '\0')
+                return 0;
+            if (*format != SAMPLE_FORMAT_CS8 && *format != SAMPLE_FORMAT_CS12)
+                return -1;
+            char extra;
+            if (sscanf(string + len + 1, "%lg%c", scale, &extra) != 1 || *scale <= 0)
+                return -1;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *sample_format_name(SampleFormat format)
+{
+    return sample_format_names[format];
+}
+
+size_t sample_format_size(SampleFormat format)
+{
+    switch (format) {
+        case SAMPLE_FORMAT_CS16:
+            return 2 * sizeof(short);
+        case SAMPLE_FORMAT_CF32:
+            return 2 * sizeof(float);
+        case SAMPLE_FORMAT_CS8:
+            return 2;
+        case SAMPLE_FORMAT_CS12:
+            return 3;
+    }
+    return 0;
+}
+
+double sample_format_default_scale(SampleFormat format)
+{
+    switch (format) {
+        case SAMPLE_FORMAT_CS8:
+            return 1.0 / 256.0;
+        case SAMPLE_FORMAT_CS12:
+            return 1.0 / 16.0;
+        default:
+            return 1.0;
+    }
+}
+
+size_t sample_format_convert(SampleFormat format, float scale, const short *in, unsigned int n, void *out, unsigned long long *clipped)
+{
+    switch (format) {
+        case SAMPLE_FORMAT_CS16:
+            memcpy(out, in, n * 2 * sizeof(short));
+            break;
+        case SAMPLE_FORMAT_CF32:
+            sample_format_kernel->to_cf32(in, n, (float *)out);
+            break;
+        case SAMPLE_FORMAT_CS8:
+            *clipped += sample_format_kernel->to_cs8(in, n, scale, out);
+            break;
+        case SAMPLE_FORMAT_CS12:
+            *clipped += sample_format_kernel->to_cs12(in, n, scale, out);
+            break;
+    }
+    return n * sample_format_size(format);
+}
+
+
+/* lrintf() rounds to nearest even, like the vector conversions */
+static inline int scale_value(short x, float scale, int min, int max, unsigned int *clipped)
+{
+    long v = lrintf(x * scale);
+    if (v < min || v > max) {
+        (*clipped)++;
+        return v < min ? min : max;
+    }
+    return (int)v;
+}
+
+static void to_cf32_scalar(const short *in, unsigned int n, float *out)
+{
+    for (unsigned int i = 0; i < 2 * n; i++)
+        out[i] = in[i] * CF32_SCALE;
+}
+
+static unsigned int to_cs8_scalar(const short *in, unsigned int n, float scale, void *out)
+{
+    int8_t *o = (int8_t *)out;
+    unsigned int clipped = 0;
+    for (unsigned int i = 0; i < 2 * n; i++)
+        o[i] = (int8_t)scale_value(in[i], scale, INT8_MIN, INT8_MAX, &clipped);
+    return clipped;
+}
+
+static unsigned int to_cs12_scalar(const short *in, unsigned int n, float scale, void *out)
+{
+    uint8_t *o = (uint8_t *)out;
+    unsigned int clipped = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        int vi = scale_value(in[2*i], scale, -2048, 2047, &clipped);
+        int vq = scale_value(in[2*i+1], scale, -2048, 2047, &clipped);
+        o[3*i] = (uint8_t)vi;
+        o[3*i+1] = (uint8_t)(((vi >> 8) & 0x0f) | ((vq & 0x0f) << 4));
+        o[3*i+2] = (uint8_t)(vq >> 4);
+    }
+    return clipped;
+}
+
+#ifdef SAMPLE_FORMAT_X86
+/* sign extend the low and the high four int16's to int32 (SSE2 has no
+ * pmovsx), and scale them */
+__attribute__((target("sse2")))
+static inline __m128i scale_lo_sse2(__m128i v, __m128 vscale)
+{
+    return _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i scale_hi_sse2(__m128i v, __m128 vscale)
+{
+    return _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale));
+}
+
+/* the int16 values out of [min, max] */
+__attribute__((target("sse2")))
+static inline unsigned int count_clipped_sse2(__m128i v, __m128i vmin, __m128i vmax)
+{
+    __m128i out_of_range = _mm_or_si128(_mm_cmplt_epi16(v, vmin), _mm_cmpgt_epi16(v, vmax));
+    return __builtin_popcount(_mm_movemask_epi8(out_of_range)) / 2;
+}
+
+/* I in bits 0-11 and Q in bits 12-23 of each 32 bit lane */
+__attribute__((target("sse2")))
+static inline __m128i pack12_sse2(__m128i v)
+{
+    __m128i vi = _mm_and_si128(v, _mm_set1_epi32(0x00000fff));
+    __m128i vq = _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x0fff0000)), 4);
+    return _mm_or_si128(vi, vq);
+}
+
+__attribute__((target("sse2")))
+static void to_cf32_sse2(const short *in, unsigned int n, float *out)
+{
+    const __m128 vscale = _mm_set1_ps(CF32_SCALE);
+    unsigned int i = 0;
+    for (; i + 8 <= 2 * n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale));
+    }
+    to_cf32_scalar(in + i, n - i / 2, out + i);
+}
+
+__attribute__((target("sse2")))
+static unsigned int to_cs8_sse2(const short *in, unsigned int n, float scale, void *out)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128i vmin = _mm_set1_epi16(INT8_MIN);
+    const __m128i vmax = _mm_set1_epi16(INT8_MAX);
+    int8_t *o = (int8_t *)out;
+    unsigned int clipped = 0;
+    unsigned int i = 0;
+    for (; i + 16 <= 2 * n; i += 16) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(in + i + 8));
+        __m128i w0 = _mm_packs_epi32(scale_lo_sse2(v0, vscale), scale_hi_sse2(v0, vscale));
+        __m128i w1 = _mm_packs_epi32(scale_lo_sse2(v1, vscale), scale_hi_sse2(v1, vscale));
+        clipped += count_clipped_sse2(w0, vmin, vmax) + count_clipped_sse2(w1, vmin, vmax);
+        _mm_storeu_si128((__m128i *)(o + i), _mm_packs_epi16(w0, w1));
+    }
+    return clipped + to_cs8_scalar(in + i, n - i / 2, scale, o + i);
+}
+
+__attribute__((target("sse2")))
+static unsigned int to_cs12_sse2(const short *in, unsigned int n, float scale, void *out)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128i vmin = _mm_set1_epi16(-2048);
+    const __m128i vmax = _mm_set1_epi16(2047);
+    uint8_t *o = (uint8_t *)out;
+    unsigned int clipped = 0;
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + 2*i));
+        __m128i w = _mm_packs_epi32(scale_lo_sse2(v, vscale), scale_hi_sse2(v, vscale));
+        clipped += count_clipped_sse2(w, vmin, vmax);
+        w = _mm_min_epi16(_mm_max_epi16(w, vmin), vmax);
+        /* no byte shuffle in SSE2: store each 3 byte sample as 4 bytes,
+         * the next one overwrites the extra byte */
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, pack12_sse2(w));
+        for (int k = 0; k < 4; k++)
+            memcpy(o + 3 * (i + k), &lanes[k], sizeof(uint32_t));
+    }
+    return clipped + to_cs12_scalar(in + 2*i, n - i, scale, o + 3*i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i scale_avx2(__m128i v, __m256 vscale)
+{
+    return _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), vscale));
+}
+
+/* 16 int16's in order (packs works within each 128 bit lane) */
+__attribute__((target("avx2")))
+static inline __m256i scale16_avx2(const short *in, __m256 vscale)
+{
+    __m256i lo = scale_avx2(_mm_loadu_si128((const __m128i *)in), vscale);
+    __m256i hi = scale_avx2(_mm_loadu_si128((const __m128i *)(in + 8)), vscale);
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned int count_clipped_avx2(__m256i v, __m256i vmin, __m256i vmax)
+{
+    __m256i out_of_range = _mm256_or_si256(_mm256_cmpgt_epi16(vmin, v), _mm256_cmpgt_epi16(v, vmax));
+    return __builtin_popcount(_mm256_movemask_epi8(out_of_range)) / 2;
+}
+
+__attribute__((target("avx2")))
+static void to_cf32_avx2(const short *in, unsigned int n, float *out)
+{
+    const __m256 vscale = _mm256_set1_ps(CF32_SCALE);
+    unsigned int i = 0;
+    for (; i + 16 <= 2 * n; i += 16) {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + i + 8)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), vscale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), vscale));
+    }
+    to_cf32_scalar(in + i, n - i / 2, out + i);
+}
+
+__attribute__((target("avx2")))
+static unsigned int to_cs8_avx2(const short *in, unsigned int n, float scale, void *out)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256i vmin = _mm256_set1_epi16(INT8_MIN);
+    const __m256i vmax = _mm256_set1_epi16(INT8_MAX);
+    int8_t *o = (int8_t *)out;
+    unsigned int clipped = 0;
+    unsigned int i = 0;
+    for (; i + 32 <= 2 * n; i += 32) {
+        __m256i w0 = scale16_avx2(in + i, vscale);
+        __m256i w1 = scale16_avx2(in + i + 16, vscale);
+        clipped += count_clipped_avx2(w0, vmin, vmax) + count_clipped_avx2(w1, vmin, vmax);
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packs_epi16(w0, w1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(o + i), b);
+    }
+    return clipped + to_cs8_scalar(in + i, n - i / 2, scale, o + i);
+}
+
+__attribute__((target("avx2")))
+static unsigned int to_cs12_avx2(const short *in, unsigned int n, float scale, void *out)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256i vmin = _mm256_set1_epi16(-2048);
+    const __m256i vmax = _mm256_set1_epi16(2047);
+    /* the 3 low bytes of each 32 bit lane, 12 bytes per 128 bit lane */
+    const __m256i compact = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                             0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    uint8_t *o = (uint8_t *)out;
+    unsigned int clipped = 0;
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i w = scale16_avx2(in + 2*i, vscale);
+        clipped += count_clipped_avx2(w, vmin, vmax);
+        w = _mm256_min_epi16(_mm256_max_epi16(w, vmin), vmax);
+        __m256i vi = _mm256_and_si256(w, _mm256_set1_epi32(0x00000fff));
+        __m256i vq = _mm256_srli_epi32(_mm256_and_si256(w, _mm256_set1_epi32(0x0fff0000)), 4);
+        __m256i packed = _mm256_shuffle_epi8(_mm256_or_si256(vi, vq), compact);
+        /* 12 bytes from each half (the second store overwrites the 4
+         * extra bytes of the first one) */
+        _mm_storeu_si128((__m128i *)(o + 3*i), _mm256_castsi256_si128(packed));
+        _mm_storeu_si128((__m128i *)(o + 3*i + 12), _mm256_extracti128_si256(packed, 1));
+    }
+    return clipped + to_cs12_scalar(in + 2*i, n - i, scale, o + 3*i);
+}
+#endif
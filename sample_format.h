@@ -0,0 +1,64 @@
+/* output sample formats and their vectorized conversion kernels
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _SAMPLE_FORMAT_H
+#define _SAMPLE_FORMAT_H
+
+#include <stddef.h>
+
+/* all of them interleaved (I,Q,I,Q,...) in the host byte order */
+typedef enum {
+    SAMPLE_FORMAT_CS16,        /* int16, as received from the RSPduo */
+    SAMPLE_FORMAT_CF32,        /* float32, full scale is +/-1.0 */
+    SAMPLE_FORMAT_CS8,         /* int8, scaled (rounded and saturated) */
+    SAMPLE_FORMAT_CS12         /* int12, scaled like int8, and packed in 3 bytes
+                                * per sample: I[7:0], Q[3:0]I[11:8], Q[11:4]
+                                * (the same as the SoapySDR CS12 format) */
+} SampleFormat;
+
+/* the conversion of n complex samples; the scaled ones return how many
+ * values (I or Q) had to be saturated; out[] may be written up to
+ * SAMPLE_FORMAT_PADDING bytes past the end of the output */
+typedef void (*SampleToCF32Fn)(const short *in, unsigned int n, float *out);
+typedef unsigned int (*SampleToScaledFn)(const short *in, unsigned int n, float scale, void *out);
+
+#define SAMPLE_FORMAT_PADDING 16
+
+typedef struct {
+    const char *name;
+    SampleToCF32Fn to_cf32;
+    SampleToScaledFn to_cs8;
+    SampleToScaledFn to_cs12;
+} SampleFormatKernel;
+
+/* all the variants, scalar first; only the ones supported by this CPU
+ * are listed (after sample_format_init()) */
+extern const SampleFormatKernel *sample_format_kernels[];
+extern int sample_format_kernels_count;
+
+/* the variant selected by sample_format_init() */
+extern const SampleFormatKernel *sample_format_kernel;
+
+/* select the widest variant supported by this CPU */
+void sample_format_init(void);
+
+/* '<name>[,<scale>]' (the scale only for cs8 and cs12); returns -1 if invalid */
+int sample_format_from_string(const char *string, SampleFormat *format, double *scale);
+const char *sample_format_name(SampleFormat format);
+/* bytes per complex sample */
+size_t sample_format_size(SampleFormat format);
+/* cs8 keeps the top 8 bits and cs12 the top 12 bits of the int16 samples */
+double sample_format_default_scale(SampleFormat format);
+
+/* convert n interleaved int16 samples with the selected variant; returns
+ * the number of bytes in out[] (n * sample_format_size()), and adds the
+ * saturated values to *clipped */
+size_t sample_format_convert(SampleFormat format, float scale, const short *in, unsigned int n, void *out, unsigned long long *clipped);
+
+#endif /* _SAMPLE_FORMAT_H */
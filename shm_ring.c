@@ -0,0 +1,287 @@
+/* shared memory I/Q ring: one producer (the recorder), many readers
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm_ring.h"
+
+struct ShmRing {
+    char *name;
+    char *mapping;
+    size_t mapping_size;
+    ShmRingHeader *header;
+    short *data;
+    uint64_t capacity;
+    uint64_t cursor;
+    uint64_t block;
+};
+
+struct ShmRingReader {
+    char *mapping;
+    size_t mapping_size;
+    const ShmRingHeader *header;
+    const short *data;
+    uint64_t capacity;
+    uint64_t next_block;
+    unsigned int block_offset;
+    uint64_t next_cursor;      /* UINT64_MAX before the first read */
+    unsigned long long lags;
+    unsigned long long lost_samples;
+};
+
+static size_t page_size(void);
+static char *shm_ring_map(int fd, size_t data_offset, size_t data_size, int writable);
+
+
+/* producer side */
+ShmRing *shm_ring_create(const char *name, size_t size, char rx_id, double sample_rate, double frequency)
+{
+    size_t data_offset = (sizeof(ShmRingHeader) + page_size() - 1) & ~(page_size() - 1);
+    size_t data_size = page_size();
+    while (data_size < size)
+        data_size <<= 1;
+
+    /* a leftover from a recorder that did not exit cleanly is replaced */
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "shm_open(%s) failed: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, data_offset + data_size) == -1) {
+        fprintf(stderr, "ftruncate(%s) failed: %s\n", name, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    char *mapping = shm_ring_map(fd, data_offset, data_size, 1);
+    close(fd);
+    if (mapping == NULL) {
+        shm_unlink(name);
+        return NULL;
+    }
+    /* prefault all the pages, so the producer never takes a page fault */
+    memset(mapping, 0, data_offset + data_size);
+
+    ShmRing *ring = (ShmRing *)malloc(sizeof(ShmRing));
+    ring->name = strdup(name);
+    ring->mapping = mapping;
+    ring->mapping_size = data_offset + 2 * data_size;
+    ring->header = (ShmRingHeader *)mapping;
+    ring->data = (short *)(mapping + data_offset);
+    ring->capacity = data_size / (2 * sizeof(short));
+    ring->cursor = 0;
+    ring->block = 0;
+
+    ShmRingHeader *header = ring->header;
+    memcpy(header->magic, SHM_RING_MAGIC, sizeof(header->magic));
+    header->version = SHM_RING_VERSION;
+    header->data_offset = data_offset;
+    header->rx_id = rx_id;
+    strncpy(header->format, "cs16", sizeof(header->format));
+    header->bytes_per_sample = 2 * sizeof(short);
+    header->num_blocks = SHM_RING_BLOCKS;
+    header->capacity = ring->capacity;
+    header->sample_rate = sample_rate;
+    header->frequency = frequency;
+    header->producer_pid = getpid();
+    atomic_init(&header->stopped, 0);
+    atomic_init(&header->reserve_cursor, 0);
+    atomic_init(&header->write_cursor, 0);
+    atomic_init(&header->write_block, 0);
+    for (int i = 0; i < SHM_RING_BLOCKS; i++)
+        atomic_init(&header->blocks[i].sequence, 0);
+    return ring;
+}
+
+void shm_ring_close(ShmRing *ring)
+{
+    if (ring == NULL)
+        return;
+    /* the readers still attached keep their mapping, and see this */
+    atomic_store_explicit(&ring->header->stopped, 1, memory_order_release);
+    munmap(ring->mapping, ring->mapping_size);
+    if (shm_unlink(ring->name) == -1)
+        fprintf(stderr, "shm_unlink(%s) failed: %s\n", ring->name, strerror(errno));
+    free(ring->name);
+    free(ring);
+}
+
+short *shm_ring_write_ptr(ShmRing *ring, unsigned int num_samples)
+{
+    if (num_samples > ring->capacity)
+        return NULL;
+    /* the readers must see that these samples are about to be overwritten
+     * before they are */
+    atomic_store_explicit(&ring->header->reserve_cursor, ring->cursor + num_samples, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return ring->data + (ring->cursor & (ring->capacity - 1)) * 2;
+}
+
+void shm_ring_commit(ShmRing *ring, uint64_t sample_index, uint32_t first_sample_num, unsigned int num_samples, double frequency)
+{
+    ShmRingHeader *header = ring->header;
+    ShmRingBlock *block = &header->blocks[ring->block & (SHM_RING_BLOCKS - 1)];
+    atomic_store_explicit(&block->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    block->cursor = ring->cursor;
+    block->sample_index = sample_index;
+    block->first_sample_num = first_sample_num;
+    block->num_samples = num_samples;
+    block->frequency = frequency;
+    atomic_store_explicit(&block->sequence, ring->block + 1, memory_order_release);
+
+    ring->cursor += num_samples;
+    ring->block++;
+    atomic_store_explicit(&header->write_cursor, ring->cursor, memory_order_release);
+    atomic_store_explicit(&header->write_block, ring->block, memory_order_release);
+}
+
+
+/* reader side */
+ShmRingReader *shm_ring_attach(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        fprintf(stderr, "shm_open(%s) failed: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    /* the header first, for the layout */
+    struct stat st;
+    ShmRingHeader header;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(header) || pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        fprintf(stderr, "%s is not ready\n", name);
+        close(fd);
+        return NULL;
+    }
+    size_t data_size = header.capacity * header.bytes_per_sample;
+    if (memcmp(header.magic, SHM_RING_MAGIC, sizeof(header.magic)) != 0 || header.version != SHM_RING_VERSION ||
+        header.num_blocks != SHM_RING_BLOCKS || (size_t)st.st_size != header.data_offset + data_size) {
+        fprintf(stderr, "%s is not a shared memory I/Q ring (version %d)\n", name, SHM_RING_VERSION);
+        close(fd);
+        return NULL;
+    }
+    char *mapping = shm_ring_map(fd, header.data_offset, data_size, 0);
+    close(fd);
+    if (mapping == NULL)
+        return NULL;
+
+    ShmRingReader *reader = (ShmRingReader *)malloc(sizeof(ShmRingReader));
+    reader->mapping = mapping;
+    reader->mapping_size = header.data_offset + 2 * data_size;
+    reader->header = (const ShmRingHeader *)mapping;
+    reader->data = (const short *)(mapping + header.data_offset);
+    reader->capacity = header.capacity;
+    reader->next_block = atomic_load_explicit(&reader->header->write_block, memory_order_acquire);
+    reader->block_offset = 0;
+    reader->next_cursor = UINT64_MAX;
+    reader->lags = 0;
+    reader->lost_samples = 0;
+    return reader;
+}
+
+void shm_ring_detach(ShmRingReader *reader)
+{
+    if (reader == NULL)
+        return;
+    munmap(reader->mapping, reader->mapping_size);
+    free(reader);
+}
+
+const ShmRingHeader *shm_ring_header(const ShmRingReader *reader)
+{
+    return reader->header;
+}
+
+int shm_ring_read(ShmRingReader *reader, short *samples, unsigned int max_samples, ShmRingRead *read)
+{
+    const ShmRingHeader *header = reader->header;
+    while (1) {
+        /* 'stopped' first, so that no block published before it is missed */
+        uint32_t stopped = atomic_load_explicit(&header->stopped, memory_order_acquire);
+        uint64_t write_block = atomic_load_explicit(&header->write_block, memory_order_acquire);
+        if (reader->next_block == write_block)
+            return stopped ? -1 : 0;
+        const ShmRingBlock *block = &header->blocks[reader->next_block & (SHM_RING_BLOCKS - 1)];
+        uint64_t sequence = atomic_load_explicit(&block->sequence, memory_order_acquire);
+        uint64_t cursor = block->cursor + reader->block_offset;
+        uint64_t sample_index = block->sample_index + reader->block_offset;
+        uint32_t first_sample_num = block->first_sample_num + reader->block_offset;
+        unsigned int num_samples = block->num_samples;
+        double frequency = block->frequency;
+        unsigned int n = num_samples - reader->block_offset < max_samples ? num_samples - reader->block_offset : max_samples;
+        if (sequence == reader->next_block + 1 && reader->block_offset < num_samples)
+            memcpy(samples, reader->data + (cursor & (reader->capacity - 1)) * 2, n * 2 * sizeof(short));
+        /* whatever was copied is good only if the producer did not get to
+         * it in the meantime */
+        atomic_thread_fence(memory_order_acquire);
+        if (sequence != reader->next_block + 1 || atomic_load_explicit(&block->sequence, memory_order_relaxed) != sequence ||
+            reader->block_offset >= num_samples ||
+            atomic_load_explicit(&header->reserve_cursor, memory_order_relaxed) > cursor + reader->capacity) {
+            /* lapped: skip ahead to the newest block */
+            reader->lags++;
+            write_block = atomic_load_explicit(&header->write_block, memory_order_acquire);
+            reader->next_block = write_block > 0 ? write_block - 1 : 0;
+            reader->block_offset = 0;
+            continue;
+        }
+
+        read->sample_index = sample_index;
+        read->first_sample_num = first_sample_num;
+        read->frequency = frequency;
+        read->lost_samples = reader->next_cursor != UINT64_MAX && cursor > reader->next_cursor ? cursor - reader->next_cursor : 0;
+        reader->lost_samples += read->lost_samples;
+        reader->next_cursor = cursor + n;
+        reader->block_offset += n;
+        if (reader->block_offset == num_samples) {
+            reader->next_block++;
+            reader->block_offset = 0;
+        }
+        return n;
+    }
+}
+
+unsigned long long shm_ring_lags(const ShmRingReader *reader, unsigned long long *lost_samples)
+{
+    *lost_samples = reader->lost_samples;
+    return reader->lags;
+}
+
+
+static size_t page_size(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* the header and the samples, then the samples again right after them */
+static char *shm_ring_map(int fd, size_t data_offset, size_t data_size, int writable)
+{
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    size_t mapping_size = data_offset + 2 * data_size;
+    char *mapping = mmap(NULL, mapping_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "mmap(%zu) failed: %s\n", mapping_size, strerror(errno));
+        return NULL;
+    }
+    if (mmap(mapping, data_offset + data_size, prot, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(mapping + data_offset + data_size, data_size, prot, MAP_SHARED | MAP_FIXED, fd, data_offset) == MAP_FAILED) {
+        fprintf(stderr, "mmap(%zu) failed: %s\n", data_size, strerror(errno));
+        munmap(mapping, mapping_size);
+        return NULL;
+    }
+    return mapping;
+}
@@ -0,0 +1,96 @@
+/* shared memory I/Q ring: one producer (the recorder), many readers
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _SHM_RING_H
+#define _SHM_RING_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* the POSIX shared memory object ('/dev/shm/<name>') is the header (which
+ * ends with the block table), padded to a page, followed by the samples
+ * (interleaved int16 I/Q, a power of two of them); both sides map the
+ * samples twice back to back, like the ring buffers in ring_buffer.h, so
+ * that each block is contiguous in memory
+ *
+ * the producer never waits for the readers: each reader has its own
+ * cursor (in its own process), and finds out it was lapped by the producer
+ * (it lagged more than the size of the ring) from the cursors in the
+ * header, in which case it skips ahead to the newest block */
+
+#define SHM_RING_MAGIC "IQSHRING"
+#define SHM_RING_VERSION 1
+#define SHM_RING_BLOCKS 4096       /* block table entries (a power of two) */
+
+typedef struct {
+    _Atomic uint64_t sequence; /* block number + 1 (0 while it is being updated) */
+    uint64_t cursor;           /* the write cursor at its first sample */
+    uint64_t sample_index;     /* the unwrapped sample number of its first sample */
+    uint32_t first_sample_num; /* the same, as received from the SDRplay API */
+    uint32_t num_samples;
+    double frequency;          /* the tuner frequency (it changes in scan mode) */
+} ShmRingBlock;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t data_offset;      /* where the samples start (page aligned) */
+    char rx_id;
+    char format[7];            /* always 'cs16' for now */
+    uint32_t bytes_per_sample;
+    uint32_t num_blocks;
+    uint64_t capacity;         /* samples in the ring (a power of two) */
+    double sample_rate;
+    double frequency;          /* the initial tuner frequency */
+    int32_t producer_pid;
+    _Atomic uint32_t stopped;  /* the producer is done */
+    /* in samples, since the start; the producer moves 'reserve' before it
+     * writes the samples, and 'write' after it has written them */
+    _Atomic uint64_t reserve_cursor;
+    _Atomic uint64_t write_cursor;
+    _Atomic uint64_t write_block;   /* blocks published */
+    ShmRingBlock blocks[SHM_RING_BLOCKS];
+} ShmRingHeader;
+
+/* producer side */
+typedef struct ShmRing ShmRing;
+
+/* size (in bytes) is rounded up to a power of two multiple of the page
+ * size; the shared memory object is removed by shm_ring_close() */
+ShmRing *shm_ring_create(const char *name, size_t size, char rx_id, double sample_rate, double frequency);
+void shm_ring_close(ShmRing *ring);
+/* room for num_samples interleaved samples, written straight in there by
+ * the caller; NULL if the block is larger than the ring */
+short *shm_ring_write_ptr(ShmRing *ring, unsigned int num_samples);
+/* publish them */
+void shm_ring_commit(ShmRing *ring, uint64_t sample_index, uint32_t first_sample_num, unsigned int num_samples, double frequency);
+
+/* reader side (a small client library: shm_ring.c is all it takes) */
+typedef struct ShmRingReader ShmRingReader;
+
+typedef struct {
+    uint64_t sample_index;     /* of the first sample read */
+    uint32_t first_sample_num;
+    double frequency;
+    uint64_t lost_samples;     /* skipped since the previous read, because
+                                * the reader lagged behind the producer */
+} ShmRingRead;
+
+/* attach read only, starting with the next block published */
+ShmRingReader *shm_ring_attach(const char *name);
+void shm_ring_detach(ShmRingReader *reader);
+const ShmRingHeader *shm_ring_header(const ShmRingReader *reader);
+/* copy up to max_samples interleaved samples (from a single block, so
+ * they are consecutive) into samples[]; returns how many, 0 if there is
+ * nothing new, or -1 if there is nothing new and the producer is done */
+int shm_ring_read(ShmRingReader *reader, short *samples, unsigned int max_samples, ShmRingRead *read);
+/* how many times the reader was lapped, and how many samples it lost */
+unsigned long long shm_ring_lags(const ShmRingReader *reader, unsigned long long *lost_samples);
+
+#endif /* _SHM_RING_H */
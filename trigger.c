@@ -0,0 +1,100 @@
+/* squelch trigger shared by the two tuners
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+
+#include "trigger.h"
+
+/* the power of a full scale complex sine */
+#define FULL_SCALE_POWER (32768.0 * 32768.0)
+
+
+int trigger_init(Trigger *trigger, double threshold_dbfs, uint64_t pre_trigger, uint64_t hang)
+{
+    trigger->threshold = FULL_SCALE_POWER * pow(10.0, threshold_dbfs / 10.0);
+    trigger->pre_trigger = pre_trigger;
+    trigger->hang = hang;
+    trigger->start = 0;
+    trigger->until = 0;
+    trigger->previous_until = 0;
+    trigger->triggers = 0;
+    return pthread_spin_init(&trigger->lock, PTHREAD_PROCESS_PRIVATE) == 0 ? 0 : -1;
+}
+
+void trigger_free(Trigger *trigger)
+{
+    pthread_spin_destroy(&trigger->lock);
+}
+
+void trigger_channel_init(TriggerChannel *channel)
+{
+    channel->open = 0;
+    channel->segment_start = 0;
+    channel->closed_at = 0;
+}
+
+int trigger_block(Trigger *trigger, TriggerChannel *channel, uint64_t sample_index, unsigned int num_samples, uint64_t energy, TriggerTransition *transitions)
+{
+    uint64_t end = sample_index + num_samples;
+    pthread_spin_lock(&trigger->lock);
+    if (energy >= trigger->threshold * num_samples) {
+        if (sample_index >= trigger->until) {
+            /* a new segment */
+            trigger->previous_until = trigger->until;
+            trigger->start = sample_index;
+            trigger->triggers++;
+        }
+        if (end + trigger->hang > trigger->until)
+            trigger->until = end + trigger->hang;
+    }
+    uint64_t start = trigger->start;
+    uint64_t until = trigger->until;
+    uint64_t previous_until = trigger->previous_until;
+    pthread_spin_unlock(&trigger->lock);
+
+    int n = 0;
+    if (channel->open && channel->segment_start != start) {
+        /* the other tuner started a new segment before the one recorded
+         * here ended: close it where it ended for both */
+        if (previous_until >= end)
+            return n;
+        channel->closed_at = previous_until > sample_index ? previous_until : sample_index;
+        transitions[n++] = (TriggerTransition){ TRIGGER_CLOSE, channel->closed_at };
+        channel->open = 0;
+    }
+    if (!channel->open && until > sample_index) {
+        /* the pre-trigger does not go back into the previous segment, and
+         * if the other tuner extended a segment after it was closed here,
+         * the recording resumes where it stopped (the writer thread still
+         * has those samples) */
+        uint64_t open_at = start > trigger->pre_trigger ? start - trigger->pre_trigger : 0;
+        if (open_at < previous_until)
+            open_at = previous_until;
+        if (open_at < channel->closed_at)
+            open_at = channel->closed_at;
+        if (open_at < end) {
+            transitions[n++] = (TriggerTransition){ TRIGGER_OPEN, open_at };
+            channel->open = 1;
+            channel->segment_start = start;
+        }
+    }
+    if (channel->open && until < end) {
+        channel->closed_at = until > sample_index ? until : sample_index;
+        transitions[n++] = (TriggerTransition){ TRIGGER_CLOSE, channel->closed_at };
+        channel->open = 0;
+    }
+    return n;
+}
+
+double trigger_power_dbfs(uint64_t energy, unsigned int num_samples)
+{
+    if (energy == 0 || num_samples == 0)
+        return -INFINITY;
+    return 10.0 * log10(energy / (FULL_SCALE_POWER * num_samples));
+}
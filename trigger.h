@@ -0,0 +1,67 @@
+/* squelch trigger shared by the two tuners
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _TRIGGER_H
+#define _TRIGGER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* a block whose mean power (I^2+Q^2, relative to a full scale complex
+ * sine) is at or above the threshold triggers a segment, which starts
+ * pre_trigger samples before that block, and ends hang samples after the
+ * last block above the threshold; A and B share the sample numbers, so
+ * either tuner can trigger (or extend) a segment, and both record the
+ * same samples; the state is only held for a few comparisons, so a
+ * spinlock between the two stream callbacks is enough */
+typedef struct {
+    double threshold;          /* mean I^2+Q^2 per sample */
+    uint64_t pre_trigger;
+    uint64_t hang;
+    pthread_spinlock_t lock;
+    uint64_t start;            /* the current (or last) segment */
+    uint64_t until;
+    uint64_t previous_until;   /* end of the segment before that */
+    unsigned long long triggers;
+} Trigger;
+
+/* per tuner: the segment being recorded */
+typedef struct {
+    int open;
+    uint64_t segment_start;    /* start of the segment being recorded */
+    uint64_t closed_at;        /* where the recording last stopped */
+} TriggerChannel;
+
+typedef enum {
+    TRIGGER_OPEN,
+    TRIGGER_CLOSE
+} TriggerTransitionType;
+
+typedef struct {
+    TriggerTransitionType type;
+    uint64_t sample_index;     /* the first sample in (or after) the segment */
+} TriggerTransition;
+
+/* at most a close, an open, and a close again in a single block */
+#define TRIGGER_MAX_TRANSITIONS 3
+
+int trigger_init(Trigger *trigger, double threshold_dbfs, uint64_t pre_trigger, uint64_t hang);
+void trigger_free(Trigger *trigger);
+void trigger_channel_init(TriggerChannel *channel);
+
+/* called by the stream callback of each tuner for every block, with its
+ * unwrapped sample index and its energy (see iq_energy()); returns the
+ * number of transitions (in order) where the recording of this tuner
+ * starts or stops; an open may be before the block (the pre-trigger) */
+int trigger_block(Trigger *trigger, TriggerChannel *channel, uint64_t sample_index, unsigned int num_samples, uint64_t energy, TriggerTransition *transitions);
+
+/* the mean power of a block in dBFS */
+double trigger_power_dbfs(uint64_t energy, unsigned int num_samples);
+
+#endif /* _TRIGGER_H */
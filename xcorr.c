@@ -0,0 +1,196 @@
+/* streaming A/B cross-correlation
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fft.h"
+#include "xcorr.h"
+
+struct Xcorr {
+    Fft *fft;
+    unsigned int size;
+    unsigned int hop;
+    unsigned int interval_samples;
+    float *window;
+    /* the last 'size' samples of A and B */
+    float *a_re;
+    float *a_im;
+    float *b_re;
+    float *b_im;
+    unsigned int fill;
+    uint64_t next_sample_index;
+    /* the FFT work buffers */
+    float *fa_re;
+    float *fa_im;
+    float *fb_re;
+    float *fb_im;
+    /* accumulated over the interval */
+    double *cross_re;
+    double *cross_im;
+    double energy_a;
+    double energy_b;
+    unsigned int frames;
+    unsigned int interval_fill;
+    uint64_t interval_start;
+};
+
+static void xcorr_frame(Xcorr *xcorr);
+static void xcorr_report(Xcorr *xcorr, XcorrReport *report);
+
+
+Xcorr *xcorr_create(unsigned int size, unsigned int interval_samples)
+{
+    Fft *fft = fft_create(size);
+    if (fft == NULL)
+        return NULL;
+    Xcorr *xcorr = (Xcorr *)calloc(1, sizeof(Xcorr));
+    xcorr->fft = fft;
+    xcorr->size = size;
+    xcorr->hop = size / 2;
+    xcorr->interval_samples = interval_samples;
+    xcorr->window = (float *)malloc(size * sizeof(float));
+    fft_hann_window(xcorr->window, size);
+    float **buffers[] = { &xcorr->a_re, &xcorr->a_im, &xcorr->b_re, &xcorr->b_im, &xcorr->fa_re, &xcorr->fa_im, &xcorr->fb_re, &xcorr->fb_im };
+    for (unsigned int k = 0; k < sizeof(buffers) / sizeof(buffers[0]); k++)
+        *buffers[k] = (float *)malloc(size * sizeof(float));
+    xcorr->cross_re = (double *)calloc(size, sizeof(double));
+    xcorr->cross_im = (double *)calloc(size, sizeof(double));
+    xcorr->fill = 0;
+    xcorr->next_sample_index = UINT64_MAX;
+    return xcorr;
+}
+
+void xcorr_free(Xcorr *xcorr)
+{
+    if (xcorr == NULL)
+        return;
+    fft_free(xcorr->fft);
+    free(xcorr->window);
+    free(xcorr->a_re);
+    free(xcorr->a_im);
+    free(xcorr->b_re);
+    free(xcorr->b_im);
+    free(xcorr->fa_re);
+    free(xcorr->fa_im);
+    free(xcorr->fb_re);
+    free(xcorr->fb_im);
+    free(xcorr->cross_re);
+    free(xcorr->cross_im);
+    free(xcorr);
+}
+
+unsigned int xcorr_process(Xcorr *xcorr, uint64_t sample_index, const short *ai, const short *aq, const short *bi, const short *bq, unsigned int n, XcorrReport *report, int *ready)
+{
+    *ready = 0;
+    if (sample_index != xcorr->next_sample_index)
+        xcorr->fill = 0;
+    if (xcorr->frames == 0 && xcorr->interval_fill == 0)
+        xcorr->interval_start = sample_index;
+    unsigned int taken = 0;
+    while (taken < n) {
+        unsigned int m = n - taken < xcorr->size - xcorr->fill ? n - taken : xcorr->size - xcorr->fill;
+        for (unsigned int k = 0; k < m; k++) {
+            xcorr->a_re[xcorr->fill + k] = ai[taken + k];
+            xcorr->a_im[xcorr->fill + k] = aq[taken + k];
+            xcorr->b_re[xcorr->fill + k] = bi[taken + k];
+            xcorr->b_im[xcorr->fill + k] = bq[taken + k];
+        }
+        xcorr->fill += m;
+        xcorr->interval_fill += m;
+        taken += m;
+        if (xcorr->fill == xcorr->size) {
+            xcorr_frame(xcorr);
+            /* keep the second half for the next frame */
+            unsigned int hop = xcorr->hop;
+            memmove(xcorr->a_re, xcorr->a_re + hop, (xcorr->size - hop) * sizeof(float));
+            memmove(xcorr->a_im, xcorr->a_im + hop, (xcorr->size - hop) * sizeof(float));
+            memmove(xcorr->b_re, xcorr->b_re + hop, (xcorr->size - hop) * sizeof(float));
+            memmove(xcorr->b_im, xcorr->b_im + hop, (xcorr->size - hop) * sizeof(float));
+            xcorr->fill -= hop;
+        }
+        if (xcorr->interval_fill >= xcorr->interval_samples && xcorr->frames > 0) {
+            xcorr_report(xcorr, report);
+            *ready = 1;
+            break;
+        }
+    }
+    xcorr->next_sample_index = sample_index + taken;
+    return taken;
+}
+
+static void xcorr_frame(Xcorr *xcorr)
+{
+    unsigned int size = xcorr->size;
+    double energy_a = 0.0;
+    double energy_b = 0.0;
+    for (unsigned int k = 0; k < size; k++) {
+        float w = xcorr->window[k];
+        xcorr->fa_re[k] = xcorr->a_re[k] * w;
+        xcorr->fa_im[k] = xcorr->a_im[k] * w;
+        xcorr->fb_re[k] = xcorr->b_re[k] * w;
+        xcorr->fb_im[k] = xcorr->b_im[k] * w;
+        energy_a += xcorr->fa_re[k] * xcorr->fa_re[k] + xcorr->fa_im[k] * xcorr->fa_im[k];
+        energy_b += xcorr->fb_re[k] * xcorr->fb_re[k] + xcorr->fb_im[k] * xcorr->fb_im[k];
+    }
+    fft_forward(xcorr->fft, xcorr->fa_re, xcorr->fa_im);
+    fft_forward(xcorr->fft, xcorr->fb_re, xcorr->fb_im);
+    for (unsigned int k = 0; k < size; k++) {
+        float ar = xcorr->fa_re[k], aim = xcorr->fa_im[k];
+        float br = xcorr->fb_re[k], bim = xcorr->fb_im[k];
+        xcorr->cross_re[k] += ar * br + aim * bim;
+        xcorr->cross_im[k] += aim * br - ar * bim;
+    }
+    xcorr->energy_a += energy_a;
+    xcorr->energy_b += energy_b;
+    xcorr->frames++;
+}
+
+/* the inverse FFT of the accumulated cross spectrum, and its peak */
+static void xcorr_report(Xcorr *xcorr, XcorrReport *report)
+{
+    unsigned int size = xcorr->size;
+    float *r_re = xcorr->fa_re;
+    float *r_im = xcorr->fa_im;
+    for (unsigned int k = 0; k < size; k++) {
+        r_re[k] = (float)xcorr->cross_re[k];
+        r_im[k] = (float)xcorr->cross_im[k];
+    }
+    fft_inverse(xcorr->fft, r_re, r_im);
+    unsigned int peak = 0;
+    float peak_power = -1.0f;
+    for (unsigned int k = 0; k < size; k++) {
+        float power = r_re[k] * r_re[k] + r_im[k] * r_im[k];
+        if (power > peak_power) {
+            peak_power = power;
+            peak = k;
+        }
+    }
+    double m0 = sqrt(r_re[(peak + size - 1) % size] * r_re[(peak + size - 1) % size] + r_im[(peak + size - 1) % size] * r_im[(peak + size - 1) % size]);
+    double m1 = sqrt(peak_power);
+    double m2 = sqrt(r_re[(peak + 1) % size] * r_re[(peak + 1) % size] + r_im[(peak + 1) % size] * r_im[(peak + 1) % size]);
+    double denominator = m0 - 2.0 * m1 + m2;
+    double fraction = denominator < 0.0 ? 0.5 * (m0 - m2) / denominator : 0.0;
+    int lag = peak < size / 2 ? (int)peak : (int)peak - (int)size;
+
+    report->sample_index = xcorr->interval_start;
+    report->frames = xcorr->frames;
+    report->lag = lag + fraction;
+    double energy = sqrt(xcorr->energy_a * xcorr->energy_b);
+    report->magnitude = energy > 0.0 ? m1 / (size * energy) : 0.0;
+    report->phase = atan2(r_im[peak], r_re[peak]) * 180.0 / M_PI;
+
+    memset(xcorr->cross_re, 0, size * sizeof(double));
+    memset(xcorr->cross_im, 0, size * sizeof(double));
+    xcorr->energy_a = 0.0;
+    xcorr->energy_b = 0.0;
+    xcorr->frames = 0;
+    xcorr->interval_fill = 0;
+}
@@ -0,0 +1,41 @@
+/* streaming A/B cross-correlation
+ */
+
+/*
+ * Copyright 2026 The dual-tuner-experiments contributors.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef _XCORR_H
+#define _XCORR_H
+
+#include <stdint.h>
+
+/* the A and B samples (aligned by sample number) are cut into Hann
+ * windowed FFT frames overlapping by half; the cross spectrum A * conj(B)
+ * of the frames is accumulated over each report interval, and its inverse
+ * FFT is the cross-correlation for lags from -size/2 to size/2 - 1 */
+typedef struct Xcorr Xcorr;
+
+typedef struct {
+    uint64_t sample_index;     /* of the first sample in the interval */
+    unsigned int frames;
+    double lag;                /* in samples (parabolic interpolation of the
+                                * peak); positive if A is behind B */
+    double magnitude;          /* normalized: 1 if A and B are the same
+                                * signal (except for the delay and phase) */
+    double phase;              /* A - B at the peak, in degrees */
+} XcorrReport;
+
+/* returns NULL (after printing the reason) if size is not a power of two */
+Xcorr *xcorr_create(unsigned int size, unsigned int interval_samples);
+void xcorr_free(Xcorr *xcorr);
+
+/* n samples of A and B (I and Q in separate arrays, like the stream
+ * callbacks), starting at sample_index (if that is not where the previous
+ * ones ended, the current frame starts over); returns how many samples were
+ * taken, stopping early when a report is ready (then *ready is set) */
+unsigned int xcorr_process(Xcorr *xcorr, uint64_t sample_index, const short *ai, const short *aq, const short *bi, const short *bq, unsigned int n, XcorrReport *report, int *ready);
+
+#endif /* _XCORR_H */